@@ -0,0 +1,296 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Thread.h>
+
+#include <thread>
+
+namespace
+{
+
+/// Object that receives events.
+class EventReceiver : public Object
+{
+    URHO3D_OBJECT(EventReceiver, Object);
+
+public:
+    using Object::Object;
+
+    float typedTimeStep_{};
+    unsigned numTypedEvents_{};
+    float legacyTimeStep_{};
+    unsigned numLegacyEvents_{};
+};
+
+}
+
+TEST_CASE("Typed events are received by typed and VariantMap subscribers")
+{
+    auto context = MakeShared<Context>();
+    auto sender = MakeShared<EventReceiver>(context);
+    auto typedReceiver = MakeShared<EventReceiver>(context);
+    auto specificReceiver = MakeShared<EventReceiver>(context);
+    auto legacyReceiver = MakeShared<EventReceiver>(context);
+
+    typedReceiver->SubscribeToTypedEvent<UpdateEventArgs>([&](const UpdateEventArgs& args)
+    {
+        typedReceiver->typedTimeStep_ = args.timeStep_;
+        ++typedReceiver->numTypedEvents_;
+    });
+    specificReceiver->SubscribeToTypedEvent<UpdateEventArgs>(sender, [&](const UpdateEventArgs& args)
+    {
+        REQUIRE(specificReceiver->GetEventSender() == sender);
+        ++specificReceiver->numTypedEvents_;
+    });
+    legacyReceiver->SubscribeToEvent(E_UPDATE, [&](StringHash, VariantMap& eventData)
+    {
+        legacyReceiver->legacyTimeStep_ = eventData[Update::P_TIMESTEP].GetFloat();
+        ++legacyReceiver->numLegacyEvents_;
+    });
+
+    UpdateEventArgs args;
+    args.timeStep_ = 0.5f;
+    sender->SendTypedEvent(args);
+
+    REQUIRE(typedReceiver->numTypedEvents_ == 1);
+    REQUIRE(typedReceiver->typedTimeStep_ == 0.5f);
+    REQUIRE(specificReceiver->numTypedEvents_ == 1);
+    REQUIRE(legacyReceiver->numLegacyEvents_ == 1);
+    REQUIRE(legacyReceiver->legacyTimeStep_ == 0.5f);
+
+    // Other senders are ignored by specific receivers
+    typedReceiver->SendTypedEvent(args);
+    REQUIRE(typedReceiver->numTypedEvents_ == 2);
+    REQUIRE(specificReceiver->numTypedEvents_ == 1);
+
+    // Unsubscribed and destroyed receivers are skipped
+    typedReceiver->UnsubscribeFromTypedEvent<UpdateEventArgs>();
+    specificReceiver = nullptr;
+    sender->SendTypedEvent(args);
+    REQUIRE(typedReceiver->numTypedEvents_ == 2);
+    REQUIRE(legacyReceiver->numLegacyEvents_ == 3);
+}
+
+TEST_CASE("Typed event index is the same in all modules")
+{
+    // Other modules have their own copy of GetTypedEventIndex, which allocates index via engine registry
+    const unsigned updateIndex = GetTypedEventIndex<UpdateEventArgs>();
+    REQUIRE(AllocateTypedEventIndex(UpdateEventArgs::GetEventType()) == updateIndex);
+    REQUIRE(AllocateTypedEventIndex(E_UPDATE) == updateIndex);
+
+    const unsigned postUpdateIndex = GetTypedEventIndex<PostUpdateEventArgs>();
+    REQUIRE(postUpdateIndex != updateIndex);
+    REQUIRE(AllocateTypedEventIndex(E_POSTUPDATE) == postUpdateIndex);
+}
+
+TEST_CASE("Typed subscribers are invoked before VariantMap subscribers")
+{
+    auto context = MakeShared<Context>();
+    auto sender = MakeShared<EventReceiver>(context);
+    auto legacyReceiver = MakeShared<EventReceiver>(context);
+    auto typedReceiver = MakeShared<EventReceiver>(context);
+
+    ea::vector<Object*> invocationOrder;
+    legacyReceiver->SubscribeToEvent(sender, E_UPDATE, [&](StringHash, VariantMap&) { invocationOrder.push_back(legacyReceiver); });
+    typedReceiver->SubscribeToTypedEvent<UpdateEventArgs>([&](const UpdateEventArgs&) { invocationOrder.push_back(typedReceiver); });
+
+    sender->SendTypedEvent(UpdateEventArgs{});
+    REQUIRE(invocationOrder == ea::vector<Object*>{ typedReceiver, legacyReceiver });
+
+    // VariantMap subscribers are skipped once unsubscribed
+    legacyReceiver->UnsubscribeFromEvent(sender, E_UPDATE);
+    invocationOrder.clear();
+    sender->SendTypedEvent(UpdateEventArgs{});
+    REQUIRE(invocationOrder == ea::vector<Object*>{ typedReceiver });
+}
+
+TEST_CASE("Typed subscriptions are removed by generic unsubscribe")
+{
+    auto context = MakeShared<Context>();
+    auto sender = MakeShared<EventReceiver>(context);
+    auto receiver = MakeShared<EventReceiver>(context);
+
+    const auto subscribe = [&]()
+    {
+        receiver->SubscribeToTypedEvent<UpdateEventArgs>([&](const UpdateEventArgs&) { ++receiver->numTypedEvents_; });
+        receiver->SubscribeToTypedEvent<PostUpdateEventArgs>(sender, [&](const PostUpdateEventArgs&) { ++receiver->numTypedEvents_; });
+    };
+    const auto sendEvents = [&]()
+    {
+        receiver->numTypedEvents_ = 0;
+        sender->SendTypedEvent(UpdateEventArgs{});
+        sender->SendTypedEvent(PostUpdateEventArgs{});
+        return receiver->numTypedEvents_;
+    };
+
+    subscribe();
+    REQUIRE(receiver->HasEventHandlers());
+    REQUIRE(receiver->HasSubscribedToEvent(E_UPDATE));
+    REQUIRE(receiver->HasSubscribedToEvent(E_POSTUPDATE));
+    REQUIRE(receiver->HasSubscribedToEvent(sender, E_POSTUPDATE));
+    REQUIRE_FALSE(receiver->HasSubscribedToEvent(sender, E_UPDATE));
+    REQUIRE(sendEvents() == 2);
+
+    receiver->UnsubscribeFromAllEvents();
+    REQUIRE_FALSE(receiver->HasEventHandlers());
+    REQUIRE_FALSE(receiver->HasSubscribedToEvent(E_UPDATE));
+    REQUIRE_FALSE(receiver->HasSubscribedToEvent(sender, E_POSTUPDATE));
+    REQUIRE(sendEvents() == 0);
+
+    subscribe();
+    receiver->UnsubscribeFromAllEventsExcept(ea::vector<StringHash>{ E_UPDATE }, false);
+    REQUIRE(receiver->HasSubscribedToEvent(E_UPDATE));
+    REQUIRE_FALSE(receiver->HasSubscribedToEvent(E_POSTUPDATE));
+    REQUIRE(sendEvents() == 1);
+
+    // Typed subscriptions have no userdata
+    receiver->UnsubscribeFromAllEventsExcept(ea::vector<StringHash>{}, true);
+    REQUIRE(sendEvents() == 1);
+
+    subscribe();
+    receiver->UnsubscribeFromAllEventsExcept(ea::vector<Object*>{ sender }, false);
+    REQUIRE_FALSE(receiver->HasSubscribedToEvent(E_UPDATE));
+    REQUIRE(receiver->HasSubscribedToEvent(sender, E_POSTUPDATE));
+    REQUIRE(sendEvents() == 1);
+
+    receiver->UnsubscribeFromEvents(sender);
+    REQUIRE_FALSE(receiver->HasEventHandlers());
+    REQUIRE(sendEvents() == 0);
+
+    // Subscriptions to destroyed senders are forgotten
+    subscribe();
+    receiver->UnsubscribeFromTypedEvent<UpdateEventArgs>();
+    sender = nullptr;
+    REQUIRE_FALSE(receiver->HasEventHandlers());
+}
+
+TEST_CASE("Events posted from worker threads are sent from main thread")
+{
+    static const unsigned numThreads = 4;
+    static const unsigned numEventsPerThread = 1000;
+
+    auto context = MakeShared<Context>();
+    auto sender = MakeShared<EventReceiver>(context);
+    auto coalescedSender = MakeShared<EventReceiver>(context);
+    auto receiver = MakeShared<EventReceiver>(context);
+
+    ea::vector<float> receivedTimeSteps;
+    receiver->SubscribeToTypedEvent<UpdateEventArgs>(sender, [&](const UpdateEventArgs& args)
+    {
+        REQUIRE(Thread::IsMainThread());
+        receivedTimeSteps.push_back(args.timeStep_);
+    });
+    receiver->SubscribeToEvent(coalescedSender, E_POSTUPDATE, [&](StringHash, VariantMap& eventData)
+    {
+        receiver->legacyTimeStep_ = eventData[PostUpdate::P_TIMESTEP].GetFloat();
+        ++receiver->numLegacyEvents_;
+    });
+
+    ea::vector<std::thread> threads;
+    for (unsigned threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+    {
+        threads.emplace_back([&, threadIndex]()
+        {
+            for (unsigned i = 0; i < numEventsPerThread; ++i)
+            {
+                UpdateEventArgs args;
+                args.timeStep_ = static_cast<float>(threadIndex * numEventsPerThread + i);
+                sender->PostTypedEvent(args);
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    for (unsigned i = 0; i < 10; ++i)
+        coalescedSender->PostEvent(E_POSTUPDATE, {{ PostUpdate::P_TIMESTEP, static_cast<float>(i) }}, true);
+
+    REQUIRE(receivedTimeSteps.empty());
+    context->DispatchPostedEvents();
+
+    // Events from each thread are received in posting order
+    REQUIRE(receivedTimeSteps.size() == numThreads * numEventsPerThread);
+    for (unsigned threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+    {
+        float lastTimeStep = -1.0f;
+        for (float timeStep : receivedTimeSteps)
+        {
+            if (static_cast<unsigned>(timeStep) / numEventsPerThread != threadIndex)
+                continue;
+            REQUIRE(timeStep > lastTimeStep);
+            lastTimeStep = timeStep;
+        }
+    }
+
+    REQUIRE(receiver->numLegacyEvents_ == 1);
+    REQUIRE(receiver->legacyTimeStep_ == 9.0f);
+    REQUIRE(context->GetPostedEvents().GetNumCoalescedEvents() == 9);
+}
+
+TEST_CASE("Typed events compared to VariantMap events", "[.benchmark]")
+{
+    static const unsigned numEvents = 10000;
+    auto context = MakeShared<Context>();
+    auto sender = MakeShared<EventReceiver>(context);
+
+    for (unsigned numReceivers : {1u, 10u, 100u})
+    {
+        ea::vector<SharedPtr<EventReceiver>> receivers;
+        float result{};
+        for (unsigned i = 0; i < numReceivers; ++i)
+        {
+            auto receiver = MakeShared<EventReceiver>(context);
+            receiver->SubscribeToTypedEvent<PostUpdateEventArgs>(
+                [&result](const PostUpdateEventArgs& args) { result += args.timeStep_; });
+            receiver->SubscribeToEvent(E_RENDERUPDATE,
+                [&result](StringHash, VariantMap& eventData) { result += eventData[RenderUpdate::P_TIMESTEP].GetFloat(); });
+            receivers.push_back(receiver);
+        }
+
+        BENCHMARK(std::string(Format("Typed events, {} receivers", numReceivers).c_str()))
+        {
+            PostUpdateEventArgs args;
+            for (unsigned i = 0; i < numEvents; ++i)
+            {
+                args.timeStep_ = static_cast<float>(i);
+                sender->SendTypedEvent(args);
+            }
+            return result;
+        };
+
+        BENCHMARK(std::string(Format("VariantMap events, {} receivers", numReceivers).c_str()))
+        {
+            for (unsigned i = 0; i < numEvents; ++i)
+            {
+                VariantMap& eventData = sender->GetEventDataMap();
+                eventData[RenderUpdate::P_TIMESTEP] = static_cast<float>(i);
+                sender->SendEvent(E_RENDERUPDATE, eventData);
+            }
+            return result;
+        };
+    }
+}
@@ -0,0 +1,61 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Container/FrameAllocator.h>
+
+TEST_CASE("FrameAllocator reuses pages after the end of the frame")
+{
+    const auto allocateFrame = []
+    {
+        FrameVector<unsigned> values;
+        for (unsigned i = 0; i < 10000; ++i)
+            values.push_back(i);
+
+        for (unsigned i = 0; i < values.size(); ++i)
+            REQUIRE(values[i] == i);
+
+        for (size_t alignment : { 1, 4, 16, 64 })
+        {
+            void* ptr = FrameAllocator::Allocate(3, alignment);
+            REQUIRE(reinterpret_cast<uintptr_t>(ptr) % alignment == 0);
+        }
+
+        FrameVector<unsigned> largeValues(FrameAllocator::PageSize, 1u);
+        REQUIRE(largeValues.back() == 1u);
+    };
+
+    allocateFrame();
+    FrameAllocator::EndFrame();
+    const FrameAllocatorStats firstFrameStats = FrameAllocator::GetFrameStats();
+    REQUIRE(firstFrameStats.numAllocations_ > 0);
+
+    // Pages allocated during the first frame are reused
+    allocateFrame();
+    FrameAllocator::EndFrame();
+    const FrameAllocatorStats secondFrameStats = FrameAllocator::GetFrameStats();
+    REQUIRE(secondFrameStats.numAllocations_ == firstFrameStats.numAllocations_);
+    REQUIRE(secondFrameStats.numBytes_ == firstFrameStats.numBytes_);
+    REQUIRE(secondFrameStats.numHeapAllocations_ == 0);
+}
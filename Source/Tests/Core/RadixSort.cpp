@@ -0,0 +1,156 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Core/RadixSort.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/RenderPipeline/PipelineBatchSortKey.h>
+
+#include <EASTL/sort.h>
+
+namespace
+{
+
+/// Create items with keys laid out like pipeline batch keys: few distinct values in each field.
+ea::vector<RadixSortItem> CreateItems(unsigned numItems)
+{
+    SetRandomSeed(1);
+    ea::vector<RadixSortItem> items(numItems);
+    for (unsigned i = 0; i < numItems; ++i)
+    {
+        const auto renderOrder = static_cast<unsigned long long>(Random(4));
+        const auto shader = static_cast<unsigned long long>(Random(200));
+        const auto material = static_cast<unsigned long long>(Random(2000));
+        const auto light = static_cast<unsigned long long>(Random(16));
+        items[i] = { (renderOrder << 56) | (shader << 40) | (material << 16) | light, i };
+    }
+    return items;
+}
+
+bool IsStableSorted(const ea::vector<RadixSortItem>& items)
+{
+    for (unsigned i = 1; i < items.size(); ++i)
+    {
+        const RadixSortItem& prev = items[i - 1];
+        const RadixSortItem& next = items[i];
+        if (prev.key_ > next.key_ || (prev.key_ == next.key_ && prev.index_ > next.index_))
+            return false;
+    }
+    return true;
+}
+
+}
+
+TEST_CASE("Radix sort is stable and matches comparison sort")
+{
+    auto context = MakeShared<Context>();
+    auto workQueue = MakeShared<WorkQueue>(context);
+    workQueue->CreateThreads(3);
+
+    for (unsigned numItems : {0u, 1u, 37u, 1000u, 100000u})
+    {
+        ea::vector<RadixSortItem> items = CreateItems(numItems);
+        ea::vector<RadixSortItem> buffer(numItems);
+
+        ea::vector<RadixSortItem> expectedItems = items;
+        ea::stable_sort(expectedItems.begin(), expectedItems.end(),
+            [](const RadixSortItem& lhs, const RadixSortItem& rhs) { return lhs.key_ < rhs.key_; });
+
+        ea::vector<RadixSortItem> sortedItems = items;
+        RadixSort(sortedItems, buffer);
+        REQUIRE(IsStableSorted(sortedItems));
+        REQUIRE(ea::equal(sortedItems.begin(), sortedItems.end(), expectedItems.begin(),
+            [](const RadixSortItem& lhs, const RadixSortItem& rhs) { return lhs.index_ == rhs.index_; }));
+
+        sortedItems = items;
+        RadixSort(sortedItems, buffer, workQueue);
+        REQUIRE(IsStableSorted(sortedItems));
+        REQUIRE(ea::equal(sortedItems.begin(), sortedItems.end(), expectedItems.begin(),
+            [](const RadixSortItem& lhs, const RadixSortItem& rhs) { return lhs.index_ == rhs.index_; }));
+    }
+}
+
+TEST_CASE("Back-to-front batch sort key matches comparison operator")
+{
+    const float distances[] = { -100.0f, -1.0f, -0.0f, 0.0f, 0.5f, 1.0f, 1.0f + M_EPSILON, 1000.0f, M_INFINITY };
+
+    for (unsigned char lhsOrder : {0, 1, 128})
+    {
+        for (unsigned char rhsOrder : {0, 1, 128})
+        {
+            for (float lhsDistance : distances)
+            {
+                for (float rhsDistance : distances)
+                {
+                    PipelineBatchBackToFront lhs;
+                    lhs.renderOrder_ = lhsOrder;
+                    lhs.distance_ = lhsDistance;
+
+                    PipelineBatchBackToFront rhs;
+                    rhs.renderOrder_ = rhsOrder;
+                    rhs.distance_ = rhsDistance;
+
+                    REQUIRE((lhs < rhs) == (lhs.GetSortKey() < rhs.GetSortKey()));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Radix sort compared to comparison sort", "[.benchmark]")
+{
+    auto context = MakeShared<Context>();
+    auto workQueue = MakeShared<WorkQueue>(context);
+    workQueue->CreateThreads(3);
+
+    for (unsigned numItems : {1000u, 10000u, 50000u, 200000u})
+    {
+        const ea::vector<RadixSortItem> items = CreateItems(numItems);
+        ea::vector<RadixSortItem> sortedItems;
+        ea::vector<RadixSortItem> buffer(numItems);
+
+        BENCHMARK(std::string(Format("ea::sort, {} items", numItems).c_str()))
+        {
+            sortedItems = items;
+            ea::sort(sortedItems.begin(), sortedItems.end(),
+                [](const RadixSortItem& lhs, const RadixSortItem& rhs) { return lhs.key_ < rhs.key_; });
+            return sortedItems[0].index_;
+        };
+
+        BENCHMARK(std::string(Format("RadixSort, {} items, 1 thread", numItems).c_str()))
+        {
+            sortedItems = items;
+            RadixSort(sortedItems, buffer);
+            return sortedItems[0].index_;
+        };
+
+        BENCHMARK(std::string(Format("RadixSort, {} items, 4 threads", numItems).c_str()))
+        {
+            sortedItems = items;
+            RadixSort(sortedItems, buffer, workQueue);
+            return sortedItems[0].index_;
+        };
+    }
+}
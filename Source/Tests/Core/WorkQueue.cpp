@@ -0,0 +1,497 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/JobSystem.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/WorkQueue.h>
+
+#include <EASTL/list.h>
+
+#include <functional>
+#include <thread>
+
+namespace
+{
+
+/// Reference queue with single mutex-protected list, used to compare against WorkQueue.
+class LockedListQueue
+{
+public:
+    explicit LockedListQueue(unsigned numThreads)
+    {
+        for (unsigned i = 0; i < numThreads; ++i)
+            threads_.emplace_back([this] { ProcessItems(); });
+    }
+
+    ~LockedListQueue()
+    {
+        shutDown_ = true;
+        for (std::thread& thread : threads_)
+            thread.join();
+    }
+
+    void AddWorkItem(std::function<void()> workFunction)
+    {
+        ++numPending_;
+        MutexLock<Mutex> lock(mutex_);
+        queue_.push_back(std::move(workFunction));
+    }
+
+    void Complete()
+    {
+        while (numPending_ != 0)
+        {
+            if (!TryProcessItem())
+                std::this_thread::yield();
+        }
+    }
+
+private:
+    bool TryProcessItem()
+    {
+        std::function<void()> workFunction;
+        {
+            MutexLock<Mutex> lock(mutex_);
+            if (queue_.empty())
+                return false;
+            workFunction = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        workFunction();
+        --numPending_;
+        return true;
+    }
+
+    void ProcessItems()
+    {
+        while (!shutDown_)
+        {
+            if (!TryProcessItem())
+                std::this_thread::yield();
+        }
+    }
+
+    ea::vector<std::thread> threads_;
+    ea::list<std::function<void()>> queue_;
+    Mutex mutex_;
+    std::atomic<unsigned> numPending_{};
+    std::atomic<bool> shutDown_{};
+};
+
+/// Small amount of work per item.
+unsigned SimulateWork(unsigned seed)
+{
+    for (unsigned i = 0; i < 64; ++i)
+        seed = seed * 1664525u + 1013904223u;
+    return seed;
+}
+
+}
+
+TEST_CASE("WorkQueue executes work items after their dependencies")
+{
+    auto context = MakeShared<Context>();
+    auto workQueue = MakeShared<WorkQueue>(context);
+    workQueue->CreateThreads(3);
+
+    for (unsigned iteration = 0; iteration < 100; ++iteration)
+    {
+        std::atomic<unsigned> numFirstStage{};
+        std::atomic<bool> orderViolated{};
+
+        ea::vector<SharedPtr<WorkItem>> firstStage;
+        for (unsigned i = 0; i < 16; ++i)
+            firstStage.push_back(workQueue->AddWorkItem([&](unsigned) { ++numFirstStage; }, M_MAX_UNSIGNED));
+
+        std::atomic<bool> secondStageDone{};
+        const auto secondStage = workQueue->AddWorkItem([&](unsigned)
+        {
+            if (numFirstStage != 16)
+                orderViolated = true;
+            secondStageDone = true;
+        }, M_MAX_UNSIGNED, firstStage);
+
+        workQueue->ContinueWith(secondStage, [&](unsigned)
+        {
+            if (!secondStageDone)
+                orderViolated = true;
+        });
+
+        workQueue->Complete(M_MAX_UNSIGNED);
+        REQUIRE(workQueue->IsCompleted(M_MAX_UNSIGNED));
+        REQUIRE_FALSE(orderViolated);
+    }
+}
+
+TEST_CASE("ForEachParallel is nested and joined via work items")
+{
+    auto context = MakeShared<Context>();
+    auto workQueue = MakeShared<WorkQueue>(context);
+    workQueue->CreateThreads(3);
+
+    static const unsigned outerSize = 64;
+    static const unsigned innerSize = 1000;
+    ea::vector<std::atomic<unsigned>> sums(outerSize);
+
+    // Nested loops wait for inner loops inside of work items
+    ForEachParallel(workQueue, 1, outerSize, [&](unsigned beginIndex, unsigned endIndex)
+    {
+        for (unsigned i = beginIndex; i < endIndex; ++i)
+        {
+            ForEachParallel(workQueue, 16, innerSize, [&, i](unsigned innerBegin, unsigned innerEnd)
+            {
+                for (unsigned j = innerBegin; j < innerEnd; ++j)
+                    sums[i] += j;
+            });
+        }
+    });
+
+    for (unsigned i = 0; i < outerSize; ++i)
+        REQUIRE(sums[i] == innerSize * (innerSize - 1) / 2);
+
+    // Second loop starts only when first one is finished
+    ea::vector<unsigned> values(innerSize);
+    std::atomic<bool> orderViolated{};
+    const auto firstLoop = ForEachParallelAsync(workQueue, 1, innerSize, [&](unsigned beginIndex, unsigned endIndex)
+    {
+        for (unsigned i = beginIndex; i < endIndex; ++i)
+            values[i] = i;
+    });
+    const auto secondLoop = ForEachParallelAsync(workQueue, 1, innerSize, [&](unsigned beginIndex, unsigned endIndex)
+    {
+        for (unsigned i = beginIndex; i < endIndex; ++i)
+        {
+            if (values[i] != i)
+                orderViolated = true;
+        }
+    }, {&firstLoop, 1});
+
+    workQueue->CompleteItem(secondLoop);
+    REQUIRE(firstLoop->completed_);
+    REQUIRE_FALSE(orderViolated);
+}
+
+TEST_CASE("ForEachParallel does not execute background work while waiting")
+{
+    auto context = MakeShared<Context>();
+    auto workQueue = MakeShared<WorkQueue>(context);
+    workQueue->CreateThreads(2);
+
+    static thread_local bool isWaiting = false;
+    std::atomic<bool> backgroundWorkNested{};
+    std::atomic<unsigned> numBackgroundExecuted{};
+    std::atomic<unsigned> sum{};
+    std::atomic<bool> done{};
+
+    // Loop is executed by worker threads only, so one of them waits for the chunk taken by another one
+    // while background work is queued. Main thread only keeps worker threads running.
+    static const unsigned numIterations = 20;
+    std::thread thread([&]
+    {
+        for (unsigned iteration = 0; iteration < numIterations; ++iteration)
+        {
+            const auto item = workQueue->PostWorkItem([&](unsigned)
+            {
+                workQueue->PostWorkItem([&](unsigned)
+                {
+                    if (isWaiting)
+                        backgroundWorkNested = true;
+                    ++numBackgroundExecuted;
+                }, 0);
+
+                isWaiting = true;
+                ForEachParallel(workQueue, 1, 8u, [&](unsigned beginIndex, unsigned endIndex)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    sum += endIndex - beginIndex;
+                });
+                isWaiting = false;
+            });
+            workQueue->CompleteItem(item);
+        }
+        done = true;
+    });
+
+    workQueue->Resume();
+    while (!done)
+        std::this_thread::yield();
+    thread.join();
+
+    workQueue->Complete(0);
+    REQUIRE(sum == numIterations * 8);
+    REQUIRE(numBackgroundExecuted == numIterations);
+    REQUIRE_FALSE(backgroundWorkNested);
+}
+
+TEST_CASE("WorkQueue accepts work from threads it does not own")
+{
+    auto context = MakeShared<Context>();
+    auto workQueue = MakeShared<WorkQueue>(context);
+    workQueue->CreateThreads(2);
+
+    static const unsigned numIterations = 50;
+    static const unsigned size = 100;
+    std::atomic<unsigned> sum{};
+    std::atomic<unsigned> numPostedExecuted{};
+    std::atomic<unsigned> foreignThreadIndex{};
+    std::atomic<bool> done{};
+
+    std::thread thread([&]
+    {
+        foreignThreadIndex = WorkQueue::GetThreadIndex();
+        for (unsigned iteration = 0; iteration < numIterations; ++iteration)
+        {
+            ForEachParallel(workQueue, 1, size, [&](unsigned beginIndex, unsigned endIndex) { sum += endIndex - beginIndex; });
+
+            const auto item = workQueue->PostWorkItem([&](unsigned) { ++numPostedExecuted; });
+            workQueue->CompleteItem(item);
+        }
+        done = true;
+    });
+
+    // Worker threads are resumed by the main thread, as they are every frame
+    while (!done)
+        workQueue->Complete(M_MAX_UNSIGNED);
+    thread.join();
+
+    REQUIRE(foreignThreadIndex == M_MAX_UNSIGNED);
+    REQUIRE(sum == numIterations * size);
+    REQUIRE(numPostedExecuted == numIterations);
+    REQUIRE(workQueue->IsCompleted(M_MAX_UNSIGNED));
+}
+
+TEST_CASE("WorkQueue reuses posted work items")
+{
+    auto context = MakeShared<Context>();
+    auto workQueue = MakeShared<WorkQueue>(context);
+
+    unsigned numExecuted = 0;
+
+    // Item released before execution is reused right away
+    WorkItem* firstItem = workQueue->PostWorkItem([&](unsigned) { ++numExecuted; });
+    workQueue->Complete(M_MAX_UNSIGNED);
+    REQUIRE(numExecuted == 1);
+    REQUIRE(workQueue->PostWorkItem([&](unsigned) { ++numExecuted; }) == firstItem);
+    workQueue->Complete(M_MAX_UNSIGNED);
+    REQUIRE(numExecuted == 2);
+
+    // Item referenced during execution is reused after the next frame begins
+    WorkItem* secondItem{};
+    {
+        const auto item = workQueue->PostWorkItem([&](unsigned) { ++numExecuted; });
+        workQueue->CompleteItem(item);
+        secondItem = item;
+    }
+    REQUIRE(numExecuted == 3);
+    workQueue->SendEvent(E_BEGINFRAME);
+    REQUIRE(workQueue->PostWorkItem([&](unsigned) { ++numExecuted; }) == secondItem);
+    workQueue->Complete(M_MAX_UNSIGNED);
+    REQUIRE(numExecuted == 4);
+}
+
+TEST_CASE("WorkQueue does not remove work items with dependents")
+{
+    auto context = MakeShared<Context>();
+    auto workQueue = MakeShared<WorkQueue>(context);
+
+    unsigned numExecuted = 0;
+    const auto item = workQueue->AddWorkItem([&](unsigned) { ++numExecuted; }, 0);
+    const auto dependentItem = workQueue->AddWorkItem([&](unsigned) { ++numExecuted; }, 0, {&item, 1});
+    const auto removedItem = workQueue->AddWorkItem([&](unsigned) { ++numExecuted; }, 0);
+
+    REQUIRE_FALSE(workQueue->RemoveWorkItem(item));
+    REQUIRE(workQueue->RemoveWorkItem(removedItem));
+
+    workQueue->Complete(0);
+    REQUIRE(numExecuted == 2);
+    REQUIRE(workQueue->IsCompleted(0));
+}
+
+TEST_CASE("PartitionedRange splits range into chunks of similar cost")
+{
+    static const unsigned size = 1000;
+    static const unsigned numWorkers = 4;
+
+    // First elements are ten times more expensive
+    ea::vector<float> costPrefixSum(size + 1);
+    for (unsigned i = 0; i < size; ++i)
+        costPrefixSum[i + 1] = costPrefixSum[i] + (i < 100 ? 10.0f : 1.0f);
+    const auto isSplitAllowed = [](unsigned index) { return index % 10 == 0; };
+
+    PartitionedRange range;
+    range.Partition(costPrefixSum, numWorkers, 4, 16, isSplitAllowed);
+    REQUIRE(range.GetNumWorkers() == numWorkers);
+    REQUIRE(range.GetNumChunks() == 16);
+
+    // Worker takes its own chunks first, then steals chunks of other workers
+    ea::vector<ea::pair<unsigned, unsigned>> chunks;
+    unsigned beginIndex{};
+    unsigned endIndex{};
+    while (range.Take(0, beginIndex, endIndex))
+        chunks.emplace_back(beginIndex, endIndex);
+    REQUIRE(chunks.size() == 16);
+    REQUIRE(range.GetNumStolenChunks() == 12);
+    REQUIRE(chunks[0].first == 0);
+    REQUIRE(chunks[1].first == chunks[0].second);
+    REQUIRE(chunks[5].second == chunks[4].first);
+    REQUIRE(chunks[12].second == size);
+
+    const float averageCost = costPrefixSum[size] / 16;
+    for (const auto& [chunkBegin, chunkEnd] : chunks)
+    {
+        REQUIRE(isSplitAllowed(chunkBegin));
+        REQUIRE(costPrefixSum[chunkEnd] - costPrefixSum[chunkBegin] <= averageCost + 10.0f * 10);
+    }
+
+    // Each element is processed exactly once in parallel
+    auto context = MakeShared<Context>();
+    auto workQueue = MakeShared<WorkQueue>(context);
+    workQueue->CreateThreads(3);
+
+    ea::vector<std::atomic<unsigned>> counters(size);
+    range.Partition(costPrefixSum, numWorkers, 4, 16, isSplitAllowed);
+    ForEachParallel(workQueue, range, [&](unsigned chunkBegin, unsigned chunkEnd)
+    {
+        for (unsigned i = chunkBegin; i < chunkEnd; ++i)
+            ++counters[i];
+    });
+
+    for (unsigned i = 0; i < size; ++i)
+        REQUIRE(counters[i] == 1);
+}
+
+TEST_CASE("JobSystem jobs wait for nested jobs without blocking threads")
+{
+    auto context = MakeShared<Context>();
+    auto workQueue = MakeShared<WorkQueue>(context);
+    context->RegisterSubsystem(workQueue);
+    workQueue->CreateThreads(3);
+    auto jobSystem = MakeShared<JobSystem>(context);
+
+    static const unsigned numOuterJobs = 16;
+    static const unsigned numInnerJobs = 64;
+    std::atomic<unsigned> numInnerFinished{};
+    std::atomic<bool> orderViolated{};
+
+    // Outer jobs wait for inner jobs, more outer jobs than threads are in flight
+    JobCounter outerCounter;
+    for (unsigned i = 0; i < numOuterJobs; ++i)
+    {
+        jobSystem->ScheduleJob([&](unsigned)
+        {
+            JobCounter innerCounter;
+            std::atomic<unsigned> numFinished{};
+            for (unsigned j = 0; j < numInnerJobs; ++j)
+            {
+                const auto priority = j % 2 ? JobPriority::Low : JobPriority::High;
+                jobSystem->ScheduleJob([&](unsigned) { ++numFinished; }, priority, &innerCounter, "Inner");
+            }
+            jobSystem->WaitForCounter(innerCounter);
+            if (numFinished != numInnerJobs)
+                orderViolated = true;
+            numInnerFinished += numFinished;
+        }, JobPriority::Normal, &outerCounter, "Outer");
+    }
+
+    jobSystem->WaitForCounter(outerCounter);
+    REQUIRE(outerCounter.GetValue() == 0);
+    REQUIRE(numInnerFinished == numOuterJobs * numInnerJobs);
+    REQUIRE_FALSE(orderViolated);
+    REQUIRE(jobSystem->GetNumScheduledJobs() == numOuterJobs * (numInnerJobs + 1));
+
+    workQueue->Complete(0);
+}
+
+TEST_CASE("JobSystem limits depth of jobs executed while waiting")
+{
+    auto context = MakeShared<Context>();
+    auto workQueue = MakeShared<WorkQueue>(context);
+    context->RegisterSubsystem(workQueue);
+    workQueue->CreateThreads(3);
+    auto jobSystem = MakeShared<JobSystem>(context);
+
+    static thread_local unsigned jobDepth = 0;
+    std::atomic<unsigned> maxJobDepth{};
+    std::atomic<unsigned> numFinished{};
+
+    // Each job schedules next job of the chain and waits for it
+    static const unsigned chainLength = 24;
+    std::function<void(unsigned)> runChain = [&](unsigned index)
+    {
+        ++jobDepth;
+        unsigned currentMax = maxJobDepth;
+        while (jobDepth > currentMax && !maxJobDepth.compare_exchange_weak(currentMax, jobDepth))
+        {
+        }
+
+        if (index + 1 < chainLength)
+        {
+            JobCounter counter;
+            jobSystem->ScheduleJob([&, index](unsigned) { runChain(index + 1); }, JobPriority::High, &counter);
+            jobSystem->WaitForCounter(counter);
+        }
+
+        ++numFinished;
+        --jobDepth;
+    };
+
+    jobSystem->RunJob([&](unsigned) { runChain(0); }, JobPriority::High);
+    REQUIRE(numFinished == chainLength);
+    REQUIRE(maxJobDepth <= JobSystem::MaxWaitDepth + 1);
+
+    workQueue->Complete(0);
+}
+
+TEST_CASE("WorkQueue compared to locked list queue", "[.benchmark]")
+{
+    static const unsigned numItems = 10000;
+    auto context = MakeShared<Context>();
+
+    for (unsigned numThreads : {1u, 2u, 4u, 8u, 16u, 32u, 64u})
+    {
+        auto workQueue = MakeShared<WorkQueue>(context);
+        workQueue->CreateThreads(numThreads - 1);
+        LockedListQueue lockedListQueue(numThreads - 1);
+
+        BENCHMARK(std::string(Format("WorkQueue, {} threads", numThreads).c_str()))
+        {
+            std::atomic<unsigned> result{};
+            for (unsigned i = 0; i < numItems; ++i)
+                workQueue->AddWorkItem([i, &result](unsigned) { result += SimulateWork(i); }, M_MAX_UNSIGNED);
+            workQueue->Complete(M_MAX_UNSIGNED);
+            return result.load();
+        };
+
+        BENCHMARK(std::string(Format("Locked list queue, {} threads", numThreads).c_str()))
+        {
+            std::atomic<unsigned> result{};
+            for (unsigned i = 0; i < numItems; ++i)
+                lockedListQueue.AddWorkItem([i, &result]() { result += SimulateWork(i); });
+            lockedListQueue.Complete();
+            return result.load();
+        };
+    }
+}
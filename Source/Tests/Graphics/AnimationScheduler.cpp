@@ -0,0 +1,256 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+#include "../ModelUtils.h"
+
+#include <Urho3D/Graphics/AnimatedModel.h>
+#include <Urho3D/Graphics/AnimationController.h>
+#include <Urho3D/Graphics/AnimationScheduler.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+namespace
+{
+
+/// Scene with animated models updated at reduced rate as seen from the camera.
+struct AnimatedScene
+{
+    static constexpr float TimeStep = 0.01f;
+
+    AnimatedScene(Context* context, unsigned numModels)
+        : context_(context)
+        , scene_(MakeShared<Scene>(context))
+    {
+        auto cache = context->GetSubsystem<ResourceCache>();
+        if (!cache->GetExistingResource<Model>("@/AnimationScheduler/SkinnedQuad.mdl"))
+        {
+            auto model = Tests::CreateSkinnedQuad_Model(context)->ExportModel("@/AnimationScheduler/SkinnedQuad.mdl");
+            cache->AddManualResource(model);
+
+            auto animation = Tests::CreateLoopedRotationAnimation(context,
+                "@/AnimationScheduler/Rotate.ani", "Quad 1", Vector3::UP, 2.0f);
+            cache->AddManualResource(animation);
+        }
+
+        // No Octree: animated models are updated manually as if they were in view
+        Node* cameraNode = scene_->CreateChild("Camera");
+        cameraNode->SetPosition({ 0.0f, 1.0f, -20.0f });
+        camera_ = cameraNode->CreateComponent<Camera>();
+
+        for (unsigned i = 0; i < numModels; ++i)
+        {
+            Node* node = scene_->CreateChild("Model");
+            auto animatedModel = node->CreateComponent<AnimatedModel>();
+            animatedModel->SetModel(cache->GetResource<Model>("@/AnimationScheduler/SkinnedQuad.mdl"));
+            animatedModel->SetUpdateInvisible(true);
+            // Animation is evaluated every 3-6 frames at this distance
+            animatedModel->SetAnimationLodBias(0.2f);
+
+            auto animationController = node->CreateComponent<AnimationController>();
+            animationController->Play("@/AnimationScheduler/Rotate.ani", 0, true);
+            models_.push_back(animatedModel);
+        }
+
+        Tests::RunFrame(context_, TimeStep);
+    }
+
+    /// Update animated models for one frame and return scheduler statistics of this frame.
+    AnimationSchedulerStats UpdateFrame()
+    {
+        FrameInfo frame;
+        frame.frameNumber_ = frameNumber_++;
+        frame.timeStep_ = TimeStep;
+        frame.camera_ = camera_;
+
+        for (AnimatedModel* animatedModel : models_)
+        {
+            animatedModel->Update(frame);
+            updateTypes_.push_back(animatedModel->GetUpdateGeometryType());
+            animatedModel->UpdateGeometry(frame);
+        }
+
+        Tests::RunFrame(context_, TimeStep);
+        return context_->GetSubsystem<AnimationScheduler>()->GetStats();
+    }
+
+    /// Return skinning matrix of the animated bone.
+    Matrix3x4 GetSkinMatrix(unsigned index) const { return models_[index]->GetBatches()[0].worldTransform_[1]; }
+
+    Context* context_{};
+    SharedPtr<Scene> scene_;
+    Camera* camera_{};
+    ea::vector<AnimatedModel*> models_;
+    ea::vector<UpdateGeometryType> updateTypes_;
+    unsigned frameNumber_{ 10 };
+};
+
+}
+
+TEST_CASE("Animation scheduler limits reduced-rate evaluations per frame")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto scheduler = context->GetSubsystem<AnimationScheduler>();
+    scheduler->SetMaxEvaluationsPerFrame(2);
+    scheduler->SetMaxDeferredFrames(M_MAX_UNSIGNED);
+
+    AnimatedScene scene(context, 8);
+
+    // First evaluation is never limited
+    const AnimationSchedulerStats firstFrameStats = scene.UpdateFrame();
+    CHECK(firstFrameStats.numEvaluated_ == 8);
+
+    unsigned numEvaluated = 0;
+    unsigned numSkipped = 0;
+    for (unsigned frame = 0; frame < 40; ++frame)
+    {
+        const AnimationSchedulerStats stats = scene.UpdateFrame();
+        CHECK(stats.numEvaluated_ <= 2);
+        CHECK(stats.numEvaluated_ + stats.numSkipped_ == 8);
+        CHECK(stats.numInterpolated_ == 0);
+        numEvaluated += stats.numEvaluated_;
+        numSkipped += stats.numSkipped_;
+    }
+    CHECK(numEvaluated > 8);
+    CHECK(numSkipped > 0);
+}
+
+TEST_CASE("Animation scheduler does not defer evaluation for too long")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto scheduler = context->GetSubsystem<AnimationScheduler>();
+    scheduler->SetMaxEvaluationsPerFrame(0);
+
+    const auto countEvaluations = [&](unsigned maxDeferredFrames)
+    {
+        scheduler->SetMaxDeferredFrames(maxDeferredFrames);
+        AnimatedScene scene(context, 4);
+        scene.UpdateFrame();
+
+        unsigned numEvaluated = 0;
+        for (unsigned frame = 0; frame < 40; ++frame)
+            numEvaluated += scene.UpdateFrame().numEvaluated_;
+        return numEvaluated;
+    };
+
+    // Models are evaluated only when deferred for max number of frames
+    CHECK(countEvaluations(M_MAX_UNSIGNED) == 0);
+
+    const unsigned numEvaluated = countEvaluations(3);
+    CHECK(numEvaluated >= 4 * 2);
+    CHECK(numEvaluated <= 4 * 40 / 4);
+}
+
+TEST_CASE("Animation scheduler interpolates skinning only if enabled")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto scheduler = context->GetSubsystem<AnimationScheduler>();
+    REQUIRE_FALSE(scheduler->GetSkinInterpolation());
+
+    // Skipped frames do not update skinning
+    {
+        AnimatedScene scene(context, 1);
+        scene.UpdateFrame();
+
+        unsigned numSkipped = 0;
+        for (unsigned frame = 0; frame < 40; ++frame)
+        {
+            const Matrix3x4 previousSkinMatrix = scene.GetSkinMatrix(0);
+            scene.updateTypes_.clear();
+            const AnimationSchedulerStats stats = scene.UpdateFrame();
+            CHECK(stats.numInterpolated_ == 0);
+            if (stats.numSkipped_ != 0)
+            {
+                ++numSkipped;
+                CHECK(scene.updateTypes_[0] == UPDATE_NONE);
+                CHECK(scene.GetSkinMatrix(0).Equals(previousSkinMatrix));
+            }
+        }
+        CHECK(numSkipped > 0);
+    }
+
+    // Skipped frames interpolate skinning between evaluated poses
+    scheduler->SetSkinInterpolation(true);
+    {
+        AnimatedScene scene(context, 1);
+        scene.UpdateFrame();
+
+        // There is nothing to interpolate until the second evaluation
+        bool hasPreviousPose = false;
+        unsigned numInterpolated = 0;
+        for (unsigned frame = 0; frame < 40; ++frame)
+        {
+            const Matrix3x4 previousSkinMatrix = scene.GetSkinMatrix(0);
+            const AnimationSchedulerStats stats = scene.UpdateFrame();
+            CHECK(stats.numSkipped_ == 0);
+            if (stats.numEvaluated_ != 0)
+                hasPreviousPose = true;
+            else if (hasPreviousPose)
+            {
+                CHECK(stats.numInterpolated_ == 1);
+                CHECK_FALSE(scene.GetSkinMatrix(0).Equals(previousSkinMatrix));
+                ++numInterpolated;
+            }
+        }
+        CHECK(numInterpolated > 0);
+    }
+}
+
+TEST_CASE("Animation scheduler shares pose between identical instances")
+{
+    auto context = Tests::CreateCompleteTestContext();
+
+    AnimatedScene scene(context, 5);
+    for (AnimatedModel* animatedModel : scene.models_)
+    {
+        animatedModel->SetAnimationLodBias(0.0f);
+        animatedModel->SetAnimationInstancing(true);
+    }
+
+    const ea::string animationName = "@/AnimationScheduler/Rotate.ani";
+    const auto getController = [&](unsigned index) { return scene.models_[index]->GetComponent<AnimationController>(); };
+    for (unsigned i = 0; i < scene.models_.size(); ++i)
+        getController(i)->SetTime(animationName, i == 2 ? 0.75f : 0.25f);
+    getController(3)->SetWeight(animationName, 0.5f);
+    getController(4)->SetStartBone(animationName, "Quad 2");
+    Tests::RunFrame(context, AnimatedScene::TimeStep);
+
+    for (unsigned frame = 0; frame < 10; ++frame)
+    {
+        // Only the second model reuses the pose of the first one
+        const AnimationSchedulerStats stats = scene.UpdateFrame();
+        CHECK(stats.numEvaluated_ == 4);
+        CHECK(stats.numInstanced_ == 1);
+
+        const auto getBoneTransform = [&](unsigned index)
+        {
+            Node* boneNode = scene.models_[index]->GetSkeleton().GetBone("Quad 1")->node_;
+            return boneNode->GetTransform();
+        };
+        CHECK(scene.GetSkinMatrix(1).Equals(scene.GetSkinMatrix(0)));
+        CHECK(getBoneTransform(1).Equals(getBoneTransform(0)));
+        CHECK_FALSE(getBoneTransform(2).Equals(getBoneTransform(0)));
+        CHECK_FALSE(getBoneTransform(3).Equals(getBoneTransform(0)));
+        CHECK_FALSE(getBoneTransform(4).Equals(getBoneTransform(0)));
+    }
+}
@@ -0,0 +1,183 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Graphics/Animation.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+
+namespace
+{
+
+SharedPtr<Animation> CreateTestAnimation(Context* context, float length, unsigned numKeyFrames)
+{
+    auto animation = MakeShared<Animation>(context);
+    animation->SetLength(length);
+
+    // Odd number of tracks to cover both vectorized and remaining tracks
+    for (unsigned trackIndex = 0; trackIndex < 7; ++trackIndex)
+    {
+        AnimationTrack* track = animation->CreateTrack(Format("Bone{}", trackIndex));
+        track->channelMask_ = CHANNEL_POSITION | CHANNEL_ROTATION;
+        if (trackIndex % 2)
+            track->channelMask_ |= CHANNEL_SCALE;
+
+        for (unsigned i = 0; i < numKeyFrames; ++i)
+        {
+            const float time = length * i / (numKeyFrames - 1);
+            const float angle = time * 180.0f + trackIndex * 30.0f;
+            const Vector3 position{ Sin(angle), Cos(angle * 2.0f), trackIndex * 0.5f };
+            const Quaternion rotation{ Sin(angle) * 120.0f, Vector3{ 1.0f, 0.5f, 0.25f * trackIndex }.Normalized() };
+            const Vector3 scale = Vector3::ONE * (1.0f + 0.2f * Cos(angle));
+            track->AddKeyFrame({ time, position, rotation, scale });
+        }
+    }
+
+    // Constant track
+    AnimationTrack* track = animation->CreateTrack("Static");
+    track->channelMask_ = CHANNEL_POSITION | CHANNEL_ROTATION;
+    for (unsigned i = 0; i < numKeyFrames; ++i)
+        track->AddKeyFrame({ length * i / (numKeyFrames - 1), Vector3::UP, Quaternion{ 45.0f, Vector3::UP } });
+
+    return animation;
+}
+
+void CheckSampledTracks(Animation* animation, Animation* referenceAnimation, float time, float positionError, float rotationError)
+{
+    CompressedAnimation* compressedData = animation->GetCompressedData();
+    ea::vector<Transform> transforms(compressedData->GetNumTracks());
+    compressedData->Sample(time, true, transforms);
+
+    for (const auto& [nameHash, referenceTrack] : referenceAnimation->GetTracks())
+    {
+        const unsigned trackIndex = compressedData->GetTrackIndex(nameHash);
+        REQUIRE(trackIndex != M_MAX_UNSIGNED);
+
+        unsigned frameIndex = 0;
+        Transform expected;
+        referenceTrack.Sample(time, referenceAnimation->GetLength(), true, frameIndex, expected);
+
+        const Transform& actual = transforms[trackIndex];
+        CHECK((actual.position_ - expected.position_).Length() <= positionError);
+        CHECK(Acos(Abs(actual.rotation_.DotProduct(expected.rotation_))) * 2.0f <= rotationError);
+        if (referenceTrack.channelMask_ & CHANNEL_SCALE)
+            CHECK((actual.scale_ - expected.scale_).Length() <= positionError);
+    }
+}
+
+}
+
+TEST_CASE("Compressed animation is sampled within error bounds")
+{
+    auto context = Tests::CreateCompleteTestContext();
+
+    const float length = 2.0f;
+    const unsigned numKeyFrames = 241;
+    auto animation = CreateTestAnimation(context, length, numKeyFrames);
+    auto referenceAnimation = CreateTestAnimation(context, length, numKeyFrames);
+
+    AnimationCompressionSettings settings;
+    settings.positionError_ = 0.001f;
+    settings.rotationError_ = 0.1f;
+    settings.scaleError_ = 0.001f;
+    animation->Compress(settings);
+
+    REQUIRE(animation->IsCompressed());
+    REQUIRE(animation->GetTrack(StringHash{ "Bone0" })->keyFrames_.empty());
+    REQUIRE(animation->GetCompressedData()->GetNumKeys() < numKeyFrames * 8 * 2);
+
+    // Slerp of the source keys and nlerp of the kept keys differ slightly between keys
+    const float positionError = settings.positionError_ + M_EPSILON;
+    const float rotationError = settings.rotationError_ * 1.5f;
+    for (unsigned i = 0; i <= 100; ++i)
+        CheckSampledTracks(animation, referenceAnimation, length * i / 100.0f, positionError, rotationError);
+
+    // Save and load compressed animation
+    VectorBuffer buffer;
+    REQUIRE(animation->Save(buffer));
+
+    MemoryBuffer loadBuffer(buffer.GetData(), buffer.GetSize());
+    auto loadedAnimation = MakeShared<Animation>(context);
+    REQUIRE(loadedAnimation->Load(loadBuffer));
+    REQUIRE(loadedAnimation->IsCompressed());
+    REQUIRE(loadedAnimation->GetNumTracks() == animation->GetNumTracks());
+    REQUIRE(loadedAnimation->GetCompressedData()->GetNumKeys() == animation->GetCompressedData()->GetNumKeys());
+
+    for (unsigned i = 0; i <= 100; ++i)
+        CheckSampledTracks(loadedAnimation, referenceAnimation, length * i / 100.0f, positionError, rotationError);
+
+    // Restore keyframes
+    loadedAnimation->Decompress();
+    REQUIRE_FALSE(loadedAnimation->IsCompressed());
+    REQUIRE(loadedAnimation->GetTrack(StringHash{ "Static" })->keyFrames_.size() == 1);
+
+    for (unsigned i = 0; i <= 100; ++i)
+    {
+        const float time = length * i / 100.0f;
+        for (const auto& [nameHash, referenceTrack] : referenceAnimation->GetTracks())
+        {
+            unsigned frameIndex = 0;
+            Transform expected;
+            referenceTrack.Sample(time, length, true, frameIndex, expected);
+
+            Transform actual;
+            loadedAnimation->GetTrack(nameHash)->Sample(time, length, true, frameIndex, actual);
+            CHECK((actual.position_ - expected.position_).Length() <= positionError);
+            CHECK(Acos(Abs(actual.rotation_.DotProduct(expected.rotation_))) * 2.0f <= rotationError);
+        }
+    }
+}
+
+TEST_CASE("Compressed animation skips tracks without keyframes")
+{
+    auto context = Tests::CreateCompleteTestContext();
+
+    const float length = 1.0f;
+    auto animation = CreateTestAnimation(context, length, 11);
+    const unsigned numKeyedTracks = animation->GetNumTracks();
+
+    AnimationTrack* emptyTrack = animation->CreateTrack("Empty");
+    emptyTrack->channelMask_ = CHANNEL_POSITION | CHANNEL_ROTATION;
+
+    animation->Compress({});
+
+    CompressedAnimation* compressedData = animation->GetCompressedData();
+    REQUIRE(compressedData->GetNumTracks() == numKeyedTracks);
+    REQUIRE(compressedData->GetTrackIndex(StringHash{ "Empty" }) == M_MAX_UNSIGNED);
+    REQUIRE(compressedData->GetTrackIndex(StringHash{ "Static" }) != M_MAX_UNSIGNED);
+
+    // Empty track stays empty after round trip
+    VectorBuffer buffer;
+    REQUIRE(animation->Save(buffer));
+
+    MemoryBuffer loadBuffer(buffer.GetData(), buffer.GetSize());
+    auto loadedAnimation = MakeShared<Animation>(context);
+    REQUIRE(loadedAnimation->Load(loadBuffer));
+    REQUIRE(loadedAnimation->GetCompressedData()->GetTrackIndex(StringHash{ "Empty" }) == M_MAX_UNSIGNED);
+
+    loadedAnimation->Decompress();
+    REQUIRE(loadedAnimation->GetTrack(StringHash{ "Empty" })->keyFrames_.empty());
+    REQUIRE_FALSE(loadedAnimation->GetTrack(StringHash{ "Static" })->keyFrames_.empty());
+}
@@ -0,0 +1,276 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/OcclusionBuffer.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Scene/Scene.h>
+
+namespace
+{
+
+/// Create camera at origin looking along Z axis.
+Camera* CreateCamera(Scene* scene)
+{
+    Node* cameraNode = scene->CreateChild("Camera");
+    auto camera = cameraNode->CreateComponent<Camera>();
+    camera->SetFov(90.0f);
+    camera->SetAspectRatio(1.0f);
+    return camera;
+}
+
+/// Create quad facing the camera as non-indexed triangle list.
+ea::vector<Vector3> CreateQuad(const Vector2& center, float halfSize, float z)
+{
+    const Vector3 min{ center.x_ - halfSize, center.y_ - halfSize, z };
+    const Vector3 max{ center.x_ + halfSize, center.y_ + halfSize, z };
+    return {
+        { min.x_, min.y_, z }, { min.x_, max.y_, z }, { max.x_, max.y_, z },
+        { min.x_, min.y_, z }, { max.x_, max.y_, z }, { max.x_, min.y_, z } };
+}
+
+/// Create random triangles in front of the camera.
+ea::vector<Vector3> CreateRandomTriangles(unsigned numTriangles, float size)
+{
+    SetRandomSeed(1);
+    ea::vector<Vector3> vertices;
+    for (unsigned i = 0; i < numTriangles; ++i)
+    {
+        const Vector3 center{ Random(-20.0f, 20.0f), Random(-20.0f, 20.0f), Random(5.0f, 40.0f) };
+        for (unsigned j = 0; j < 3; ++j)
+            vertices.push_back(center + Vector3{ Random(-size, size), Random(-size, size), Random(-1.0f, 1.0f) });
+    }
+    return vertices;
+}
+
+void DrawVertices(OcclusionBuffer* buffer, const ea::vector<Vector3>& vertices)
+{
+    buffer->SetCullMode(CULL_NONE);
+    buffer->Clear();
+    buffer->AddTriangles(Matrix3x4::IDENTITY, vertices.data(), sizeof(Vector3), 0, vertices.size());
+    buffer->DrawTriangles();
+    buffer->BuildDepthHierarchy();
+}
+
+}
+
+TEST_CASE("Occlusion buffer hides boxes behind occluder")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto scene = MakeShared<Scene>(context);
+    auto buffer = MakeShared<OcclusionBuffer>(context);
+    buffer->SetSize(64, 64, false);
+    buffer->SetView(CreateCamera(scene));
+
+    // Quad covers the center of the screen, from -0.2 to 0.2 in normalized coordinates
+    DrawVertices(buffer, CreateQuad(Vector2::ZERO, 1.0f, 5.0f));
+    REQUIRE(buffer->GetNumTriangles() > 0);
+
+    const BoundingBox boxes[] = {
+        { Vector3{ -0.5f, -0.5f, 8.0f }, Vector3{ 0.5f, 0.5f, 9.0f } },
+        { Vector3{ -0.5f, -0.5f, 3.0f }, Vector3{ 0.5f, 0.5f, 4.0f } },
+        { Vector3{ -0.5f, -0.5f, 4.0f }, Vector3{ 0.5f, 0.5f, 6.0f } },
+        { Vector3{ 4.0f, -0.5f, 9.0f }, Vector3{ 5.0f, 0.5f, 10.0f } },
+        { Vector3{ 0.5f, 0.5f, 20.0f }, Vector3{ 1.5f, 1.5f, 21.0f } },
+        { Vector3{ -1.0f, -1.0f, -1.0f }, Vector3{ 1.0f, 1.0f, 10.0f } },
+    };
+    const bool expectedVisible[] = { false, true, true, true, false, true };
+
+    bool isVisible[6]{};
+    buffer->AreVisible(boxes, isVisible);
+    for (unsigned i = 0; i < 6; ++i)
+    {
+        REQUIRE(buffer->IsVisible(boxes[i]) == expectedVisible[i]);
+        REQUIRE(isVisible[i] == expectedVisible[i]);
+    }
+}
+
+TEST_CASE("Occlusion buffer reprojects depth of previous frame")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto scene = MakeShared<Scene>(context);
+    Camera* camera = CreateCamera(scene);
+
+    auto previousBuffer = MakeShared<OcclusionBuffer>(context);
+    previousBuffer->SetSize(64, 64, false);
+    previousBuffer->SetView(camera);
+    DrawVertices(previousBuffer, CreateQuad(Vector2::ZERO, 2.0f, 5.0f));
+
+    // Move camera sideways, so the occluder is no longer in the center of the screen
+    camera->GetNode()->SetPosition({ 0.5f, 0.0f, 0.0f });
+
+    auto buffer = MakeShared<OcclusionBuffer>(context);
+    buffer->SetSize(64, 64, false);
+    buffer->SetView(camera);
+    buffer->Clear();
+    REQUIRE(buffer->Reproject(*previousBuffer));
+    buffer->BuildDepthHierarchy();
+    REQUIRE(buffer->IsReprojected());
+
+    REQUIRE_FALSE(buffer->IsVisible({ Vector3{ -0.5f, -0.5f, 8.0f }, Vector3{ 0.5f, 0.5f, 9.0f } }));
+    REQUIRE(buffer->IsVisible({ Vector3{ -0.5f, -0.5f, 3.0f }, Vector3{ 0.5f, 0.5f, 4.0f } }));
+    REQUIRE(buffer->IsVisible({ Vector3{ 6.0f, -0.5f, 9.0f }, Vector3{ 7.0f, 0.5f, 10.0f } }));
+
+    buffer->Clear();
+    REQUIRE_FALSE(buffer->IsReprojected());
+
+    // Buffers of different size cannot be reprojected
+    buffer->SetSize(32, 32, false);
+    REQUIRE_FALSE(buffer->Reproject(*previousBuffer));
+}
+
+TEST_CASE("Occlusion buffer culls boxes near edges of reprojected occluders only if view is unchanged")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto scene = MakeShared<Scene>(context);
+    Camera* camera = CreateCamera(scene);
+    const ea::vector<Vector3> occluder = CreateQuad(Vector2::ZERO, 2.0f, 5.0f);
+
+    auto previousBuffer = MakeShared<OcclusionBuffer>(context);
+    previousBuffer->SetSize(64, 64, false);
+    previousBuffer->SetView(camera);
+    DrawVertices(previousBuffer, occluder);
+
+    // Box in the center is deep behind the occluder, box near the right edge is covered by the last column of cells
+    const BoundingBox centerBox{ Vector3{ -0.5f, -0.5f, 8.0f }, Vector3{ 0.5f, 0.5f, 8.5f } };
+    const BoundingBox edgeBox{ Vector3{ 2.125f, -0.5f, 8.0f }, Vector3{ 2.625f, 0.5f, 8.5f } };
+
+    auto buffer = MakeShared<OcclusionBuffer>(context);
+    buffer->SetSize(64, 64, false);
+
+    // Reprojected depth is exact if view is unchanged
+    buffer->SetView(camera);
+    buffer->Clear();
+    REQUIRE(buffer->Reproject(*previousBuffer));
+    buffer->BuildDepthHierarchy();
+    REQUIRE_FALSE(buffer->IsVisible(centerBox));
+    REQUIRE_FALSE(buffer->IsVisible(edgeBox));
+
+    // If view is changed, even slightly, boxes near uncovered cells are not culled
+    camera->GetNode()->SetPosition({ 0.01f, 0.0f, 0.0f });
+    buffer->SetView(camera);
+    buffer->Clear();
+    REQUIRE(buffer->Reproject(*previousBuffer));
+    buffer->BuildDepthHierarchy();
+    REQUIRE_FALSE(buffer->IsVisible(centerBox));
+    REQUIRE(buffer->IsVisible(edgeBox));
+
+    // Occluder drawn from scratch still hides both boxes
+    DrawVertices(buffer, occluder);
+    REQUIRE_FALSE(buffer->IsVisible(centerBox));
+    REQUIRE_FALSE(buffer->IsVisible(edgeBox));
+}
+
+TEST_CASE("Occlusion buffer rasterized in threads matches single-threaded rasterization")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto scene = MakeShared<Scene>(context);
+    Camera* camera = CreateCamera(scene);
+    const ea::vector<Vector3> vertices = CreateRandomTriangles(2000, 4.0f);
+
+    auto buffer = MakeShared<OcclusionBuffer>(context);
+    buffer->SetSize(256, 128, false);
+    buffer->SetView(camera);
+    DrawVertices(buffer, vertices);
+
+    auto threadedBuffer = MakeShared<OcclusionBuffer>(context);
+    threadedBuffer->SetSize(256, 128, true);
+    threadedBuffer->SetView(camera);
+    DrawVertices(threadedBuffer, vertices);
+
+    const unsigned numPixels = 256 * 128;
+    REQUIRE(ea::equal(buffer->GetBuffer(), buffer->GetBuffer() + numPixels, threadedBuffer->GetBuffer()));
+}
+
+TEST_CASE("Occlusion buffer rasterization of many triangles", "[.benchmark]")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto scene = MakeShared<Scene>(context);
+    Camera* camera = CreateCamera(scene);
+
+    for (float size : {1.0f, 12.0f})
+    {
+        const ea::vector<Vector3> vertices = CreateRandomTriangles(5000, size);
+
+        for (bool threaded : {false, true})
+        {
+            auto buffer = MakeShared<OcclusionBuffer>(context);
+            buffer->SetSize(256, 128, threaded);
+            buffer->SetView(camera);
+
+            BENCHMARK(std::string(Format("5000 triangles, size={}, threaded={}", size, threaded).c_str()))
+            {
+                DrawVertices(buffer, vertices);
+                return buffer->GetBuffer()[0];
+            };
+        }
+    }
+}
+
+TEST_CASE("Occlusion buffer reprojection on stable camera view", "[.benchmark]")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto scene = MakeShared<Scene>(context);
+    Camera* camera = CreateCamera(scene);
+
+    const ea::vector<Vector3> vertices = CreateRandomTriangles(5000, 4.0f);
+    SetRandomSeed(2);
+    ea::vector<BoundingBox> boxes;
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+        const Vector3 center{ Random(-20.0f, 20.0f), Random(-20.0f, 20.0f), Random(5.0f, 40.0f) };
+        boxes.push_back(BoundingBox{ center - Vector3::ONE * 0.5f, center + Vector3::ONE * 0.5f });
+    }
+    ea::vector<bool> isVisible(boxes.size());
+    const auto testBoxes = [&](OcclusionBuffer* buffer)
+    {
+        buffer->AreVisible(boxes, { isVisible.data(), isVisible.size() });
+        return ea::count(isVisible.begin(), isVisible.end(), true);
+    };
+
+    auto previousBuffer = MakeShared<OcclusionBuffer>(context);
+    previousBuffer->SetSize(256, 128, false);
+    previousBuffer->SetView(camera);
+    DrawVertices(previousBuffer, vertices);
+
+    auto buffer = MakeShared<OcclusionBuffer>(context);
+    buffer->SetSize(256, 128, false);
+    buffer->SetView(camera);
+
+    // Occluders are unchanged, so the frame either draws them again or reprojects the previous frame
+    BENCHMARK("Draw occluders from scratch")
+    {
+        DrawVertices(buffer, vertices);
+        return testBoxes(buffer);
+    };
+
+    BENCHMARK("Reproject previous frame")
+    {
+        buffer->Clear();
+        buffer->Reproject(*previousBuffer);
+        buffer->BuildDepthHierarchy();
+        return testBoxes(buffer);
+    };
+}
@@ -0,0 +1,238 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+#include "../ModelUtils.h"
+
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include <EASTL/sort.h>
+
+#include <thread>
+
+namespace
+{
+
+/// Drawable which changes bounding box without moving the node, like camera-facing drawables do.
+class LazyBoundsDrawable : public Drawable
+{
+    URHO3D_OBJECT(LazyBoundsDrawable, Drawable);
+
+public:
+    explicit LazyBoundsDrawable(Context* context) : Drawable(context, DRAWABLE_GEOMETRY) {}
+
+    void SetLocalBoundingBox(const BoundingBox& box)
+    {
+        boundingBox_ = box;
+        MarkWorldBoundingBoxDirty();
+    }
+
+    void Update(const FrameInfo& frame) override { ++numUpdates_; }
+
+    unsigned numUpdates_{};
+
+private:
+    void OnWorldBoundingBoxUpdate() override { worldBoundingBox_ = boundingBox_.Transformed(node_->GetWorldTransform()); }
+};
+
+ea::vector<Drawable*> QueryOctree(Octree* octree, const Frustum& frustum, unsigned viewMask)
+{
+    ea::vector<Drawable*> result;
+    FrustumOctreeQuery query(result, frustum, DRAWABLE_GEOMETRY, viewMask);
+    octree->GetDrawables(query);
+    ea::sort(result.begin(), result.end());
+    return result;
+}
+
+ea::vector<Drawable*> QueryBruteForce(Octree* octree, const Frustum& frustum, unsigned viewMask)
+{
+    ea::vector<Drawable*> result;
+    for (Drawable* drawable : octree->GetAllDrawables())
+    {
+        if ((drawable->GetViewMask() & viewMask) && frustum.IsInsideFast(drawable->GetWorldBoundingBox()) != OUTSIDE)
+            result.push_back(drawable);
+    }
+    ea::sort(result.begin(), result.end());
+    return result;
+}
+
+}
+
+TEST_CASE("Octree frustum query matches brute force culling")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto model = Tests::CreateSkinnedQuad_Model(context)->ExportModel();
+
+    auto scene = MakeShared<Scene>(context);
+    auto octree = scene->CreateComponent<Octree>();
+
+    SetRandomSeed(1);
+    ea::vector<Node*> nodes;
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+        Node* node = scene->CreateChild();
+        node->SetPosition({ Random(-200.0f, 200.0f), Random(-20.0f, 20.0f), Random(-200.0f, 200.0f) });
+        node->SetScale(Random(0.1f, 20.0f));
+        auto staticModel = node->CreateComponent<StaticModel>();
+        staticModel->SetModel(model);
+        staticModel->SetViewMask(i % 3 == 0 ? 0x2 : 0x1);
+        nodes.push_back(node);
+    }
+    Tests::RunFrame(context, 0.05f, 0.05f);
+
+    Frustum frustum;
+    frustum.Define(60.0f, 1.5f, 1.0f, 0.1f, 150.0f, Matrix3x4(Vector3(0.0f, 5.0f, -100.0f), Quaternion(30.0f, Vector3::UP), 1.0f));
+
+    REQUIRE(QueryOctree(octree, frustum, 0x1) == QueryBruteForce(octree, frustum, 0x1));
+    REQUIRE(QueryOctree(octree, frustum, 0x2) == QueryBruteForce(octree, frustum, 0x2));
+
+    // Culling data is updated when drawables are moved, removed or change view mask
+    for (unsigned i = 0; i < nodes.size(); ++i)
+    {
+        if (i % 2 == 0)
+            nodes[i]->Translate({ Random(-50.0f, 50.0f), 0.0f, Random(-50.0f, 50.0f) });
+        if (i % 5 == 0)
+            nodes[i]->GetComponent<StaticModel>()->SetViewMask(0x3);
+        if (i % 7 == 0)
+            nodes[i]->Remove();
+    }
+    Tests::RunFrame(context, 0.05f, 0.05f);
+
+    REQUIRE(QueryOctree(octree, frustum, 0x1) == QueryBruteForce(octree, frustum, 0x1));
+    REQUIRE(QueryOctree(octree, frustum, 0x2) == QueryBruteForce(octree, frustum, 0x2));
+}
+
+TEST_CASE("Octree batched raycast matches single raycasts")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto model = Tests::CreateSkinnedQuad_Model(context)->ExportModel();
+
+    auto scene = MakeShared<Scene>(context);
+    auto octree = scene->CreateComponent<Octree>();
+
+    SetRandomSeed(2);
+    for (unsigned i = 0; i < 500; ++i)
+    {
+        Node* node = scene->CreateChild();
+        node->SetPosition({ Random(-100.0f, 100.0f), Random(-10.0f, 10.0f), Random(-100.0f, 100.0f) });
+        node->SetScale(Random(1.0f, 10.0f));
+        auto staticModel = node->CreateComponent<StaticModel>();
+        staticModel->SetModel(model);
+    }
+    Tests::RunFrame(context, 0.05f, 0.05f);
+
+    ea::vector<Ray> rays;
+    for (unsigned i = 0; i < 203; ++i)
+    {
+        const Vector3 origin{ Random(-120.0f, 120.0f), Random(-20.0f, 20.0f), Random(-120.0f, 120.0f) };
+        Vector3 direction{ Random(-1.0f, 1.0f), Random(-0.2f, 0.2f), Random(-1.0f, 1.0f) };
+        // Axis-aligned rays are handled without NaNs
+        if (i % 10 == 0)
+            direction = Vector3::FORWARD;
+        rays.emplace_back(origin, direction);
+    }
+
+    for (RayQueryLevel level : { RAY_AABB, RAY_OBB })
+    {
+        ea::vector<RayQueryResult> batchResults(rays.size());
+        octree->RaycastSingleBatch(rays, batchResults, level, 150.0f);
+
+        for (unsigned i = 0; i < rays.size(); ++i)
+        {
+            ea::vector<RayQueryResult> results;
+            RayOctreeQuery query(results, rays[i], level, 150.0f);
+            octree->RaycastSingle(query);
+
+            const RayQueryResult& batchResult = batchResults[i];
+            REQUIRE(results.empty() == (batchResult.drawable_ == nullptr));
+            if (!results.empty())
+                REQUIRE(batchResult.distance_ == Catch::Approx(results[0].distance_).margin(0.001f));
+        }
+    }
+}
+
+TEST_CASE("Octree culling data follows lazily updated bounding boxes")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    context->RegisterFactory<LazyBoundsDrawable>();
+
+    auto scene = MakeShared<Scene>(context);
+    auto octree = scene->CreateComponent<Octree>();
+
+    auto drawable = scene->CreateChild()->CreateComponent<LazyBoundsDrawable>();
+    drawable->SetLocalBoundingBox({ -Vector3::ONE, Vector3::ONE });
+    Tests::RunFrame(context, 0.05f, 0.05f);
+
+    Frustum frustum;
+    frustum.Define(BoundingBox(Vector3(90.0f, -10.0f, -10.0f), Vector3(110.0f, 10.0f, 10.0f)));
+    const Ray ray{ Vector3(100.0f, 0.0f, -50.0f), Vector3::FORWARD };
+
+    REQUIRE(QueryOctree(octree, frustum, M_MAX_UNSIGNED).empty());
+
+    // Bounding box is moved without node transform change
+    drawable->SetLocalBoundingBox({ Vector3(99.0f, -1.0f, -1.0f), Vector3(101.0f, 1.0f, 1.0f) });
+    Tests::RunFrame(context, 0.05f, 0.05f);
+
+    REQUIRE(QueryOctree(octree, frustum, M_MAX_UNSIGNED) == ea::vector<Drawable*>{ drawable });
+
+    RayQueryResult result;
+    octree->RaycastSingleBatch({ &ray, 1 }, { &result, 1 }, RAY_AABB, 100.0f);
+    REQUIRE(result.drawable_ == drawable);
+}
+
+TEST_CASE("Octree forgets updates queued from other threads when drawable is removed")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    context->RegisterFactory<LazyBoundsDrawable>();
+
+    auto scene = MakeShared<Scene>(context);
+    auto octree = scene->CreateComponent<Octree>();
+
+    Node* node = scene->CreateChild();
+    SharedPtr<LazyBoundsDrawable> drawable{ node->CreateComponent<LazyBoundsDrawable>() };
+    drawable->SetLocalBoundingBox({ -Vector3::ONE, Vector3::ONE });
+    Tests::RunFrame(context, 0.05f, 0.05f);
+    const unsigned numUpdates = drawable->numUpdates_;
+
+    // Drawable is dirtied from other threads several times, but queued only once
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        std::thread thread([&] { drawable->SetLocalBoundingBox({ -Vector3::ONE * 2.0f, Vector3::ONE * 2.0f }); });
+        thread.join();
+    }
+
+    Tests::RunFrame(context, 0.05f, 0.05f);
+    REQUIRE(drawable->numUpdates_ == numUpdates + 1);
+
+    // Drawable is removed from octree before queued update is processed
+    std::thread thread([&] { drawable->SetLocalBoundingBox({ -Vector3::ONE, Vector3::ONE }); });
+    thread.join();
+
+    node->RemoveComponent(drawable);
+    Tests::RunFrame(context, 0.05f, 0.05f);
+    REQUIRE(drawable->numUpdates_ == numUpdates + 1);
+}
@@ -0,0 +1,64 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Graphics/Skeleton.h>
+
+namespace
+{
+
+ea::vector<unsigned> GetBoneOrderPositions(const Skeleton& skeleton)
+{
+    const ea::vector<unsigned>& order = skeleton.GetBoneOrder();
+    ea::vector<unsigned> positions(order.size());
+    for (unsigned i = 0; i < order.size(); ++i)
+        positions[order[i]] = i;
+    return positions;
+}
+
+}
+
+TEST_CASE("Skeleton bone order puts parents before children")
+{
+    // Bones are stored in arbitrary order
+    static const unsigned parentIndices[] = { 3, 4, 1, 3, 3, 2, 0 };
+    const unsigned numBones = static_cast<unsigned>(ea::size(parentIndices));
+
+    Skeleton skeleton;
+    skeleton.SetNumBones(numBones);
+    for (unsigned i = 0; i < numBones; ++i)
+        skeleton.GetModifiableBones()[i].parentIndex_ = parentIndices[i];
+
+    REQUIRE(skeleton.GetBoneOrder().size() == numBones);
+    const ea::vector<unsigned> positions = GetBoneOrderPositions(skeleton);
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        if (parentIndices[i] != i)
+            REQUIRE(positions[parentIndices[i]] < positions[i]);
+    }
+
+    // Cycles are not valid hierarchy
+    skeleton.GetModifiableBones()[3].parentIndex_ = 5;
+    REQUIRE(skeleton.GetBoneOrder().empty());
+}
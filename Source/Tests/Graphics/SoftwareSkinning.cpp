@@ -0,0 +1,173 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/SoftwareModelAnimator.h>
+
+namespace
+{
+
+/// Vertex with position, normal and tangent.
+struct SkinnedVertex
+{
+    Vector3 position_;
+    Vector3 normal_;
+    Vector4 tangent_;
+};
+
+/// Mesh with 4 bones per vertex.
+struct SkinnedMesh
+{
+    ea::vector<SkinnedVertex> vertices_;
+    ea::vector<unsigned char> blendIndices_;
+    ea::vector<float> blendWeights_;
+    ea::vector<Matrix3x4> boneTransforms_;
+
+    SoftwareSkinningParams GetParams()
+    {
+        SoftwareSkinningParams params;
+        params.vertexData_ = reinterpret_cast<unsigned char*>(vertices_.data());
+        params.vertexSize_ = sizeof(SkinnedVertex);
+        params.normalOffset_ = offsetof(SkinnedVertex, normal_);
+        params.tangentOffset_ = offsetof(SkinnedVertex, tangent_);
+        params.blendIndices_ = blendIndices_.data();
+        params.blendWeights_ = blendWeights_.data();
+        params.numBones_ = SoftwareModelAnimator::MaxBones;
+        params.boneTransforms_ = boneTransforms_.data();
+        return params;
+    }
+};
+
+SkinnedMesh CreateSkinnedMesh(unsigned numVertices, unsigned numBones)
+{
+    static const unsigned bonesPerVertex = SoftwareModelAnimator::MaxBones;
+
+    SkinnedMesh mesh;
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        const float angle = i * 37.0f;
+        mesh.boneTransforms_.emplace_back(Vector3{ Sin(angle), i * 0.1f, Cos(angle) },
+            Quaternion{ angle, Vector3{ 1.0f, 2.0f, 0.5f * i }.Normalized() }, 1.0f + (i % 3) * 0.25f);
+    }
+
+    for (unsigned i = 0; i < numVertices; ++i)
+    {
+        const float angle = i * 11.0f;
+        SkinnedVertex vertex;
+        vertex.position_ = { Sin(angle), i * 0.001f, Cos(angle) };
+        vertex.normal_ = Vector3{ Cos(angle), 1.0f, Sin(angle) }.Normalized();
+        vertex.tangent_ = { Vector3{ Sin(angle), 0.0f, -Cos(angle) }, 1.0f };
+        mesh.vertices_.push_back(vertex);
+
+        float totalWeight = 0.0f;
+        for (unsigned j = 0; j < bonesPerVertex; ++j)
+        {
+            mesh.blendIndices_.push_back(static_cast<unsigned char>((i + j * 7) % numBones));
+            mesh.blendWeights_.push_back(static_cast<float>(bonesPerVertex - j));
+            totalWeight += mesh.blendWeights_.back();
+        }
+        for (unsigned j = 0; j < bonesPerVertex; ++j)
+            mesh.blendWeights_[i * bonesPerVertex + j] /= totalWeight;
+    }
+    return mesh;
+}
+
+Matrix3x4 GetBlendedTransform(const SkinnedMesh& mesh, unsigned vertexIndex)
+{
+    static const unsigned bonesPerVertex = SoftwareModelAnimator::MaxBones;
+
+    Matrix3x4 result = Matrix3x4::ZERO;
+    for (unsigned j = 0; j < bonesPerVertex; ++j)
+    {
+        const unsigned index = vertexIndex * bonesPerVertex + j;
+        result = result + mesh.boneTransforms_[mesh.blendIndices_[index]] * mesh.blendWeights_[index];
+    }
+    return result;
+}
+
+}
+
+TEST_CASE("Software skinning transforms positions, normals and tangents")
+{
+    // Odd number of vertices to cover both vectorized and remaining vertices
+    SkinnedMesh mesh = CreateSkinnedMesh(1003, 16);
+    const ea::vector<SkinnedVertex> originalVertices = mesh.vertices_;
+
+    SoftwareModelAnimator::SkinVertices(mesh.GetParams(), 0, 501);
+    SoftwareModelAnimator::SkinVertices(mesh.GetParams(), 501, mesh.vertices_.size());
+
+    for (unsigned i = 0; i < mesh.vertices_.size(); ++i)
+    {
+        const Matrix3x4 transform = GetBlendedTransform(mesh, i);
+        const Matrix3 rotation = transform.ToMatrix3();
+        const SkinnedVertex& original = originalVertices[i];
+        const SkinnedVertex& vertex = mesh.vertices_[i];
+
+        REQUIRE(vertex.position_.Equals(transform * original.position_, M_LARGE_EPSILON));
+        REQUIRE(vertex.normal_.Equals(rotation * original.normal_, M_LARGE_EPSILON));
+        REQUIRE(Vector3{ vertex.tangent_ }.Equals(rotation * Vector3{ original.tangent_ }, M_LARGE_EPSILON));
+        REQUIRE(vertex.tangent_.w_ == original.tangent_.w_);
+    }
+}
+
+TEST_CASE("Software skinning of large meshes", "[.benchmark]")
+{
+    auto context = MakeShared<Context>();
+    auto workQueue = MakeShared<WorkQueue>(context);
+    workQueue->CreateThreads(3);
+
+    for (unsigned numVertices : {10000u, 100000u, 500000u})
+    {
+        // Skinning is done in place, so restore vertices from unchanged source before skinning like
+        // SoftwareModelAnimator::ResetAnimation does. Otherwise values grow with each iteration.
+        SkinnedMesh mesh = CreateSkinnedMesh(numVertices, 64);
+        const ea::vector<SkinnedVertex> sourceVertices = mesh.vertices_;
+        const SoftwareSkinningParams params = mesh.GetParams();
+
+        const auto skinVertexRange = [&](unsigned beginVertex, unsigned endVertex)
+        {
+            ea::copy(sourceVertices.begin() + beginVertex, sourceVertices.begin() + endVertex,
+                mesh.vertices_.begin() + beginVertex);
+            SoftwareModelAnimator::SkinVertices(params, beginVertex, endVertex);
+        };
+
+        BENCHMARK(std::string(Format("{} vertices, 1 thread", numVertices).c_str()))
+        {
+            skinVertexRange(0, numVertices);
+            return mesh.vertices_[0].position_.x_;
+        };
+
+        BENCHMARK(std::string(Format("{} vertices, 4 threads", numVertices).c_str()))
+        {
+            ForEachParallel(workQueue, SoftwareModelAnimator::SkinningBucket, numVertices, skinVertexRange);
+            return mesh.vertices_[0].position_.x_;
+        };
+
+        // Skinned vertices are the same regardless of the number of benchmark iterations
+        const Matrix3x4 transform = GetBlendedTransform(mesh, 0);
+        CHECK(mesh.vertices_[0].position_.Equals(transform * sourceVertices[0].position_, M_LARGE_EPSILON));
+    }
+}
@@ -0,0 +1,229 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/IO/Compression.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/PackageFile.h>
+#include <Urho3D/Resource/JSONFile.h>
+#include <Urho3D/Resource/XMLFile.h>
+
+namespace
+{
+
+ea::string WriteTestPackage(Context* context, const ea::vector<ea::pair<ea::string, ea::string>>& files)
+{
+    auto fileSystem = context->GetSubsystem<FileSystem>();
+    const ea::string fileName = fileSystem->GetTemporaryDir() + "MemoryMappedPackageTest.pak";
+
+    // Legacy UPAK layout: header, file list, then the file data
+    unsigned headerSize = 4 + 4 + 4;
+    for (const auto& [name, data] : files)
+        headerSize += name.length() + 1 + 4 + 4 + 4;
+
+    File file(context, fileName, FILE_WRITE);
+    file.WriteFileID("UPAK");
+    file.WriteUInt(files.size());
+    file.WriteUInt(0);
+
+    unsigned offset = headerSize;
+    for (const auto& [name, data] : files)
+    {
+        file.WriteString(name);
+        file.WriteUInt(offset);
+        file.WriteUInt(data.length());
+        file.WriteUInt(0);
+        offset += data.length();
+    }
+    for (const auto& [name, data] : files)
+        file.Write(data.data(), data.length());
+
+    return fileName;
+}
+
+ea::string WriteBlockIndexedPackage(Context* context, const ByteVector& data, CompressionCodec codec, unsigned blockSize)
+{
+    auto fileSystem = context->GetSubsystem<FileSystem>();
+    const ea::string fileName = fileSystem->GetTemporaryDir() + "BlockIndexedPackageTest.pak";
+
+    File file(context, fileName, FILE_WRITE);
+    file.WriteFileID("RPAK");
+    file.WriteUInt(1);
+    file.WriteUInt(0);
+    file.WriteUInt(PACKAGE_VERSION_BLOCK_INDEX);
+    file.WriteInt64(0);
+    file.WriteUByte(static_cast<unsigned char>(codec));
+    file.WriteUInt(blockSize);
+
+    const unsigned entryOffset = file.GetSize();
+    ea::vector<unsigned> blockOffsets;
+    ByteVector packedBlock(EstimateCompressBound(blockSize, codec));
+    for (unsigned pos = 0; pos < data.size(); pos += blockSize)
+    {
+        const unsigned unpackedSize = ea::min<unsigned>(blockSize, data.size() - pos);
+        const unsigned packedSize = CompressData(packedBlock.data(), &data[pos], unpackedSize, codec);
+        REQUIRE(packedSize != 0);
+        if (packedSize >= unpackedSize)
+            file.Write(&data[pos], unpackedSize);
+        else
+            file.Write(packedBlock.data(), packedSize);
+        blockOffsets.push_back(file.GetSize() - entryOffset);
+    }
+
+    const unsigned entriesOffset = file.GetSize();
+    file.WriteString("Data.bin");
+    file.WriteUInt(entryOffset);
+    file.WriteUInt(data.size());
+    file.WriteUInt(0);
+    for (unsigned blockOffset : blockOffsets)
+        file.WriteUInt(blockOffset);
+    file.WriteUInt(file.GetSize() + sizeof(unsigned));
+
+    file.Seek(16);
+    file.WriteInt64(entriesOffset);
+    return fileName;
+}
+
+}
+
+TEST_CASE("Memory-mapped package files are read without file handles")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    const ea::vector<ea::pair<ea::string, ea::string>> files = {
+        {"First.txt", "Hello, world!"},
+        {"Second.txt", "Memory-mapped package contents"},
+    };
+    const ea::string fileName = WriteTestPackage(context, files);
+
+    auto package = MakeShared<PackageFile>(context);
+    REQUIRE(package->Open(fileName));
+    REQUIRE(package->MapMemory());
+    REQUIRE(package->IsMemoryMapped());
+
+    for (const auto& [name, data] : files)
+    {
+        File file(context, package, name);
+        REQUIRE(file.IsOpen());
+        REQUIRE(file.GetHandle() == nullptr);
+        REQUIRE(file.GetSize() == data.length());
+
+        const unsigned char* mappedData = file.GetMappedData();
+        REQUIRE(mappedData);
+        REQUIRE(ea::string(reinterpret_cast<const char*>(mappedData), data.length()) == data);
+
+        REQUIRE(file.ReadText() == data);
+
+        file.Seek(7);
+        char buffer[4]{};
+        REQUIRE(file.Read(buffer, 3) == 3);
+        REQUIRE(ea::string(buffer) == data.substr(7, 3));
+    }
+
+    // Files keep the mapping alive after the package is released
+    File file(context, package, "Second.txt");
+    package = nullptr;
+    REQUIRE(file.ReadText() == files[1].second);
+    file.Close();
+
+    context->GetSubsystem<FileSystem>()->Delete(fileName);
+}
+
+TEST_CASE("Resources are parsed directly from memory-mapped package files")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    const ea::vector<ea::pair<ea::string, ea::string>> files = {
+        {"Data.xml", "<root value=\"42\" />"},
+        {"Data.json", "{ \"value\": 42 }"},
+    };
+    const ea::string fileName = WriteTestPackage(context, files);
+
+    auto package = MakeShared<PackageFile>(context);
+    REQUIRE(package->Open(fileName));
+    REQUIRE(package->MapMemory());
+
+    {
+        File file(context, package, "Data.xml");
+        REQUIRE(file.GetMappedData());
+        auto xmlFile = MakeShared<XMLFile>(context);
+        REQUIRE(xmlFile->Load(file));
+        REQUIRE(xmlFile->GetRoot().GetInt("value") == 42);
+    }
+
+    {
+        File file(context, package, "Data.json");
+        REQUIRE(file.GetMappedData());
+        auto jsonFile = MakeShared<JSONFile>(context);
+        REQUIRE(jsonFile->Load(file));
+        REQUIRE(jsonFile->GetRoot().Get("value").GetInt() == 42);
+    }
+
+    package = nullptr;
+    context->GetSubsystem<FileSystem>()->Delete(fileName);
+}
+
+TEST_CASE("Compressed package files with block index support random access")
+{
+    auto context = Tests::CreateCompleteTestContext();
+
+    // Compressible text with incompressible noise in the middle
+    ByteVector data(300000);
+    unsigned seed = 1;
+    for (unsigned i = 0; i < data.size(); ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        data[i] = i > 100000 && i < 140000 ? static_cast<unsigned char>(seed >> 16) : static_cast<unsigned char>('a' + i % 7);
+    }
+
+    for (CompressionCodec codec : {CompressionCodec::LZ4, CompressionCodec::Deflate})
+    {
+        const ea::string fileName = WriteBlockIndexedPackage(context, data, codec, 16384);
+
+        for (bool memoryMapped : {false, true})
+        {
+            auto package = MakeShared<PackageFile>(context);
+            REQUIRE(package->Open(fileName));
+            REQUIRE(package->HasBlockIndex());
+            REQUIRE(package->GetCodec() == codec);
+            if (memoryMapped)
+                REQUIRE(package->MapMemory());
+
+            File file(context, package, "Data.bin");
+            REQUIRE(file.GetSize() == data.size());
+            REQUIRE(file.ReadBinary() == data);
+
+            // Seek backward and across block boundaries
+            for (unsigned position : {250000u, 16380u, 0u, 120000u, 299990u, 5u})
+            {
+                unsigned char buffer[20]{};
+                const unsigned size = ea::min<unsigned>(sizeof(buffer), data.size() - position);
+                REQUIRE(file.Seek(position) == position);
+                REQUIRE(file.Read(buffer, sizeof(buffer)) == size);
+                REQUIRE(ea::equal(buffer, buffer + size, &data[position]));
+            }
+        }
+
+        context->GetSubsystem<FileSystem>()->Delete(fileName);
+    }
+}
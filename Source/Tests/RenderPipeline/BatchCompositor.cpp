@@ -0,0 +1,201 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+#include "../ModelUtils.h"
+
+#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/Graphics/Technique.h>
+#include <Urho3D/RenderPipeline/BatchCompositor.h>
+#include <Urho3D/Scene/Scene.h>
+
+namespace
+{
+
+/// Pipeline state cache callback that creates empty pipeline states.
+class TestBatchStateCacheCallback : public BatchStateCacheCallback
+{
+public:
+    SharedPtr<PipelineState> CreateBatchPipelineState(
+        const BatchStateCreateKey& key, const BatchStateCreateContext& ctx) override
+    {
+        return MakeShared<PipelineState>(nullptr);
+    }
+};
+
+/// Create pipeline state in the cache and return it.
+PipelineState* CreatePipelineState(BatchStateCache& cache, const PipelineBatchDesc& desc)
+{
+    TestBatchStateCacheCallback callback;
+    return cache.GetOrCreatePipelineState(desc.GetKey(), BatchStateCreateContext{}, &callback);
+}
+
+}
+
+TEST_CASE("Retained pipeline states are reused until batch changes")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto model = Tests::CreateSkinnedQuad_Model(context)->ExportModel();
+    auto otherModel = Tests::CreateSkinnedQuad_Model(context)->ExportModel();
+
+    auto technique = MakeShared<Technique>(context);
+    Pass* basePass = technique->CreatePass("base");
+    Pass* lightPass = technique->CreatePass("light");
+    auto material = MakeShared<Material>(context);
+    material->SetTechnique(0, technique);
+
+    auto scene = MakeShared<Scene>(context);
+    scene->CreateComponent<Octree>();
+    auto staticModel = scene->CreateChild()->CreateComponent<StaticModel>();
+    staticModel->SetModel(model);
+    staticModel->SetMaterial(material);
+    Tests::RunFrame(context, 0.05f, 0.05f);
+
+    BatchStateCache cache;
+    const BatchStateCache emptyCache;
+    RetainedBatchStorage storage;
+
+    // Return pipeline state of base or light batch, retained state is used before cache lookup
+    const auto getPipelineState = [&](const BatchStateCache& stateCache, unsigned lightHash = 0)
+    {
+        PipelineBatchDesc desc(staticModel, 0, lightHash ? lightPass : basePass);
+        if (lightHash)
+            desc.InitializeLitBatch(nullptr, 0, lightHash);
+        storage.Allocate(staticModel, 0);
+        RetainedGeometryBatch* retainedBatch = storage.Get(desc);
+        return RetainedBatchStorage::GetPipelineState(desc, stateCache, retainedBatch->GetState(lightHash ? 1 : 0));
+    };
+    const auto createPipelineStates = [&]()
+    {
+        PipelineBatchDesc baseDesc(staticModel, 0, basePass);
+        PipelineBatchDesc lightDesc(staticModel, 0, lightPass);
+        lightDesc.InitializeLitBatch(nullptr, 0, 1);
+        PipelineState* baseState = CreatePipelineState(cache, baseDesc);
+        PipelineState* lightState = CreatePipelineState(cache, lightDesc);
+        REQUIRE(getPipelineState(cache) == baseState);
+        REQUIRE(getPipelineState(cache, 1) == lightState);
+        return ea::make_pair(baseState, lightState);
+    };
+
+    storage.Resize(scene->GetComponent<Octree>()->GetAllDrawables().size());
+
+    // Not retained yet
+    REQUIRE(getPipelineState(emptyCache) == nullptr);
+
+    // Reused when nothing changed, even if cache lookup would fail
+    auto states = createPipelineStates();
+    REQUIRE(getPipelineState(emptyCache) == states.first);
+    REQUIRE(getPipelineState(emptyCache, 1) == states.second);
+
+    SECTION("Material change invalidates all retained states")
+    {
+        material->SetCullMode(CULL_NONE);
+        REQUIRE(getPipelineState(emptyCache) == nullptr);
+        REQUIRE(getPipelineState(emptyCache, 1) == nullptr);
+
+        states = createPipelineStates();
+        REQUIRE(getPipelineState(emptyCache) == states.first);
+    }
+
+    SECTION("Pass change invalidates retained state of the pass")
+    {
+        basePass->SetBlendMode(BLEND_ALPHA);
+        REQUIRE(getPipelineState(emptyCache) == nullptr);
+        REQUIRE(getPipelineState(emptyCache, 1) == states.second);
+    }
+
+    SECTION("Geometry change invalidates all retained states")
+    {
+        staticModel->SetModel(otherModel);
+        staticModel->SetMaterial(material);
+        REQUIRE(getPipelineState(emptyCache) == nullptr);
+        REQUIRE(getPipelineState(emptyCache, 1) == nullptr);
+
+        states = createPipelineStates();
+        REQUIRE(getPipelineState(emptyCache) == states.first);
+    }
+
+    SECTION("Light change invalidates retained state of the light")
+    {
+        REQUIRE(getPipelineState(emptyCache, 2) == nullptr);
+        REQUIRE(getPipelineState(emptyCache) == states.first);
+    }
+
+    SECTION("Pipeline state invalidation invalidates all retained states")
+    {
+        storage.Invalidate();
+        REQUIRE(getPipelineState(emptyCache) == nullptr);
+        REQUIRE(getPipelineState(emptyCache, 1) == nullptr);
+    }
+}
+
+TEST_CASE("Retained pipeline states are not reused by another drawable with the same index")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto model = Tests::CreateSkinnedQuad_Model(context)->ExportModel();
+
+    auto technique = MakeShared<Technique>(context);
+    Pass* basePass = technique->CreatePass("base");
+    auto material = MakeShared<Material>(context);
+    material->SetTechnique(0, technique);
+
+    auto scene = MakeShared<Scene>(context);
+    auto octree = scene->CreateComponent<Octree>();
+    auto createStaticModel = [&]()
+    {
+        auto staticModel = scene->CreateChild()->CreateComponent<StaticModel>();
+        staticModel->SetModel(model);
+        staticModel->SetMaterial(material);
+        return SharedPtr<StaticModel>(staticModel);
+    };
+    auto firstModel = createStaticModel();
+    auto secondModel = createStaticModel();
+    Tests::RunFrame(context, 0.05f, 0.05f);
+
+    BatchStateCache cache;
+    const BatchStateCache emptyCache;
+    RetainedBatchStorage storage;
+    storage.Resize(octree->GetAllDrawables().size());
+
+    const auto getPipelineState = [&](StaticModel* staticModel, const BatchStateCache& stateCache)
+    {
+        PipelineBatchDesc desc(staticModel, 0, basePass);
+        storage.Allocate(staticModel, 0);
+        RetainedGeometryBatch* retainedBatch = storage.Get(desc);
+        return RetainedBatchStorage::GetPipelineState(desc, stateCache, retainedBatch->GetState(0));
+    };
+
+    // Both drawables have identical batches, so they share pipeline state
+    REQUIRE(firstModel->GetPipelineStateHash() == secondModel->GetPipelineStateHash());
+    PipelineState* pipelineState = CreatePipelineState(cache, PipelineBatchDesc(firstModel, 0, basePass));
+    REQUIRE(getPipelineState(firstModel, cache) == pipelineState);
+    REQUIRE(getPipelineState(firstModel, emptyCache) == pipelineState);
+
+    // Removed drawable gives its index to another drawable, which has nothing retained
+    const unsigned firstIndex = firstModel->GetDrawableIndex();
+    firstModel->GetNode()->Remove();
+    REQUIRE(secondModel->GetDrawableIndex() == firstIndex);
+    REQUIRE(getPipelineState(secondModel, emptyCache) == nullptr);
+}
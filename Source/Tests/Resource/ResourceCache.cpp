@@ -0,0 +1,242 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/Resource/BinaryFile.h>
+#include <Urho3D/Resource/ResourceCache.h>
+
+namespace
+{
+
+SharedPtr<BinaryFile> CreateManualResource(ResourceCache* cache, const ea::string& name, unsigned memoryUse)
+{
+    auto resource = MakeShared<BinaryFile>(cache->GetContext());
+    resource->SetName(name);
+    resource->SetMemoryUse(memoryUse);
+    cache->AddManualResource(resource);
+    return resource;
+}
+
+}
+
+TEST_CASE("ResourceCache releases least recently used resources over memory budget")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto cache = context->GetSubsystem<ResourceCache>();
+    const StringHash type = BinaryFile::GetTypeStatic();
+
+    cache->SetMemoryBudget(type, 350);
+
+    // Resource A stays in use, B and C are only referenced by the cache
+    SharedPtr<BinaryFile> resourceA = CreateManualResource(cache, "Test/A.bin", 100);
+    CreateManualResource(cache, "Test/B.bin", 100);
+    CreateManualResource(cache, "Test/C.bin", 100);
+    REQUIRE(cache->GetMemoryUse(type) == 300);
+
+    Time::Sleep(2);
+    SharedPtr<BinaryFile> resourceD = CreateManualResource(cache, "Test/D.bin", 100);
+
+    REQUIRE(cache->GetExistingResource<BinaryFile>("Test/A.bin"));
+    REQUIRE_FALSE(cache->GetExistingResource<BinaryFile>("Test/B.bin"));
+    REQUIRE(cache->GetExistingResource<BinaryFile>("Test/C.bin"));
+    REQUIRE(cache->GetExistingResource<BinaryFile>("Test/D.bin"));
+    REQUIRE(cache->GetMemoryUse(type) == 300);
+
+    // Memory use is tracked when stored resources change size
+    resourceD->SetMemoryUse(200);
+    REQUIRE(cache->GetMemoryUse(type) == 400);
+
+    Time::Sleep(2);
+    cache->SetMemoryBudget(type, 350);
+    REQUIRE_FALSE(cache->GetExistingResource<BinaryFile>("Test/C.bin"));
+    REQUIRE(cache->GetMemoryUse(type) == 300);
+
+    // Deferred release destroys evicted resources on the next frame
+    cache->SetDeferredRelease(true);
+    WeakPtr<BinaryFile> weakResourceD{resourceD};
+    resourceD = nullptr;
+
+    Time::Sleep(2);
+    cache->SetMemoryBudget(type, 100);
+    REQUIRE_FALSE(cache->GetExistingResource<BinaryFile>("Test/D.bin"));
+    REQUIRE(cache->GetMemoryUse(type) == 100);
+    REQUIRE(cache->GetNumDeferredReleaseResources() == 1);
+    REQUIRE_FALSE(weakResourceD.Expired());
+
+    cache->SendEvent(E_BEGINFRAME);
+    REQUIRE(cache->GetNumDeferredReleaseResources() == 0);
+    REQUIRE(weakResourceD.Expired());
+
+    cache->SetDeferredRelease(false);
+    cache->SetMemoryBudget(type, 0);
+    cache->ReleaseResources(type, true);
+}
+
+TEST_CASE("Resources are background loaded on multiple threads")
+{
+    static const unsigned numResources = 64;
+
+    auto context = Tests::CreateCompleteTestContext();
+    auto cache = context->GetSubsystem<ResourceCache>();
+    auto fileSystem = context->GetSubsystem<FileSystem>();
+
+    const ea::string resourceDir = fileSystem->GetTemporaryDir() + "BackgroundLoaderTest/";
+    REQUIRE(fileSystem->CreateDir(resourceDir));
+
+    const auto getFileName = [](unsigned index) { return Format("Resource{}.bin", index); };
+    const auto getFileData = [](unsigned index) { return ByteVector(1000 + index, static_cast<unsigned char>(index)); };
+    for (unsigned i = 0; i < numResources; ++i)
+    {
+        const ByteVector data = getFileData(i);
+        File file(context, resourceDir + getFileName(i), FILE_WRITE);
+        file.Write(data.data(), data.size());
+    }
+    REQUIRE(cache->AddResourceDir(resourceDir));
+
+    cache->SetNumBackgroundLoadThreads(4);
+    for (unsigned i = 0; i < numResources; ++i)
+    {
+        REQUIRE(cache->BackgroundLoadResource<BinaryFile>(getFileName(i)));
+
+        // Resize the pool while resources are being loaded
+        if (i == numResources / 2)
+            cache->SetNumBackgroundLoadThreads(2);
+    }
+    REQUIRE(cache->GetNumBackgroundLoadThreads() == 2);
+
+    // Requesting a queued resource waits for it
+    auto* waitedResource = cache->GetResource<BinaryFile>(getFileName(numResources - 1));
+    REQUIRE(waitedResource);
+    REQUIRE(waitedResource->GetData() == getFileData(numResources - 1));
+
+    for (unsigned i = 0; i < 10000 && cache->GetNumBackgroundLoadResources() > 0; ++i)
+    {
+        cache->SendEvent(E_BEGINFRAME);
+        Time::Sleep(1);
+    }
+    REQUIRE(cache->GetNumBackgroundLoadResources() == 0);
+
+    for (unsigned i = 0; i < numResources; ++i)
+    {
+        auto* resource = cache->GetExistingResource<BinaryFile>(getFileName(i));
+        REQUIRE(resource);
+        REQUIRE(resource->GetData() == getFileData(i));
+    }
+
+    const BackgroundLoadStats stats = cache->GetBackgroundLoadStats()[BinaryFile::GetTypeStatic()];
+    REQUIRE(stats.numLoaded_ == numResources);
+    REQUIRE(stats.numFailed_ == 0);
+
+    cache->ReleaseAllResources(true);
+    cache->RemoveResourceDir(resourceDir);
+    fileSystem->RemoveDir(resourceDir, true);
+}
+
+TEST_CASE("ResourceCache finds files created in unwatched resource directories")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto cache = context->GetSubsystem<ResourceCache>();
+    auto fileSystem = context->GetSubsystem<FileSystem>();
+
+    const ea::string resourceDir = fileSystem->GetTemporaryDir() + "ResourceDirIndexTest/";
+    REQUIRE(fileSystem->CreateDir(resourceDir));
+    {
+        File file(context, resourceDir + "Indexed.txt", FILE_WRITE);
+        file.WriteLine("Indexed");
+    }
+
+    cache->SetAutoReloadResources(false);
+    REQUIRE(cache->AddResourceDir(resourceDir));
+    REQUIRE(cache->Exists("Indexed.txt"));
+    REQUIRE_FALSE(cache->Exists("Created.txt"));
+
+    // Index of unwatched directory is not updated, file system is checked on index miss
+    {
+        File file(context, resourceDir + "Created.txt", FILE_WRITE);
+        file.WriteLine("Created");
+    }
+    REQUIRE(cache->Exists("Created.txt"));
+    REQUIRE(cache->GetResourceFileName("Created.txt") == resourceDir + "Created.txt");
+
+    cache->RemoveResourceDir(resourceDir);
+    fileSystem->RemoveDir(resourceDir, true);
+}
+
+TEST_CASE("ResourceCache finds files in watched resource directories before changes are reported")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto cache = context->GetSubsystem<ResourceCache>();
+    auto fileSystem = context->GetSubsystem<FileSystem>();
+
+    const ea::string resourceDir = fileSystem->GetTemporaryDir() + "WatchedResourceDirIndexTest/";
+    REQUIRE(fileSystem->CreateDir(resourceDir));
+    {
+        File file(context, resourceDir + "Indexed.txt", FILE_WRITE);
+        file.WriteLine("Indexed");
+    }
+
+    cache->SetAutoReloadResources(true);
+    REQUIRE(cache->AddResourceDir(resourceDir));
+    REQUIRE(cache->Exists("Indexed.txt"));
+    REQUIRE_FALSE(cache->Exists("Created.txt"));
+
+    // File watcher reports changes with a delay, written file is loaded immediately
+    {
+        File file(context, resourceDir + "Created.txt", FILE_WRITE);
+        file.WriteLine("Created");
+    }
+    auto createdFile = cache->GetResource<BinaryFile>("Created.txt");
+    REQUIRE(createdFile);
+    REQUIRE_FALSE(createdFile->GetData().empty());
+
+    // Files in new subdirectories are found too
+    REQUIRE(fileSystem->CreateDir(resourceDir + "Subdir/"));
+    {
+        File file(context, resourceDir + "Subdir/Nested.txt", FILE_WRITE);
+        file.WriteLine("Nested");
+    }
+    REQUIRE(cache->Exists("Subdir/Nested.txt"));
+    REQUIRE(cache->GetResourceFileName("Subdir/Nested.txt") == resourceDir + "Subdir/Nested.txt");
+
+    // File which is removed and written again is found after the changes are reported
+    cache->ReleaseAllResources(true);
+    REQUIRE(fileSystem->Delete(resourceDir + "Indexed.txt"));
+    {
+        File file(context, resourceDir + "Indexed.txt", FILE_WRITE);
+        file.WriteLine("Rewritten");
+    }
+    Time::Sleep(1500);
+    cache->SendEvent(E_BEGINFRAME);
+    REQUIRE(cache->Exists("Indexed.txt"));
+    REQUIRE(cache->GetResource<BinaryFile>("Indexed.txt"));
+
+    cache->ReleaseAllResources(true);
+    cache->SetAutoReloadResources(false);
+    cache->RemoveResourceDir(resourceDir);
+    fileSystem->RemoveDir(resourceDir, true);
+}
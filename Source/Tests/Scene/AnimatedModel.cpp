@@ -26,12 +26,16 @@
 
 #include <Urho3D/Graphics/AnimatedModel.h>
 #include <Urho3D/Graphics/AnimationController.h>
+#include <Urho3D/Graphics/AnimationScheduler.h>
 #include <Urho3D/Graphics/Camera.h>
 #include <Urho3D/Graphics/Octree.h>
 #include <Urho3D/Scene/Scene.h>
 #include <Urho3D/Resource/ResourceCache.h>
 #include <Urho3D/UI/Text3D.h>
 
+#include <atomic>
+#include <thread>
+
 TEST_CASE("Lerp animation blending")
 {
     auto context = Tests::CreateCompleteTestContext();
@@ -346,6 +350,226 @@ TEST_CASE("Animation start bone")
     }
 }
 
+namespace
+{
+
+/// Apply animation states to bone nodes directly and return world transforms of bones.
+/// Bones deeper than max depth keep bind pose relative to their parents.
+ea::vector<Matrix3x4> ApplyAnimationToBoneNodes(AnimatedModel* animatedModel, unsigned maxBoneDepth)
+{
+    Skeleton& skeleton = animatedModel->GetSkeleton();
+    skeleton.ResetSilent();
+    for (AnimationState* state : animatedModel->GetComponent<AnimationController>()->GetAnimationStates())
+        state->ApplyModelTracks();
+
+    ea::vector<Bone>& bones = skeleton.GetModifiableBones();
+    for (unsigned i = 0; i < bones.size(); ++i)
+    {
+        unsigned depth = 0;
+        for (unsigned j = i; bones[j].parentIndex_ != j; j = bones[j].parentIndex_)
+            ++depth;
+
+        Bone& bone = bones[i];
+        if (depth > maxBoneDepth)
+            bone.node_->SetTransformSilent(bone.initialPosition_, bone.initialRotation_, bone.initialScale_);
+        bone.node_->MarkDirty();
+    }
+
+    ea::vector<Matrix3x4> worldTransforms;
+    for (const Bone& bone : bones)
+        worldTransforms.push_back(bone.node_->GetWorldTransform());
+    return worldTransforms;
+}
+
+}
+
+TEST_CASE("Animation pose buffer matches animation applied to bone nodes")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto cache = context->GetSubsystem<ResourceCache>();
+    auto scheduler = context->GetSubsystem<AnimationScheduler>();
+
+    auto model = Tests::CreateSkinnedQuad_Model(context)->ExportModel("@/SkinnedQuad.mdl");
+    cache->AddManualResource(model);
+
+    auto animationRotate = Tests::CreateLoopedRotationAnimation(context,
+        "Tests/Rotate.ani", "Quad 1", Vector3::UP, 2.0f);
+    auto animationTranslateX = Tests::CreateLoopedTranslationAnimation(context,
+        "Tests/TranslateX.ani", "Quad 2", { 0.0f, 1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, 2.0f);
+    auto animationTranslateZ = Tests::CreateLoopedTranslationAnimation(context,
+        "Tests/TranslateZ.ani", "Quad 2", { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 2.0f }, 2.0f);
+    auto animationTranslateRoot = Tests::CreateLoopedTranslationAnimation(context,
+        "Tests/TranslateRoot.ani", "Quad 1", { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, 2.0f);
+    auto animationTranslateXZ = Tests::CreateCombinedAnimation(context,
+        "Tests/TranslateXZ.ani", { animationTranslateRoot, animationTranslateZ });
+
+    cache->AddManualResource(animationRotate);
+    cache->AddManualResource(animationTranslateX);
+    cache->AddManualResource(animationTranslateZ);
+    cache->AddManualResource(animationTranslateXZ);
+
+    const auto checkPoseMatchesBoneNodes = [&](const ea::function<void(AnimationController*)>& setup, unsigned maxBoneDepth)
+    {
+        // Setup
+        scheduler->SetLodBoneDistance(maxBoneDepth != M_MAX_UNSIGNED ? -1.0f : M_INFINITY);
+        scheduler->SetLodBoneDepth(maxBoneDepth);
+
+        auto scene = MakeShared<Scene>(context);
+        scene->CreateComponent<Octree>();
+
+        auto node = scene->CreateChild("Node");
+        node->SetPosition({ 1.0f, 0.0f, 2.0f });
+        node->SetRotation({ 30.0f, Vector3::UP });
+        auto animatedModel = node->CreateComponent<AnimatedModel>();
+        animatedModel->SetModel(model);
+
+        auto animationController = node->CreateComponent<AnimationController>();
+        setup(animationController);
+
+        const ea::vector<Bone>& bones = animatedModel->GetSkeleton().GetBones();
+        const Matrix3x4* skinMatrices = animatedModel->GetBatches()[0].worldTransform_;
+        FrameInfo frameInfo;
+
+        for (unsigned frame = 0; frame < 20; ++frame)
+        {
+            // Bone nodes and skinning are updated from the pose buffer
+            Tests::RunFrame(context, 0.1f);
+            animatedModel->UpdateGeometry(frameInfo);
+
+            ea::vector<Matrix3x4> actualTransforms;
+            for (const Bone& bone : bones)
+                actualTransforms.push_back(bone.node_->GetWorldTransform());
+            const ea::vector<Matrix3x4> actualSkinMatrices(skinMatrices, skinMatrices + bones.size());
+
+            // Assert
+            const ea::vector<Matrix3x4> expectedTransforms = ApplyAnimationToBoneNodes(animatedModel, maxBoneDepth);
+            for (unsigned i = 0; i < bones.size(); ++i)
+            {
+                CHECK(actualTransforms[i].Equals(expectedTransforms[i], M_LARGE_EPSILON));
+                CHECK(actualSkinMatrices[i].Equals(expectedTransforms[i] * bones[i].offsetMatrix_, M_LARGE_EPSILON));
+            }
+        }
+
+        // Skinning follows bone nodes changed after animation
+        Tests::RunFrame(context, 0.1f);
+        Node* quad2 = bones[2].node_;
+        quad2->SetPosition({ 0.0f, 2.0f, 0.5f });
+        animatedModel->UpdateGeometry(frameInfo);
+        CHECK(skinMatrices[2].Equals(quad2->GetWorldTransform() * bones[2].offsetMatrix_, M_LARGE_EPSILON));
+    };
+
+    // Lerp blending
+    checkPoseMatchesBoneNodes([](AnimationController* animationController)
+    {
+        animationController->Play("Tests/Rotate.ani", 0, true);
+        animationController->Play("Tests/TranslateX.ani", 0, true);
+        animationController->Play("Tests/TranslateZ.ani", 1, true);
+        animationController->SetWeight("Tests/TranslateZ.ani", 0.75f);
+    }, M_MAX_UNSIGNED);
+
+    // Additive blending
+    checkPoseMatchesBoneNodes([](AnimationController* animationController)
+    {
+        animationController->Play("Tests/TranslateX.ani", 0, true);
+        animationController->Play("Tests/Rotate.ani", 1, true);
+        animationController->SetWeight("Tests/Rotate.ani", 0.5f);
+        animationController->SetBlendMode("Tests/Rotate.ani", ABM_ADDITIVE);
+        animationController->Play("Tests/TranslateZ.ani", 2, true);
+        animationController->SetWeight("Tests/TranslateZ.ani", 0.75f);
+        animationController->SetBlendMode("Tests/TranslateZ.ani", ABM_ADDITIVE);
+    }, M_MAX_UNSIGNED);
+
+    // Start bone
+    checkPoseMatchesBoneNodes([](AnimationController* animationController)
+    {
+        animationController->Play("Tests/TranslateXZ.ani", 0, true);
+        animationController->SetStartBone("Tests/TranslateXZ.ani", "Quad 2");
+        animationController->Play("Tests/Rotate.ani", 1, true);
+        animationController->SetWeight("Tests/Rotate.ani", 0.5f);
+    }, M_MAX_UNSIGNED);
+
+    // Bone LOD: Quad 2 is not evaluated
+    checkPoseMatchesBoneNodes([](AnimationController* animationController)
+    {
+        animationController->Play("Tests/Rotate.ani", 0, true);
+        animationController->Play("Tests/TranslateX.ani", 0, true);
+        animationController->Play("Tests/TranslateZ.ani", 1, true);
+        animationController->SetWeight("Tests/TranslateZ.ani", 0.75f);
+    }, 1);
+}
+
+TEST_CASE("Bone nodes are read from multiple threads at once")
+{
+    auto context = Tests::CreateCompleteTestContext();
+    auto cache = context->GetSubsystem<ResourceCache>();
+
+    auto model = Tests::CreateSkinnedQuad_Model(context)->ExportModel("@/SkinnedQuad.mdl");
+    cache->AddManualResource(model);
+
+    auto animationRotate = Tests::CreateLoopedRotationAnimation(context,
+        "Tests/Rotate.ani", "Quad 1", Vector3::UP, 2.0f);
+    auto animationTranslateX = Tests::CreateLoopedTranslationAnimation(context,
+        "Tests/TranslateX.ani", "Quad 2", { 0.0f, 1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, 2.0f);
+    cache->AddManualResource(animationRotate);
+    cache->AddManualResource(animationTranslateX);
+
+    auto scene = MakeShared<Scene>(context);
+    scene->CreateComponent<Octree>();
+
+    auto node = scene->CreateChild("Node");
+    node->SetPosition({ 1.0f, 0.0f, 2.0f });
+    auto animatedModel = node->CreateComponent<AnimatedModel>();
+    animatedModel->SetModel(model);
+
+    auto animationController = node->CreateComponent<AnimationController>();
+    animationController->Play("Tests/Rotate.ani", 0, true);
+    animationController->Play("Tests/TranslateX.ani", 0, true);
+
+    const ea::vector<Bone>& bones = animatedModel->GetSkeleton().GetBones();
+    const unsigned numBones = bones.size();
+    const Matrix3x4* skinMatrices = animatedModel->GetBatches()[0].worldTransform_;
+    FrameInfo frameInfo;
+
+    static const unsigned numThreads = 4;
+    for (unsigned frame = 0; frame < 50; ++frame)
+    {
+        // Pose is evaluated, but not written to bone nodes yet
+        Tests::RunFrame(context, 0.05f);
+
+        // Read bone nodes from several threads, one of them also updates skinning
+        std::atomic<unsigned> numStartedThreads{};
+        ea::vector<ea::vector<Matrix3x4>> actualTransforms(numThreads);
+        std::vector<std::thread> threads;
+        for (unsigned threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+        {
+            threads.emplace_back([&, threadIndex]
+            {
+                ++numStartedThreads;
+                while (numStartedThreads.load() != numThreads)
+                    ;
+
+                if (threadIndex == 0)
+                    animatedModel->UpdateGeometry(frameInfo);
+                for (unsigned i = numBones; i-- > 0;)
+                    actualTransforms[threadIndex].push_back(bones[i].node_->GetWorldTransform());
+            });
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+
+        const ea::vector<Matrix3x4> actualSkinMatrices(skinMatrices, skinMatrices + numBones);
+
+        // Assert
+        const ea::vector<Matrix3x4> expectedTransforms = ApplyAnimationToBoneNodes(animatedModel, M_MAX_UNSIGNED);
+        for (unsigned i = 0; i < numBones; ++i)
+        {
+            for (unsigned threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+                CHECK(actualTransforms[threadIndex][numBones - 1 - i].Equals(expectedTransforms[i], M_LARGE_EPSILON));
+            CHECK(actualSkinMatrices[i].Equals(expectedTransforms[i] * bones[i].offsetMatrix_, M_LARGE_EPSILON));
+        }
+    }
+}
+
 TEST_CASE("Variant animation tracks")
 {
     auto context = Tests::CreateCompleteTestContext();
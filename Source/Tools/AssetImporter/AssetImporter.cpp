@@ -164,6 +164,7 @@ bool noOverwriteTexture_ = false;
 bool noOverwriteNewerTexture_ = false;
 bool checkUniqueModel_ = true;
 bool moveToBindPose_ = false;
+bool compressAnimations_ = false;
 unsigned maxBones_ = 64;
 ea::vector<ea::string> nonSkinningBoneIncludes_;
 ea::vector<ea::string> nonSkinningBoneExcludes_;
@@ -305,6 +306,7 @@ void Run(const ea::vector<ea::string>& arguments)
             "-ctn        Check and do not overwrite if texture has newer timestamp\n"
             "-am         Export all meshes even if identical (scene mode only)\n"
             "-bp         Move bones to bind pose before saving model\n"
+            "-ca         Compress animations: quantize rotations and remove redundant keyframes\n"
             "-split <start> <end> (animation model only)\n"
             "            Split animation, will only import from start frame to end frame\n"
             "-np         Do not suppress $fbx pivot nodes (FBX files only)\n"
@@ -463,6 +465,8 @@ void Run(const ea::vector<ea::string>& arguments)
                 checkUniqueModel_ = false;
             else if (argument == "bp")
                 moveToBindPose_ = true;
+            else if (argument == "ca")
+                compressAnimations_ = true;
             else if (argument == "split")
             {
                 ea::string value2 = i + 2 < arguments.size() ? arguments[i + 2] : EMPTY_STRING;
@@ -1496,6 +1500,12 @@ void BuildAndSaveAnimations(OutModel* model)
             }
         }
 
+        if (compressAnimations_)
+        {
+            outAnim->Compress();
+            PrintLine("Compressed animation " + animName + " to " + ea::to_string(outAnim->GetCompressedData()->GetNumKeys()) + " keys");
+        }
+
         File outFile(context_);
         if (!outFile.Open(animOutName, FILE_WRITE))
             ErrorExit("Could not open output file " + animOutName);
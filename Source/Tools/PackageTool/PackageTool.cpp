@@ -24,6 +24,7 @@
 
 #include <Urho3D/Core/Context.h>
 #include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/IO/Compression.h>
 #include <Urho3D/IO/File.h>
 #include <Urho3D/IO/FileSystem.h>
 #include <Urho3D/IO/PackageFile.h>
@@ -33,8 +34,6 @@
 #endif
 
 #include <EASTL/unique_ptr.h>
-#include <LZ4/lz4.h>
-#include <LZ4/lz4hc.h>
 
 #include <Urho3D/DebugNew.h>
 
@@ -49,6 +48,7 @@ struct FileEntry
     unsigned offset_{};
     unsigned size_{};
     unsigned checksum_{};
+    ea::vector<unsigned> blockOffsets_;
 };
 
 Context* context_ = nullptr;
@@ -56,7 +56,8 @@ FileSystem* fileSystem_ = nullptr;
 ea::string basePath_;
 ea::vector<FileEntry> entries_;
 unsigned checksum_ = 0;
-bool compress_ = false;
+CompressionCodec codec_ = CompressionCodec::None;
+int64_t entriesOffset_ = 0;
 bool quiet_ = false;
 unsigned blockSize_ = COMPRESSED_BLOCK_SIZE;
 
@@ -70,6 +71,7 @@ void Run(const ea::vector<ea::string>& arguments);
 void ProcessFile(const ea::string& fileName, const ea::string& rootDir);
 void WritePackageFile(const ea::string& fileName, const ea::string& rootDir);
 void WriteHeader(File& dest);
+void WriteEntries(File& dest);
 
 int main(int argc, char** argv)
 {
@@ -97,6 +99,7 @@ void Run(const ea::vector<ea::string>& arguments)
             "\n"
             "Options:\n"
             "-c      Enable package file LZ4 compression\n"
+            "-d      Enable package file Deflate compression, smaller but slower to decompress than LZ4\n"
             "-q      Enable quiet mode\n"
             "\n"
             "Basepath is an optional prefix that will be added to the file entries.\n\n"
@@ -123,7 +126,10 @@ void Run(const ea::vector<ea::string>& arguments)
                     switch (arguments[i][1])
                     {
                     case 'c':
-                        compress_ = true;
+                        codec_ = CompressionCodec::LZ4;
+                        break;
+                    case 'd':
+                        codec_ = CompressionCodec::Deflate;
                         break;
                     case 'q':
                         quiet_ = true;
@@ -221,9 +227,19 @@ void Run(const ea::vector<ea::string>& arguments)
                     ea::string fileEntry(current->first);
                     if (outputCompressionRatio)
                     {
-                        unsigned compressedSize =
-                            (i == entries.end() ? packageFile->GetTotalSize() - sizeof(unsigned) : i->second.offset_) -
-                            current->second.offset_;
+                        unsigned compressedSize{};
+                        if (packageFile->HasBlockIndex())
+                        {
+                            const unsigned blockSize = packageFile->GetBlockSize();
+                            const unsigned numBlocks = (current->second.size_ + blockSize - 1) / blockSize;
+                            compressedSize = packageFile->GetBlockOffsets()[current->second.firstBlock_ + numBlocks];
+                        }
+                        else
+                        {
+                            compressedSize =
+                                (i == entries.end() ? packageFile->GetTotalSize() - sizeof(unsigned) : i->second.offset_) -
+                                current->second.offset_;
+                        }
                         fileEntry.append_sprintf("\tin: %u\tout: %u\tratio: %f", current->second.size_, compressedSize,
                             compressedSize ? 1.f * current->second.size_ / compressedSize : 0.f);
                     }
@@ -261,22 +277,13 @@ void WritePackageFile(const ea::string& fileName, const ea::string& rootDir)
     if (!dest.Open(fileName, FILE_WRITE))
         ErrorExit("Could not open output file " + fileName);
 
-    // Write ID, number of files & placeholder for checksum
+    // Write ID, number of files & placeholders for checksum and file list offset
     WriteHeader(dest);
 
-    for (unsigned i = 0; i < entries_.size(); ++i)
-    {
-        // Write entry (correct offset is still unknown, will be filled in later)
-        dest.WriteString(basePath_ + entries_[i].name_);
-        dest.WriteUInt(entries_[i].offset_);
-        dest.WriteUInt(entries_[i].size_);
-        dest.WriteUInt(entries_[i].checksum_);
-    }
-
     unsigned totalDataSize = 0;
     unsigned lastOffset;
 
-    // Write file data, calculate checksums & correct offsets
+    // Write file data, calculate checksums & offsets
     for (unsigned i = 0; i < entries_.size(); ++i)
     {
         lastOffset = entries_[i].offset_ = dest.GetSize();
@@ -300,7 +307,7 @@ void WritePackageFile(const ea::string& fileName, const ea::string& rootDir)
             entries_[i].checksum_ = SDBMHash(entries_[i].checksum_, buffer[j]);
         }
 
-        if (!compress_)
+        if (codec_ == CompressionCodec::None)
         {
             if (!quiet_)
                 PrintLine(entries_[i].name_ + " size " + ea::to_string(dataSize));
@@ -308,7 +315,7 @@ void WritePackageFile(const ea::string& fileName, const ea::string& rootDir)
         }
         else
         {
-            ea::unique_ptr<unsigned char[]> compressBuffer(new unsigned char[LZ4_compressBound(blockSize_)]);
+            ea::unique_ptr<unsigned char[]> compressBuffer(new unsigned char[EstimateCompressBound(blockSize_, codec_)]);
 
             unsigned pos = 0;
 
@@ -318,14 +325,17 @@ void WritePackageFile(const ea::string& fileName, const ea::string& rootDir)
                 if (pos + unpackedSize > dataSize)
                     unpackedSize = dataSize - pos;
 
-                auto packedSize = (unsigned)LZ4_compress_HC((const char*)&buffer[pos], (char*)compressBuffer.get(), unpackedSize, LZ4_compressBound(unpackedSize), 0);
+                unsigned packedSize = CompressData(compressBuffer.get(), &buffer[pos], unpackedSize, codec_);
                 if (!packedSize)
-                    ErrorExit("LZ4 compression failed for file " + entries_[i].name_ + " at offset " + ea::to_string(pos));
+                    ErrorExit("Compression failed for file " + entries_[i].name_ + " at offset " + ea::to_string(pos));
 
-                dest.WriteUShort((unsigned short)unpackedSize);
-                dest.WriteUShort((unsigned short)packedSize);
-                dest.Write(compressBuffer.get(), packedSize);
+                // Store blocks which do not benefit from compression as is, equal sizes tell them apart when reading
+                if (packedSize >= unpackedSize)
+                    dest.Write(&buffer[pos], unpackedSize);
+                else
+                    dest.Write(compressBuffer.get(), packedSize);
 
+                entries_[i].blockOffsets_.push_back(dest.GetSize() - lastOffset);
                 pos += unpackedSize;
             }
 
@@ -340,38 +350,48 @@ void WritePackageFile(const ea::string& fileName, const ea::string& rootDir)
         }
     }
 
+    // Write file list after the data
+    entriesOffset_ = dest.GetSize();
+    WriteEntries(dest);
+
     // Write package size to the end of file to allow finding it linked to an executable file
     unsigned currentSize = dest.GetSize();
     dest.WriteUInt(currentSize + sizeof(unsigned));
 
-    // Write header again with correct offsets & checksums
+    // Write header again with correct checksum & file list offset
     dest.Seek(0);
     WriteHeader(dest);
 
-    for (unsigned i = 0; i < entries_.size(); ++i)
-    {
-        dest.WriteString(basePath_ + entries_[i].name_);
-        dest.WriteUInt(entries_[i].offset_);
-        dest.WriteUInt(entries_[i].size_);
-        dest.WriteUInt(entries_[i].checksum_);
-    }
-
     if (!quiet_)
     {
         PrintLine("Number of files: " + ea::to_string(entries_.size()));
         PrintLine("File data size: " + ea::to_string(totalDataSize));
         PrintLine("Package size: " + ea::to_string(dest.GetSize()));
         PrintLine("Checksum: " + ea::to_string(checksum_));
-        PrintLine("Compressed: " + ea::string(compress_ ? "yes" : "no"));
+        PrintLine("Compressed: " + ea::string(codec_ != CompressionCodec::None ? "yes" : "no"));
     }
 }
 
 void WriteHeader(File& dest)
 {
-    if (!compress_)
-        dest.WriteFileID("UPAK");
-    else
-        dest.WriteFileID("ULZ4");
+    dest.WriteFileID("RPAK");
     dest.WriteUInt(entries_.size());
     dest.WriteUInt(checksum_);
+    dest.WriteUInt(PACKAGE_VERSION_BLOCK_INDEX);
+    dest.WriteInt64(entriesOffset_);
+    dest.WriteUByte(static_cast<unsigned char>(codec_));
+    dest.WriteUInt(codec_ != CompressionCodec::None ? blockSize_ : 0);
+}
+
+void WriteEntries(File& dest)
+{
+    for (const FileEntry& entry : entries_)
+    {
+        dest.WriteString(basePath_ + entry.name_);
+        dest.WriteUInt(entry.offset_);
+        dest.WriteUInt(entry.size_);
+        dest.WriteUInt(entry.checksum_);
+        for (unsigned blockOffset : entry.blockOffsets_)
+            dest.WriteUInt(blockOffset);
+    }
 }
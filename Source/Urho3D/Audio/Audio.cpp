@@ -101,7 +101,7 @@ Audio::Audio(Context* context) :
     // Register Audio library object factories
     RegisterAudioLibrary(context_);
 
-    SubscribeToEvent(E_RENDERUPDATE, URHO3D_HANDLER(Audio, HandleRenderUpdate));
+    SubscribeToTypedEvent<RenderUpdateEventArgs>([this](const RenderUpdateEventArgs& args) { HandleRenderUpdate(args); });
 }
 
 Audio::~Audio()
@@ -407,11 +407,9 @@ void Audio::MixOutput(void* dest, unsigned samples)
     }
 }
 
-void Audio::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
+void Audio::HandleRenderUpdate(const RenderUpdateEventArgs& args)
 {
-    using namespace RenderUpdate;
-
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(args.timeStep_);
 }
 
 void Audio::Release()
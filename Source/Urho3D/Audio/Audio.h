@@ -37,6 +37,7 @@ class Microphone;
 class Sound;
 class SoundListener;
 class SoundSource;
+struct RenderUpdateEventArgs;
 
 /// %Audio subsystem.
 class URHO3D_API Audio : public Object
@@ -142,7 +143,7 @@ public:
 
 private:
     /// Handle render update event.
-    void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleRenderUpdate(const RenderUpdateEventArgs& args);
     /// Stop sound output and release the sound buffer.
     void Release();
     /// Actually update sound sources with the specific timestep. Called internally.
@@ -578,7 +578,8 @@ public:
 %ignore Urho3D::CustomGeometry::DrawOcclusion;
 %ignore Urho3D::CustomGeometry::MakeCircleGraph;
 %ignore Urho3D::CustomGeometry::ProcessRayQuery;
-%ignore Urho3D::OcclusionBufferData::dataWithSafety_;
+%ignore Urho3D::OcclusionTriangle;
+%ignore Urho3D::OcclusionBuffer::AreVisible;
 %ignore Urho3D::ScenePassInfo::batchQueue_;
 %ignore Urho3D::LightQueryResult;
 %ignore Urho3D::View::GetLightQueues;
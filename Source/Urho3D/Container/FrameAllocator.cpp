@@ -0,0 +1,242 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Container/FrameAllocator.h"
+#include "../Core/Mutex.h"
+#include "../Math/MathDefs.h"
+
+#include <atomic>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+namespace
+{
+
+class ThreadFrameArena;
+
+/// Registry of per-thread arenas.
+struct FrameAllocatorRegistry
+{
+    /// Mutex that protects registry.
+    Mutex mutex_;
+    /// Arenas of alive threads.
+    ea::vector<ThreadFrameArena*> arenas_;
+    /// Statistics of finished threads.
+    FrameAllocatorStats retiredStats_;
+    /// Total statistics at the end of previous frame.
+    FrameAllocatorStats lastTotalStats_;
+    /// Statistics of previous frame.
+    FrameAllocatorStats frameStats_;
+};
+
+/// Index of current frame.
+std::atomic<unsigned> currentFrameIndex{};
+
+FrameAllocatorRegistry& GetRegistry()
+{
+    static FrameAllocatorRegistry registry;
+    return registry;
+}
+
+void AccumulateStats(FrameAllocatorStats& dest, const FrameAllocatorStats& source)
+{
+    dest.numAllocations_ += source.numAllocations_;
+    dest.numBytes_ += source.numBytes_;
+    dest.numHeapAllocations_ += source.numHeapAllocations_;
+    dest.numHeapBytes_ += source.numHeapBytes_;
+}
+
+FrameAllocatorStats SubtractStats(const FrameAllocatorStats& lhs, const FrameAllocatorStats& rhs)
+{
+    FrameAllocatorStats result;
+    result.numAllocations_ = lhs.numAllocations_ - rhs.numAllocations_;
+    result.numBytes_ = lhs.numBytes_ - rhs.numBytes_;
+    result.numHeapAllocations_ = lhs.numHeapAllocations_ - rhs.numHeapAllocations_;
+    result.numHeapBytes_ = lhs.numHeapBytes_ - rhs.numHeapBytes_;
+    return result;
+}
+
+/// Pages of frame allocator owned by one thread.
+class ThreadFrameArena
+{
+public:
+    ThreadFrameArena()
+    {
+        FrameAllocatorRegistry& registry = GetRegistry();
+        MutexLock<Mutex> lock(registry.mutex_);
+        registry.arenas_.push_back(this);
+    }
+
+    ~ThreadFrameArena()
+    {
+        FrameAllocatorRegistry& registry = GetRegistry();
+        {
+            MutexLock<Mutex> lock(registry.mutex_);
+            registry.arenas_.erase_first(this);
+            AccumulateStats(registry.retiredStats_, GetStats());
+        }
+
+        for (const Page& page : pages_)
+            delete[] page.data_;
+    }
+
+    /// Allocate memory from current page or from new page.
+    void* Allocate(size_t size, size_t alignment, size_t offset)
+    {
+        // Pages are rewound lazily on first allocation in new frame
+        const unsigned frameIndex = currentFrameIndex.load(std::memory_order_relaxed);
+        if (frameIndex_ != frameIndex)
+        {
+            frameIndex_ = frameIndex;
+            currentPage_ = 0;
+            pageOffset_ = 0;
+        }
+
+        Increment(numAllocations_, 1);
+        Increment(numBytes_, size);
+
+        while (currentPage_ < pages_.size())
+        {
+            if (void* result = AllocateFromPage(pages_[currentPage_], size, alignment, offset))
+                return result;
+
+            ++currentPage_;
+            pageOffset_ = 0;
+        }
+
+        const size_t pageSize = ea::max<size_t>(FrameAllocator::PageSize, size + alignment + offset);
+        pages_.push_back(Page{ new unsigned char[pageSize], pageSize });
+        Increment(numHeapAllocations_, 1);
+        Increment(numHeapBytes_, pageSize);
+        return AllocateFromPage(pages_.back(), size, alignment, offset);
+    }
+
+    /// Return statistics. May be called from any thread.
+    FrameAllocatorStats GetStats() const
+    {
+        FrameAllocatorStats stats;
+        stats.numAllocations_ = numAllocations_.load(std::memory_order_relaxed);
+        stats.numBytes_ = numBytes_.load(std::memory_order_relaxed);
+        stats.numHeapAllocations_ = numHeapAllocations_.load(std::memory_order_relaxed);
+        stats.numHeapBytes_ = numHeapBytes_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    /// Page of memory.
+    struct Page
+    {
+        unsigned char* data_{};
+        size_t size_{};
+    };
+
+    /// Update counter. Only owner thread writes the counter, so atomic increment is not needed.
+    static void Increment(std::atomic<unsigned long long>& counter, size_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    /// Allocate memory from page if possible.
+    void* AllocateFromPage(const Page& page, size_t size, size_t alignment, size_t offset)
+    {
+        const auto pageBegin = reinterpret_cast<uintptr_t>(page.data_);
+        const uintptr_t begin = ((pageBegin + pageOffset_ + offset + alignment - 1) & ~(alignment - 1)) - offset;
+        if (begin + size > pageBegin + page.size_)
+            return nullptr;
+
+        pageOffset_ = begin + size - pageBegin;
+        return reinterpret_cast<void*>(begin);
+    }
+
+    /// Pages owned by thread.
+    ea::vector<Page> pages_;
+    /// Current page.
+    unsigned currentPage_{};
+    /// Offset in current page.
+    size_t pageOffset_{};
+    /// Frame index of the last allocation.
+    unsigned frameIndex_{ M_MAX_UNSIGNED };
+
+    /// Number of allocations.
+    std::atomic<unsigned long long> numAllocations_{};
+    /// Number of allocated bytes.
+    std::atomic<unsigned long long> numBytes_{};
+    /// Number of heap allocations.
+    std::atomic<unsigned long long> numHeapAllocations_{};
+    /// Number of bytes allocated from heap.
+    std::atomic<unsigned long long> numHeapBytes_{};
+};
+
+FrameAllocatorStats GetTotalStatsLocked(const FrameAllocatorRegistry& registry)
+{
+    FrameAllocatorStats stats = registry.retiredStats_;
+    for (const ThreadFrameArena* arena : registry.arenas_)
+        AccumulateStats(stats, arena->GetStats());
+    return stats;
+}
+
+}
+
+void* FrameAllocator::Allocate(size_t size, size_t alignment, size_t offset)
+{
+    static thread_local ThreadFrameArena arena;
+    return arena.Allocate(size, ea::max<size_t>(alignment, 1), offset);
+}
+
+void FrameAllocator::EndFrame()
+{
+    FrameAllocatorRegistry& registry = GetRegistry();
+    MutexLock<Mutex> lock(registry.mutex_);
+
+    const FrameAllocatorStats totalStats = GetTotalStatsLocked(registry);
+    registry.frameStats_ = SubtractStats(totalStats, registry.lastTotalStats_);
+    registry.lastTotalStats_ = totalStats;
+
+    currentFrameIndex.fetch_add(1, std::memory_order_relaxed);
+}
+
+unsigned FrameAllocator::GetFrameIndex()
+{
+    return currentFrameIndex.load(std::memory_order_relaxed);
+}
+
+FrameAllocatorStats FrameAllocator::GetFrameStats()
+{
+    FrameAllocatorRegistry& registry = GetRegistry();
+    MutexLock<Mutex> lock(registry.mutex_);
+    return registry.frameStats_;
+}
+
+FrameAllocatorStats FrameAllocator::GetTotalStats()
+{
+    FrameAllocatorRegistry& registry = GetRegistry();
+    MutexLock<Mutex> lock(registry.mutex_);
+    return GetTotalStatsLocked(registry);
+}
+
+}
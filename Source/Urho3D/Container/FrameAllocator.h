@@ -0,0 +1,92 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Urho3D.h"
+
+#include <EASTL/vector.h>
+
+#include <cstddef>
+
+namespace Urho3D
+{
+
+/// Statistics of frame allocator.
+struct FrameAllocatorStats
+{
+    /// Number of allocations served.
+    unsigned long long numAllocations_{};
+    /// Number of bytes served.
+    unsigned long long numBytes_{};
+    /// Number of pages allocated from heap.
+    unsigned long long numHeapAllocations_{};
+    /// Number of bytes allocated from heap.
+    unsigned long long numHeapBytes_{};
+};
+
+/// Frame-scoped linear allocator. Each thread allocates from its own pages without synchronization.
+/// Memory is released at once when the frame ends, pages are reused in the next frame.
+/// Allocated memory must not be accessed after the end of the frame.
+class URHO3D_API FrameAllocator
+{
+public:
+    /// Default size of allocator page.
+    static const unsigned PageSize = 64 * 1024;
+
+    /// Construct. Name is ignored.
+    explicit FrameAllocator(const char* /*name*/ = nullptr) {}
+
+    /// Allocate memory for current frame.
+    void* allocate(size_t n, int /*flags*/ = 0) { return Allocate(n, alignof(std::max_align_t), 0); }
+    /// Allocate aligned memory for current frame.
+    void* allocate(size_t n, size_t alignment, size_t offset, int /*flags*/ = 0) { return Allocate(n, alignment, offset); }
+    /// Deallocate memory. No-op, memory is released when the frame ends.
+    void deallocate(void* /*p*/, size_t /*n*/) {}
+
+    /// Return name of allocator.
+    const char* get_name() const { return "FrameAllocator"; }
+    /// Set name of allocator. Ignored.
+    void set_name(const char* /*name*/) {}
+
+    /// Allocate memory for current frame. Pointer + offset is aligned to alignment.
+    static void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t), size_t offset = 0);
+    /// End current frame. Memory allocated by all threads during current frame becomes invalid.
+    static void EndFrame();
+    /// Return index of current frame.
+    static unsigned GetFrameIndex();
+
+    /// Return statistics of the previous frame.
+    static FrameAllocatorStats GetFrameStats();
+    /// Return total statistics since startup.
+    static FrameAllocatorStats GetTotalStats();
+};
+
+/// All frame allocators are interchangeable.
+inline bool operator==(const FrameAllocator& /*lhs*/, const FrameAllocator& /*rhs*/) { return true; }
+inline bool operator!=(const FrameAllocator& /*lhs*/, const FrameAllocator& /*rhs*/) { return false; }
+
+/// Vector allocated in frame memory. Use reset_lose_memory() instead of clear() to reuse the vector in the next frame.
+template <class T> using FrameVector = ea::vector<T, FrameAllocator>;
+
+}
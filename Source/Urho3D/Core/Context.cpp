@@ -157,6 +157,9 @@ Context::Context() :
 
 Context::~Context()
 {
+    // Release senders of pending events while subsystems are still alive
+    postedEvents_.Clear();
+
 #ifndef MINI_URHO
     // Destroying resource cache does clear it, however some resources depend on resource cache being available when
     // destructor executes.
@@ -492,6 +495,26 @@ void Context::AddEventReceiver(Object* receiver, Object* sender, StringHash even
     if (!group)
         group = new EventReceiverGroup();
     group->Add(receiver);
+    sender->hasSpecificEventReceivers_ = true;
+}
+
+TypedEventReceivers& Context::GetTypedEventReceivers(unsigned index, StringHash eventType)
+{
+    if (index >= typedEventReceivers_.size())
+        typedEventReceivers_.resize(index + 1);
+
+    TypedEventReceivers& receivers = typedEventReceivers_[index];
+    if (!receivers.receivers_)
+    {
+        receivers.receivers_ = MakeShared<TypedEventReceiverGroup>();
+
+        // Group of non-specific receivers is never removed, so it's safe to keep it
+        SharedPtr<EventReceiverGroup>& legacyReceivers = eventReceivers_[eventType];
+        if (!legacyReceivers)
+            legacyReceivers = new EventReceiverGroup();
+        receivers.legacyReceivers_ = legacyReceivers;
+    }
+    return receivers;
 }
 
 void Context::RemoveEventSender(Object* sender)
@@ -523,9 +546,18 @@ void Context::RemoveEventReceiver(Object* receiver, StringHash eventType)
 
 void Context::RemoveEventReceiver(Object* receiver, Object* sender, StringHash eventType)
 {
-    EventReceiverGroup* group = GetEventReceivers(sender, eventType);
-    if (group)
-        group->Remove(receiver);
+    auto i = specificEventReceivers_.find(sender);
+    if (i == specificEventReceivers_.end())
+        return;
+
+    auto j = i->second.find(eventType);
+    if (j != i->second.end())
+        j->second->Remove(receiver);
+
+    // Typed events of the sender don't need VariantMap fallback when no specific receivers are left
+    const auto isEmpty = [](const auto& groupPair) { return groupPair.second->receivers_.empty(); };
+    if (ea::all_of(i->second.begin(), i->second.end(), isEmpty))
+        sender->hasSpecificEventReceivers_ = false;
 }
 
 void Context::BeginSendEvent(Object* sender, StringHash eventType)
@@ -65,6 +65,15 @@ private:
     bool dirty_;
 };
 
+/// Receivers of typed event.
+struct TypedEventReceivers
+{
+    /// Receivers subscribed to typed event.
+    SharedPtr<TypedEventReceiverGroup> receivers_;
+    /// Receivers subscribed to the same event via VariantMap.
+    SharedPtr<EventReceiverGroup> legacyReceivers_;
+};
+
 /// Urho3D execution context. Provides access to subsystems, object factories and attributes, and event receivers.
 class URHO3D_API Context : public RefCounted
 {
@@ -213,6 +222,11 @@ public:
             return nullptr;
     }
 
+    /// Send events posted from any thread since the last dispatch. Should be called from the main thread.
+    void DispatchPostedEvents() { postedEvents_.Dispatch(); }
+    /// Return queue of posted events.
+    const PostedEventQueue& GetPostedEvents() const { return postedEvents_; }
+
     /// Return event receivers for an event type, or null if they do not exist.
     EventReceiverGroup* GetEventReceivers(StringHash eventType)
     {
@@ -232,6 +246,8 @@ private:
     void RemoveEventReceiver(Object* receiver, Object* sender, StringHash eventType);
     /// Remove event receiver from non-specific events.
     void RemoveEventReceiver(Object* receiver, StringHash eventType);
+    /// Return receivers of typed event. Created on first use.
+    TypedEventReceivers& GetTypedEventReceivers(unsigned index, StringHash eventType);
     /// Begin event send.
     void BeginSendEvent(Object* sender, StringHash eventType);
     /// End event send. Clean up event receivers removed in the meanwhile.
@@ -252,6 +268,10 @@ private:
     ea::unordered_map<StringHash, SharedPtr<EventReceiverGroup> > eventReceivers_;
     /// Event receivers for specific senders' events.
     ea::unordered_map<Object*, ea::unordered_map<StringHash, SharedPtr<EventReceiverGroup> > > specificEventReceivers_;
+    /// Receivers of typed events, indexed by typed event index.
+    ea::vector<TypedEventReceivers> typedEventReceivers_;
+    /// Events posted from any thread.
+    PostedEventQueue postedEvents_;
     /// Event sender stack.
     ea::vector<Object*> eventSenders_;
     /// Event data stack.
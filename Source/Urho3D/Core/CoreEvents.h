@@ -63,4 +63,42 @@ URHO3D_EVENT(E_ENDFRAME, EndFrame)
 {
 }
 
+/// Base payload of typed update events.
+struct TimeStepEventArgs
+{
+    /// Frame time step.
+    float timeStep_{};
+
+    /// Convert to event parameters.
+    void ToVariantMap(VariantMap& eventData) const { eventData[Update::P_TIMESTEP] = timeStep_; }
+};
+
+/// Typed payload of E_UPDATE.
+struct UpdateEventArgs : public TimeStepEventArgs
+{
+    /// Return event type.
+    static StringHash GetEventType() { return E_UPDATE; }
+};
+
+/// Typed payload of E_POSTUPDATE.
+struct PostUpdateEventArgs : public TimeStepEventArgs
+{
+    /// Return event type.
+    static StringHash GetEventType() { return E_POSTUPDATE; }
+};
+
+/// Typed payload of E_RENDERUPDATE.
+struct RenderUpdateEventArgs : public TimeStepEventArgs
+{
+    /// Return event type.
+    static StringHash GetEventType() { return E_RENDERUPDATE; }
+};
+
+/// Typed payload of E_POSTRENDERUPDATE.
+struct PostRenderUpdateEventArgs : public TimeStepEventArgs
+{
+    /// Return event type.
+    static StringHash GetEventType() { return E_POSTRENDERUPDATE; }
+};
+
 }
@@ -0,0 +1,123 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Core/JobSystem.h"
+#include "../Core/Profiler.h"
+
+#include <cstring>
+#include <thread>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Number of WaitForCounter calls that are currently waiting in this thread.
+static thread_local unsigned currentWaitDepth = 0;
+
+JobSystem::JobSystem(Context* context)
+    : Object(context)
+    , workQueue_(context->GetSubsystem<WorkQueue>())
+{
+}
+
+JobSystem::~JobSystem() = default;
+
+void JobSystem::ScheduleJob(WorkFunction job, JobPriority priority, JobCounter* counter, const char* name)
+{
+    if (counter)
+        counter->Increment();
+    numScheduledJobs_.fetch_add(1, std::memory_order_relaxed);
+
+    // Execute in place if there is no work queue
+    if (!workQueue_)
+    {
+        job(0);
+        if (counter)
+            counter->Decrement();
+        return;
+    }
+
+    workQueue_->PostWorkItem([job = ea::move(job), counter, name](unsigned threadIndex)
+    {
+        // Job zone is opened in the executing thread, so zones of nested jobs executed while waiting are nested too
+        URHO3D_PROFILE("Job");
+        if (name)
+        {
+            URHO3D_PROFILE_ZONENAME(name, strlen(name));
+        }
+
+        job(threadIndex);
+        if (counter)
+            counter->Decrement();
+    }, GetWorkQueuePriority(priority));
+}
+
+void JobSystem::WaitForCounter(const JobCounter& counter, unsigned target)
+{
+    if (counter.GetValue() <= target)
+        return;
+
+    URHO3D_PROFILE("WaitForCounter");
+
+    // Main thread should not pick up long background work if there are worker threads
+    const bool isMainThread = WorkQueue::GetThreadIndex() == 0;
+    const unsigned priority = workQueue_ && isMainThread && workQueue_->GetNumThreads() > 0 ? M_MAX_UNSIGNED : 0;
+
+    // Jobs executed while waiting may wait too. Limit the depth of the stack, so the waiting job is resumed
+    // in reasonable time and the stack doesn't overflow. Past the limit, other threads have to finish the jobs.
+    const bool canExecute = workQueue_ && currentWaitDepth < MaxWaitDepth;
+    ++currentWaitDepth;
+    while (counter.GetValue() > target)
+    {
+        if (!canExecute || !workQueue_->TryProcessItem(priority))
+            std::this_thread::yield();
+    }
+    --currentWaitDepth;
+}
+
+void JobSystem::RunJob(WorkFunction job, JobPriority priority, const char* name)
+{
+    JobCounter counter;
+    ScheduleJob(ea::move(job), priority, &counter, name);
+    WaitForCounter(counter);
+}
+
+unsigned JobSystem::GetWorkQueuePriority(JobPriority priority)
+{
+    switch (priority)
+    {
+    case JobPriority::High:
+        return M_MAX_UNSIGNED;
+    case JobPriority::Normal:
+        return NormalPriority;
+    case JobPriority::Low:
+    default:
+        return 0;
+    }
+}
+
+}
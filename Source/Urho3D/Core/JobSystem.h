@@ -0,0 +1,111 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Core/Object.h"
+#include "../Core/WorkQueue.h"
+
+#include <atomic>
+
+namespace Urho3D
+{
+
+/// Priority of job.
+enum class JobPriority
+{
+    /// Executed as immediate work item, before any other work.
+    High,
+    /// Executed before any user work items of the WorkQueue.
+    Normal,
+    /// Executed in background together with user work items of the WorkQueue.
+    Low
+};
+
+/// Counter of unfinished jobs. Jobs may wait for counter to reach specified value.
+/// @nobind
+class URHO3D_API JobCounter : public NonCopyable
+{
+public:
+    /// Construct with initial value.
+    explicit JobCounter(unsigned value = 0) : value_(value) {}
+
+    /// Increment counter.
+    void Increment(unsigned count = 1) { value_.fetch_add(count, std::memory_order_relaxed); }
+    /// Decrement counter.
+    void Decrement() { value_.fetch_sub(1, std::memory_order_release); }
+    /// Return current value.
+    unsigned GetValue() const { return value_.load(std::memory_order_acquire); }
+
+private:
+    /// Current value.
+    std::atomic<unsigned> value_;
+};
+
+/// Job system subsystem. Jobs are executed by WorkQueue threads.
+/// Jobs may schedule other jobs and wait for them without blocking the thread:
+/// waiting thread executes other jobs until the counter reaches target value.
+class URHO3D_API JobSystem : public Object
+{
+    URHO3D_OBJECT(JobSystem, Object);
+
+public:
+    /// WorkQueue priority of Normal jobs.
+    static constexpr unsigned NormalPriority = M_MAX_UNSIGNED / 2;
+    /// Maximum number of nested waits in one thread that execute other jobs.
+    static constexpr unsigned MaxWaitDepth = 8;
+
+    /// Construct.
+    explicit JobSystem(Context* context);
+    /// Destruct.
+    ~JobSystem() override;
+
+    /// Schedule job. Counter is incremented immediately and decremented when the job is finished.
+    /// Name should be string literal, it is used as profiler zone name.
+    /// Can be called from any WorkQueue thread, including from within other jobs.
+    /// @nobind
+    void ScheduleJob(WorkFunction job, JobPriority priority = JobPriority::Normal,
+        JobCounter* counter = nullptr, const char* name = nullptr);
+    /// Wait until counter reaches target value. Current thread executes other jobs meanwhile.
+    /// Main thread executes only High priority jobs if there are worker threads.
+    /// If MaxWaitDepth waits are already nested in current thread, it yields until other threads finish the jobs.
+    /// Jobs should not nest deeper than the total capacity of all threads, otherwise they may wait forever.
+    /// @nobind
+    void WaitForCounter(const JobCounter& counter, unsigned target = 0);
+    /// Schedule job and wait until it is finished.
+    /// @nobind
+    void RunJob(WorkFunction job, JobPriority priority = JobPriority::Normal, const char* name = nullptr);
+
+    /// Return number of jobs scheduled since construction.
+    unsigned long long GetNumScheduledJobs() const { return numScheduledJobs_.load(std::memory_order_relaxed); }
+    /// Return WorkQueue priority corresponding to job priority.
+    static unsigned GetWorkQueuePriority(JobPriority priority);
+
+private:
+    /// Work queue subsystem.
+    WeakPtr<WorkQueue> workQueue_;
+    /// Number of jobs scheduled since construction.
+    std::atomic<unsigned long long> numScheduledJobs_{};
+};
+
+}
@@ -240,11 +240,31 @@ void Object::UnsubscribeFromEvent(Object* sender, StringHash eventType)
     }
 }
 
+template <class Predicate>
+void Object::RemoveTypedSubscriptions(Predicate predicate)
+{
+    for (auto iter = typedSubscriptions_.begin(); iter != typedSubscriptions_.end();)
+    {
+        // Group is expired if the sender has been destroyed
+        TypedEventReceiverGroup* group = iter->group_;
+        if (!group || predicate(*iter))
+        {
+            if (group)
+                group->Remove(this);
+            iter = typedSubscriptions_.erase(iter);
+        }
+        else
+            ++iter;
+    }
+}
+
 void Object::UnsubscribeFromEvents(Object* sender)
 {
     if (!sender)
         return;
 
+    RemoveTypedSubscriptions([sender](const TypedSubscription& subscription) { return subscription.sender_ == sender; });
+
     for (;;)
     {
         auto handler = FindSpecificEventHandler(sender);
@@ -260,6 +280,8 @@ void Object::UnsubscribeFromEvents(Object* sender)
 
 void Object::UnsubscribeFromAllEvents()
 {
+    RemoveTypedSubscriptions([](const TypedSubscription&) { return true; });
+
     for (;;)
     {
         auto handler = eventHandlers_.begin();
@@ -278,6 +300,13 @@ void Object::UnsubscribeFromAllEvents()
 
 void Object::UnsubscribeFromAllEventsExcept(const ea::vector<StringHash>& exceptions, bool onlyUserData)
 {
+    // Typed subscriptions never have userdata
+    if (!onlyUserData)
+    {
+        RemoveTypedSubscriptions([&exceptions](const TypedSubscription& subscription)
+            { return !exceptions.contains(subscription.eventType_); });
+    }
+
     for (auto handler = eventHandlers_.begin(); handler != eventHandlers_.end(); )
     {
         if ((!onlyUserData || handler->GetUserData()) && !exceptions.contains(handler->GetEventType()))
@@ -296,6 +325,13 @@ void Object::UnsubscribeFromAllEventsExcept(const ea::vector<StringHash>& except
 
 void Object::UnsubscribeFromAllEventsExcept(const ea::vector<Object*>& exceptions, bool onlyUserData)
 {
+    // Typed subscriptions never have userdata
+    if (!onlyUserData)
+    {
+        RemoveTypedSubscriptions([&exceptions](const TypedSubscription& subscription)
+            { return !exceptions.contains(subscription.sender_); });
+    }
+
     for (auto handler = eventHandlers_.begin(); handler != eventHandlers_.end(); )
     {
         if ((!onlyUserData || handler->GetUserData()) && !exceptions.contains(handler->GetSender()))
@@ -401,6 +437,102 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
     context->EndSendEvent();
 }
 
+void Object::SubscribeToTypedEvent(Object* sender, unsigned index, StringHash eventType, TypedEventHandler handler)
+{
+    TypedEventReceiverGroup* group = nullptr;
+    if (sender)
+    {
+        group = sender->GetTypedEventReceivers(index);
+        if (!group)
+        {
+            group = new TypedEventReceiverGroup();
+            sender->typedEventReceivers_.emplace_back(index, SharedPtr<TypedEventReceiverGroup>(group));
+        }
+    }
+    else
+        group = context_->GetTypedEventReceivers(index, eventType).receivers_;
+
+    group->Add(this, ea::move(handler));
+
+    const auto isSameGroup = [group](const TypedSubscription& subscription) { return subscription.group_ == group; };
+    if (ea::none_of(typedSubscriptions_.begin(), typedSubscriptions_.end(), isSameGroup))
+        typedSubscriptions_.push_back(TypedSubscription{ WeakPtr<TypedEventReceiverGroup>(group), sender, eventType });
+}
+
+void Object::UnsubscribeFromTypedEvent(Object* sender, unsigned index, StringHash eventType)
+{
+    TypedEventReceiverGroup* group = sender
+        ? sender->GetTypedEventReceivers(index)
+        : context_->GetTypedEventReceivers(index, eventType).receivers_.Get();
+    if (group)
+    {
+        RemoveTypedSubscriptions([group](const TypedSubscription& subscription)
+            { return subscription.group_ == group; });
+    }
+}
+
+void Object::SendTypedEvent(unsigned index, StringHash eventType, const void* payload,
+    void (*toVariantMap)(const void* payload, VariantMap& eventData))
+{
+    if (!Thread::IsMainThread())
+    {
+        URHO3D_LOGERROR("Sending events is only supported from the main thread");
+        return;
+    }
+
+    if (blockEvents_)
+        return;
+
+#if URHO3D_PROFILING
+    URHO3D_PROFILE_C("SendTypedEvent", PROFILER_COLOR_EVENTS);
+    const auto& eventName = GetEventNameRegister().GetString(eventType);
+    URHO3D_PROFILE_ZONENAME(eventName.c_str(), eventName.length());
+#endif
+
+    // Make a weak pointer to self to check for destruction during event handling
+    WeakPtr<Object> self(this);
+    Context* context = context_;
+
+    // Note: groups are held alive with shared ptrs, as they may get destroyed along with the sender
+    SharedPtr<TypedEventReceiverGroup> group(GetTypedEventReceivers(index));
+    const TypedEventReceivers& receivers = context->GetTypedEventReceivers(index, eventType);
+    SharedPtr<TypedEventReceiverGroup> groupNonSpec = receivers.receivers_;
+    SharedPtr<EventReceiverGroup> legacyGroup = receivers.legacyReceivers_;
+
+    context->BeginSendEvent(this, eventType);
+    const bool isAlive = (!group || group->Invoke(payload, self, nullptr))
+        && groupNonSpec->Invoke(payload, self, group);
+    context->EndSendEvent();
+
+    // Fall back to VariantMap for receivers that are not aware of the typed event
+    if (isAlive && (!legacyGroup->receivers_.empty() || hasSpecificEventReceivers_))
+    {
+        VariantMap& eventData = GetEventDataMap();
+        toVariantMap(payload, eventData);
+        SendEvent(eventType, eventData);
+    }
+}
+
+void Object::PostEvent(StringHash eventType, const VariantMap& eventData, bool coalesce)
+{
+    PostEvent(new VariantMapPostedEvent(this, eventType, eventData, coalesce));
+}
+
+void Object::PostEvent(PostedEvent* event)
+{
+    context_->postedEvents_.Post(event);
+}
+
+TypedEventReceiverGroup* Object::GetTypedEventReceivers(unsigned index) const
+{
+    for (const auto& [groupIndex, group] : typedEventReceivers_)
+    {
+        if (groupIndex == index)
+            return group;
+    }
+    return nullptr;
+}
+
 VariantMap& Object::GetEventDataMap() const
 {
     return context_->GetEventDataMap();
@@ -436,17 +568,30 @@ EventHandler* Object::GetEventHandler() const
     return context_->GetEventHandler();
 }
 
+bool Object::HasEventHandlers() const
+{
+    const auto isTypedSubscription = [](const TypedSubscription& subscription) { return !subscription.group_.Expired(); };
+    return !eventHandlers_.empty()
+        || ea::any_of(typedSubscriptions_.begin(), typedSubscriptions_.end(), isTypedSubscription);
+}
+
 bool Object::HasSubscribedToEvent(StringHash eventType) const
 {
-    return FindEventHandler(eventType) != eventHandlers_.end();
+    const auto isTypedSubscription = [eventType](const TypedSubscription& subscription)
+        { return subscription.group_ && subscription.eventType_ == eventType; };
+    return FindEventHandler(eventType) != eventHandlers_.end()
+        || ea::any_of(typedSubscriptions_.begin(), typedSubscriptions_.end(), isTypedSubscription);
 }
 
 bool Object::HasSubscribedToEvent(Object* sender, StringHash eventType) const
 {
     if (!sender)
         return false;
-    else
-        return FindSpecificEventHandler(sender, eventType) != eventHandlers_.end();
+
+    const auto isTypedSubscription = [sender, eventType](const TypedSubscription& subscription)
+        { return subscription.group_ && subscription.sender_ == sender && subscription.eventType_ == eventType; };
+    return FindSpecificEventHandler(sender, eventType) != eventHandlers_.end()
+        || ea::any_of(typedSubscriptions_.begin(), typedSubscriptions_.end(), isTypedSubscription);
 }
 
 const ea::string& Object::GetCategory() const
@@ -519,4 +664,125 @@ void Object::SendEvent(StringHash eventType, const VariantMap& eventData)
     SendEvent(eventType, eventDataCopy);
 }
 
+void TypedEventReceiverGroup::EndSendEvent()
+{
+    assert(inSend_ > 0);
+    --inSend_;
+
+    if (inSend_ == 0)
+    {
+        if (dirty_)
+        {
+            const auto isExpired = [](const TypedEventSubscription& subscription) { return !subscription.receiver_; };
+            subscriptions_.erase(ea::remove_if(subscriptions_.begin(), subscriptions_.end(), isExpired), subscriptions_.end());
+            dirty_ = false;
+        }
+
+        for (TypedEventSubscription& subscription : delayedSubscriptions_)
+        {
+            if (Object* receiver = subscription.receiver_)
+                Add(receiver, ea::move(subscription.handler_));
+        }
+        delayedSubscriptions_.clear();
+    }
+}
+
+void TypedEventReceiverGroup::Add(Object* receiver, TypedEventHandler handler)
+{
+    if (!receiver)
+        return;
+
+    // Handlers may be executing now, so don't touch the subscriptions
+    if (inSend_ > 0)
+    {
+        delayedSubscriptions_.push_back(TypedEventSubscription{ WeakPtr<Object>(receiver), ea::move(handler) });
+        return;
+    }
+
+    for (TypedEventSubscription& subscription : subscriptions_)
+    {
+        if (subscription.receiver_ == receiver)
+        {
+            subscription.handler_ = ea::move(handler);
+            return;
+        }
+    }
+
+    subscriptions_.push_back(TypedEventSubscription{ WeakPtr<Object>(receiver), ea::move(handler) });
+}
+
+void TypedEventReceiverGroup::Remove(Object* receiver)
+{
+    for (TypedEventSubscription& subscription : delayedSubscriptions_)
+    {
+        if (subscription.receiver_ == receiver)
+            subscription.receiver_ = nullptr;
+    }
+
+    for (TypedEventSubscription& subscription : subscriptions_)
+    {
+        if (subscription.receiver_ == receiver)
+        {
+            subscription.receiver_ = nullptr;
+            dirty_ = true;
+        }
+    }
+
+    if (inSend_ == 0 && dirty_)
+    {
+        ++inSend_;
+        EndSendEvent();
+    }
+}
+
+bool TypedEventReceiverGroup::Invoke(const void* payload, const WeakPtr<Object>& sender, const TypedEventReceiverGroup* skipGroup)
+{
+    BeginSendEvent();
+
+    bool isSenderAlive = true;
+    const unsigned numSubscriptions = subscriptions_.size();
+    for (unsigned i = 0; i < numSubscriptions; ++i)
+    {
+        TypedEventSubscription& subscription = subscriptions_[i];
+        Object* receiver = subscription.receiver_;
+        if (!receiver)
+        {
+            dirty_ = true;
+            continue;
+        }
+
+        // If there were specific receivers, check that the event is not sent doubly to them
+        if (receiver->GetBlockEvents() || (skipGroup && skipGroup->Contains(receiver)))
+            continue;
+
+        subscription.handler_(payload);
+
+        // If sender has been destroyed as a result of event handling, exit
+        if (sender.Expired())
+        {
+            isSenderAlive = false;
+            break;
+        }
+    }
+
+    EndSendEvent();
+    return isSenderAlive;
+}
+
+bool TypedEventReceiverGroup::Contains(Object* receiver) const
+{
+    const auto isReceiver = [receiver](const TypedEventSubscription& subscription) { return subscription.receiver_ == receiver; };
+    return ea::any_of(subscriptions_.begin(), subscriptions_.end(), isReceiver);
+}
+
+unsigned AllocateTypedEventIndex(StringHash eventType)
+{
+    static Mutex indicesMutex;
+    static ea::unordered_map<StringHash, unsigned> indices;
+
+    MutexLock lock(indicesMutex);
+    const unsigned nextIndex = indices.size();
+    return indices.emplace(eventType, nextIndex).first->second;
+}
+
 }
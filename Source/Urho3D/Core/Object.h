@@ -22,10 +22,12 @@
 
 #pragma once
 
+#include <EASTL/fixed_function.h>
 #include <EASTL/intrusive_list.h>
 
 #include "../Container/Allocator.h"
 #include "../Core/Mutex.h"
+#include "../Core/PostedEventQueue.h"
 #include "../Core/Profiler.h"
 #include "../Core/StringHashRegister.h"
 #include "../Core/SubsystemCache.h"
@@ -40,6 +42,10 @@ class Archive;
 class ArchiveBlock;
 class Context;
 class EventHandler;
+class TypedEventReceiverGroup;
+
+/// Type-erased handler of typed event. Called with pointer to event payload.
+using TypedEventHandler = ea::fixed_function<4 * sizeof(void*), void(const void*)>;
 
 /// Type info.
 /// @nobind
@@ -163,6 +169,25 @@ public:
     {
         SendEvent(eventType, GetEventDataMap().populate(args...));
     }
+    /// Subscribe to typed event that can be sent by any sender. Callback is invoked with const T&.
+    template <class T, class Callback> void SubscribeToTypedEvent(Callback callback);
+    /// Subscribe to a specific sender's typed event. Callback is invoked with const T&.
+    template <class T, class Callback> void SubscribeToTypedEvent(Object* sender, Callback callback);
+    /// Unsubscribe from typed event.
+    template <class T> void UnsubscribeFromTypedEvent();
+    /// Unsubscribe from a specific sender's typed event.
+    template <class T> void UnsubscribeFromTypedEvent(Object* sender);
+    /// Send typed event to all subscribers without heap allocations.
+    /// Subscribers of the event with VariantMap receive payload converted with T::ToVariantMap.
+    /// Typed subscribers are invoked first, VariantMap subscribers are invoked after all typed subscribers.
+    template <class T> void SendTypedEvent(const T& payload);
+    /// Post event from any thread. Event is sent from the main thread when posted events are dispatched.
+    /// Event data must not contain object pointers if posted from worker thread.
+    /// If coalesce is true, only the last of the events with the same sender and type is sent.
+    void PostEvent(StringHash eventType, const VariantMap& eventData = Variant::emptyVariantMap, bool coalesce = false);
+    /// Post typed event from any thread. Event is sent from the main thread when posted events are dispatched.
+    /// If coalesce is true, only the last of the events with the same sender and type is sent.
+    template <class T> void PostTypedEvent(const T& payload, bool coalesce = false);
 
     /// Return execution context.
     Context* GetContext() const { return context_; }
@@ -187,7 +212,7 @@ public:
     bool HasSubscribedToEvent(Object* sender, StringHash eventType) const;
 
     /// Return whether has subscribed to any event.
-    bool HasEventHandlers() const { return !eventHandlers_.empty(); }
+    bool HasEventHandlers() const;
 
     /// Template version of returning a subsystem.
     template <class T> T* GetSubsystem() const;
@@ -225,9 +250,38 @@ private:
     ea::intrusive_list<EventHandler>::iterator EraseEventHandler(ea::intrusive_list<EventHandler>::iterator handlerIter);
     /// Remove event handlers related to a specific sender.
     void RemoveEventSender(Object* sender);
+    /// Subscribe to typed event with given index. Sender is null for non-specific event.
+    void SubscribeToTypedEvent(Object* sender, unsigned index, StringHash eventType, TypedEventHandler handler);
+    /// Unsubscribe from typed event with given index. Sender is null for non-specific event.
+    void UnsubscribeFromTypedEvent(Object* sender, unsigned index, StringHash eventType);
+    /// Send typed event with given index.
+    void SendTypedEvent(unsigned index, StringHash eventType, const void* payload,
+        void (*toVariantMap)(const void* payload, VariantMap& eventData));
+    /// Return receivers of typed event sent by this object.
+    TypedEventReceiverGroup* GetTypedEventReceivers(unsigned index) const;
+    /// Remove typed subscriptions of this object that match predicate.
+    template <class Predicate> void RemoveTypedSubscriptions(Predicate predicate);
+    /// Post event to the queue of the context.
+    void PostEvent(PostedEvent* event);
 
     /// Event handlers. Sender is null for non-specific handlers.
     ea::intrusive_list<EventHandler> eventHandlers_;
+    /// Typed event subscription of this object.
+    struct TypedSubscription
+    {
+        /// Group of receivers that contains this object.
+        WeakPtr<TypedEventReceiverGroup> group_;
+        /// Sender. Null for non-specific event.
+        Object* sender_{};
+        /// Event type.
+        StringHash eventType_;
+    };
+    /// Typed event subscriptions of this object.
+    ea::vector<TypedSubscription> typedSubscriptions_;
+    /// Receivers of typed events sent by this object, indexed by typed event index.
+    ea::vector<ea::pair<unsigned, SharedPtr<TypedEventReceiverGroup>>> typedEventReceivers_;
+    /// Whether there are receivers subscribed to events of this specific object via VariantMap.
+    bool hasSpecificEventReceivers_{};
 
     /// Block object from sending and receiving any events.
     bool blockEvents_;
@@ -399,6 +453,111 @@ private:
     std::function<void(StringHash, VariantMap&)> function_;
 };
 
+/// Subscription to typed event.
+/// @nobind
+struct TypedEventSubscription
+{
+    /// Event receiver. Handler is not invoked if receiver is expired.
+    WeakPtr<Object> receiver_;
+    /// Handler.
+    TypedEventHandler handler_;
+};
+
+/// Tracking structure for typed event receivers.
+/// @nobind
+class URHO3D_API TypedEventReceiverGroup : public RefCounted
+{
+public:
+    /// Begin event send. Subscriptions added during send are delayed until the end of the send.
+    void BeginSendEvent() { ++inSend_; }
+    /// End event send. Clean up if necessary.
+    void EndSendEvent();
+    /// Add or replace subscription of receiver.
+    void Add(Object* receiver, TypedEventHandler handler);
+    /// Remove subscription of receiver.
+    void Remove(Object* receiver);
+    /// Invoke handlers. Return false if sender was destroyed during invocation.
+    bool Invoke(const void* payload, const WeakPtr<Object>& sender, const TypedEventReceiverGroup* skipGroup);
+    /// Return whether the receiver is subscribed.
+    bool Contains(Object* receiver) const;
+
+private:
+    /// Subscriptions. May contain expired subscriptions.
+    ea::vector<TypedEventSubscription> subscriptions_;
+    /// Subscriptions added during send.
+    ea::vector<TypedEventSubscription> delayedSubscriptions_;
+    /// "In send" recursion counter.
+    unsigned inSend_{};
+    /// Cleanup required flag.
+    bool dirty_{};
+};
+
+/// Return unique index of typed event with specified event type. Allocate new index on first call.
+/// Index registry is owned by the engine library, so the index is the same in all modules.
+URHO3D_API unsigned AllocateTypedEventIndex(StringHash eventType);
+
+/// Return unique index of typed event.
+/// Each module (executable, shared library or plugin) caches its own copy of the index,
+/// but the index is keyed by T::GetEventType(), so all copies are equal.
+/// Each event type should have only one payload type.
+template <class T> unsigned GetTypedEventIndex()
+{
+    static const unsigned index = AllocateTypedEventIndex(T::GetEventType());
+    return index;
+}
+
+template <class T, class Callback>
+inline void Object::SubscribeToTypedEvent(Callback callback)
+{
+    static_assert(ea::is_invocable_v<Callback, const T&>, "Callback should accept const T& as parameter");
+    SubscribeToTypedEvent(nullptr, GetTypedEventIndex<T>(), T::GetEventType(),
+        [callback](const void* payload) { callback(*static_cast<const T*>(payload)); });
+}
+
+template <class T, class Callback>
+inline void Object::SubscribeToTypedEvent(Object* sender, Callback callback)
+{
+    static_assert(ea::is_invocable_v<Callback, const T&>, "Callback should accept const T& as parameter");
+    // If a null sender was specified, the event can not be subscribed to
+    if (sender)
+    {
+        SubscribeToTypedEvent(sender, GetTypedEventIndex<T>(), T::GetEventType(),
+            [callback](const void* payload) { callback(*static_cast<const T*>(payload)); });
+    }
+}
+
+template <class T>
+inline void Object::UnsubscribeFromTypedEvent()
+{
+    UnsubscribeFromTypedEvent(nullptr, GetTypedEventIndex<T>(), T::GetEventType());
+}
+
+template <class T>
+inline void Object::UnsubscribeFromTypedEvent(Object* sender)
+{
+    if (sender)
+        UnsubscribeFromTypedEvent(sender, GetTypedEventIndex<T>(), T::GetEventType());
+}
+
+template <class T>
+inline void Object::SendTypedEvent(const T& payload)
+{
+    SendTypedEvent(GetTypedEventIndex<T>(), T::GetEventType(), &payload,
+        [](const void* payload, VariantMap& eventData) { static_cast<const T*>(payload)->ToVariantMap(eventData); });
+}
+
+template <class T>
+inline void Object::PostTypedEvent(const T& payload, bool coalesce)
+{
+    PostEvent(new TypedPostedEvent<T>(this, payload, coalesce));
+}
+
+template <class T>
+inline void TypedPostedEvent<T>::Send()
+{
+    sender_->SendTypedEvent(payload_);
+}
+
 template<typename T>
 inline void Object::SubscribeToEvent(StringHash eventType, void(T::*handler)(StringHash, VariantMap&))
 {
@@ -0,0 +1,134 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Object.h"
+#include "../Core/PostedEventQueue.h"
+#include "../Core/Profiler.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+PostedEvent::PostedEvent(Object* sender, StringHash eventType, bool coalesce)
+    : sender_(sender)
+    , eventType_(eventType)
+    , coalesce_(coalesce)
+{
+}
+
+PostedEvent::~PostedEvent() = default;
+
+VariantMapPostedEvent::VariantMapPostedEvent(Object* sender, StringHash eventType, const VariantMap& eventData, bool coalesce)
+    : PostedEvent(sender, eventType, coalesce)
+    , eventData_(eventData)
+{
+}
+
+void VariantMapPostedEvent::Send()
+{
+    sender_->SendEvent(eventType_, eventData_);
+}
+
+PostedEventQueue::~PostedEventQueue()
+{
+    Clear();
+}
+
+void PostedEventQueue::Post(PostedEvent* event)
+{
+    PostedEvent* head = head_.load(std::memory_order_relaxed);
+    do
+    {
+        event->next_ = head;
+    } while (!head_.compare_exchange_weak(head, event, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void PostedEventQueue::Dispatch()
+{
+    URHO3D_PROFILE("DispatchPostedEvents");
+
+    // Events may be posted while dispatching, so use local storage
+    ea::vector<PostedEvent*> events;
+    events.swap(events_);
+    TakeEvents(events);
+
+    // Keep only the last event among coalesced ones
+    numCoalescedEvents_ = 0;
+    coalescedEvents_.clear();
+    for (unsigned i = events.size(); i-- > 0;)
+    {
+        PostedEvent* event = events[i];
+        if (!event->coalesce_)
+            continue;
+
+        const ea::pair<Object*, StringHash> key{ event->sender_.Get(), event->eventType_ };
+        if (!coalescedEvents_.contains(key))
+            coalescedEvents_.push_back(key);
+        else
+        {
+            delete event;
+            events[i] = nullptr;
+            ++numCoalescedEvents_;
+        }
+    }
+
+    numSentEvents_ = 0;
+    for (PostedEvent*& event : events)
+    {
+        if (!event)
+            continue;
+
+        event->Send();
+        delete event;
+        event = nullptr;
+        ++numSentEvents_;
+    }
+
+    events.clear();
+    events_.swap(events);
+}
+
+void PostedEventQueue::Clear()
+{
+    ea::vector<PostedEvent*> events;
+    TakeEvents(events);
+    for (PostedEvent* event : events)
+        delete event;
+}
+
+void PostedEventQueue::TakeEvents(ea::vector<PostedEvent*>& events)
+{
+    PostedEvent* event = head_.exchange(nullptr, std::memory_order_acquire);
+    const unsigned firstIndex = events.size();
+    while (event)
+    {
+        events.push_back(event);
+        event = event->next_;
+    }
+    ea::reverse(events.begin() + firstIndex, events.end());
+}
+
+}
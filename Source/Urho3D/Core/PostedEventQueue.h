@@ -0,0 +1,141 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Container/Ptr.h"
+#include "../Core/Variant.h"
+
+#include <EASTL/vector.h>
+
+#include <atomic>
+
+namespace Urho3D
+{
+
+class Object;
+
+/// Event posted from any thread and sent later from the main thread.
+/// @nobind
+class URHO3D_API PostedEvent
+{
+    friend class PostedEventQueue;
+
+public:
+    /// Construct.
+    PostedEvent(Object* sender, StringHash eventType, bool coalesce);
+    /// Destruct.
+    virtual ~PostedEvent();
+
+    /// Send event. Called from the main thread.
+    virtual void Send() = 0;
+
+protected:
+    /// Event sender. Kept alive until the event is sent.
+    SharedPtr<Object> sender_;
+    /// Event type.
+    StringHash eventType_;
+    /// Whether only the last posted event with the same sender and type should be sent.
+    bool coalesce_{};
+
+private:
+    /// Next event in the queue.
+    PostedEvent* next_{};
+};
+
+/// Posted event with VariantMap parameters.
+/// @nobind
+class URHO3D_API VariantMapPostedEvent : public PostedEvent
+{
+public:
+    /// Construct.
+    VariantMapPostedEvent(Object* sender, StringHash eventType, const VariantMap& eventData, bool coalesce);
+
+    /// Send event.
+    void Send() override;
+
+private:
+    /// Event parameters.
+    VariantMap eventData_;
+};
+
+/// Posted event with typed payload.
+/// @nobind
+template <class T>
+class TypedPostedEvent : public PostedEvent
+{
+public:
+    /// Construct.
+    TypedPostedEvent(Object* sender, const T& payload, bool coalesce)
+        : PostedEvent(sender, T::GetEventType(), coalesce)
+        , payload_(payload)
+    {
+    }
+
+    /// Send event.
+    void Send() override;
+
+private:
+    /// Event payload.
+    T payload_;
+};
+
+/// Lock-free multi-producer queue of posted events. Events are sent in posting order from the main thread.
+/// @nobind
+class URHO3D_API PostedEventQueue
+{
+public:
+    /// Construct.
+    PostedEventQueue() = default;
+    /// Destruct. Pending events are discarded.
+    ~PostedEventQueue();
+
+    /// Post event. May be called from any thread. Queue takes ownership of the event.
+    void Post(PostedEvent* event);
+    /// Send all events posted so far. Events posted during dispatch are sent on the next dispatch.
+    void Dispatch();
+    /// Discard all pending events.
+    void Clear();
+
+    /// Return number of events sent during last dispatch.
+    unsigned GetNumSentEvents() const { return numSentEvents_; }
+    /// Return number of events skipped during last dispatch due to coalescing.
+    unsigned GetNumCoalescedEvents() const { return numCoalescedEvents_; }
+
+private:
+    /// Take all posted events in posting order.
+    void TakeEvents(ea::vector<PostedEvent*>& events);
+
+    /// Last posted event. Events are linked in reverse posting order.
+    std::atomic<PostedEvent*> head_{};
+    /// Events being dispatched.
+    ea::vector<PostedEvent*> events_;
+    /// Sender and type of coalesced events.
+    ea::vector<ea::pair<Object*, StringHash>> coalescedEvents_;
+    /// Number of events sent during last dispatch.
+    unsigned numSentEvents_{};
+    /// Number of events coalesced during last dispatch.
+    unsigned numCoalescedEvents_{};
+};
+
+}
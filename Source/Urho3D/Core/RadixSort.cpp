@@ -0,0 +1,175 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/RadixSort.h"
+#include "../Core/WorkQueue.h"
+
+#include <EASTL/algorithm.h>
+#include <EASTL/fixed_vector.h>
+#include <EASTL/vector.h>
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+namespace
+{
+
+/// Number of bits sorted in one pass.
+const unsigned RadixBits = 8;
+/// Number of buckets in one pass.
+const unsigned RadixSize = 1u << RadixBits;
+/// Number of passes needed to sort 64-bit keys.
+const unsigned NumRadixPasses = 64 / RadixBits;
+/// Arrays smaller than this are sorted with insertion sort.
+const unsigned InsertionSortThreshold = 64;
+/// Minimum number of items processed by one parallel block.
+const unsigned MinBlockSize = 8 * 1024;
+/// Maximum number of parallel blocks.
+const unsigned MaxBlocks = 32;
+
+/// Stable insertion sort for small arrays.
+void InsertionSort(ea::span<RadixSortItem> items)
+{
+    for (unsigned i = 1; i < items.size(); ++i)
+    {
+        const RadixSortItem item = items[i];
+        unsigned j = i;
+        for (; j > 0 && items[j - 1].key_ > item.key_; --j)
+            items[j] = items[j - 1];
+        items[j] = item;
+    }
+}
+
+unsigned GetDigit(unsigned long long key, unsigned shift) { return static_cast<unsigned>(key >> shift) & (RadixSize - 1); }
+
+}
+
+void RadixSort(ea::span<RadixSortItem> items, ea::span<RadixSortItem> buffer, WorkQueue* workQueue)
+{
+    const unsigned numItems = items.size();
+    if (numItems < InsertionSortThreshold)
+    {
+        InsertionSort(items);
+        return;
+    }
+
+    assert(buffer.size() >= numItems);
+
+    // Split items into fixed blocks, each block keeps its own histogram so blocks can be scattered independently
+    const unsigned numThreads = workQueue ? workQueue->GetNumThreads() + 1 : 1;
+    const unsigned maxBlocks = numThreads > 1 ? ea::min(MaxBlocks, 2 * numThreads) : 1;
+    const unsigned numBlocks = ea::clamp(numItems / MinBlockSize, 1u, maxBlocks);
+    const unsigned blockSize = (numItems + numBlocks - 1) / numBlocks;
+
+    const auto forEachBlock = [&](const auto& callback)
+    {
+        const auto processBlocks = [&](unsigned beginBlock, unsigned endBlock)
+        {
+            for (unsigned blockIndex = beginBlock; blockIndex < endBlock; ++blockIndex)
+            {
+                const unsigned beginIndex = blockIndex * blockSize;
+                const unsigned endIndex = ea::min(beginIndex + blockSize, numItems);
+                callback(blockIndex, beginIndex, endIndex);
+            }
+        };
+
+        if (numBlocks > 1)
+            ForEachParallel(workQueue, 1, numBlocks, processBlocks);
+        else
+            processBlocks(0, 1);
+    };
+
+    // Find bytes that are equal in all keys, sorting by them is no-op
+    ea::fixed_vector<ea::pair<unsigned long long, unsigned long long>, MaxBlocks> blockBits(numBlocks);
+    forEachBlock([&](unsigned blockIndex, unsigned beginIndex, unsigned endIndex)
+    {
+        unsigned long long allBits = 0;
+        unsigned long long commonBits = ~0ull;
+        for (unsigned i = beginIndex; i < endIndex; ++i)
+        {
+            allBits |= items[i].key_;
+            commonBits &= items[i].key_;
+        }
+        blockBits[blockIndex] = { allBits, commonBits };
+    });
+
+    unsigned long long allBits = 0;
+    unsigned long long commonBits = ~0ull;
+    for (const auto& bits : blockBits)
+    {
+        allBits |= bits.first;
+        commonBits &= bits.second;
+    }
+    const unsigned long long changingBits = allBits ^ commonBits;
+
+    ea::vector<unsigned> offsets(numBlocks * RadixSize);
+    RadixSortItem* source = items.data();
+    RadixSortItem* destination = buffer.data();
+
+    for (unsigned pass = 0; pass < NumRadixPasses; ++pass)
+    {
+        const unsigned shift = pass * RadixBits;
+        if (GetDigit(changingBits, shift) == 0)
+            continue;
+
+        // Count digits in each block
+        forEachBlock([&](unsigned blockIndex, unsigned beginIndex, unsigned endIndex)
+        {
+            unsigned* counts = &offsets[blockIndex * RadixSize];
+            ea::fill_n(counts, RadixSize, 0u);
+            for (unsigned i = beginIndex; i < endIndex; ++i)
+                ++counts[GetDigit(source[i].key_, shift)];
+        });
+
+        // Convert counts to output offsets: all blocks for digit 0, then all blocks for digit 1 and so on
+        unsigned offset = 0;
+        for (unsigned digit = 0; digit < RadixSize; ++digit)
+        {
+            for (unsigned blockIndex = 0; blockIndex < numBlocks; ++blockIndex)
+            {
+                unsigned& blockOffset = offsets[blockIndex * RadixSize + digit];
+                const unsigned count = blockOffset;
+                blockOffset = offset;
+                offset += count;
+            }
+        }
+
+        // Scatter items, order within each block and across blocks is preserved
+        forEachBlock([&](unsigned blockIndex, unsigned beginIndex, unsigned endIndex)
+        {
+            unsigned* blockOffsets = &offsets[blockIndex * RadixSize];
+            for (unsigned i = beginIndex; i < endIndex; ++i)
+                destination[blockOffsets[GetDigit(source[i].key_, shift)]++] = source[i];
+        });
+
+        ea::swap(source, destination);
+    }
+
+    if (source != items.data())
+        ea::copy(source, source + numItems, items.data());
+}
+
+}
@@ -0,0 +1,49 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Urho3D.h"
+
+#include <EASTL/span.h>
+
+namespace Urho3D
+{
+
+class WorkQueue;
+
+/// Element sorted by radix sort: 64-bit key and arbitrary payload index.
+struct RadixSortItem
+{
+    /// Sorting key.
+    unsigned long long key_{};
+    /// Payload index, usually index of sorted object.
+    unsigned index_{};
+};
+
+/// Stable LSD radix sort of items by key in ascending order.
+/// Buffer is used as temporary storage and should be at least as large as items.
+/// Passes over bytes that are equal for all keys are skipped.
+/// Large arrays are sorted in parallel if WorkQueue is provided. Safe to call from WorkQueue thread.
+URHO3D_API void RadixSort(ea::span<RadixSortItem> items, ea::span<RadixSortItem> buffer, WorkQueue* workQueue = nullptr);
+
+}
@@ -22,6 +22,7 @@
 
 #include "../Precompiled.h"
 
+#include "../Container/FrameAllocator.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
 #include "../Core/Timer.h"
@@ -142,6 +143,9 @@ void Time::EndFrame()
 
         // Internal frame end event used only by the engine/tools
         SendEvent(E_ENDFRAMEPRIVATE);
+
+        // Release transient memory of this frame
+        FrameAllocator::EndFrame();
     }
 }
 
@@ -79,6 +79,7 @@ WorkQueue::WorkQueue(Context* context) :
     maxNonThreadedWorkMs_(5)
 {
     currentThreadIndex = 0;
+    deques_.push_back(ea::make_unique<WorkStealingDeque<WorkItem*>>());
     SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(WorkQueue, HandleBeginFrame));
 }
 
@@ -104,6 +105,9 @@ void WorkQueue::CreateThreads(unsigned numThreads)
     Pause();
 
     maxThreadIndex = numThreads + 1;
+    for (unsigned i = 0; i < numThreads; ++i)
+        deques_.push_back(ea::make_unique<WorkStealingDeque<WorkItem*>>());
+
     for (unsigned i = 0; i < numThreads; ++i)
     {
         SharedPtr<WorkerThread> thread(new WorkerThread(this, i + 1));
@@ -120,8 +124,8 @@ SharedPtr<WorkItem> WorkQueue::GetFreeItem()
 {
     if (!poolItems_.empty())
     {
-        SharedPtr<WorkItem> item = poolItems_.front();
-        poolItems_.pop_front();
+        SharedPtr<WorkItem> item = ea::move(poolItems_.back());
+        poolItems_.pop_back();
         return item;
     }
     else
@@ -134,6 +138,11 @@ SharedPtr<WorkItem> WorkQueue::GetFreeItem()
 }
 
 void WorkQueue::AddWorkItem(const SharedPtr<WorkItem>& item)
+{
+    AddWorkItem(item, {});
+}
+
+void WorkQueue::AddWorkItem(const SharedPtr<WorkItem>& item, ea::span<const SharedPtr<WorkItem>> dependencies)
 {
     if (!item)
     {
@@ -148,49 +157,301 @@ void WorkQueue::AddWorkItem(const SharedPtr<WorkItem>& item)
     // Clear completed flag in case item is reused
     workItems_.push_back(item);
     item->completed_ = false;
+    item->finished_ = false;
+    item->continuations_.clear();
+    if (IsImmediate(item))
+        numPendingImmediate_.fetch_add(1, std::memory_order_relaxed);
 
-    // Make sure worker threads' list is safe to modify
-    if (threads_.size() && !paused_)
-        queueMutex_.Acquire();
+    if (RegisterDependencies(item, dependencies))
+        ScheduleItem(item, 0);
+}
 
-    // Find position for new item
-    if (queue_.empty())
-        queue_.push_back(item.Get());
-    else
+bool WorkQueue::RegisterDependencies(WorkItem* item, ea::span<const SharedPtr<WorkItem>> dependencies)
+{
+    // Hold extra dependency so the item is not scheduled until all dependencies are registered
+    item->numDependencies_.store(1, std::memory_order_relaxed);
+    for (const SharedPtr<WorkItem>& dependency : dependencies)
     {
-        bool inserted = false;
+        MutexLock<SpinLockMutex> lock(dependency->continuationsMutex_);
+        if (!dependency->finished_)
+        {
+            item->numDependencies_.fetch_add(1, std::memory_order_relaxed);
+            dependency->continuations_.push_back(item);
+        }
+    }
+
+    return item->numDependencies_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+}
+
+SharedPtr<WorkItem> WorkQueue::AddWorkItem(WorkFunction workFunction, unsigned priority)
+{
+    return AddWorkItem(ea::move(workFunction), priority, {});
+}
+
+SharedPtr<WorkItem> WorkQueue::AddWorkItem(WorkFunction workFunction, unsigned priority,
+    ea::span<const SharedPtr<WorkItem>> dependencies)
+{
+    SharedPtr<WorkItem> item = GetFreeItem();
+    item->workLambda_ = ea::move(workFunction);
+    item->workFunction_ = [](const WorkItem* item, unsigned threadIndex) { item->workLambda_(threadIndex); };
+    item->priority_ = priority;
+    AddWorkItem(item, dependencies);
+    return item;
+}
+
+SharedPtr<WorkItem> WorkQueue::ContinueWith(const SharedPtr<WorkItem>& item, WorkFunction workFunction, unsigned priority)
+{
+    return AddWorkItem(ea::move(workFunction), priority, {&item, 1});
+}
 
-        for (auto i = queue_.begin(); i != queue_.end(); ++i)
+SharedPtr<WorkItem> WorkQueue::PostWorkItem(WorkFunction workFunction, unsigned priority,
+    ea::span<const SharedPtr<WorkItem>> dependencies)
+{
+    SharedPtr<WorkItem> item = GetFreeDetachedItem();
+    item->workLambda_ = ea::move(workFunction);
+    item->workFunction_ = [](const WorkItem* item, unsigned threadIndex) { item->workLambda_(threadIndex); };
+    item->priority_ = priority;
+    if (IsImmediate(item))
+        numPendingImmediate_.fetch_add(1, std::memory_order_relaxed);
+
+    // Keep the item alive until it is executed
+    item->AddRef();
+    if (RegisterDependencies(item, dependencies))
+        ScheduleItem(item, GetThreadIndex());
+    return item;
+}
+
+SharedPtr<WorkItem> WorkQueue::GetFreeDetachedItem()
+{
+    {
+        MutexLock<SpinLockMutex> lock(detachedPoolMutex_);
+        if (!detachedPoolItems_.empty())
         {
-            if ((*i)->priority_ <= item->priority_)
-            {
-                queue_.insert(i, item.Get());
-                inserted = true;
-                break;
-            }
+            SharedPtr<WorkItem> item = ea::move(detachedPoolItems_.back());
+            detachedPoolItems_.pop_back();
+
+            // Clear state left from previous execution
+            item->completed_ = false;
+            item->finished_ = false;
+            item->continuations_.clear();
+            return item;
         }
+    }
+
+    SharedPtr<WorkItem> item(new WorkItem());
+    item->detached_ = true;
+    return item;
+}
+
+void WorkQueue::RetireDetachedItem(WorkItem* item)
+{
+    // Release captured objects right away, the item may stay in the pool for a while
+    item->workLambda_.Reset();
+
+    // Take over the reference taken when the item was posted.
+    // If nobody else references the item, it can be reused immediately.
+    // Otherwise wait until the item is released by its owner, see SweepRetiredItems.
+    SharedPtr<WorkItem> itemPtr(item);
+    item->ReleaseRef();
+
+    MutexLock<SpinLockMutex> lock(detachedPoolMutex_);
+    if (item->Refs() == 1)
+        detachedPoolItems_.push_back(ea::move(itemPtr));
+    else
+        retiredItems_.push_back(ea::move(itemPtr));
+}
 
-        if (!inserted)
-            queue_.push_back(item.Get());
+void WorkQueue::SweepRetiredItems()
+{
+    MutexLock<SpinLockMutex> lock(detachedPoolMutex_);
+
+    // Reference count cannot grow once the item is referenced only by the queue
+    unsigned numRemaining = 0;
+    for (unsigned i = 0; i < retiredItems_.size(); ++i)
+    {
+        SharedPtr<WorkItem>& item = retiredItems_[i];
+        if (item->Refs() == 1)
+            detachedPoolItems_.push_back(ea::move(item));
+        else
+        {
+            if (numRemaining != i)
+                retiredItems_[numRemaining] = ea::move(item);
+            ++numRemaining;
+        }
     }
+    retiredItems_.resize(numRemaining);
+}
 
-    if (threads_.size())
+void WorkQueue::CompleteItem(WorkItem* item)
+{
+    // Threads not owned by WorkQueue cannot execute work items, so just wait
+    const unsigned threadIndex = GetThreadIndex();
+    if (threadIndex >= deques_.size())
     {
-        queueMutex_.Release();
-        paused_ = false;
+        WaitForItem(item);
+        return;
+    }
+
+    // Without worker threads, main thread has to execute everything itself
+    if (threads_.empty())
+    {
+        while (!item->completed_)
+            TryProcessItem(0);
+        return;
+    }
+
+    // Don't pick up unrelated background work, it may take much longer than the awaited item.
+    // Items of the awaited range are immediate, lower priority item is taken only if it is awaited itself.
+    while (!item->completed_)
+    {
+        if (TryProcessItem(M_MAX_UNSIGNED))
+            continue;
+        if (!IsImmediate(item) && TakeQueuedItem(item))
+            ExecuteItem(item, threadIndex);
     }
 }
 
-SharedPtr<WorkItem> WorkQueue::AddWorkItem(std::function<void(unsigned threadIndex)> workFunction, unsigned priority)
+bool WorkQueue::TryProcessItem(unsigned priority)
 {
-    SharedPtr<WorkItem> item = GetFreeItem();
-    item->workLambda_ = std::move(workFunction);
-    item->workFunction_ = [](const WorkItem* item, unsigned threadIndex) { item->workLambda_(threadIndex); };
-    item->priority_ = priority;
-    AddWorkItem(item);
+    const unsigned threadIndex = GetThreadIndex();
+    if (threadIndex >= deques_.size())
+        return false;
+
+    // Worker threads may be paused by the main thread
+    if (threadIndex == 0 && threads_.size())
+        Resume();
+
+    if (WorkItem* item = GetImmediateItem(threadIndex))
+    {
+        ExecuteItem(item, threadIndex);
+        return true;
+    }
+
+    // Prioritized queue contains immediate items only if they are posted from threads not owned by WorkQueue
+    if (queue_.empty() || (priority == M_MAX_UNSIGNED && numQueuedImmediate_.load(std::memory_order_relaxed) == 0))
+        return false;
+
+    WorkItem* item = GetQueuedItem(priority);
+    if (!item)
+        return false;
+
+    ExecuteItem(item, threadIndex);
+    return true;
+}
+
+void WorkQueue::ScheduleItem(WorkItem* item, unsigned threadIndex)
+{
+    const bool isImmediate = IsImmediate(item);
+    if (isImmediate && threadIndex < deques_.size())
+    {
+        deques_[threadIndex]->Push(item);
+
+        // Resume worker threads if scheduled from the main thread
+        if (threadIndex == 0 && threads_.size())
+            Resume();
+        return;
+    }
+
+    // Find position for new item
+    {
+        MutexLock lock(queueMutex_);
+        auto iter = ea::find_if(queue_.begin(), queue_.end(),
+            [&](const WorkItem* queuedItem) { return queuedItem->priority_ <= item->priority_; });
+        queue_.insert(iter, item);
+        if (isImmediate)
+            numQueuedImmediate_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Resume worker threads if scheduled from the main thread
+    if (threadIndex == 0 && threads_.size())
+        Resume();
+}
+
+WorkItem* WorkQueue::GetImmediateItem(unsigned threadIndex)
+{
+    WorkItem* item = nullptr;
+    if (deques_[threadIndex]->Pop(item))
+        return item;
+
+    const unsigned numDeques = deques_.size();
+    for (unsigned i = 1; i < numDeques; ++i)
+    {
+        const unsigned victimIndex = (threadIndex + i) % numDeques;
+        if (deques_[victimIndex]->Steal(item))
+            return item;
+    }
+    return nullptr;
+}
+
+WorkItem* WorkQueue::GetQueuedItem(unsigned priority)
+{
+    MutexLock lock(queueMutex_);
+    if (queue_.empty() || queue_.front()->priority_ < priority)
+        return nullptr;
+
+    WorkItem* item = queue_.front();
+    queue_.pop_front();
+    if (IsImmediate(item))
+        numQueuedImmediate_.fetch_sub(1, std::memory_order_relaxed);
     return item;
 }
 
+bool WorkQueue::TakeQueuedItem(WorkItem* item)
+{
+    MutexLock lock(queueMutex_);
+    const auto iter = ea::find(queue_.begin(), queue_.end(), item);
+    if (iter == queue_.end())
+        return false;
+
+    queue_.erase(iter);
+    return true;
+}
+
+void WorkQueue::WaitForItem(WorkItem* item)
+{
+    // Completion is checked under the mutex, so notification cannot be missed
+    numWaitingThreads_.fetch_add(1);
+    {
+        std::unique_lock<std::mutex> lock(completionMutex_);
+        completionCondition_.wait(lock, [item] { return item->completed_.load(); });
+    }
+    numWaitingThreads_.fetch_sub(1);
+}
+
+void WorkQueue::ExecuteItem(WorkItem* item, unsigned threadIndex)
+{
+    item->workFunction_(item, threadIndex);
+
+    // Continuations cannot be added after the item is finished, so they are safe to iterate without lock
+    item->continuationsMutex_.Acquire();
+    item->finished_ = true;
+    item->continuationsMutex_.Release();
+
+    for (WorkItem* continuation : item->continuations_)
+    {
+        if (continuation->numDependencies_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            ScheduleItem(continuation, threadIndex);
+    }
+
+    // Main thread may recycle the item as soon as it is completed, don't touch it afterwards
+    const bool isImmediate = IsImmediate(item);
+    const bool isDetached = item->detached_;
+    item->completed_ = true;
+    if (isImmediate)
+        numPendingImmediate_.fetch_sub(1, std::memory_order_release);
+
+    // Wake up threads blocked in WaitForItem
+    if (numWaitingThreads_.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(completionMutex_);
+        completionCondition_.notify_all();
+    }
+
+    // Return detached item to the pool
+    if (isDetached)
+        RetireDetachedItem(item);
+}
+
 bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
 {
     if (!item)
@@ -203,10 +464,10 @@ bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
     if (i != queue_.end())
     {
         auto j = ea::find(workItems_.begin(), workItems_.end(), item);
-        if (j != workItems_.end())
+        if (j != workItems_.end() && CancelItem(item))
         {
             queue_.erase(i);
-            ReturnToPool(item);
+            ReturnToPool(*j);
             workItems_.erase(j);
             return true;
         }
@@ -226,7 +487,7 @@ unsigned WorkQueue::RemoveWorkItems(const ea::vector<SharedPtr<WorkItem> >& item
         if (j != queue_.end())
         {
             auto k = ea::find(workItems_.begin(), workItems_.end(), *i);
-            if (k != workItems_.end())
+            if (k != workItems_.end() && CancelItem(*i))
             {
                 queue_.erase(j);
                 ReturnToPool(*k);
@@ -239,13 +500,28 @@ unsigned WorkQueue::RemoveWorkItems(const ea::vector<SharedPtr<WorkItem> >& item
     return removed;
 }
 
+bool WorkQueue::CancelItem(WorkItem* item)
+{
+    if (IsImmediate(item))
+        return false;
+
+    // Dependent items would never be scheduled, so such item cannot be removed.
+    // Once removed, item is treated as finished by items added later.
+    MutexLock<SpinLockMutex> lock(item->continuationsMutex_);
+    if (!item->continuations_.empty())
+        return false;
+
+    item->finished_ = true;
+    return true;
+}
+
 void WorkQueue::Pause()
 {
     if (!paused_)
     {
         pausing_ = true;
 
-        queueMutex_.Acquire();
+        pauseMutex_.Acquire();
         paused_ = true;
 
         pausing_ = false;
@@ -256,7 +532,7 @@ void WorkQueue::Resume()
 {
     if (paused_)
     {
-        queueMutex_.Release();
+        pauseMutex_.Release();
         paused_ = false;
     }
 }
@@ -271,42 +547,25 @@ void WorkQueue::Complete(unsigned priority)
         Resume();
 
         // Take work items also in the main thread until queue empty or no high-priority items anymore
-        while (!queue_.empty())
+        while (true)
         {
-            queueMutex_.Acquire();
-            if (!queue_.empty() && queue_.front()->priority_ >= priority)
-            {
-                WorkItem* item = queue_.front();
-                queue_.pop_front();
-                queueMutex_.Release();
-                item->workFunction_(item, 0);
-                item->completed_ = true;
-            }
-            else
-            {
-                queueMutex_.Release();
-                break;
-            }
-        }
+            if (TryProcessItem(priority))
+                continue;
 
-        // Wait for threaded work to complete
-        while (!IsCompleted(priority))
-        {
+            // Wait for threaded work to complete
+            if (IsCompleted(priority))
+                break;
         }
 
-        // If no work at all remaining, pause worker threads by leaving the mutex locked
+        // If no work at all remaining, pause worker threads by leaving the pause mutex locked
         if (queue_.empty())
             Pause();
     }
     else
     {
         // No worker threads: ensure all high-priority items are completed in the main thread
-        while (!queue_.empty() && queue_.front()->priority_ >= priority)
+        while (TryProcessItem(priority))
         {
-            WorkItem* item = queue_.front();
-            queue_.pop_front();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
         }
     }
 
@@ -328,6 +587,9 @@ unsigned WorkQueue::GetNumIncomplete(unsigned priority) const
 
 bool WorkQueue::IsCompleted(unsigned priority) const
 {
+    if (priority == M_MAX_UNSIGNED)
+        return numPendingImmediate_.load(std::memory_order_acquire) == 0;
+
     for (const auto & workItem : workItems_)
     {
         if (workItem->priority_ >= priority && !workItem->completed_)
@@ -346,26 +608,27 @@ void WorkQueue::ProcessItems(unsigned threadIndex)
         if (shutDown_)
             return;
 
-        if (pausing_ && !wasActive)
+        if (WorkItem* item = GetImmediateItem(threadIndex))
+        {
+            wasActive = true;
+            ExecuteItem(item, threadIndex);
+        }
+        else if (pausing_ && !wasActive)
             Time::Sleep(0);
         else
         {
-            queueMutex_.Acquire();
-            if (!queue_.empty())
+            // Block while paused
+            pauseMutex_.Acquire();
+            pauseMutex_.Release();
+
+            if (WorkItem* item = GetQueuedItem(0))
             {
                 wasActive = true;
-
-                WorkItem* item = queue_.front();
-                queue_.pop_front();
-                queueMutex_.Release();
-                item->workFunction_(item, threadIndex);
-                item->completed_ = true;
+                ExecuteItem(item, threadIndex);
             }
             else
             {
                 wasActive = false;
-
-                queueMutex_.Release();
                 Time::Sleep(0);
             }
         }
@@ -377,24 +640,38 @@ void WorkQueue::PurgeCompleted(unsigned priority)
     // Purge completed work items and send completion events. Do not signal items lower than priority threshold,
     // as those may be user submitted and lead to eg. scene manipulation that could happen in the middle of the
     // render update, which is not allowed
-    for (auto i = workItems_.begin(); i != workItems_.end();)
+    // Compact the collection in place to keep the order of remaining items.
+    // Events are sent afterwards because handlers may queue new work items.
+    ea::vector<SharedPtr<WorkItem>> signaledItems;
+    unsigned numRemaining = 0;
+    for (unsigned i = 0; i < workItems_.size(); ++i)
     {
-        if ((*i)->completed_ && (*i)->priority_ >= priority)
+        SharedPtr<WorkItem>& item = workItems_[i];
+        if (item->completed_ && item->priority_ >= priority)
         {
-            if ((*i)->sendEvent_)
-            {
-                using namespace WorkItemCompleted;
-
-                VariantMap& eventData = GetEventDataMap();
-                eventData[P_ITEM] = i->Get();
-                SendEvent(E_WORKITEMCOMPLETED, eventData);
-            }
-
-            ReturnToPool(*i);
-            i = workItems_.erase(i);
+            if (item->sendEvent_)
+                signaledItems.push_back(ea::move(item));
+            else
+                ReturnToPool(item);
         }
         else
-            ++i;
+        {
+            if (numRemaining != i)
+                workItems_[numRemaining] = ea::move(item);
+            ++numRemaining;
+        }
+    }
+    workItems_.resize(numRemaining);
+
+    for (SharedPtr<WorkItem>& item : signaledItems)
+    {
+        using namespace WorkItemCompleted;
+
+        VariantMap& eventData = GetEventDataMap();
+        eventData[P_ITEM] = item.Get();
+        SendEvent(E_WORKITEMCOMPLETED, eventData);
+
+        ReturnToPool(item);
     }
 }
 
@@ -405,7 +682,7 @@ void WorkQueue::PurgePool()
 
     // Difference tolerance, should be fairly significant to reduce the pool size.
     for (unsigned i = 0; !poolItems_.empty() && difference > tolerance_ && i < (unsigned)difference; i++)
-        poolItems_.pop_front();
+        poolItems_.pop_back();
 
     lastSize_ = currentSize;
 }
@@ -423,6 +700,7 @@ void WorkQueue::ReturnToPool(SharedPtr<WorkItem>& item)
         item->end_ = nullptr;
         item->aux_ = nullptr;
         item->workFunction_ = nullptr;
+        item->workLambda_.Reset();
         item->priority_ = M_MAX_UNSIGNED;
         item->sendEvent_ = false;
         item->completed_ = false;
@@ -434,24 +712,90 @@ void WorkQueue::ReturnToPool(SharedPtr<WorkItem>& item)
 void WorkQueue::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
 {
     // If no worker threads, complete low-priority work here
-    if (threads_.empty() && !queue_.empty())
+    if (threads_.empty() && (!queue_.empty() || !deques_[0]->IsEmpty()))
     {
         URHO3D_PROFILE("CompleteWorkNonthreaded");
 
         HiresTimer timer;
 
-        while (!queue_.empty() && timer.GetUSec(false) < maxNonThreadedWorkMs_ * 1000LL)
+        while (timer.GetUSec(false) < maxNonThreadedWorkMs_ * 1000LL)
         {
-            WorkItem* item = queue_.front();
-            queue_.pop_front();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
+            WorkItem* item = GetImmediateItem(0);
+            if (!item)
+                item = GetQueuedItem(0);
+
+            if (!item)
+                break;
+            ExecuteItem(item, 0);
         }
     }
 
     // Complete and signal items down to the lowest priority
     PurgeCompleted(0);
     PurgePool();
+    SweepRetiredItems();
+}
+
+bool PartitionedRange::Take(unsigned workerIndex, unsigned& beginIndex, unsigned& endIndex)
+{
+    unsigned chunkIndex{};
+    bool taken = TakeChunk(workerChunks_[workerIndex], false, chunkIndex);
+
+    // Steal from the end of other blocks, so owners keep processing neighbouring chunks
+    for (unsigned i = 1; !taken && i < numWorkers_; ++i)
+    {
+        taken = TakeChunk(workerChunks_[(workerIndex + i) % numWorkers_], true, chunkIndex);
+        if (taken)
+            numStolenChunks_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (!taken)
+        return false;
+
+    beginIndex = chunkBoundaries_[chunkIndex];
+    endIndex = chunkBoundaries_[chunkIndex + 1];
+    return true;
+}
+
+void PartitionedRange::AssignChunks(unsigned numWorkers)
+{
+    numWorkers_ = ea::max(1u, numWorkers);
+    if (numWorkers_ > maxWorkers_)
+    {
+        workerChunks_ = ea::make_unique<WorkerChunks[]>(numWorkers_);
+        maxWorkers_ = numWorkers_;
+    }
+
+    const unsigned numChunks = GetNumChunks();
+    for (unsigned workerIndex = 0; workerIndex < numWorkers_; ++workerIndex)
+    {
+        const unsigned long long beginChunk = numChunks * workerIndex / numWorkers_;
+        const unsigned long long endChunk = numChunks * (workerIndex + 1) / numWorkers_;
+        workerChunks_[workerIndex].range_.store(beginChunk | (endChunk << 32u), std::memory_order_relaxed);
+    }
+
+    numStolenChunks_.store(0, std::memory_order_relaxed);
+}
+
+bool PartitionedRange::TakeChunk(WorkerChunks& chunks, bool fromEnd, unsigned& chunkIndex)
+{
+    unsigned long long range = chunks.range_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        const auto beginChunk = static_cast<unsigned>(range);
+        const auto endChunk = static_cast<unsigned>(range >> 32u);
+        if (beginChunk >= endChunk)
+            return false;
+
+        const unsigned long long newRange = fromEnd
+            ? beginChunk | (static_cast<unsigned long long>(endChunk - 1) << 32u)
+            : (beginChunk + 1) | (static_cast<unsigned long long>(endChunk) << 32u);
+        if (chunks.range_.compare_exchange_weak(range, newRange, std::memory_order_relaxed))
+        {
+            chunkIndex = fromEnd ? endChunk - 1 : beginChunk;
+            return true;
+        }
+    }
 }
 
 unsigned WorkQueue::GetThreadIndex()
@@ -24,11 +24,21 @@
 
 #include "../Core/Mutex.h"
 #include "../Core/Object.h"
+#include "../Core/Timer.h"
+#include "../Core/WorkStealingDeque.h"
 #include "../Container/MultiVector.h"
 
+#include <EASTL/algorithm.h>
+#include <EASTL/fixed_vector.h>
 #include <EASTL/list.h>
+#include <EASTL/shared_ptr.h>
 #include <EASTL/span.h>
+#include <EASTL/unique_ptr.h>
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <type_traits>
 
 namespace Urho3D
 {
@@ -41,6 +51,105 @@ URHO3D_EVENT(E_WORKITEMCOMPLETED, WorkItemCompleted)
 
 class WorkerThread;
 
+/// Type-erased work function. Small callables are stored inline without heap allocation.
+/// Signature of callable: void(unsigned threadIndex)
+/// @nobind
+class WorkFunction
+{
+public:
+    /// Size of inline storage.
+    static constexpr unsigned InlineStorageSize = 8 * sizeof(void*);
+
+    /// Construct empty.
+    WorkFunction() = default;
+
+    /// Construct from callable.
+    template <class T, class U = std::decay_t<T>, class = std::enable_if_t<
+        !std::is_same_v<U, WorkFunction> && std::is_invocable_v<U&, unsigned>>>
+    WorkFunction(T&& callable)
+    {
+        if constexpr (IsInline<U>)
+        {
+            new (storage_) U(std::forward<T>(callable));
+            invoke_ = [](void* storage, unsigned threadIndex) { (*static_cast<U*>(storage))(threadIndex); };
+            manage_ = [](void* dest, void* source)
+            {
+                if (dest)
+                    new (dest) U(std::move(*static_cast<U*>(source)));
+                static_cast<U*>(source)->~U();
+            };
+        }
+        else
+        {
+            *reinterpret_cast<U**>(storage_) = new U(std::forward<T>(callable));
+            invoke_ = [](void* storage, unsigned threadIndex) { (**static_cast<U**>(storage))(threadIndex); };
+            manage_ = [](void* dest, void* source)
+            {
+                if (dest)
+                    *static_cast<U**>(dest) = *static_cast<U**>(source);
+                else
+                    delete *static_cast<U**>(source);
+            };
+        }
+    }
+
+    /// Move-construct.
+    WorkFunction(WorkFunction&& other) noexcept { MoveFrom(other); }
+
+    /// Move-assign.
+    WorkFunction& operator=(WorkFunction&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    /// Destruct.
+    ~WorkFunction() { Reset(); }
+
+    /// Destroy stored callable.
+    void Reset()
+    {
+        if (manage_)
+            manage_(nullptr, storage_);
+        invoke_ = nullptr;
+        manage_ = nullptr;
+    }
+
+    /// Invoke stored callable.
+    void operator()(unsigned threadIndex) const { invoke_(storage_, threadIndex); }
+
+    /// Return whether the callable is stored.
+    explicit operator bool() const { return invoke_ != nullptr; }
+
+private:
+    /// Whether the callable fits into inline storage.
+    template <class U>
+    static constexpr bool IsInline = sizeof(U) <= InlineStorageSize && alignof(U) <= alignof(std::max_align_t)
+        && std::is_nothrow_move_constructible_v<U>;
+
+    /// Move callable from another function.
+    void MoveFrom(WorkFunction& other)
+    {
+        if (other.manage_)
+            other.manage_(storage_, other.storage_);
+        invoke_ = other.invoke_;
+        manage_ = other.manage_;
+        other.invoke_ = nullptr;
+        other.manage_ = nullptr;
+    }
+
+    /// Storage for callable or pointer to heap-allocated callable.
+    alignas(std::max_align_t) mutable unsigned char storage_[InlineStorageSize];
+    /// Invoke callable in storage.
+    void (*invoke_)(void* storage, unsigned threadIndex){};
+    /// Move callable to destination storage (if not null) and destroy callable in source storage.
+    void (*manage_)(void* dest, void* source){};
+};
+
 /// Work queue item.
 /// @nobind
 struct WorkItem : public RefCounted
@@ -65,11 +174,24 @@ public:
 
 private:
     bool pooled_{};
+    /// Whether the item is not tracked by the main thread. Such item is owned by the queue until executed.
+    bool detached_{};
     /// Work function. Called without any parameters.
-    std::function<void(unsigned threadIndex)> workLambda_;
+    WorkFunction workLambda_;
+    /// Number of unfinished dependencies. Item is scheduled when it reaches zero.
+    std::atomic<unsigned> numDependencies_{};
+    /// Items waiting for this item to finish.
+    ea::vector<WorkItem*> continuations_;
+    /// Whether the item is finished and continuations are no longer accepted. Protected by continuationsMutex_.
+    bool finished_{};
+    /// Mutex for continuations.
+    SpinLockMutex continuationsMutex_;
 };
 
 /// Work queue subsystem for multithreading.
+/// Items of maximum priority (M_MAX_UNSIGNED) are immediate: they are pushed into lock-free per-thread deques
+/// and executed by any thread that runs out of own work. Items of lower priority are kept in shared prioritized queue.
+/// Threads not owned by WorkQueue have no deque: their immediate items are kept in prioritized queue too.
 class URHO3D_API WorkQueue : public Object
 {
     URHO3D_OBJECT(WorkQueue, Object);
@@ -89,8 +211,24 @@ public:
     /// Add a work item and resume worker threads.
     void AddWorkItem(const SharedPtr<WorkItem>& item);
     /// Add a work item and resume worker threads.
-    SharedPtr<WorkItem> AddWorkItem(std::function<void(unsigned threadIndex)> workFunction, unsigned priority = 0);
+    SharedPtr<WorkItem> AddWorkItem(WorkFunction workFunction, unsigned priority = 0);
+    /// Add a work item that is started only after all dependencies are finished. Dependencies must be queued.
+    SharedPtr<WorkItem> AddWorkItem(WorkFunction workFunction, unsigned priority, ea::span<const SharedPtr<WorkItem>> dependencies);
+    /// Add a work item that is started only after specified item is finished.
+    SharedPtr<WorkItem> ContinueWith(const SharedPtr<WorkItem>& item, WorkFunction workFunction, unsigned priority = M_MAX_UNSIGNED);
+    /// Add work item that is not tracked by the main thread. Can be called from any thread,
+    /// including from within other work items. Such items never send completion events.
+    SharedPtr<WorkItem> PostWorkItem(WorkFunction workFunction, unsigned priority = M_MAX_UNSIGNED,
+        ea::span<const SharedPtr<WorkItem>> dependencies = {});
+    /// Wait until the work item is completed. WorkQueue thread executes other immediate work items meanwhile,
+    /// and the awaited item itself if it is queued. Other threads are blocked.
+    /// Can be called from any thread, including from within other work items.
+    void CompleteItem(WorkItem* item);
+    /// Execute one work item in the current WorkQueue thread. Immediate work items are executed first,
+    /// then work items with at least the specified priority. Return whether any work item was executed.
+    bool TryProcessItem(unsigned priority);
     /// Remove a work item before it has started executing. Return true if successfully removed.
+    /// Immediate work items, items with unfinished dependencies and items that other items depend on cannot be removed.
     bool RemoveWorkItem(SharedPtr<WorkItem> item);
     /// Remove a number of work items before they have started executing. Return the number of items successfully removed.
     unsigned RemoveWorkItems(const ea::vector<SharedPtr<WorkItem> >& items);
@@ -129,6 +267,24 @@ public:
     static unsigned GetMaxThreadIndex();
 
 private:
+    /// Return whether the work item is immediate.
+    static bool IsImmediate(const WorkItem* item) { return item->priority_ == M_MAX_UNSIGNED; }
+    /// Add a work item with dependencies.
+    void AddWorkItem(const SharedPtr<WorkItem>& item, ea::span<const SharedPtr<WorkItem>> dependencies);
+    /// Register work item as continuation of dependencies. Return whether the item has no unfinished dependencies.
+    bool RegisterDependencies(WorkItem* item, ea::span<const SharedPtr<WorkItem>> dependencies);
+    /// Schedule the work item which has no unfinished dependencies.
+    void ScheduleItem(WorkItem* item, unsigned threadIndex);
+    /// Pop immediate work item from own deque or steal it from other threads.
+    WorkItem* GetImmediateItem(unsigned threadIndex);
+    /// Pop work item with at least the specified priority from prioritized queue.
+    WorkItem* GetQueuedItem(unsigned priority);
+    /// Remove specified work item from prioritized queue. Return whether the item was queued.
+    bool TakeQueuedItem(WorkItem* item);
+    /// Block current thread until the work item is completed. Used by threads not owned by WorkQueue.
+    void WaitForItem(WorkItem* item);
+    /// Execute work item and schedule its continuations.
+    void ExecuteItem(WorkItem* item, unsigned threadIndex);
     /// Process work items until shut down. Called by the worker threads.
     void ProcessItems(unsigned threadIndex);
     /// Purge completed work items which have at least the specified priority, and send completion events as necessary.
@@ -137,24 +293,51 @@ private:
     void PurgePool();
     /// Return a work item to the pool.
     void ReturnToPool(SharedPtr<WorkItem>& item);
+    /// Get detached work item from the pool. Allocate one if no more free items. Can be called from any thread.
+    SharedPtr<WorkItem> GetFreeDetachedItem();
+    /// Return executed detached work item to the pool, or keep it until it is released by other owners.
+    void RetireDetachedItem(WorkItem* item);
+    /// Move retired detached work items that are no longer referenced outside of the queue to the pool.
+    void SweepRetiredItems();
+    /// Prepare queued work item for removal. Return false if the item cannot be removed.
+    bool CancelItem(WorkItem* item);
     /// Handle frame start event. Purge completed work from the main thread queue, and perform work if no threads at all.
     void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
 
     /// Worker threads.
     ea::vector<SharedPtr<WorkerThread> > threads_;
     /// Work item pool for reuse to cut down on allocation. The bool is a flag for item pooling and whether it is available or not.
-    ea::list<SharedPtr<WorkItem> > poolItems_;
+    ea::vector<SharedPtr<WorkItem> > poolItems_;
+    /// Detached work item pool. Accessed from any thread.
+    ea::vector<SharedPtr<WorkItem> > detachedPoolItems_;
+    /// Executed detached work items that are still referenced outside of the queue.
+    ea::vector<SharedPtr<WorkItem> > retiredItems_;
+    /// Detached work item pool mutex.
+    SpinLockMutex detachedPoolMutex_;
     /// Work item collection. Accessed only by the main thread.
-    ea::list<SharedPtr<WorkItem> > workItems_;
+    ea::vector<SharedPtr<WorkItem> > workItems_;
     /// Work item prioritized queue for worker threads. Pointers are guaranteed to be valid (point to workItems).
     ea::list<WorkItem*> queue_;
+    /// Immediate work item deques, one per thread. Index 0 is the main thread.
+    ea::vector<ea::unique_ptr<WorkStealingDeque<WorkItem*>>> deques_;
+    /// Number of immediate work items that are not completed yet.
+    std::atomic<unsigned> numPendingImmediate_{};
+    /// Number of immediate work items in prioritized queue.
+    std::atomic<unsigned> numQueuedImmediate_{};
+    /// Number of threads blocked in WaitForItem.
+    std::atomic<unsigned> numWaitingThreads_{};
+    /// Mutex and condition used to wake up blocked threads when work item is completed.
+    std::mutex completionMutex_;
+    std::condition_variable completionCondition_;
     /// Worker queue mutex.
     Mutex queueMutex_;
+    /// Pause mutex. Locked by the main thread while worker threads are paused.
+    Mutex pauseMutex_;
     /// Shutting down flag.
     std::atomic<bool> shutDown_;
-    /// Pausing flag. Indicates the worker threads should not contend for the queue mutex.
+    /// Pausing flag. Indicates the worker threads should not contend for the pause mutex.
     std::atomic<bool> pausing_;
-    /// Paused flag. Indicates the queue mutex being locked to prevent worker threads using up CPU time.
+    /// Paused flag. Indicates the pause mutex being locked to prevent worker threads using up CPU time.
     bool paused_;
     /// Completing work in the main thread flag.
     bool completing_;
@@ -193,39 +376,254 @@ public:
     }
 };
 
-/// Process arbitrary array in multiple threads. Callback is copied internally.
+/// Range of indices that is consumed in chunks by multiple threads.
+/// Chunks get smaller as the range is exhausted, and are limited so that each chunk takes about the same time.
+class AdaptiveRange
+{
+public:
+    /// Desired duration of one chunk in microseconds.
+    static constexpr float ChunkDurationUs = 25.0f;
+
+    /// Construct.
+    AdaptiveRange(unsigned size, unsigned minChunkSize, unsigned numThreads)
+        : size_(size)
+        , minChunkSize_(ea::max(1u, minChunkSize))
+        , numThreads_(numThreads)
+    {
+    }
+
+    /// Take next chunk. Return false if the range is exhausted.
+    bool Take(unsigned& beginIndex, unsigned& endIndex)
+    {
+        const unsigned offset = offset_.load(std::memory_order_relaxed);
+        if (offset >= size_)
+            return false;
+
+        // Keep enough chunks for all threads while the range is large
+        unsigned chunkSize = (size_ - offset) / (2 * numThreads_);
+
+        // Don't let the chunk take too long, otherwise threads will wait for the slowest chunk.
+        // First chunks are always small to measure the cost.
+        const float costPerElementUs = costPerElementUs_.load(std::memory_order_relaxed);
+        const float maxChunkSize = costPerElementUs > 0.0f ? ChunkDurationUs / costPerElementUs : 0.0f;
+        chunkSize = static_cast<unsigned>(ea::min(static_cast<float>(chunkSize), maxChunkSize));
+        chunkSize = ea::max(chunkSize, minChunkSize_);
+
+        beginIndex = offset_.fetch_add(chunkSize, std::memory_order_relaxed);
+        if (beginIndex >= size_)
+            return false;
+
+        endIndex = ea::min(beginIndex + chunkSize, size_);
+        return true;
+    }
+
+    /// Report time spent on processing of the chunk.
+    void ReportCost(unsigned numElements, long long durationUs)
+    {
+        // Treat chunks faster than timer resolution as taking one microsecond, the estimate will refine with larger chunks
+        const float costPerElementUs = ea::max(1.0f, static_cast<float>(durationUs)) / numElements;
+        costPerElementUs_.store(costPerElementUs, std::memory_order_relaxed);
+    }
+
+private:
+    /// Total number of elements.
+    const unsigned size_;
+    /// Minimum size of chunk.
+    const unsigned minChunkSize_;
+    /// Number of threads that consume the range.
+    const unsigned numThreads_;
+    /// Beginning of remaining range.
+    std::atomic<unsigned> offset_{};
+    /// Last measured cost of one element in microseconds. Zero if unknown.
+    std::atomic<float> costPerElementUs_{};
+};
+
+/// Range of indices split into chunks of about the same cost.
+/// Chunks are assigned to workers in contiguous blocks, so each worker processes neighbouring elements.
+/// Worker takes chunks from the beginning of its own block first, then steals chunks from the end of other blocks.
+class URHO3D_API PartitionedRange
+{
+public:
+    /// Split range into chunks for specified number of workers.
+    /// Prefix sum of element costs has one more element than the range, the first element is zero.
+    /// Chunk boundary may be moved forward by up to maxBoundaryShift elements to the index where split is allowed.
+    /// Signature of isSplitAllowed: bool(unsigned index), return whether chunk may begin at index.
+    template <class T>
+    void Partition(ea::span<const float> costPrefixSum, unsigned numWorkers, unsigned chunksPerWorker,
+        unsigned maxBoundaryShift, const T& isSplitAllowed)
+    {
+        const unsigned size = costPrefixSum.size() - 1;
+        const unsigned numChunks = ea::max(1u, ea::min(size, numWorkers * chunksPerWorker));
+        const float totalCost = costPrefixSum[size];
+
+        chunkBoundaries_.clear();
+        chunkBoundaries_.push_back(0);
+        for (unsigned chunkIndex = 1; chunkIndex < numChunks; ++chunkIndex)
+        {
+            const float targetCost = totalCost * chunkIndex / numChunks;
+            const auto iter = ea::lower_bound(costPrefixSum.begin(), costPrefixSum.end(), targetCost);
+            const unsigned index = ea::max(static_cast<unsigned>(iter - costPrefixSum.begin()), chunkBoundaries_.back() + 1);
+
+            unsigned boundary = index;
+            const unsigned maxBoundary = ea::min(index + maxBoundaryShift, size);
+            while (boundary < maxBoundary && !isSplitAllowed(boundary))
+                ++boundary;
+            if (boundary == maxBoundary)
+                boundary = index;
+
+            if (boundary >= size)
+                break;
+            chunkBoundaries_.push_back(boundary);
+        }
+        chunkBoundaries_.push_back(size);
+
+        AssignChunks(numWorkers);
+    }
+
+    /// Take next chunk for the worker. Return false if all chunks are taken.
+    bool Take(unsigned workerIndex, unsigned& beginIndex, unsigned& endIndex);
+
+    /// Return number of workers.
+    unsigned GetNumWorkers() const { return numWorkers_; }
+    /// Return number of chunks.
+    unsigned GetNumChunks() const { return chunkBoundaries_.size() - 1; }
+    /// Return number of chunks taken by workers other than their owners.
+    unsigned GetNumStolenChunks() const { return numStolenChunks_.load(std::memory_order_relaxed); }
+
+private:
+    /// Remaining chunks of the worker, packed as beginning in lower 32 bits and end in higher 32 bits.
+    struct alignas(64) WorkerChunks
+    {
+        std::atomic<unsigned long long> range_;
+    };
+
+    /// Assign chunks to workers.
+    void AssignChunks(unsigned numWorkers);
+    /// Take chunk from the beginning or the end of worker's block.
+    bool TakeChunk(WorkerChunks& chunks, bool fromEnd, unsigned& chunkIndex);
+
+    /// Indices where chunks begin, followed by the range size.
+    ea::vector<unsigned> chunkBoundaries_;
+    /// Chunks of each worker.
+    ea::unique_ptr<WorkerChunks[]> workerChunks_;
+    /// Number of workers.
+    unsigned numWorkers_{};
+    /// Number of allocated workers.
+    unsigned maxWorkers_{};
+    /// Number of stolen chunks.
+    std::atomic<unsigned> numStolenChunks_{};
+};
+
+namespace Detail
+{
+
+/// Post work items that consume adaptive range. Range should be alive until all items are completed.
+template <class RangePtr, class Callback>
+void PostAdaptiveRangeItems(WorkQueue* workQueue, unsigned numItems, const RangePtr& range, Callback& callback,
+    ea::span<const SharedPtr<WorkItem>> dependencies, ea::fixed_vector<SharedPtr<WorkItem>, 16>& items)
+{
+    for (unsigned i = 0; i < numItems; ++i)
+    {
+        items.push_back(workQueue->PostWorkItem([=](unsigned /*threadIndex*/) mutable
+        {
+            unsigned beginIndex{};
+            unsigned endIndex{};
+            while (range->Take(beginIndex, endIndex))
+            {
+                HiresTimer timer;
+                callback(beginIndex, endIndex);
+                range->ReportCost(endIndex - beginIndex, timer.GetUSec(false));
+            }
+        }, M_MAX_UNSIGNED, dependencies));
+    }
+}
+
+}
+
+/// Process arbitrary array in multiple threads asynchronously.
+/// Return work item that is completed when all elements are processed. Use WorkQueue::CompleteItem to wait for it.
+/// May be called from any thread, including WorkQueue threads, so parallel loops may be nested.
+/// Bucket is the minimum number of elements processed at once, actual chunk size adapts to cost of elements.
+/// Callback is copied internally.
 /// One copy of callback is always used by at most one thread.
 /// One copy of callback is always invoked from smaller to larger indices.
 /// Signature of callback: void(unsigned beginIndex, unsigned endIndex)
 template <class Callback>
+SharedPtr<WorkItem> ForEachParallelAsync(WorkQueue* workQueue, unsigned bucket, unsigned size, Callback callback,
+    ea::span<const SharedPtr<WorkItem>> dependencies = {})
+{
+    const unsigned numThreads = workQueue->GetNumThreads() + 1;
+    const unsigned numChunks = (size + ea::max(1u, bucket) - 1) / ea::max(1u, bucket);
+    const unsigned numItems = ea::min(numThreads, numChunks);
+    const auto range = ea::make_shared<AdaptiveRange>(size, bucket, numThreads);
+
+    ea::fixed_vector<SharedPtr<WorkItem>, 16> items;
+    Detail::PostAdaptiveRangeItems(workQueue, numItems, range, callback, dependencies, items);
+
+    // Join all items into one
+    return workQueue->PostWorkItem([](unsigned /*threadIndex*/) {}, M_MAX_UNSIGNED, {items.data(), items.size()});
+}
+
+/// Process arbitrary array in multiple threads and wait for completion.
+/// May be called from any thread, including WorkQueue threads, so parallel loops may be nested.
+/// Signature of callback: void(unsigned beginIndex, unsigned endIndex)
+template <class Callback>
 void ForEachParallel(WorkQueue* workQueue, unsigned bucket, unsigned size, Callback callback)
 {
-    // Just call in main thread
-    if (size <= bucket)
+    // Just call in current thread
+    if (size <= bucket || workQueue->GetNumThreads() == 0)
     {
         if (size > 0)
             callback(0, size);
         return;
     }
 
-    std::atomic<unsigned> offset = 0;
-    const unsigned maxThreads = workQueue->GetNumThreads() + 1;
-    for (unsigned i = 0; i < maxThreads; ++i)
+    // Range outlives the work items, so it is kept on stack and no join item is needed
+    const unsigned numThreads = workQueue->GetNumThreads() + 1;
+    const unsigned numChunks = (size + ea::max(1u, bucket) - 1) / ea::max(1u, bucket);
+    const unsigned numItems = ea::min(numThreads, numChunks);
+    AdaptiveRange range(size, bucket, numThreads);
+
+    ea::fixed_vector<SharedPtr<WorkItem>, 16> items;
+    Detail::PostAdaptiveRangeItems(workQueue, numItems, &range, callback, {}, items);
+    for (const SharedPtr<WorkItem>& item : items)
+        workQueue->CompleteItem(item);
+}
+
+/// Process partitioned range in multiple threads and wait for completion.
+/// Each worker of the range is processed by separate work item.
+/// Signature of callback: void(unsigned beginIndex, unsigned endIndex)
+template <class Callback>
+void ForEachParallel(WorkQueue* workQueue, PartitionedRange& range, Callback callback)
+{
+    const auto processChunks = [&range](unsigned workerIndex, Callback& workerCallback)
+    {
+        unsigned beginIndex{};
+        unsigned endIndex{};
+        while (range.Take(workerIndex, beginIndex, endIndex))
+            workerCallback(beginIndex, endIndex);
+    };
+
+    // Just call in current thread
+    const unsigned numWorkers = range.GetNumWorkers();
+    if (numWorkers <= 1 || workQueue->GetNumThreads() == 0)
+    {
+        for (unsigned workerIndex = 0; workerIndex < numWorkers; ++workerIndex)
+            processChunks(workerIndex, callback);
+        return;
+    }
+
+    ea::fixed_vector<SharedPtr<WorkItem>, 16> items;
+    for (unsigned workerIndex = 0; workerIndex < numWorkers; ++workerIndex)
     {
-        workQueue->AddWorkItem([=, &offset](unsigned /*threadIndex*/) mutable
+        items.push_back(workQueue->PostWorkItem([=](unsigned /*threadIndex*/) mutable
         {
-            while (true)
-            {
-                const unsigned beginIndex = offset.fetch_add(bucket, std::memory_order_relaxed);
-                if (beginIndex >= size)
-                    break;
-
-                const unsigned endIndex = ea::min(beginIndex + bucket, size);
-                callback(beginIndex, endIndex);
-            }
-        }, M_MAX_UNSIGNED);
+            processChunks(workerIndex, callback);
+        }, M_MAX_UNSIGNED));
     }
-    workQueue->Complete(M_MAX_UNSIGNED);
+
+    for (const SharedPtr<WorkItem>& item : items)
+        workQueue->CompleteItem(item);
 }
 
 /// Process collection in multiple threads.
@@ -0,0 +1,158 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <EASTL/unique_ptr.h>
+#include <EASTL/vector.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace Urho3D
+{
+
+/// Lock-free work-stealing deque (Chase-Lev).
+/// Owner thread may push and pop elements at the bottom, any other thread may steal elements from the top.
+/// T must be trivially copyable, e.g. a pointer.
+template <class T>
+class WorkStealingDeque
+{
+public:
+    /// Construct with initial capacity. Capacity must be a power of two.
+    explicit WorkStealingDeque(unsigned capacity = 256)
+    {
+        buffers_.push_back(ea::make_unique<Buffer>(capacity));
+        buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+    }
+
+    /// Push element at the bottom. Owner thread only.
+    void Push(T value)
+    {
+        const int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        const int64_t top = top_.load(std::memory_order_acquire);
+        Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+        if (bottom - top > buffer->mask_)
+            buffer = Grow(buffer, top, bottom);
+
+        buffer->Store(bottom, value);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    /// Pop element from the bottom. Owner thread only. Return false if empty.
+    bool Pop(T& value)
+    {
+        const int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_relaxed);
+
+        if (top > bottom)
+        {
+            // Empty
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        value = buffer->Load(bottom);
+        if (top == bottom)
+        {
+            // Last element, race against thieves
+            const bool won = top_.compare_exchange_strong(top, top + 1,
+                std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /// Steal element from the top. Any thread. Return false if empty or if lost the race to another thread.
+    bool Steal(T& value)
+    {
+        int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t bottom = bottom_.load(std::memory_order_acquire);
+        if (top >= bottom)
+            return false;
+
+        Buffer* buffer = buffer_.load(std::memory_order_acquire);
+        value = buffer->Load(top);
+        return top_.compare_exchange_strong(top, top + 1,
+            std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    /// Return whether the deque is empty. The result is approximate if other threads access the deque.
+    bool IsEmpty() const
+    {
+        const int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        const int64_t top = top_.load(std::memory_order_relaxed);
+        return top >= bottom;
+    }
+
+private:
+    /// Circular buffer of elements.
+    struct Buffer
+    {
+        explicit Buffer(unsigned capacity)
+            : mask_(static_cast<int64_t>(capacity) - 1)
+            , elements_(capacity)
+        {
+        }
+
+        /// Store element at index.
+        void Store(int64_t index, T value) { elements_[index & mask_].store(value, std::memory_order_relaxed); }
+        /// Load element at index.
+        T Load(int64_t index) const { return elements_[index & mask_].load(std::memory_order_relaxed); }
+
+        /// Capacity minus one.
+        const int64_t mask_;
+        /// Elements.
+        ea::vector<std::atomic<T>> elements_;
+    };
+
+    /// Replace the buffer with one of double capacity. Old buffers are kept alive because thieves may still read them.
+    Buffer* Grow(Buffer* buffer, int64_t top, int64_t bottom)
+    {
+        auto newBuffer = ea::make_unique<Buffer>(static_cast<unsigned>(buffer->mask_ + 1) * 2);
+        for (int64_t i = top; i < bottom; ++i)
+            newBuffer->Store(i, buffer->Load(i));
+
+        Buffer* result = newBuffer.get();
+        buffers_.push_back(ea::move(newBuffer));
+        buffer_.store(result, std::memory_order_release);
+        return result;
+    }
+
+    /// Index of the next element to steal.
+    alignas(64) std::atomic<int64_t> top_{};
+    /// Index of the next element to push.
+    alignas(64) std::atomic<int64_t> bottom_{};
+    /// Current buffer.
+    alignas(64) std::atomic<Buffer*> buffer_{};
+    /// All allocated buffers. Owner thread only.
+    ea::vector<ea::unique_ptr<Buffer>> buffers_;
+};
+
+}
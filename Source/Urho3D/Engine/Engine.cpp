@@ -25,6 +25,7 @@
 #include "../Audio/Audio.h"
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
+#include "../Core/JobSystem.h"
 #include "../Core/Profiler.h"
 #include "../Core/ProcessUtils.h"
 #include "../Core/Thread.h"
@@ -37,6 +38,7 @@
 #include "../Engine/Engine.h"
 #include "../Engine/EngineDefs.h"
 #include "../Engine/EventManager.h"
+#include "../Graphics/AnimationScheduler.h"
 #include "../Graphics/Graphics.h"
 #include "../Graphics/Renderer.h"
 #include "../Input/Input.h"
@@ -136,12 +138,14 @@ Engine::Engine(Context* context) :
     // Create subsystems which do not depend on engine initialization or startup parameters
     context_->RegisterSubsystem(new Time(context_));
     context_->RegisterSubsystem(new WorkQueue(context_));
+    context_->RegisterSubsystem(new JobSystem(context_));
     context_->RegisterSubsystem(new FileSystem(context_));
 #ifdef URHO3D_LOGGING
     context_->RegisterSubsystem(new Log(context_));
 #endif
     context_->RegisterSubsystem(new ResourceCache(context_));
     context_->RegisterSubsystem(new Localization(context_));
+    context_->RegisterSubsystem(new AnimationScheduler(context_));
 #ifdef URHO3D_NETWORK
     context_->RegisterSubsystem(new Network(context_));
 #endif
@@ -734,22 +738,29 @@ void Engine::Update()
 {
     URHO3D_PROFILE("Update");
 
-    // Logic update event
-    using namespace Update;
+    // Send events posted from worker threads since the last frame
+    context_->DispatchPostedEvents();
 
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_TIMESTEP] = timeStep_;
-    SendEvent(E_UPDATE, eventData);
+    // Logic update event
+    UpdateEventArgs updateArgs;
+    updateArgs.timeStep_ = timeStep_;
+    SendTypedEvent(updateArgs);
 
     // Logic post-update event
-    SendEvent(E_POSTUPDATE, eventData);
+    PostUpdateEventArgs postUpdateArgs;
+    postUpdateArgs.timeStep_ = timeStep_;
+    SendTypedEvent(postUpdateArgs);
     EventManager::GetSingleton()->DispatchDeferred();
 
     // Rendering update event
-    SendEvent(E_RENDERUPDATE, eventData);
+    RenderUpdateEventArgs renderUpdateArgs;
+    renderUpdateArgs.timeStep_ = timeStep_;
+    SendTypedEvent(renderUpdateArgs);
 
     // Post-render update event
-    SendEvent(E_POSTRENDERUPDATE, eventData);
+    PostRenderUpdateEventArgs postRenderUpdateArgs;
+    postRenderUpdateArgs.timeStep_ = timeStep_;
+    SendTypedEvent(postRenderUpdateArgs);
 }
 
 void Engine::Render()
@@ -28,6 +28,7 @@
 #include "../Core/Profiler.h"
 #include "../Graphics/AnimatedModel.h"
 #include "../Graphics/Animation.h"
+#include "../Graphics/AnimationScheduler.h"
 #include "../Graphics/AnimationState.h"
 #include "../Graphics/Batch.h"
 #include "../Graphics/Camera.h"
@@ -80,6 +81,8 @@ AnimatedModel::AnimatedModel(Context* context) :
 
 AnimatedModel::~AnimatedModel()
 {
+    UnbindBoneNodes();
+
     // When being destroyed, remove the bone hierarchy if appropriate (last AnimatedModel in the node)
     Bone* rootBone = skeleton_.GetRootBone();
     if (rootBone && rootBone->node_)
@@ -106,6 +109,7 @@ void AnimatedModel::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Shadow Distance", GetShadowDistance, SetShadowDistance, float, 0.0f, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("LOD Bias", GetLodBias, SetLodBias, float, 1.0f, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Animation LOD Bias", GetAnimationLodBias, SetAnimationLodBias, float, 1.0f, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Animation Instancing", GetAnimationInstancing, SetAnimationInstancing, bool, false, AM_DEFAULT);
     URHO3D_COPY_BASE_ATTRIBUTES(Drawable);
     URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Bone Animation Enabled", GetBonesEnabledAttr, SetBonesEnabledAttr, VariantVector,
         Variant::emptyVariantVector, AM_FILE | AM_NOEDIT);
@@ -244,13 +248,19 @@ void AnimatedModel::Update(const FrameInfo& frame)
             {
                 animationLodTimer_ = -1.0f;
                 forceAnimationUpdate_ = true;
+                if (auto scheduler = GetSubsystem<AnimationScheduler>())
+                    scheduler->ReportSkipped();
             }
             return;
         }
         float distance = frame.camera_->GetDistance(node_->GetWorldPosition());
         // If distance is greater than draw distance, no need to update at all
         if (drawDistance_ > 0.0f && distance > drawDistance_)
+        {
+            if (auto scheduler = GetSubsystem<AnimationScheduler>())
+                scheduler->ReportSkipped();
             return;
+        }
         float scale = GetWorldBoundingBox().Size().DotProduct(DOT_SCALE);
         animationLodDistance_ = frame.camera_->GetLodDistance(distance, scale, lodBias_);
     }
@@ -462,6 +472,12 @@ void AnimatedModel::SetUpdateInvisible(bool enable)
     MarkNetworkUpdate();
 }
 
+void AnimatedModel::SetAnimationInstancing(bool enable)
+{
+    animationInstancing_ = enable;
+    MarkNetworkUpdate();
+}
+
 
 void AnimatedModel::SetMorphWeight(unsigned index, float weight)
 {
@@ -613,6 +629,8 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
                 return;
         }
 
+        UnbindBoneNodes();
+
         // Notify animation controller about model change so it can reconnect tracks
         if (animationStateSource_)
             animationStateSource_->MarkAnimationStateTracksDirty();
@@ -731,26 +749,42 @@ void AnimatedModel::UpdateBoneBoundingBox()
     {
         // The bone bounding box is in local space, so need the node's inverse transform
         boneBoundingBox_.Clear();
-        Matrix3x4 inverseNodeTransform = node_->GetWorldTransform().Inverse();
 
         const ea::vector<Bone>& bones = skeleton_.GetBones();
-        for (auto i = bones.begin(); i != bones.end(); ++i)
+        if (IsBonePoseInSync() || UpdateBonePoseFromNodes())
         {
-            Node* boneNode = i->node_;
-            if (!boneNode)
-                continue;
+            // Bone transforms are already known in model space
+            const ea::vector<Matrix3x4>& boneModelTransforms = GetCurrentBoneModelTransforms();
+            for (unsigned i = 0; i < bones.size(); ++i)
+            {
+                const Bone& bone = bones[i];
+                if (bone.collisionMask_ & BONECOLLISION_BOX)
+                    boneBoundingBox_.Merge(bone.boundingBox_.Transformed(boneModelTransforms[i]));
+                else if (bone.collisionMask_ & BONECOLLISION_SPHERE)
+                    boneBoundingBox_.Merge(Sphere(boneModelTransforms[i].Translation(), bone.radius_ * 0.5f));
+            }
+        }
+        else
+        {
+            Matrix3x4 inverseNodeTransform = node_->GetWorldTransform().Inverse();
+            for (auto i = bones.begin(); i != bones.end(); ++i)
+            {
+                Node* boneNode = i->node_;
+                if (!boneNode)
+                    continue;
 
-            // Use hitbox if available. If not, use only half of the sphere radius
-            /// \todo The sphere radius should be multiplied with bone scale
-            if (i->collisionMask_ & BONECOLLISION_BOX)
-                boneBoundingBox_.Merge(i->boundingBox_.Transformed(inverseNodeTransform * boneNode->GetWorldTransform()));
-            else if (i->collisionMask_ & BONECOLLISION_SPHERE)
-                boneBoundingBox_.Merge(Sphere(inverseNodeTransform * boneNode->GetWorldPosition(), i->radius_ * 0.5f));
+                // Use hitbox if available. If not, use only half of the sphere radius
+                /// \todo The sphere radius should be multiplied with bone scale
+                if (i->collisionMask_ & BONECOLLISION_BOX)
+                    boneBoundingBox_.Merge(i->boundingBox_.Transformed(inverseNodeTransform * boneNode->GetWorldTransform()));
+                else if (i->collisionMask_ & BONECOLLISION_SPHERE)
+                    boneBoundingBox_.Merge(Sphere(inverseNodeTransform * boneNode->GetWorldPosition(), i->radius_ * 0.5f));
+            }
         }
     }
 
     boneBoundingBoxDirty_ = false;
-    worldBoundingBoxDirty_ = true;
+    MarkWorldBoundingBoxDirty();
 }
 
 void AnimatedModel::OnNodeSet(Node* node)
@@ -778,6 +812,31 @@ void AnimatedModel::OnMarkedDirty(Node* node)
     }
 }
 
+void AnimatedModel::OnNodeTransformChanged(Node* node)
+{
+    // Pose buffer no longer matches bone nodes. Bone node may be already dirty, so react as if it was marked dirty
+    bonePoseDirty_ = true;
+    OnMarkedDirty(node);
+}
+
+void AnimatedModel::WritePendingTransforms()
+{
+    const ea::vector<Bone>& bones = skeleton_.GetBones();
+    const ea::vector<Transform>& pose = GetCurrentPose();
+    if (pose.size() != bones.size())
+        return;
+
+    for (unsigned i = 0; i < bones.size(); ++i)
+    {
+        const Bone& bone = bones[i];
+        if (bone.animated_ && bone.node_)
+        {
+            const Transform& transform = pose[i];
+            WriteNodeTransform(bone.node_, transform.position_, transform.rotation_, transform.scale_);
+        }
+    }
+}
+
 void AnimatedModel::OnWorldBoundingBoxUpdate()
 {
     if (isMaster_)
@@ -805,6 +864,8 @@ void AnimatedModel::AssignBoneNodes()
     if (!node_)
         return;
 
+    UnbindBoneNodes();
+
     // Find the bone nodes from the node hierarchy and add listeners
     ea::vector<Bone>& bones = skeleton_.GetModifiableBones();
     bool boneFound = false;
@@ -963,23 +1024,81 @@ void AnimatedModel::SetGeometryBoneMappings()
 
 void AnimatedModel::UpdateAnimation(const FrameInfo& frame)
 {
+    AnimationScheduler* scheduler = GetSubsystem<AnimationScheduler>();
+    bool reducedRate = false;
+    bool firstUpdate = false;
+
     // If using animation LOD, accumulate time and see if it is time to update
     if (animationLodBias_ > 0.0f && animationLodDistance_ > 0.0f)
     {
         // Perform the first update always regardless of LOD timer
         if (animationLodTimer_ >= 0.0f)
         {
-            animationLodTimer_ += animationLodBias_ * frame.timeStep_ * ANIMATION_LOD_BASESCALE;
-            if (animationLodTimer_ >= animationLodDistance_)
-                animationLodTimer_ = fmodf(animationLodTimer_, animationLodDistance_);
-            else
+            const float timerStep = animationLodBias_ * frame.timeStep_ * ANIMATION_LOD_BASESCALE;
+            animationLodTimer_ += timerStep;
+            reducedRate = timerStep < animationLodDistance_;
+            if (animationLodTimer_ < animationLodDistance_)
+            {
+                SkipAnimationUpdate(scheduler);
+                return;
+            }
+
+            // Reduced-rate updates are limited by frame budget, but are not deferred for too long
+            if (reducedRate && scheduler
+                && !scheduler->TryAcquireEvaluation(numDeferredFrames_ >= scheduler->GetMaxDeferredFrames()))
+            {
+                ++numDeferredFrames_;
+                SkipAnimationUpdate(scheduler);
                 return;
+            }
+
+            animationLodTimer_ = fmodf(animationLodTimer_, animationLodDistance_);
         }
         else
+        {
             animationLodTimer_ = 0.0f;
+            firstUpdate = true;
+        }
     }
 
+    numDeferredFrames_ = 0;
+    if (scheduler)
+        maxEvaluatedBoneDepth_ = scheduler->GetMaxBoneDepth(animationLodDistance_);
+
     ApplyAnimation();
+    maxEvaluatedBoneDepth_ = M_MAX_UNSIGNED;
+
+    // Interpolate skinning from previous evaluation until the next one
+    if (firstUpdate || GetPreviousBoneModelTransforms().size() != GetCurrentBoneModelTransforms().size())
+    {
+        previousSharedAnimationPose_ = sharedAnimationPoseReused_ ? sharedAnimationPose_ : nullptr;
+        if (!sharedAnimationPoseReused_)
+            previousBoneModelTransforms_ = boneModelTransforms_;
+    }
+    const bool interpolate = scheduler && scheduler->GetSkinInterpolation() && reducedRate;
+    skinInterpolationFactor_ = interpolate ? Min(animationLodTimer_ / animationLodDistance_, 1.0f) : 1.0f;
+
+    // Instances that reused the pose evaluated by another instance are already reported
+    if (scheduler && !sharedAnimationPoseReused_)
+        scheduler->ReportEvaluated();
+}
+
+void AnimatedModel::SkipAnimationUpdate(AnimationScheduler* scheduler)
+{
+    if (!scheduler)
+        return;
+
+    // Skinning is updated only if interpolation actually changes it
+    const float interpolationFactor = Min(animationLodTimer_ / animationLodDistance_, 1.0f);
+    if (scheduler->GetSkinInterpolation() && interpolationFactor != skinInterpolationFactor_
+        && GetPreviousBoneModelTransforms().size() == GetCurrentBoneModelTransforms().size() && IsBonePoseInSync())
+    {
+        skinInterpolationFactor_ = interpolationFactor;
+        skinningDirty_ = true;
+        scheduler->ReportInterpolated();
+    }
+    else
+        scheduler->ReportSkipped();
 }
 
 void AnimatedModel::ApplyAnimation()
@@ -988,25 +1107,295 @@ void AnimatedModel::ApplyAnimation()
     // (first AnimatedModel in a node)
     if (isMaster_)
     {
-        skeleton_.ResetSilent();
+        // Bone nodes may take the pending pose when unbound, so bind them before the pose is replaced
+        AnimationScheduler* scheduler = animationInstancing_ ? GetSubsystem<AnimationScheduler>() : nullptr;
+        const bool poseEvaluationSupported = BindBoneNodes();
+
+        // Previous pose is not written to bone nodes, it is replaced by the new one.
+        // Bone nodes may be read from other threads meanwhile, they keep the transforms written last
+        DiscardPendingTransforms();
+
+        // Keep model-space transforms of the current pose for skinning interpolation
+        previousSharedAnimationPose_ = sharedAnimationPoseReused_ ? sharedAnimationPose_ : nullptr;
+        if (!sharedAnimationPoseReused_)
+            previousBoneModelTransforms_.swap(boneModelTransforms_);
+        sharedAnimationPoseReused_ = false;
 
-        // AnimationStateSource is a weak pointer which may or may not be an issue
-        if (AnimationStateSource* animationStateSource = animationStateSource_)
+        if (poseEvaluationSupported)
+        {
+            if (!scheduler || !ApplySharedAnimationPose(scheduler))
+            {
+                sharedAnimationPose_ = nullptr;
+                ApplyAnimationToPose();
+            }
+        }
+        else
         {
-            for (AnimationState* state : animationStateSource->GetAnimationStates())
-                state->ApplyModelTracks();
+            sharedAnimationPose_ = nullptr;
+            boneModelTransforms_.clear();
+            skeleton_.ResetSilent();
+
+            // AnimationStateSource is a weak pointer which may or may not be an issue
+            if (AnimationStateSource* animationStateSource = animationStateSource_)
+            {
+                for (AnimationState* state : animationStateSource->GetAnimationStates())
+                    state->ApplyModelTracks();
+            }
         }
 
         // Skeleton reset and animations apply the node transforms "silently" to avoid repeated marking dirty. Mark dirty now
         node_->MarkDirty();
 
-        // Calculate new bone bounding box
-        UpdateBoneBoundingBox();
+        // Calculate new bone bounding box or take the shared one
+        if (sharedAnimationPose_)
+        {
+            boneBoundingBox_ = sharedAnimationPose_->boneBoundingBox_;
+            boneBoundingBoxDirty_ = false;
+            MarkWorldBoundingBoxDirty();
+        }
+        else
+            UpdateBoneBoundingBox();
     }
 
     animationDirty_ = false;
 }
 
+bool AnimatedModel::IsPoseEvaluationSupported() const
+{
+    // Skeleton should be a valid hierarchy and bone nodes should mirror it
+    const ea::vector<Bone>& bones = skeleton_.GetBones();
+    if (skeleton_.GetBoneOrder().size() != bones.size())
+        return false;
+
+    for (unsigned i = 0; i < bones.size(); ++i)
+    {
+        const Bone& bone = bones[i];
+        if (!bone.node_)
+            return false;
+
+        Node* parentNode = bone.node_->GetParent();
+        if (parentNode != (bone.parentIndex_ == i ? node_ : bones[bone.parentIndex_].node_))
+            return false;
+    }
+    return true;
+}
+
+bool AnimatedModel::BindBoneNodes()
+{
+    // Bone nodes are checked again only if they are reassigned or changed externally
+    if (boneNodesBound_ && !bonePoseDirty_)
+        return true;
+
+    if (!IsPoseEvaluationSupported())
+    {
+        UnbindBoneNodes();
+        return false;
+    }
+
+    for (const Bone& bone : skeleton_.GetBones())
+        bone.node_->SetTransformSource(this);
+    boneNodesBound_ = true;
+    return true;
+}
+
+void AnimatedModel::UnbindBoneNodes()
+{
+    if (!boneNodesBound_)
+        return;
+
+    ApplyPendingTransforms();
+    for (const Bone& bone : skeleton_.GetBones())
+    {
+        if (bone.node_ && bone.node_->GetTransformSource() == this)
+            bone.node_->SetTransformSource(nullptr);
+    }
+    boneNodesBound_ = false;
+}
+
+bool AnimatedModel::ApplySharedAnimationPose(AnimationScheduler* scheduler)
+{
+    // Bones with animation disabled are controlled per instance
+    const ea::vector<Bone>& bones = skeleton_.GetBones();
+    for (const Bone& bone : bones)
+    {
+        if (!bone.animated_)
+            return false;
+    }
+
+    const float timeStep = scheduler->GetInstancingTimeStep();
+    BuildAnimationInstanceKey(timeStep);
+
+    if (SharedPtr<SharedAnimationPose> sharedPose = scheduler->FindSharedPose(animationInstanceKey_))
+    {
+        // Reference pose evaluated by another instance, bone nodes are updated from it when queried
+        sharedAnimationPose_ = sharedPose;
+        sharedAnimationPoseReused_ = true;
+        SetTransformsPending();
+        bonePoseDirty_ = false;
+
+        scheduler->ReportInstanced();
+        return true;
+    }
+
+    // Evaluate pose and share it with other instances
+    ApplyAnimationToPose(timeStep);
+
+    auto sharedPose = MakeShared<SharedAnimationPose>();
+    sharedPose->key_ = animationInstanceKey_;
+    sharedPose->pose_ = animationPose_;
+    sharedPose->boneModelTransforms_ = boneModelTransforms_;
+    sharedPose->skinMatrices_ = boneSkinTransforms_;
+    UpdateBoneBoundingBox();
+    sharedPose->boneBoundingBox_ = boneBoundingBox_;
+
+    sharedAnimationPose_ = scheduler->StoreSharedPose(sharedPose);
+    return true;
+}
+
+void AnimatedModel::BuildAnimationInstanceKey(float timeStep)
+{
+    animationInstanceKey_.clear();
+    animationInstanceKey_.push_back(reinterpret_cast<uintptr_t>(model_.Get()));
+    animationInstanceKey_.push_back(maxEvaluatedBoneDepth_);
+
+    if (AnimationStateSource* animationStateSource = animationStateSource_)
+    {
+        for (AnimationState* state : animationStateSource->GetAnimationStates())
+        {
+            if (!state->IsEnabled())
+                continue;
+
+            const float weight = state->GetWeight();
+            unsigned weightBits{};
+            memcpy(&weightBits, &weight, sizeof(weight));
+
+            animationInstanceKey_.push_back(reinterpret_cast<uintptr_t>(state->GetAnimation()));
+            animationInstanceKey_.push_back(state->GetQuantizedTimeIndex(timeStep));
+            animationInstanceKey_.push_back(weightBits | (static_cast<unsigned long long>(state->GetBlendMode()) << 32u)
+                | (static_cast<unsigned long long>(state->IsLooped()) << 40u));
+            animationInstanceKey_.push_back(StringHash(state->GetStartBone()).Value());
+        }
+    }
+}
+
+void AnimatedModel::ApplyAnimationToPose(float timeStep)
+{
+    const ea::vector<Bone>& bones = skeleton_.GetBones();
+    const unsigned numBones = bones.size();
+
+    // Evaluate only bones up to max depth, the rest keep bind pose relative to their parents
+    boneDepths_.resize(numBones);
+    evaluatedBones_.resize(numBones);
+    for (unsigned i : skeleton_.GetBoneOrder())
+    {
+        const unsigned parentIndex = bones[i].parentIndex_;
+        boneDepths_[i] = parentIndex == i ? 0 : boneDepths_[parentIndex] + 1;
+        evaluatedBones_[i] = boneDepths_[i] <= maxEvaluatedBoneDepth_;
+    }
+
+    // Start from bind pose. Bones with animation disabled keep their current transform.
+    animationPose_.resize(numBones);
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        const Bone& bone = bones[i];
+        Transform& transform = animationPose_[i];
+        if (bone.animated_)
+            transform = { bone.initialPosition_, bone.initialRotation_, bone.initialScale_ };
+        else
+            transform = { bone.node_->GetPosition(), bone.node_->GetRotation(), bone.node_->GetScale() };
+    }
+
+    // AnimationStateSource is a weak pointer which may or may not be an issue
+    if (AnimationStateSource* animationStateSource = animationStateSource_)
+    {
+        for (AnimationState* state : animationStateSource->GetAnimationStates())
+            state->ApplyModelTracksToPose(animationPose_, evaluatedBones_, timeStep);
+    }
+
+    // Bone nodes are updated only if queried
+    SetTransformsPending();
+    bonePoseDirty_ = false;
+
+    UpdateBoneModelTransforms();
+}
+
+bool AnimatedModel::UpdateBonePoseFromNodes()
+{
+    if (!IsPoseEvaluationSupported())
+        return false;
+
+    // Bone nodes should have the pending pose before they are read. Once it is written,
+    // bone nodes no longer read the pose buffer, so it can be replaced even if they are read from other threads
+    ApplyPendingTransforms();
+
+    const ea::vector<Bone>& bones = skeleton_.GetBones();
+    animationPose_.resize(bones.size());
+    for (unsigned i = 0; i < bones.size(); ++i)
+    {
+        const Node* boneNode = bones[i].node_;
+        animationPose_[i] = { boneNode->GetPosition(), boneNode->GetRotation(), boneNode->GetScale() };
+    }
+
+    // Pose no longer matches animation
+    sharedAnimationPose_ = nullptr;
+    sharedAnimationPoseReused_ = false;
+    previousSharedAnimationPose_ = nullptr;
+    skinInterpolationFactor_ = 1.0f;
+    bonePoseDirty_ = false;
+    UpdateBoneModelTransforms();
+    return true;
+}
+
+void AnimatedModel::UpdateBoneModelTransforms()
+{
+    const ea::vector<Bone>& bones = skeleton_.GetBones();
+    const unsigned numBones = bones.size();
+
+    // Calculate model-space transforms and skinning matrices in one pass, parents are processed before children
+    boneModelTransforms_.resize(numBones);
+    boneSkinTransforms_.resize(numBones);
+    for (unsigned i : skeleton_.GetBoneOrder())
+    {
+        const Bone& bone = bones[i];
+        const Transform& transform = animationPose_[i];
+
+        const Matrix3x4 localTransform{ transform.position_, transform.rotation_, transform.scale_ };
+        if (bone.parentIndex_ == i)
+            boneModelTransforms_[i] = localTransform;
+        else
+            boneModelTransforms_[i] = boneModelTransforms_[bone.parentIndex_] * localTransform;
+        boneSkinTransforms_[i] = boneModelTransforms_[i] * bone.offsetMatrix_;
+    }
+}
+
+const ea::vector<Transform>& AnimatedModel::GetCurrentPose() const
+{
+    return sharedAnimationPoseReused_ ? sharedAnimationPose_->pose_ : animationPose_;
+}
+
+const ea::vector<Matrix3x4>& AnimatedModel::GetCurrentBoneModelTransforms() const
+{
+    return sharedAnimationPoseReused_ ? sharedAnimationPose_->boneModelTransforms_ : boneModelTransforms_;
+}
+
+const ea::vector<Matrix3x4>& AnimatedModel::GetCurrentBoneSkinTransforms() const
+{
+    return sharedAnimationPoseReused_ ? sharedAnimationPose_->skinMatrices_ : boneSkinTransforms_;
+}
+
+const ea::vector<Matrix3x4>& AnimatedModel::GetPreviousBoneModelTransforms() const
+{
+    return previousSharedAnimationPose_ ? previousSharedAnimationPose_->boneModelTransforms_ : previousBoneModelTransforms_;
+}
+
+bool AnimatedModel::IsBonePoseInSync() const
+{
+    // Bound bone nodes notify the model when moved or reparented, bone nodes of non-master models are not tracked
+    const ea::vector<Matrix3x4>& boneModelTransforms = GetCurrentBoneModelTransforms();
+    return isMaster_ && boneNodesBound_ && !bonePoseDirty_ && !boneModelTransforms.empty()
+        && boneModelTransforms.size() == skeleton_.GetNumBones();
+}
+
 void AnimatedModel::ConnectToAnimationStateSource(AnimationStateSource* source)
 {
     animationStateSource_ = source;
@@ -1019,8 +1408,35 @@ void AnimatedModel::UpdateSkinning()
     // Use model's world transform in case a bone is missing
     const Matrix3x4& worldTransform = node_->GetWorldTransform();
 
+    // Use model-space transforms from the pose buffer, recalculate them from bone nodes if bone nodes were modified
+    if (IsBonePoseInSync() || UpdateBonePoseFromNodes())
+    {
+        const ea::vector<Matrix3x4>& boneModelTransforms = GetCurrentBoneModelTransforms();
+        const ea::vector<Matrix3x4>& boneSkinTransforms = GetCurrentBoneSkinTransforms();
+        const ea::vector<Matrix3x4>& previousBoneModelTransforms = GetPreviousBoneModelTransforms();
+        const bool interpolate = skinInterpolationFactor_ < 1.0f
+            && previousBoneModelTransforms.size() == boneModelTransforms.size();
+        for (unsigned i = 0; i < bones.size(); ++i)
+        {
+            if (interpolate)
+            {
+                const Matrix3x4 boneTransform = previousBoneModelTransforms[i] * (1.0f - skinInterpolationFactor_)
+                    + boneModelTransforms[i] * skinInterpolationFactor_;
+                skinMatrices_[i] = worldTransform * boneTransform * bones[i].offsetMatrix_;
+            }
+            else
+                skinMatrices_[i] = worldTransform * boneSkinTransforms[i];
+
+            // Copy the skin matrix to per-geometry matrices as needed
+            if (!geometrySkinMatrixPtrs_.empty())
+            {
+                for (unsigned j = 0; j < geometrySkinMatrixPtrs_[i].size(); ++j)
+                    *geometrySkinMatrixPtrs_[i][j] = skinMatrices_[i];
+            }
+        }
+    }
     // Skinning with global matrices only
-    if (!geometrySkinMatrices_.size())
+    else if (!geometrySkinMatrices_.size())
     {
         for (unsigned i = 0; i < bones.size(); ++i)
         {
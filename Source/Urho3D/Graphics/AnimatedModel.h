@@ -26,16 +26,19 @@
 #include "../Graphics/Model.h"
 #include "../Graphics/Skeleton.h"
 #include "../Graphics/StaticModel.h"
+#include "../Math/Transform.h"
 
 namespace Urho3D
 {
 
 class Animation;
+class AnimationScheduler;
 class AnimationState;
 class SoftwareModelAnimator;
+struct SharedAnimationPose;
 
 /// Animated model component.
-class URHO3D_API AnimatedModel : public StaticModel
+class URHO3D_API AnimatedModel : public StaticModel, public NodeTransformSource
 {
     URHO3D_OBJECT(AnimatedModel, StaticModel);
 
@@ -84,6 +87,10 @@ public:
     /// Set whether to update animation and the bounding box when not visible. Recommended to enable for physically controlled models like ragdolls.
     /// @property
     void SetUpdateInvisible(bool enable);
+    /// Set whether to share evaluated animation pose with other instances of the same model playing the same animations.
+    /// Animation time is quantized to the instancing time step of AnimationScheduler.
+    /// @property
+    void SetAnimationInstancing(bool enable);
     /// Set vertex morph weight by index.
     void SetMorphWeight(unsigned index, float weight);
     /// Set vertex morph weight by name.
@@ -110,6 +117,10 @@ public:
     /// @property
     bool GetUpdateInvisible() const { return updateInvisible_; }
 
+    /// Return whether evaluated animation pose is shared with other instances.
+    /// @property
+    bool GetAnimationInstancing() const { return animationInstancing_; }
+
     /// Return all vertex morphs.
     const ea::vector<ModelMorph>& GetMorphs() const { return morphs_; }
 
@@ -160,6 +171,10 @@ protected:
     void OnMarkedDirty(Node* node) override;
     /// Recalculate the world-space bounding box.
     void OnWorldBoundingBoxUpdate() override;
+    /// Handle bone node being moved or reparented externally.
+    void OnNodeTransformChanged(Node* node) override;
+    /// Write evaluated pose to bone nodes.
+    void WritePendingTransforms() override;
 
 private:
     /// Assign skeleton and animation bone node references as a postprocess. Called by ApplyAttributes.
@@ -180,6 +195,34 @@ private:
     void CloneGeometries();
     /// Recalculate animations. Called from Update().
     void UpdateAnimation(const FrameInfo& frame);
+    /// Return whether bone nodes mirror the skeleton so that animation can be evaluated in the pose buffer.
+    bool IsPoseEvaluationSupported() const;
+    /// Make bone nodes take transforms from the pose buffer on demand. Return false if pose evaluation is not supported.
+    bool BindBoneNodes();
+    /// Write pending pose to bone nodes and stop taking their transforms from the pose buffer.
+    void UnbindBoneNodes();
+    /// Evaluate all animation states in the pose buffer. Bone nodes are updated when queried.
+    void ApplyAnimationToPose(float timeStep = 0.0f);
+    /// Apply pose shared between instances, evaluate and share it if not evaluated yet. Return false if instancing is not possible.
+    bool ApplySharedAnimationPose(AnimationScheduler* scheduler);
+    /// Build key of model and animation states for sharing evaluated pose.
+    void BuildAnimationInstanceKey(float timeStep);
+    /// Handle skipped animation update. Skinning is interpolated if possible.
+    void SkipAnimationUpdate(AnimationScheduler* scheduler);
+    /// Return local bone transforms of the current pose, which may be evaluated by another instance.
+    const ea::vector<Transform>& GetCurrentPose() const;
+    /// Return model-space bone transforms of the current pose.
+    const ea::vector<Matrix3x4>& GetCurrentBoneModelTransforms() const;
+    /// Return model-space skinning matrices of the current pose.
+    const ea::vector<Matrix3x4>& GetCurrentBoneSkinTransforms() const;
+    /// Return model-space bone transforms of the previous evaluation.
+    const ea::vector<Matrix3x4>& GetPreviousBoneModelTransforms() const;
+    /// Return whether cached model-space bone transforms still match bone nodes, i.e. bone nodes were not changed externally.
+    bool IsBonePoseInSync() const;
+    /// Read pose buffer from bone nodes and recalculate model-space bone transforms. Return false if bone nodes do not mirror the skeleton.
+    bool UpdateBonePoseFromNodes();
+    /// Calculate model-space bone transforms and skinning matrices from the pose buffer in one pass.
+    void UpdateBoneModelTransforms();
     /// Recalculate skinning.
     void UpdateSkinning();
     /// Reapply all vertex morphs.
@@ -197,6 +240,38 @@ private:
     ea::vector<ModelMorph> morphs_;
     /// Skinning matrices.
     ea::vector<Matrix3x4> skinMatrices_;
+    /// Local bone transforms evaluated from animation states.
+    ea::vector<Transform> animationPose_;
+    /// Model-space bone transforms calculated from the pose buffer.
+    ea::vector<Matrix3x4> boneModelTransforms_;
+    /// Model-space skinning matrices calculated from the pose buffer.
+    ea::vector<Matrix3x4> boneSkinTransforms_;
+    /// Model-space bone transforms of the previous evaluation, used for skinning interpolation.
+    ea::vector<Matrix3x4> previousBoneModelTransforms_;
+    /// Hierarchy depths of bones, used for bone LOD.
+    ea::vector<unsigned> boneDepths_;
+    /// Flags of bones evaluated with current bone LOD.
+    ea::vector<unsigned char> evaluatedBones_;
+    /// Whether bone nodes take transforms from the pose buffer.
+    bool boneNodesBound_{};
+    /// Whether bone nodes were changed externally since the pose buffer was evaluated.
+    bool bonePoseDirty_{};
+    /// Interpolation factor between previous and current model-space bone transforms for skinning.
+    float skinInterpolationFactor_{ 1.0f };
+    /// Max hierarchy depth of evaluated bones.
+    unsigned maxEvaluatedBoneDepth_{ M_MAX_UNSIGNED };
+    /// Number of frames the evaluation was deferred due to animation scheduler budget.
+    unsigned numDeferredFrames_{};
+    /// Whether the evaluated animation pose is shared between instances.
+    bool animationInstancing_{};
+    /// Key of model and animation states for sharing evaluated pose.
+    ea::vector<unsigned long long> animationInstanceKey_;
+    /// Shared animation pose applied last time, if any.
+    SharedPtr<SharedAnimationPose> sharedAnimationPose_;
+    /// Whether the shared animation pose applied last time was evaluated by another instance. If so, it is used instead of own pose buffer.
+    bool sharedAnimationPoseReused_{};
+    /// Shared animation pose of the previous evaluation if it was evaluated by another instance, used for skinning interpolation.
+    SharedPtr<SharedAnimationPose> previousSharedAnimationPose_;
     /// Mapping of subgeometry bone indices, used if more bones than skinning shader can manage.
     ea::vector<ea::vector<unsigned> > geometryBoneMappings_;
     /// Subgeometry skinning matrices, used if more bones than skinning shader can manage.
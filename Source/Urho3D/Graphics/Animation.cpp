@@ -217,6 +217,7 @@ bool Animation::BeginLoad(Deserializer& source)
     animationName_ = source.ReadString();
     animationNameHash_ = animationName_;
     length_ = source.ReadFloat();
+    const bool isCompressed = version >= compressedTrackVersion && source.ReadBool();
 
     const unsigned tracks = source.ReadUInt();
     memoryUse += tracks * sizeof(AnimationTrack);
@@ -243,6 +244,15 @@ bool Animation::BeginLoad(Deserializer& source)
         }
     }
 
+    // Read compressed keys of the tracks
+    if (isCompressed)
+    {
+        compressedData_ = MakeShared<CompressedAnimation>();
+        if (!compressedData_->Load(source))
+            return false;
+        memoryUse += compressedData_->GetMemoryUse();
+    }
+
     // Read variant tracks
     if (version >= variantTrackVersion)
     {
@@ -311,6 +321,7 @@ bool Animation::Save(Serializer& dest) const
     dest.WriteUInt(currentVersion);
     dest.WriteString(animationName_);
     dest.WriteFloat(length_);
+    dest.WriteBool(compressedData_ != nullptr);
 
     // Write tracks
     dest.WriteUInt(tracks_.size());
@@ -331,6 +342,10 @@ bool Animation::Save(Serializer& dest) const
         }
     }
 
+    // Write compressed keys of the tracks
+    if (compressedData_)
+        compressedData_->Save(dest);
+
     // Write variant tracks
     dest.WriteUInt(variantTracks_.size());
     for (const auto& item : variantTracks_)
@@ -439,6 +454,7 @@ void Animation::RemoveAllTracks()
 {
     tracks_.clear();
     variantTracks_.clear();
+    compressedData_ = nullptr;
 }
 
 void Animation::SetTrigger(unsigned index, const AnimationTriggerPoint& trigger)
@@ -493,12 +509,47 @@ SharedPtr<Animation> Animation::Clone(const ea::string& cloneName) const
     ret->length_ = length_;
     ret->tracks_ = tracks_;
     ret->triggers_ = triggers_;
+    ret->compressedData_ = compressedData_;
     ret->CopyMetadata(*this);
     ret->SetMemoryUse(GetMemoryUse());
 
     return ret;
 }
 
+void Animation::Compress(const AnimationCompressionSettings& settings)
+{
+    Decompress();
+
+    ea::vector<const AnimationTrack*> tracks;
+    for (const auto& item : tracks_)
+        tracks.push_back(&item.second);
+
+    compressedData_ = MakeShared<CompressedAnimation>();
+    compressedData_->Compress(tracks, length_, settings);
+
+    for (auto& item : tracks_)
+    {
+        item.second.keyFrames_.clear();
+        item.second.keyFrames_.shrink_to_fit();
+    }
+}
+
+void Animation::Decompress()
+{
+    if (!compressedData_)
+        return;
+
+    for (auto& item : tracks_)
+    {
+        AnimationTrack& track = item.second;
+        const unsigned trackIndex = compressedData_->GetTrackIndex(track.nameHash_);
+        if (trackIndex != M_MAX_UNSIGNED && track.keyFrames_.empty())
+            compressedData_->Decompress(trackIndex, track);
+    }
+
+    compressedData_ = nullptr;
+}
+
 AnimationTrack* Animation::GetTrack(unsigned index)
 {
     if (index >= tracks_.size())
@@ -549,6 +600,7 @@ AnimationTriggerPoint* Animation::GetTrigger(unsigned index)
 void Animation::SetTracks(const ea::vector<AnimationTrack>& tracks)
 {
     tracks_.clear();
+    compressedData_ = nullptr;
 
     for (auto itr = tracks.begin(); itr != tracks.end(); itr++)
     {
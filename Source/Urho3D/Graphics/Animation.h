@@ -25,6 +25,7 @@
 #pragma once
 
 #include "../Graphics/AnimationTrack.h"
+#include "../Graphics/CompressedAnimation.h"
 #include "../Container/Ptr.h"
 #include "../Resource/Resource.h"
 
@@ -94,6 +95,10 @@ public:
     void SetNumTriggers(unsigned num);
     /// Clone the animation.
     SharedPtr<Animation> Clone(const ea::string& cloneName = EMPTY_STRING) const;
+    /// Compress transform tracks within error bounds. Keyframes of compressed tracks are released.
+    void Compress(const AnimationCompressionSettings& settings = AnimationCompressionSettings{});
+    /// Restore keyframes of compressed transform tracks and release compressed data.
+    void Decompress();
 
     /// Return animation name.
     /// @property
@@ -131,6 +136,12 @@ public:
     VariantAnimationTrack* GetVariantTrack(StringHash nameHash);
     /// @}
 
+    /// Return whether transform tracks are compressed.
+    bool IsCompressed() const { return compressedData_ != nullptr; }
+
+    /// Return compressed transform tracks, or null if not compressed.
+    CompressedAnimation* GetCompressedData() const { return compressedData_; }
+
     /// Return animation trigger points.
     const ea::vector<AnimationTriggerPoint>& GetTriggers() const { return triggers_; }
 
@@ -151,8 +162,9 @@ private:
     /// @{
     static const unsigned legacyVersion = 1; // Fake version for legacy unversioned UANI file
     static const unsigned variantTrackVersion = 2; // VariantAnimationTrack support added here
+    static const unsigned compressedTrackVersion = 3; // CompressedAnimation support added here
 
-    static const unsigned currentVersion = variantTrackVersion;
+    static const unsigned currentVersion = compressedTrackVersion;
     /// @}
 
     /// Animation name.
@@ -167,6 +179,8 @@ private:
     ea::unordered_map<StringHash, VariantAnimationTrack> variantTracks_;
     /// Animation trigger points.
     ea::vector<AnimationTriggerPoint> triggers_;
+    /// Compressed transform tracks.
+    SharedPtr<CompressedAnimation> compressedData_;
 };
 
 }
@@ -1037,6 +1037,7 @@ void AnimationController::UpdateAnimationStateTracks(AnimationState* state)
         startNode = node_;
 
     // Setup model and node tracks
+    const CompressedAnimation* compressedData = animation->GetCompressedData();
     const auto& tracks = animation->GetTracks();
     for (const auto& item : tracks)
     {
@@ -1052,6 +1053,9 @@ void AnimationController::UpdateAnimationStateTracks(AnimationState* state)
             stateTrack.track_ = &track;
             stateTrack.node_ = trackNode;
             stateTrack.bone_ = trackBone;
+            stateTrack.boneIndex_ = model->GetSkeleton().GetBoneIndex(trackBone);
+            if (compressedData)
+                stateTrack.compressedTrackIndex_ = compressedData->GetTrackIndex(track.nameHash_);
             state->AddModelTrack(stateTrack);
         }
         else if (trackNode)
@@ -1059,6 +1063,8 @@ void AnimationController::UpdateAnimationStateTracks(AnimationState* state)
             NodeAnimationStateTrack stateTrack;
             stateTrack.track_ = &track;
             stateTrack.node_ = trackNode;
+            if (compressedData)
+                stateTrack.compressedTrackIndex_ = compressedData->GetTrackIndex(track.nameHash_);
             state->AddNodeTrack(stateTrack);
         }
     }
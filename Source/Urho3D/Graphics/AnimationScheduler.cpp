@@ -0,0 +1,113 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Container/Hash.h"
+#include "../Core/CoreEvents.h"
+#include "../Graphics/AnimationScheduler.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+namespace
+{
+
+unsigned GetSharedPoseKeyHash(ea::span<const unsigned long long> key)
+{
+    unsigned hash = 0;
+    for (unsigned long long value : key)
+    {
+        CombineHash(hash, static_cast<unsigned>(value));
+        CombineHash(hash, static_cast<unsigned>(value >> 32));
+    }
+    return hash;
+}
+
+bool IsSameKey(ea::span<const unsigned long long> lhs, ea::span<const unsigned long long> rhs)
+{
+    return lhs.size() == rhs.size() && ea::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+}
+
+AnimationScheduler::AnimationScheduler(Context* context)
+    : Object(context)
+{
+    SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(AnimationScheduler, HandleBeginFrame));
+}
+
+AnimationScheduler::~AnimationScheduler() = default;
+
+bool AnimationScheduler::TryAcquireEvaluation(bool force)
+{
+    const unsigned index = numBudgetedEvaluations_.fetch_add(1, std::memory_order_relaxed);
+    return force || index < maxEvaluationsPerFrame_;
+}
+
+SharedPtr<SharedAnimationPose> AnimationScheduler::FindSharedPose(ea::span<const unsigned long long> key) const
+{
+    MutexLock lock(sharedPosesMutex_);
+    const auto iter = sharedPoses_.find(GetSharedPoseKeyHash(key));
+    if (iter == sharedPoses_.end())
+        return nullptr;
+
+    for (SharedAnimationPose* pose : iter->second)
+    {
+        if (IsSameKey(pose->key_, key))
+            return SharedPtr<SharedAnimationPose>(pose);
+    }
+    return nullptr;
+}
+
+SharedPtr<SharedAnimationPose> AnimationScheduler::StoreSharedPose(SharedAnimationPose* pose)
+{
+    MutexLock lock(sharedPosesMutex_);
+    auto& poses = sharedPoses_[GetSharedPoseKeyHash(pose->key_)];
+
+    // Another instance may have evaluated the same pose concurrently
+    for (SharedAnimationPose* existingPose : poses)
+    {
+        if (IsSameKey(existingPose->key_, pose->key_))
+            return SharedPtr<SharedAnimationPose>(existingPose);
+    }
+
+    poses.emplace_back(pose);
+    return SharedPtr<SharedAnimationPose>(pose);
+}
+
+void AnimationScheduler::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
+{
+    stats_.numEvaluated_ = numEvaluated_.exchange(0, std::memory_order_relaxed);
+    stats_.numInterpolated_ = numInterpolated_.exchange(0, std::memory_order_relaxed);
+    stats_.numSkipped_ = numSkipped_.exchange(0, std::memory_order_relaxed);
+    stats_.numInstanced_ = numInstanced_.exchange(0, std::memory_order_relaxed);
+    numBudgetedEvaluations_.store(0, std::memory_order_relaxed);
+
+    MutexLock lock(sharedPosesMutex_);
+    sharedPoses_.clear();
+}
+
+}
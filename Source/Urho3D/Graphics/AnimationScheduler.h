@@ -0,0 +1,174 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+/// \file
+
+#pragma once
+
+#include "../Core/Mutex.h"
+#include "../Core/Object.h"
+#include "../Math/BoundingBox.h"
+#include "../Math/Transform.h"
+
+#include <EASTL/span.h>
+#include <EASTL/unordered_map.h>
+
+#include <atomic>
+
+namespace Urho3D
+{
+
+/// Statistics of animation scheduling for one frame.
+struct AnimationSchedulerStats
+{
+    /// Number of models with animation evaluated.
+    unsigned numEvaluated_{};
+    /// Number of models with skinning interpolated between evaluated frames.
+    unsigned numInterpolated_{};
+    /// Number of models with animation update skipped.
+    unsigned numSkipped_{};
+    /// Number of models that reused animation pose evaluated for another instance.
+    unsigned numInstanced_{};
+};
+
+/// Animation pose evaluated once per frame and shared between instanced AnimatedModels.
+struct URHO3D_API SharedAnimationPose : public RefCounted
+{
+    /// Key of model and animation states the pose is evaluated for.
+    ea::vector<unsigned long long> key_;
+    /// Local bone transforms.
+    ea::vector<Transform> pose_;
+    /// Model-space bone transforms.
+    ea::vector<Matrix3x4> boneModelTransforms_;
+    /// Model-space skinning matrices.
+    ea::vector<Matrix3x4> skinMatrices_;
+    /// Bone bounding box in model space.
+    BoundingBox boneBoundingBox_;
+};
+
+/// Animation scheduler subsystem. Spreads animation updates of AnimatedModels
+/// that are updated at reduced rate due to animation LOD across frames.
+class URHO3D_API AnimationScheduler : public Object
+{
+    URHO3D_OBJECT(AnimationScheduler, Object);
+
+public:
+    /// Construct.
+    explicit AnimationScheduler(Context* context);
+    /// Destruct.
+    ~AnimationScheduler() override;
+
+    /// Set max number of reduced-rate animation evaluations per frame. Models updated every frame are not limited.
+    /// @property
+    void SetMaxEvaluationsPerFrame(unsigned count) { maxEvaluationsPerFrame_ = count; }
+    /// Set max number of frames the evaluation may be deferred when frame budget is exceeded.
+    /// @property
+    void SetMaxDeferredFrames(unsigned count) { maxDeferredFrames_ = count; }
+    /// Set whether to interpolate skinning between evaluated frames of reduced-rate models. Disabled by default.
+    /// Interpolated models are skinned every frame, software-skinned models included.
+    /// @property
+    void SetSkinInterpolation(bool enable) { skinInterpolation_ = enable; }
+    /// Set animation LOD distance beyond which only bones up to LOD bone depth are evaluated.
+    /// @property
+    void SetLodBoneDistance(float distance) { lodBoneDistance_ = distance; }
+    /// Set max depth of bones evaluated beyond LOD bone distance. Root bones have zero depth.
+    /// @property
+    void SetLodBoneDepth(unsigned depth) { lodBoneDepth_ = depth; }
+    /// Set time step that animation time of instanced models is quantized to.
+    /// @property
+    void SetInstancingTimeStep(float step) { instancingTimeStep_ = step; }
+
+    /// Return max number of reduced-rate animation evaluations per frame.
+    /// @property
+    unsigned GetMaxEvaluationsPerFrame() const { return maxEvaluationsPerFrame_; }
+    /// Return max number of frames the evaluation may be deferred.
+    /// @property
+    unsigned GetMaxDeferredFrames() const { return maxDeferredFrames_; }
+    /// Return whether skinning is interpolated between evaluated frames.
+    /// @property
+    bool GetSkinInterpolation() const { return skinInterpolation_; }
+    /// Return animation LOD distance beyond which bone LOD is applied.
+    /// @property
+    float GetLodBoneDistance() const { return lodBoneDistance_; }
+    /// Return max depth of bones evaluated beyond LOD bone distance.
+    /// @property
+    unsigned GetLodBoneDepth() const { return lodBoneDepth_; }
+    /// Return time step that animation time of instanced models is quantized to.
+    /// @property
+    float GetInstancingTimeStep() const { return instancingTimeStep_; }
+    /// Return max evaluated bone depth for given animation LOD distance.
+    unsigned GetMaxBoneDepth(float lodDistance) const { return lodDistance > lodBoneDistance_ ? lodBoneDepth_ : M_MAX_UNSIGNED; }
+
+    /// Return statistics of the last finished frame.
+    const AnimationSchedulerStats& GetStats() const { return stats_; }
+
+    /// Internal API for AnimatedModel. Safe to call from worker threads.
+    /// @{
+    /// Try to take reduced-rate evaluation from frame budget. Forced evaluation always succeeds.
+    bool TryAcquireEvaluation(bool force);
+    void ReportEvaluated() { numEvaluated_.fetch_add(1, std::memory_order_relaxed); }
+    void ReportInterpolated() { numInterpolated_.fetch_add(1, std::memory_order_relaxed); }
+    void ReportSkipped() { numSkipped_.fetch_add(1, std::memory_order_relaxed); }
+    void ReportInstanced() { numInstanced_.fetch_add(1, std::memory_order_relaxed); }
+    /// Return pose evaluated this frame for given key, if any.
+    SharedPtr<SharedAnimationPose> FindSharedPose(ea::span<const unsigned long long> key) const;
+    /// Store pose evaluated this frame. Return previously stored pose with the same key, if any.
+    SharedPtr<SharedAnimationPose> StoreSharedPose(SharedAnimationPose* pose);
+    /// @}
+
+private:
+    /// Handle begin frame event.
+    void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
+
+    /// Max number of reduced-rate evaluations per frame.
+    unsigned maxEvaluationsPerFrame_{ M_MAX_UNSIGNED };
+    /// Max number of deferred frames.
+    unsigned maxDeferredFrames_{ 8 };
+    /// Whether to interpolate skinning.
+    bool skinInterpolation_{ false };
+    /// LOD distance beyond which bone LOD is applied.
+    float lodBoneDistance_{ M_INFINITY };
+    /// Max depth of evaluated bones beyond LOD bone distance.
+    unsigned lodBoneDepth_{ M_MAX_UNSIGNED };
+    /// Time step of instanced animation.
+    float instancingTimeStep_{ 1.0f / 30.0f };
+
+    /// Poses shared between instanced models this frame, grouped by key hash.
+    ea::unordered_map<unsigned, ea::vector<SharedPtr<SharedAnimationPose>>> sharedPoses_;
+    /// Shared poses mutex.
+    mutable Mutex sharedPosesMutex_;
+
+    /// Number of reduced-rate evaluations taken this frame.
+    std::atomic<unsigned> numBudgetedEvaluations_{};
+    /// Counters of current frame.
+    /// @{
+    std::atomic<unsigned> numEvaluated_{};
+    std::atomic<unsigned> numInterpolated_{};
+    std::atomic<unsigned> numSkipped_{};
+    std::atomic<unsigned> numInstanced_{};
+    /// @}
+    /// Statistics of the last finished frame.
+    AnimationSchedulerStats stats_;
+};
+
+}
@@ -336,18 +336,67 @@ float AnimationState::GetLength() const
     return animation_ ? animation_->GetLength() : 0.0f;
 }
 
+float AnimationState::GetQuantizedTime(float timeStep) const
+{
+    return timeStep > 0.0f ? GetQuantizedTimeIndex(timeStep) * timeStep : time_;
+}
+
+unsigned AnimationState::GetQuantizedTimeIndex(float timeStep) const
+{
+    return timeStep > 0.0f ? static_cast<unsigned>(time_ / timeStep) : 0;
+}
+
 void AnimationState::ApplyModelTracks()
 {
     if (!animation_ || !IsEnabled())
         return;
 
+    SampleCompressedTracks(time_);
+
     for (ModelAnimationStateTrack& stateTrack : modelTracks_)
     {
         // Do not apply if the bone has animation disabled
         if (!stateTrack.bone_->animated_)
             continue;
 
-        ApplyTransformTrack(*stateTrack.track_, stateTrack.node_, stateTrack.bone_, stateTrack.keyFrame_, weight_, true);
+        ApplyTransformTrack(*stateTrack.track_, stateTrack.compressedTrackIndex_,
+            stateTrack.node_, stateTrack.bone_, stateTrack.keyFrame_, weight_, true);
+    }
+}
+
+void AnimationState::ApplyModelTracksToPose(ea::span<Transform> pose, ea::span<const unsigned char> evaluatedBones,
+    float timeStep)
+{
+    if (!animation_ || !IsEnabled())
+        return;
+
+    const float sampleTime = GetQuantizedTime(timeStep);
+    SampleCompressedTracks(sampleTime);
+
+    for (ModelAnimationStateTrack& stateTrack : modelTracks_)
+    {
+        // Do not apply if the bone has animation disabled or is outside of start bone hierarchy
+        if (!stateTrack.bone_->animated_ || !stateTrack.node_ || stateTrack.boneIndex_ >= pose.size())
+            continue;
+
+        // Do not apply if the bone is excluded by bone LOD
+        if (!evaluatedBones.empty() && !evaluatedBones[stateTrack.boneIndex_])
+            continue;
+
+        Transform newTransform;
+        if (!SampleTransformTrack(*stateTrack.track_, stateTrack.compressedTrackIndex_, sampleTime, stateTrack.keyFrame_, newTransform))
+            continue;
+
+        Transform& poseTransform = pose[stateTrack.boneIndex_];
+        BlendTransform(*stateTrack.track_, stateTrack.bone_, poseTransform, weight_, newTransform);
+
+        const AnimationChannelFlags channelMask = stateTrack.track_->channelMask_;
+        if (channelMask & CHANNEL_POSITION)
+            poseTransform.position_ = newTransform.position_;
+        if (channelMask & CHANNEL_ROTATION)
+            poseTransform.rotation_ = newTransform.rotation_;
+        if (channelMask & CHANNEL_SCALE)
+            poseTransform.scale_ = newTransform.scale_;
     }
 }
 
@@ -356,9 +405,12 @@ void AnimationState::ApplyNodeTracks()
     if (!animation_ || !IsEnabled())
         return;
 
+    SampleCompressedTracks(time_);
+
     for (NodeAnimationStateTrack& stateTrack : nodeTracks_)
     {
-        ApplyTransformTrack(*stateTrack.track_, stateTrack.node_, nullptr, stateTrack.keyFrame_, weight_, false);
+        ApplyTransformTrack(*stateTrack.track_, stateTrack.compressedTrackIndex_,
+            stateTrack.node_, nullptr, stateTrack.keyFrame_, weight_, false);
     }
 }
 
@@ -373,16 +425,35 @@ void AnimationState::ApplyAttributeTracks()
     }
 }
 
-void AnimationState::ApplyTransformTrack(const AnimationTrack& track,
-    Node* node, Bone* bone, unsigned& frame, float weight, bool silent)
+void AnimationState::SampleCompressedTracks(float time)
 {
-    if (track.keyFrames_.empty() || !node)
+    CompressedAnimation* compressedData = animation_->GetCompressedData();
+    if (!compressedData)
+    {
+        compressedTransforms_.clear();
         return;
+    }
 
-    const AnimationChannelFlags channelMask = track.channelMask_;
+    compressedTransforms_.resize(compressedData->GetNumTracks());
+    compressedData->Sample(time, looped_, compressedTransforms_);
+}
 
-    Transform newTransform;
-    track.Sample(time_, animation_->GetLength(), looped_, frame, newTransform);
+bool AnimationState::SampleTransformTrack(const AnimationTrack& track, unsigned compressedTrackIndex,
+    float time, unsigned& frame, Transform& result) const
+{
+    if (compressedTrackIndex < compressedTransforms_.size())
+        result = compressedTransforms_[compressedTrackIndex];
+    else if (!track.keyFrames_.empty())
+        track.Sample(time, animation_->GetLength(), looped_, frame, result);
+    else
+        return false;
+    return true;
+}
+
+void AnimationState::BlendTransform(const AnimationTrack& track, const Bone* bone, const Transform& oldTransform,
+    float weight, Transform& newTransform) const
+{
+    const AnimationChannelFlags channelMask = track.channelMask_;
 
     if (blendingMode_ == ABM_ADDITIVE) // not ABM_LERP
     {
@@ -390,21 +461,21 @@ void AnimationState::ApplyTransformTrack(const AnimationTrack& track,
         {
             const Vector3& base = bone ? bone->initialPosition_ : track.baseValue_.position_;
             const Vector3 delta = newTransform.position_ - base;
-            newTransform.position_ = node->GetPosition() + delta * weight;
+            newTransform.position_ = oldTransform.position_ + delta * weight;
         }
         if (channelMask & CHANNEL_ROTATION)
         {
             const Quaternion& base = bone ? bone->initialRotation_ : track.baseValue_.rotation_;
             const Quaternion delta = newTransform.rotation_ * base.Inverse();
-            newTransform.rotation_ = (delta * node->GetRotation()).Normalized();
+            newTransform.rotation_ = (delta * oldTransform.rotation_).Normalized();
             if (!Equals(weight, 1.0f))
-                newTransform.rotation_ = node->GetRotation().Slerp(newTransform.rotation_, weight);
+                newTransform.rotation_ = oldTransform.rotation_.Slerp(newTransform.rotation_, weight);
         }
         if (channelMask & CHANNEL_SCALE)
         {
             const Vector3& base = bone ? bone->initialScale_ : track.baseValue_.scale_;
             const Vector3 delta = newTransform.scale_ - base;
-            newTransform.scale_ = node->GetScale() + delta * weight;
+            newTransform.scale_ = oldTransform.scale_ + delta * weight;
         }
     }
     else
@@ -412,14 +483,29 @@ void AnimationState::ApplyTransformTrack(const AnimationTrack& track,
         if (!Equals(weight, 1.0f)) // not full weight
         {
             if (channelMask & CHANNEL_POSITION)
-                newTransform.position_ = node->GetPosition().Lerp(newTransform.position_, weight);
+                newTransform.position_ = oldTransform.position_.Lerp(newTransform.position_, weight);
             if (channelMask & CHANNEL_ROTATION)
-                newTransform.rotation_ = node->GetRotation().Slerp(newTransform.rotation_, weight);
+                newTransform.rotation_ = oldTransform.rotation_.Slerp(newTransform.rotation_, weight);
             if (channelMask & CHANNEL_SCALE)
-                newTransform.scale_ = node->GetScale().Lerp(newTransform.scale_, weight);
+                newTransform.scale_ = oldTransform.scale_.Lerp(newTransform.scale_, weight);
         }
     }
+}
+
+void AnimationState::ApplyTransformTrack(const AnimationTrack& track, unsigned compressedTrackIndex,
+    Node* node, Bone* bone, unsigned& frame, float weight, bool silent)
+{
+    if (!node)
+        return;
+
+    Transform newTransform;
+    if (!SampleTransformTrack(track, compressedTrackIndex, time_, frame, newTransform))
+        return;
+
+    const Transform oldTransform{ node->GetPosition(), node->GetRotation(), node->GetScale() };
+    BlendTransform(track, bone, oldTransform, weight, newTransform);
 
+    const AnimationChannelFlags channelMask = track.channelMask_;
     if (silent)
     {
         if (channelMask & CHANNEL_POSITION)
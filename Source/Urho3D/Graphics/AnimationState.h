@@ -24,10 +24,12 @@
 
 #pragma once
 
+#include <EASTL/span.h>
 #include <EASTL/unordered_map.h>
 
 #include "../Container/Ptr.h"
 #include "../Math/StringHash.h"
+#include "../Math/Transform.h"
 
 namespace Urho3D
 {
@@ -61,6 +63,10 @@ struct URHO3D_API ModelAnimationStateTrack
     Bone* bone_{};
     WeakPtr<Node> node_;
     unsigned keyFrame_{};
+    /// Index of the track in compressed animation data, if compressed.
+    unsigned compressedTrackIndex_{ M_MAX_UNSIGNED };
+    /// Index of the bone in the skeleton.
+    unsigned boneIndex_{ M_MAX_UNSIGNED };
 };
 
 /// Per-track data of node model animation.
@@ -69,6 +75,8 @@ struct URHO3D_API NodeAnimationStateTrack
     const AnimationTrack* track_{};
     WeakPtr<Node> node_;
     unsigned keyFrame_{};
+    /// Index of the track in compressed animation data, if compressed.
+    unsigned compressedTrackIndex_{ M_MAX_UNSIGNED };
 };
 
 /// Per-track data of attribute animation.
@@ -167,16 +175,34 @@ public:
     /// @property
     unsigned char GetLayer() const { return layer_; }
 
+    /// Return time position quantized to given time step. Return exact time if time step is not positive.
+    float GetQuantizedTime(float timeStep) const;
+    /// Return index of time step that contains time position.
+    unsigned GetQuantizedTimeIndex(float timeStep) const;
+
     /// Apply animation to a skeleton. Transform changes are applied silently, so the model needs to dirty its root model afterward.
     void ApplyModelTracks();
+    /// Apply animation to a local pose buffer indexed by bone. Bone nodes are not touched.
+    /// If evaluated bone flags are not empty, only flagged bones are animated.
+    /// If time step is positive, animation is sampled at time quantized to the step.
+    void ApplyModelTracksToPose(ea::span<Transform> pose, ea::span<const unsigned char> evaluatedBones = {},
+        float timeStep = 0.0f);
     /// Apply animation to a scene node hierarchy.
     void ApplyNodeTracks();
     /// Apply animation to attributes.
     void ApplyAttributeTracks();
 
 private:
+    /// Sample all compressed transform tracks of the animation at given time.
+    void SampleCompressedTracks(float time);
+    /// Sample single transformation track at given time. Key frame hint is updated on call.
+    bool SampleTransformTrack(const AnimationTrack& track, unsigned compressedTrackIndex, float time,
+        unsigned& frame, Transform& result) const;
+    /// Blend sampled transform with the current one according to blending mode and weight.
+    void BlendTransform(const AnimationTrack& track, const Bone* bone, const Transform& oldTransform,
+        float weight, Transform& newTransform) const;
     /// Apply single transformation track to target object. Key frame hint is updated on call.
-    void ApplyTransformTrack(const AnimationTrack& track,
+    void ApplyTransformTrack(const AnimationTrack& track, unsigned compressedTrackIndex,
         Node* node, Bone* bone, unsigned& frame, float weight, bool silent);
     /// Apply single attribute track to target object. Key frame hint is updated on call.
     void ApplyAttributeTrack(AttributeAnimationStateTrack& stateTrack, float weight);
@@ -209,6 +235,9 @@ private:
     ea::vector<NodeAnimationStateTrack> nodeTracks_;
     ea::vector<AttributeAnimationStateTrack> attributeTracks_;
     /// @}
+
+    /// Transforms sampled from compressed animation data.
+    ea::vector<Transform> compressedTransforms_;
 };
 
 using AnimationStateVector = ea::vector<SharedPtr<AnimationState>>;
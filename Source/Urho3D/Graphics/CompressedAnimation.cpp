@@ -0,0 +1,613 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Graphics/AnimationTrack.h"
+#include "../Graphics/CompressedAnimation.h"
+#include "../IO/Deserializer.h"
+#include "../IO/Log.h"
+#include "../IO/Serializer.h"
+
+#include <EASTL/algorithm.h>
+#include <EASTL/sort.h>
+
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+namespace
+{
+
+/// Largest magnitude of any but the largest component of an unit quaternion.
+const float ROTATION_COMPONENT_RANGE = 0.70710678f;
+/// Maximum quantized value of a rotation component.
+const float ROTATION_COMPONENT_MAX = 32767.0f;
+
+unsigned short QuantizeRotationComponent(float value)
+{
+    const float normalized = Clamp(value / ROTATION_COMPONENT_RANGE * 0.5f + 0.5f, 0.0f, 1.0f);
+    return static_cast<unsigned short>(RoundToInt(normalized * ROTATION_COMPONENT_MAX));
+}
+
+float DequantizeRotationComponent(unsigned value)
+{
+    return (value & 0x7fff) * (2.0f * ROTATION_COMPONENT_RANGE / ROTATION_COMPONENT_MAX) - ROTATION_COMPONENT_RANGE;
+}
+
+/// Encode rotation as three smallest components. The index of the largest component is stored in the high bits of the first two.
+void EncodeRotation(const Quaternion& rotation, unsigned short& a, unsigned short& b, unsigned short& c)
+{
+    const Quaternion normalizedRotation = rotation.Normalized();
+    const float* data = normalizedRotation.Data();
+
+    unsigned largest = 0;
+    for (unsigned i = 1; i < 4; ++i)
+    {
+        if (Abs(data[i]) > Abs(data[largest]))
+            largest = i;
+    }
+
+    // Largest component is restored as positive
+    const float sign = data[largest] < 0.0f ? -1.0f : 1.0f;
+    unsigned short components[3]{};
+    for (unsigned i = 0, j = 0; i < 4; ++i)
+    {
+        if (i != largest)
+            components[j++] = QuantizeRotationComponent(data[i] * sign);
+    }
+
+    a = static_cast<unsigned short>(components[0] | ((largest & 1u) << 15u));
+    b = static_cast<unsigned short>(components[1] | ((largest >> 1u) << 15u));
+    c = components[2];
+}
+
+Quaternion DecodeRotation(unsigned a, unsigned b, unsigned c)
+{
+    const unsigned largest = (a >> 15u) | ((b >> 15u) << 1u);
+    const float components[3]{ DequantizeRotationComponent(a), DequantizeRotationComponent(b), DequantizeRotationComponent(c) };
+    const float largestComponent = sqrtf(Max(0.0f,
+        1.0f - components[0] * components[0] - components[1] * components[1] - components[2] * components[2]));
+
+    float data[4]{};
+    for (unsigned i = 0, j = 0; i < 4; ++i)
+        data[i] = i == largest ? largestComponent : components[j++];
+    return Quaternion(data[0], data[1], data[2], data[3]);
+}
+
+/// Return indices of keys to keep, so that interpolation between kept keys reproduces all source keys within error.
+template <class T, class InterpolateFunction, class ErrorFunction>
+ea::vector<unsigned> ReduceKeys(const ea::vector<float>& times, const ea::vector<T>& sourceValues,
+    const ea::vector<T>& keyValues, float maxError, const InterpolateFunction& interpolate, const ErrorFunction& getError)
+{
+    const unsigned numKeys = times.size();
+
+    ea::vector<unsigned> keys;
+    keys.push_back(0);
+
+    // Constant channels need only one key
+    bool isConstant = true;
+    for (unsigned i = 1; i < numKeys && isConstant; ++i)
+        isConstant = getError(keyValues[0], sourceValues[i]) <= maxError;
+    if (isConstant)
+        return keys;
+
+    const auto isSegmentValid = [&](unsigned first, unsigned last)
+    {
+        const float interval = times[last] - times[first];
+        for (unsigned i = first + 1; i < last; ++i)
+        {
+            const float blendFactor = interval > 0.0f ? (times[i] - times[first]) / interval : 0.0f;
+            if (getError(interpolate(keyValues[first], keyValues[last], blendFactor), sourceValues[i]) > maxError)
+                return false;
+        }
+        return true;
+    };
+
+    // Extend each segment as long as the skipped keys stay within error. First and last keys are always kept for looping
+    unsigned segmentStart = 0;
+    for (unsigned i = 2; i < numKeys; ++i)
+    {
+        if (!isSegmentValid(segmentStart, i))
+        {
+            segmentStart = i - 1;
+            keys.push_back(segmentStart);
+        }
+    }
+    keys.push_back(numKeys - 1);
+    return keys;
+}
+
+template <class T>
+void WriteVector(Serializer& dest, const ea::vector<T>& values)
+{
+    dest.WriteUInt(values.size());
+    dest.Write(values.data(), values.size() * sizeof(T));
+}
+
+template <class T>
+bool ReadVector(Deserializer& source, ea::vector<T>& values)
+{
+    values.resize(source.ReadUInt());
+    const unsigned size = values.size() * sizeof(T);
+    return source.Read(values.data(), size) == size;
+}
+
+template <class T>
+unsigned GetVectorMemoryUse(const ea::vector<T>& values)
+{
+    return values.capacity() * sizeof(T);
+}
+
+#ifdef URHO3D_SSE
+inline __m128 SelectPs(__m128 mask, __m128 lhs, __m128 rhs)
+{
+    return _mm_or_ps(_mm_and_ps(mask, lhs), _mm_andnot_ps(mask, rhs));
+}
+
+/// Decode four quantized rotations into components.
+inline void DecodeRotations(__m128i a, __m128i b, __m128i c, __m128& w, __m128& x, __m128& y, __m128& z)
+{
+    const __m128i componentMask = _mm_set1_epi32(0x7fff);
+    const __m128 scale = _mm_set1_ps(2.0f * ROTATION_COMPONENT_RANGE / ROTATION_COMPONENT_MAX);
+    const __m128 offset = _mm_set1_ps(-ROTATION_COMPONENT_RANGE);
+
+    const __m128i largest = _mm_or_si128(_mm_srli_epi32(a, 15), _mm_slli_epi32(_mm_srli_epi32(b, 15), 1));
+    const __m128 first = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(a, componentMask)), scale), offset);
+    const __m128 second = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(b, componentMask)), scale), offset);
+    const __m128 third = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(c, componentMask)), scale), offset);
+
+    const __m128 sumSquares = _mm_add_ps(_mm_add_ps(_mm_mul_ps(first, first), _mm_mul_ps(second, second)), _mm_mul_ps(third, third));
+    const __m128 restored = _mm_sqrt_ps(_mm_max_ps(_mm_setzero_ps(), _mm_sub_ps(_mm_set1_ps(1.0f), sumSquares)));
+
+    const __m128 isLargest0 = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(0)));
+    const __m128 isLargest1 = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(1)));
+    const __m128 isLargest2 = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(2)));
+    const __m128 isLargest3 = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(3)));
+
+    w = SelectPs(isLargest0, restored, first);
+    x = SelectPs(isLargest0, first, SelectPs(isLargest1, restored, second));
+    y = SelectPs(_mm_or_ps(isLargest0, isLargest1), second, SelectPs(isLargest2, restored, third));
+    z = SelectPs(isLargest3, restored, third);
+}
+#endif
+
+}
+
+void CompressedAnimation::Compress(ea::span<const AnimationTrack* const> tracks, float length,
+    const AnimationCompressionSettings& settings)
+{
+    length_ = length;
+    trackNameHashes_.clear();
+    positions_ = {};
+    rotations_ = {};
+    scales_ = {};
+
+    const auto lerpVector = [](const Vector3& lhs, const Vector3& rhs, float t) { return lhs.Lerp(rhs, t); };
+    const auto vectorError = [](const Vector3& lhs, const Vector3& rhs) { return (lhs - rhs).Length(); };
+    const auto nlerpRotation = [](const Quaternion& lhs, const Quaternion& rhs, float t) { return lhs.Nlerp(rhs, t, true); };
+    // Rotation error is the angle in degrees between the rotations
+    const auto rotationError = [](const Quaternion& lhs, const Quaternion& rhs)
+    {
+        return Acos(Abs(lhs.DotProduct(rhs))) * 2.0f;
+    };
+
+    const auto compressVectorChannel = [&](VectorChannel& channel, unsigned trackIndex, const AnimationTrack& track,
+        Vector3 Transform::*member, float maxError)
+    {
+        ea::vector<float> times;
+        ea::vector<Vector3> values;
+        for (const AnimationKeyFrame& keyFrame : track.keyFrames_)
+        {
+            times.push_back(keyFrame.time_);
+            values.push_back(keyFrame.*member);
+        }
+
+        const ea::vector<unsigned> keys = ReduceKeys(times, values, values, maxError, lerpVector, vectorError);
+        channel.trackIndices_.push_back(trackIndex);
+        channel.streams_.push_back({ channel.times_.size(), keys.size() });
+        for (unsigned key : keys)
+        {
+            channel.times_.push_back(times[key]);
+            channel.x_.push_back(values[key].x_);
+            channel.y_.push_back(values[key].y_);
+            channel.z_.push_back(values[key].z_);
+        }
+    };
+
+    const auto compressRotationChannel = [&](unsigned trackIndex, const AnimationTrack& track, float maxError)
+    {
+        ea::vector<float> times;
+        ea::vector<Quaternion> sourceValues;
+        ea::vector<Quaternion> keyValues;
+        ea::vector<unsigned short> a, b, c;
+        for (const AnimationKeyFrame& keyFrame : track.keyFrames_)
+        {
+            times.push_back(keyFrame.time_);
+            sourceValues.push_back(keyFrame.rotation_.Normalized());
+
+            a.push_back(0);
+            b.push_back(0);
+            c.push_back(0);
+            EncodeRotation(keyFrame.rotation_, a.back(), b.back(), c.back());
+            keyValues.push_back(DecodeRotation(a.back(), b.back(), c.back()));
+        }
+
+        const ea::vector<unsigned> keys = ReduceKeys(times, sourceValues, keyValues, maxError, nlerpRotation, rotationError);
+        rotations_.trackIndices_.push_back(trackIndex);
+        rotations_.streams_.push_back({ rotations_.times_.size(), keys.size() });
+        for (unsigned key : keys)
+        {
+            rotations_.times_.push_back(times[key]);
+            rotations_.a_.push_back(a[key]);
+            rotations_.b_.push_back(b[key]);
+            rotations_.c_.push_back(c[key]);
+        }
+    };
+
+    for (const AnimationTrack* sourceTrack : tracks)
+    {
+        // Tracks without keyframes are not sampled, so they don't get compressed index
+        const AnimationTrack& track = *sourceTrack;
+        if (track.keyFrames_.empty() || !(track.channelMask_ & (CHANNEL_POSITION | CHANNEL_ROTATION | CHANNEL_SCALE)))
+            continue;
+
+        const unsigned trackIndex = trackNameHashes_.size();
+        trackNameHashes_.push_back(track.nameHash_);
+
+        if (track.channelMask_ & CHANNEL_POSITION)
+            compressVectorChannel(positions_, trackIndex, track, &Transform::position_, settings.positionError_);
+        if (track.channelMask_ & CHANNEL_ROTATION)
+            compressRotationChannel(trackIndex, track, settings.rotationError_);
+        if (track.channelMask_ & CHANNEL_SCALE)
+            compressVectorChannel(scales_, trackIndex, track, &Transform::scale_, settings.scaleError_);
+    }
+}
+
+bool CompressedAnimation::Load(Deserializer& source)
+{
+    length_ = source.ReadFloat();
+    trackNameHashes_.resize(source.ReadUInt());
+    for (StringHash& nameHash : trackNameHashes_)
+        nameHash = source.ReadStringHash();
+
+    const auto readKeyStreams = [&](ea::vector<unsigned>& trackIndices, ea::vector<KeyStream>& streams, ea::vector<float>& times)
+    {
+        if (!ReadVector(source, trackIndices) || !ReadVector(source, streams) || !ReadVector(source, times))
+            return false;
+        if (trackIndices.size() != streams.size())
+            return false;
+
+        for (unsigned i = 0; i < streams.size(); ++i)
+        {
+            const KeyStream& stream = streams[i];
+            if (trackIndices[i] >= trackNameHashes_.size() || stream.numKeys_ == 0
+                || stream.firstKey_ + stream.numKeys_ > times.size())
+                return false;
+        }
+        return true;
+    };
+
+    const auto readVectorChannel = [&](VectorChannel& channel)
+    {
+        return readKeyStreams(channel.trackIndices_, channel.streams_, channel.times_)
+            && ReadVector(source, channel.x_) && ReadVector(source, channel.y_) && ReadVector(source, channel.z_)
+            && channel.x_.size() == channel.times_.size() && channel.y_.size() == channel.times_.size()
+            && channel.z_.size() == channel.times_.size();
+    };
+
+    const auto readRotationChannel = [&](RotationChannel& channel)
+    {
+        return readKeyStreams(channel.trackIndices_, channel.streams_, channel.times_)
+            && ReadVector(source, channel.a_) && ReadVector(source, channel.b_) && ReadVector(source, channel.c_)
+            && channel.a_.size() == channel.times_.size() && channel.b_.size() == channel.times_.size()
+            && channel.c_.size() == channel.times_.size();
+    };
+
+    if (!readVectorChannel(positions_) || !readRotationChannel(rotations_) || !readVectorChannel(scales_))
+    {
+        URHO3D_LOGERROR("Invalid compressed animation data in " + source.GetName());
+        return false;
+    }
+
+    return true;
+}
+
+bool CompressedAnimation::Save(Serializer& dest) const
+{
+    dest.WriteFloat(length_);
+    dest.WriteUInt(trackNameHashes_.size());
+    for (const StringHash& nameHash : trackNameHashes_)
+        dest.WriteStringHash(nameHash);
+
+    const auto writeVectorChannel = [&](const VectorChannel& channel)
+    {
+        WriteVector(dest, channel.trackIndices_);
+        WriteVector(dest, channel.streams_);
+        WriteVector(dest, channel.times_);
+        WriteVector(dest, channel.x_);
+        WriteVector(dest, channel.y_);
+        WriteVector(dest, channel.z_);
+    };
+
+    const auto writeRotationChannel = [&](const RotationChannel& channel)
+    {
+        WriteVector(dest, channel.trackIndices_);
+        WriteVector(dest, channel.streams_);
+        WriteVector(dest, channel.times_);
+        WriteVector(dest, channel.a_);
+        WriteVector(dest, channel.b_);
+        WriteVector(dest, channel.c_);
+    };
+
+    writeVectorChannel(positions_);
+    writeRotationChannel(rotations_);
+    writeVectorChannel(scales_);
+    return true;
+}
+
+void CompressedAnimation::Sample(float time, bool isLooped, ea::span<Transform> result) const
+{
+    assert(result.size() >= trackNameHashes_.size());
+
+    SampleVectorChannel(positions_, time, isLooped, result, &Transform::position_);
+    SampleRotationChannel(rotations_, time, isLooped, result);
+    SampleVectorChannel(scales_, time, isLooped, result, &Transform::scale_);
+}
+
+void CompressedAnimation::Decompress(unsigned trackIndex, AnimationTrack& track) const
+{
+    const auto findStream = [&](const ea::vector<unsigned>& trackIndices, const ea::vector<KeyStream>& streams) -> const KeyStream*
+    {
+        const auto iter = ea::lower_bound(trackIndices.begin(), trackIndices.end(), trackIndex);
+        return iter != trackIndices.end() && *iter == trackIndex ? &streams[iter - trackIndices.begin()] : nullptr;
+    };
+
+    const KeyStream* positionStream = findStream(positions_.trackIndices_, positions_.streams_);
+    const KeyStream* rotationStream = findStream(rotations_.trackIndices_, rotations_.streams_);
+    const KeyStream* scaleStream = findStream(scales_.trackIndices_, scales_.streams_);
+
+    // Keyframes are restored at the union of kept key times of all channels
+    ea::vector<float> times;
+    const auto addTimes = [&](const KeyStream* stream, const ea::vector<float>& channelTimes)
+    {
+        if (stream)
+            times.insert(times.end(), channelTimes.begin() + stream->firstKey_, channelTimes.begin() + stream->firstKey_ + stream->numKeys_);
+    };
+    addTimes(positionStream, positions_.times_);
+    addTimes(rotationStream, rotations_.times_);
+    addTimes(scaleStream, scales_.times_);
+    ea::sort(times.begin(), times.end());
+    times.erase(ea::unique(times.begin(), times.end()), times.end());
+
+    track.keyFrames_.clear();
+    for (float time : times)
+    {
+        AnimationKeyFrame keyFrame;
+        keyFrame.time_ = time;
+
+        unsigned key{};
+        unsigned nextKey{};
+        float blendFactor{};
+        if (positionStream)
+        {
+            FindKeys(*positionStream, positions_.times_, time, false, key, nextKey, blendFactor);
+            const Vector3 value{ positions_.x_[key], positions_.y_[key], positions_.z_[key] };
+            const Vector3 nextValue{ positions_.x_[nextKey], positions_.y_[nextKey], positions_.z_[nextKey] };
+            keyFrame.position_ = value.Lerp(nextValue, blendFactor);
+        }
+        if (rotationStream)
+        {
+            FindKeys(*rotationStream, rotations_.times_, time, false, key, nextKey, blendFactor);
+            const Quaternion value = DecodeRotation(rotations_.a_[key], rotations_.b_[key], rotations_.c_[key]);
+            const Quaternion nextValue = DecodeRotation(rotations_.a_[nextKey], rotations_.b_[nextKey], rotations_.c_[nextKey]);
+            keyFrame.rotation_ = value.Nlerp(nextValue, blendFactor, true);
+        }
+        if (scaleStream)
+        {
+            FindKeys(*scaleStream, scales_.times_, time, false, key, nextKey, blendFactor);
+            const Vector3 value{ scales_.x_[key], scales_.y_[key], scales_.z_[key] };
+            const Vector3 nextValue{ scales_.x_[nextKey], scales_.y_[nextKey], scales_.z_[nextKey] };
+            keyFrame.scale_ = value.Lerp(nextValue, blendFactor);
+        }
+
+        track.keyFrames_.push_back(keyFrame);
+    }
+}
+
+unsigned CompressedAnimation::GetTrackIndex(StringHash nameHash) const
+{
+    const auto iter = ea::find(trackNameHashes_.begin(), trackNameHashes_.end(), nameHash);
+    return iter != trackNameHashes_.end() ? static_cast<unsigned>(iter - trackNameHashes_.begin()) : M_MAX_UNSIGNED;
+}
+
+unsigned CompressedAnimation::GetNumKeys() const
+{
+    return positions_.times_.size() + rotations_.times_.size() + scales_.times_.size();
+}
+
+unsigned CompressedAnimation::GetMemoryUse() const
+{
+    const auto getVectorChannelMemoryUse = [](const VectorChannel& channel)
+    {
+        return GetVectorMemoryUse(channel.trackIndices_) + GetVectorMemoryUse(channel.streams_)
+            + GetVectorMemoryUse(channel.times_) + GetVectorMemoryUse(channel.x_)
+            + GetVectorMemoryUse(channel.y_) + GetVectorMemoryUse(channel.z_);
+    };
+
+    return sizeof(CompressedAnimation) + GetVectorMemoryUse(trackNameHashes_)
+        + getVectorChannelMemoryUse(positions_) + getVectorChannelMemoryUse(scales_)
+        + GetVectorMemoryUse(rotations_.trackIndices_) + GetVectorMemoryUse(rotations_.streams_)
+        + GetVectorMemoryUse(rotations_.times_) + GetVectorMemoryUse(rotations_.a_)
+        + GetVectorMemoryUse(rotations_.b_) + GetVectorMemoryUse(rotations_.c_);
+}
+
+void CompressedAnimation::SampleVectorChannel(const VectorChannel& channel, float time, bool isLooped,
+    ea::span<Transform> result, Vector3 Transform::*member) const
+{
+    const unsigned numTracks = channel.trackIndices_.size();
+    unsigned i = 0;
+
+#ifdef URHO3D_SSE
+    // Interpolate four tracks at once
+    for (; i + 4 <= numTracks; i += 4)
+    {
+        unsigned keys[4];
+        unsigned nextKeys[4];
+        float blendFactors[4];
+        for (unsigned j = 0; j < 4; ++j)
+            FindKeys(channel.streams_[i + j], channel.times_, time, isLooped, keys[j], nextKeys[j], blendFactors[j]);
+
+        const __m128 blendFactor = _mm_loadu_ps(blendFactors);
+        const auto interpolate = [&](const ea::vector<float>& values)
+        {
+            const __m128 value = _mm_setr_ps(values[keys[0]], values[keys[1]], values[keys[2]], values[keys[3]]);
+            const __m128 nextValue = _mm_setr_ps(values[nextKeys[0]], values[nextKeys[1]], values[nextKeys[2]], values[nextKeys[3]]);
+            return _mm_add_ps(value, _mm_mul_ps(_mm_sub_ps(nextValue, value), blendFactor));
+        };
+
+        alignas(16) float x[4];
+        alignas(16) float y[4];
+        alignas(16) float z[4];
+        _mm_store_ps(x, interpolate(channel.x_));
+        _mm_store_ps(y, interpolate(channel.y_));
+        _mm_store_ps(z, interpolate(channel.z_));
+
+        for (unsigned j = 0; j < 4; ++j)
+            result[channel.trackIndices_[i + j]].*member = Vector3{ x[j], y[j], z[j] };
+    }
+#endif
+
+    for (; i < numTracks; ++i)
+    {
+        unsigned key{};
+        unsigned nextKey{};
+        float blendFactor{};
+        FindKeys(channel.streams_[i], channel.times_, time, isLooped, key, nextKey, blendFactor);
+
+        const Vector3 value{ channel.x_[key], channel.y_[key], channel.z_[key] };
+        const Vector3 nextValue{ channel.x_[nextKey], channel.y_[nextKey], channel.z_[nextKey] };
+        result[channel.trackIndices_[i]].*member = value.Lerp(nextValue, blendFactor);
+    }
+}
+
+void CompressedAnimation::SampleRotationChannel(const RotationChannel& channel, float time, bool isLooped,
+    ea::span<Transform> result) const
+{
+    const unsigned numTracks = channel.trackIndices_.size();
+    unsigned i = 0;
+
+#ifdef URHO3D_SSE
+    // Decode and interpolate four tracks at once
+    for (; i + 4 <= numTracks; i += 4)
+    {
+        unsigned keys[4];
+        unsigned nextKeys[4];
+        float blendFactors[4];
+        for (unsigned j = 0; j < 4; ++j)
+            FindKeys(channel.streams_[i + j], channel.times_, time, isLooped, keys[j], nextKeys[j], blendFactors[j]);
+
+        const auto gather = [&](const ea::vector<unsigned short>& values, const unsigned* indices)
+        {
+            return _mm_setr_epi32(values[indices[0]], values[indices[1]], values[indices[2]], values[indices[3]]);
+        };
+
+        __m128 w0, x0, y0, z0;
+        __m128 w1, x1, y1, z1;
+        DecodeRotations(gather(channel.a_, keys), gather(channel.b_, keys), gather(channel.c_, keys), w0, x0, y0, z0);
+        DecodeRotations(gather(channel.a_, nextKeys), gather(channel.b_, nextKeys), gather(channel.c_, nextKeys), w1, x1, y1, z1);
+
+        // Normalized linear interpolation along the shortest path
+        const __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, w1), _mm_mul_ps(x0, x1)),
+            _mm_add_ps(_mm_mul_ps(y0, y1), _mm_mul_ps(z0, z1)));
+        const __m128 sign = _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), _mm_set1_ps(-0.0f));
+        const __m128 blendFactor = _mm_loadu_ps(blendFactors);
+        const auto interpolate = [&](__m128 value, __m128 nextValue)
+        {
+            return _mm_add_ps(value, _mm_mul_ps(_mm_sub_ps(_mm_xor_ps(nextValue, sign), value), blendFactor));
+        };
+
+        __m128 w = interpolate(w0, w1);
+        __m128 x = interpolate(x0, x1);
+        __m128 y = interpolate(y0, y1);
+        __m128 z = interpolate(z0, z1);
+        const __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w, w), _mm_mul_ps(x, x)),
+            _mm_add_ps(_mm_mul_ps(y, y), _mm_mul_ps(z, z)));
+        const __m128 invLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSquared));
+
+        alignas(16) float rotationW[4];
+        alignas(16) float rotationX[4];
+        alignas(16) float rotationY[4];
+        alignas(16) float rotationZ[4];
+        _mm_store_ps(rotationW, _mm_mul_ps(w, invLength));
+        _mm_store_ps(rotationX, _mm_mul_ps(x, invLength));
+        _mm_store_ps(rotationY, _mm_mul_ps(y, invLength));
+        _mm_store_ps(rotationZ, _mm_mul_ps(z, invLength));
+
+        for (unsigned j = 0; j < 4; ++j)
+            result[channel.trackIndices_[i + j]].rotation_ = Quaternion(rotationW[j], rotationX[j], rotationY[j], rotationZ[j]);
+    }
+#endif
+
+    for (; i < numTracks; ++i)
+    {
+        unsigned key{};
+        unsigned nextKey{};
+        float blendFactor{};
+        FindKeys(channel.streams_[i], channel.times_, time, isLooped, key, nextKey, blendFactor);
+
+        const Quaternion value = DecodeRotation(channel.a_[key], channel.b_[key], channel.c_[key]);
+        const Quaternion nextValue = DecodeRotation(channel.a_[nextKey], channel.b_[nextKey], channel.c_[nextKey]);
+        result[channel.trackIndices_[i]].rotation_ = value.Nlerp(nextValue, blendFactor, true);
+    }
+}
+
+void CompressedAnimation::FindKeys(const KeyStream& stream, const ea::vector<float>& times, float time, bool isLooped,
+    unsigned& key, unsigned& nextKey, float& blendFactor) const
+{
+    const float* streamTimes = times.data() + stream.firstKey_;
+    const unsigned numKeys = stream.numKeys_;
+
+    const unsigned upperKey = ea::upper_bound(streamTimes, streamTimes + numKeys, time) - streamTimes;
+    const unsigned keyIndex = upperKey > 0 ? upperKey - 1 : 0;
+    const unsigned nextKeyIndex = isLooped ? (keyIndex + 1) % numKeys : ea::min(keyIndex + 1, numKeys - 1);
+
+    blendFactor = 0.0f;
+    if (keyIndex != nextKeyIndex)
+    {
+        float timeInterval = streamTimes[nextKeyIndex] - streamTimes[keyIndex];
+        if (timeInterval < 0.0f)
+            timeInterval += length_;
+        blendFactor = timeInterval > 0.0f ? Clamp((time - streamTimes[keyIndex]) / timeInterval, 0.0f, 1.0f) : 1.0f;
+    }
+
+    key = stream.firstKey_ + keyIndex;
+    nextKey = stream.firstKey_ + nextKeyIndex;
+}
+
+}
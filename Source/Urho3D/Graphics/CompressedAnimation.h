@@ -0,0 +1,137 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+/// \file
+
+#pragma once
+
+#include "../Container/RefCounted.h"
+#include "../Math/StringHash.h"
+#include "../Math/Transform.h"
+
+#include <EASTL/span.h>
+#include <EASTL/vector.h>
+
+namespace Urho3D
+{
+
+class Deserializer;
+class Serializer;
+struct AnimationTrack;
+
+/// Error bounds of animation compression.
+struct AnimationCompressionSettings
+{
+    /// Maximum position error.
+    float positionError_{ 0.001f };
+    /// Maximum rotation error in degrees.
+    float rotationError_{ 0.1f };
+    /// Maximum scale error.
+    float scaleError_{ 0.001f };
+};
+
+/// Compressed transform tracks of an animation.
+/// Keys of each channel are reduced within error bounds and stored as separate time and value streams,
+/// rotations are quantized to smallest three components. All tracks are sampled at once.
+class URHO3D_API CompressedAnimation : public RefCounted
+{
+public:
+    /// Compress tracks. Tracks without keyframes are skipped.
+    void Compress(ea::span<const AnimationTrack* const> tracks, float length, const AnimationCompressionSettings& settings);
+    /// Load from stream. Return true if successful.
+    bool Load(Deserializer& source);
+    /// Save to stream. Return true if successful.
+    bool Save(Serializer& dest) const;
+
+    /// Sample all tracks at given time. Only the channels present in the track are written.
+    void Sample(float time, bool isLooped, ea::span<Transform> result) const;
+    /// Restore keyframes of a track from compressed keys.
+    void Decompress(unsigned trackIndex, AnimationTrack& track) const;
+
+    /// Return number of tracks.
+    unsigned GetNumTracks() const { return trackNameHashes_.size(); }
+    /// Return index of track by name hash, or M_MAX_UNSIGNED if not found.
+    unsigned GetTrackIndex(StringHash nameHash) const;
+    /// Return number of keys stored in all channels of all tracks.
+    unsigned GetNumKeys() const;
+    /// Return memory use in bytes.
+    unsigned GetMemoryUse() const;
+
+private:
+    /// Keys of a channel of a track.
+    struct KeyStream
+    {
+        /// Index of the first key.
+        unsigned firstKey_{};
+        /// Number of keys.
+        unsigned numKeys_{};
+    };
+
+    /// Position or scale keys of all tracks.
+    struct VectorChannel
+    {
+        /// Indices of tracks having the channel.
+        ea::vector<unsigned> trackIndices_;
+        /// Key streams of tracks having the channel.
+        ea::vector<KeyStream> streams_;
+        /// Key times.
+        ea::vector<float> times_;
+        /// Key values.
+        ea::vector<float> x_, y_, z_;
+    };
+
+    /// Rotation keys of all tracks. Quaternions are stored as three 15-bit components with the index of the omitted largest component in the high bits.
+    struct RotationChannel
+    {
+        /// Indices of tracks having the channel.
+        ea::vector<unsigned> trackIndices_;
+        /// Key streams of tracks having the channel.
+        ea::vector<KeyStream> streams_;
+        /// Key times.
+        ea::vector<float> times_;
+        /// Quantized key values.
+        ea::vector<unsigned short> a_, b_, c_;
+    };
+
+    /// Sample vector channel.
+    void SampleVectorChannel(const VectorChannel& channel, float time, bool isLooped,
+        ea::span<Transform> result, Vector3 Transform::*member) const;
+    /// Sample rotation channel.
+    void SampleRotationChannel(const RotationChannel& channel, float time, bool isLooped, ea::span<Transform> result) const;
+    /// Find keys to interpolate between and blend factor.
+    void FindKeys(const KeyStream& stream, const ea::vector<float>& times, float time, bool isLooped,
+        unsigned& key, unsigned& nextKey, float& blendFactor) const;
+
+    /// Animation length.
+    float length_{};
+    /// Track name hashes.
+    ea::vector<StringHash> trackNameHashes_;
+    /// Position keys.
+    VectorChannel positions_;
+    /// Rotation keys.
+    RotationChannel rotations_;
+    /// Scale keys.
+    VectorChannel scales_;
+};
+
+}
@@ -102,7 +102,7 @@ Drawable::~Drawable()
 void Drawable::RegisterObject(Context* context)
 {
     URHO3D_ATTRIBUTE("Max Lights", int, maxLights_, 0, AM_DEFAULT);
-    URHO3D_ATTRIBUTE("View Mask", int, viewMask_, DEFAULT_VIEWMASK, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("View Mask", GetViewMask, SetViewMask, unsigned, DEFAULT_VIEWMASK, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Light Mask", int, lightMask_, DEFAULT_LIGHTMASK, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Shadow Mask", int, shadowMask_, DEFAULT_SHADOWMASK, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Zone Mask", GetZoneMask, SetZoneMask, unsigned, DEFAULT_ZONEMASK, AM_DEFAULT);
@@ -195,6 +195,9 @@ void Drawable::SetLodBias(float bias)
 void Drawable::SetViewMask(unsigned mask)
 {
     viewMask_ = mask;
+    // View mask is stored in octant culling data
+    if (octant_)
+        octant_->UpdateCullingData(this);
     MarkNetworkUpdate();
 }
 
@@ -263,6 +266,12 @@ void Drawable::MarkForUpdate()
         octant_->GetOctree()->QueueUpdate(this);
 }
 
+void Drawable::MarkWorldBoundingBoxDirty()
+{
+    worldBoundingBoxDirty_ = true;
+    MarkForUpdate();
+}
+
 const BoundingBox& Drawable::GetWorldBoundingBox()
 {
     if (worldBoundingBoxDirty_)
@@ -410,9 +419,7 @@ void Drawable::OnSceneSet(Scene* scene)
 
 void Drawable::OnMarkedDirty(Node* node)
 {
-    worldBoundingBoxDirty_ = true;
-    if (!updateQueued_ && octant_)
-        octant_->GetOctree()->QueueUpdate(this);
+    MarkWorldBoundingBoxDirty();
 
     // Mark zone assignment dirty when transform changes
     if (node == node_)
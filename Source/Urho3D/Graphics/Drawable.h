@@ -29,6 +29,8 @@
 #include "../Math/BoundingBox.h"
 #include "../Scene/Component.h"
 
+#include <atomic>
+
 namespace Urho3D
 {
 
@@ -427,6 +429,8 @@ protected:
     void OnMarkedDirty(Node* node) override;
     /// Recalculate the world-space bounding box.
     virtual void OnWorldBoundingBoxUpdate() = 0;
+    /// Mark world-space bounding box dirty and queue octree update, so the octant culling data is refreshed.
+    void MarkWorldBoundingBoxDirty();
 
     /// Handle removal from octree.
     virtual void OnRemoveFromOctree() { }
@@ -459,12 +463,14 @@ protected:
     bool occluder_;
     /// Occludee flag.
     bool occludee_;
-    /// Octree update queued flag.
-    bool updateQueued_;
+    /// Octree update queued flag. May be set from worker threads.
+    std::atomic<bool> updateQueued_;
     /// Zone inconclusive or dirtied flag.
     bool zoneDirty_;
     /// Octree octant.
     Octant* octant_;
+    /// Index of Drawable in Octant. May be updated.
+    unsigned octantIndex_{};
     /// Index of Drawable in Scene. May be updated.
     unsigned drawableIndex_{ M_MAX_UNSIGNED };
     /// Current zone.
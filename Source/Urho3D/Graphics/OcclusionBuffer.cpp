@@ -29,6 +29,10 @@
 #include "../Graphics/OcclusionBuffer.h"
 #include "../IO/Log.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -45,12 +49,104 @@ enum ClipMask : unsigned
 };
 URHO3D_FLAGSET(ClipMask, ClipMaskFlags);
 
-void DrawOcclusionBatchWork(const WorkItem* item, unsigned threadIndex)
+namespace
+{
+
+/// Rasterize triangle into block of pixels. Edge and depth values are evaluated at the block origin.
+/// Return new maximum depth of the block.
+int RasterizeBlock(int* data, int stride, const OcclusionTriangle& triangle, const float* edgeValues, float depthValue)
 {
-    URHO3D_PROFILE("DrawOcclusionBatchWork");
-    auto* buffer = reinterpret_cast<OcclusionBuffer*>(item->aux_);
-    OcclusionBatch& batch = *reinterpret_cast<OcclusionBatch*>(item->start_);
-    buffer->DrawBatch(batch, threadIndex);
+    const Vector3* edges = triangle.edges_;
+    const Vector3& depthPlane = triangle.depthPlane_;
+
+#ifdef URHO3D_SSE
+    static_assert(OCCLUSION_BLOCK_WIDTH == 8, "Block row is processed as two vectors");
+
+    const __m128 laneOffsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    const __m128 laneStep = _mm_set1_ps(4.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    __m128 rowEdges[3];
+    __m128 edgeStepsX[3];
+    __m128 edgeStepsY[3];
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        const __m128 a = _mm_set1_ps(edges[i].x_);
+        rowEdges[i] = _mm_add_ps(_mm_set1_ps(edgeValues[i]), _mm_mul_ps(a, laneOffsets));
+        edgeStepsX[i] = _mm_mul_ps(a, laneStep);
+        edgeStepsY[i] = _mm_set1_ps(edges[i].y_);
+    }
+
+    const __m128 depthA = _mm_set1_ps(depthPlane.x_);
+    __m128 rowDepth = _mm_add_ps(_mm_set1_ps(depthValue), _mm_mul_ps(depthA, laneOffsets));
+    const __m128 depthStepX = _mm_mul_ps(depthA, laneStep);
+    const __m128 depthStepY = _mm_set1_ps(depthPlane.y_);
+    const __m128 minDepth = _mm_set1_ps(triangle.minDepth_);
+    const __m128 maxDepth = _mm_set1_ps(triangle.maxDepth_);
+
+    __m128 blockMaxDepth = zero;
+    for (int y = 0; y < OCCLUSION_BLOCK_HEIGHT; ++y)
+    {
+        __m128 edge0 = rowEdges[0];
+        __m128 edge1 = rowEdges[1];
+        __m128 edge2 = rowEdges[2];
+        __m128 depth = rowDepth;
+
+        for (int x = 0; x < OCCLUSION_BLOCK_WIDTH; x += 4)
+        {
+            const __m128 inside = _mm_and_ps(_mm_and_ps(
+                _mm_cmpge_ps(edge0, zero), _mm_cmpge_ps(edge1, zero)), _mm_cmpge_ps(edge2, zero));
+
+            auto* dest = reinterpret_cast<__m128i*>(data + y * stride + x);
+            const __m128i oldDepth = _mm_loadu_si128(dest);
+            const __m128i newDepth = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(depth, minDepth), maxDepth));
+            const __m128i write = _mm_and_si128(_mm_castps_si128(inside), _mm_cmplt_epi32(newDepth, oldDepth));
+            const __m128i resultDepth = _mm_or_si128(_mm_and_si128(write, newDepth), _mm_andnot_si128(write, oldDepth));
+            _mm_storeu_si128(dest, resultDepth);
+
+            // Depth values are integers not greater than 2^24, so they are exactly representable as floats
+            blockMaxDepth = _mm_max_ps(blockMaxDepth, _mm_cvtepi32_ps(resultDepth));
+
+            edge0 = _mm_add_ps(edge0, edgeStepsX[0]);
+            edge1 = _mm_add_ps(edge1, edgeStepsX[1]);
+            edge2 = _mm_add_ps(edge2, edgeStepsX[2]);
+            depth = _mm_add_ps(depth, depthStepX);
+        }
+
+        for (unsigned i = 0; i < 3; ++i)
+            rowEdges[i] = _mm_add_ps(rowEdges[i], edgeStepsY[i]);
+        rowDepth = _mm_add_ps(rowDepth, depthStepY);
+    }
+
+    blockMaxDepth = _mm_max_ps(blockMaxDepth, _mm_shuffle_ps(blockMaxDepth, blockMaxDepth, _MM_SHUFFLE(1, 0, 3, 2)));
+    blockMaxDepth = _mm_max_ps(blockMaxDepth, _mm_shuffle_ps(blockMaxDepth, blockMaxDepth, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_si32(blockMaxDepth);
+#else
+    int blockMaxDepth = 0;
+    for (int y = 0; y < OCCLUSION_BLOCK_HEIGHT; ++y)
+    {
+        for (int x = 0; x < OCCLUSION_BLOCK_WIDTH; ++x)
+        {
+            int& dest = data[y * stride + x];
+            bool inside = true;
+            for (unsigned i = 0; i < 3; ++i)
+            {
+                if (edgeValues[i] + edges[i].x_ * x + edges[i].y_ * y < 0.0f)
+                    inside = false;
+            }
+
+            if (inside)
+            {
+                const float depth = depthValue + depthPlane.x_ * x + depthPlane.y_ * y;
+                dest = Min(dest, RoundToInt(Clamp(depth, triangle.minDepth_, triangle.maxDepth_)));
+            }
+            blockMaxDepth = Max(blockMaxDepth, dest);
+        }
+    }
+    return blockMaxDepth;
+#endif
+}
+
 }
 
 OcclusionBuffer::OcclusionBuffer(Context* context) :
@@ -71,32 +167,33 @@ bool OcclusionBuffer::SetSize(int width, int height, bool threaded)
     if (height & 1u)
         ++height;
 
+    threaded_ = threaded;
+
     if (width == width_ && height == height_)
         return true;
 
     if (width <= 0 || height <= 0)
         return false;
 
-    if (!IsPowerOfTwo((unsigned)width))
+    if (!IsPowerOfTwo((unsigned)width) || width < OCCLUSION_BLOCK_WIDTH)
     {
-        URHO3D_LOGERRORF("Requested occlusion buffer width %d is not a power of two", width);
+        URHO3D_LOGERRORF("Requested occlusion buffer width %d is not a power of two or is less than %d", width,
+            OCCLUSION_BLOCK_WIDTH);
         return false;
     }
 
     width_ = width;
     height_ = height;
 
-    // Build work buffers for threading
-    unsigned numThreadBuffers = threaded ? GetSubsystem<WorkQueue>()->GetNumThreads() + 1 : 1;
-    buffers_.resize(numThreadBuffers);
-    for (unsigned i = 0; i < numThreadBuffers; ++i)
-    {
-        // Reserve extra memory in case 3D clipping is not exact
-        OcclusionBufferData& buffer = buffers_[i];
-        buffer.dataWithSafety_ = new int[width * (height + 2) + 2];
-        buffer.data_ = buffer.dataWithSafety_.get() + width + 1;
-        buffer.used_ = false;
-    }
+    // Pad height to whole blocks, padding rows are never read
+    numBlocksX_ = width_ / OCCLUSION_BLOCK_WIDTH;
+    const int numBlocksY = (height_ + OCCLUSION_BLOCK_HEIGHT - 1) / OCCLUSION_BLOCK_HEIGHT;
+    buffer_ = new int[width_ * numBlocksY * OCCLUSION_BLOCK_HEIGHT];
+    blockMaxDepth_.resize(numBlocksX_ * numBlocksY);
+
+    numTilesX_ = (width_ + OCCLUSION_TILE_WIDTH - 1) / OCCLUSION_TILE_WIDTH;
+    numTilesY_ = (height_ + OCCLUSION_TILE_HEIGHT - 1) / OCCLUSION_TILE_HEIGHT;
+    tileTriangles_.resize(numTilesX_ * numTilesY_);
 
     mipBuffers_.clear();
 
@@ -113,7 +210,7 @@ bool OcclusionBuffer::SetSize(int width, int height, bool threaded)
     }
 
     URHO3D_LOGDEBUG("Set occlusion buffer size " + ea::to_string(width_) + "x" + ea::to_string(height_) + " with " +
-             ea::to_string(mipBuffers_.size()) + " mip levels and " + ea::to_string(numThreadBuffers) + " thread buffers");
+             ea::to_string(mipBuffers_.size()) + " mip levels and " + ea::to_string(tileTriangles_.size()) + " tiles");
 
     CalculateViewport();
     return true;
@@ -160,10 +257,16 @@ void OcclusionBuffer::Clear()
 {
     Reset();
 
-    // Only clear the main thread buffer. Rest are cleared on-demand when drawing the first batch
-    ClearBuffer(0);
-    for (unsigned i = 1; i < buffers_.size(); ++i)
-        buffers_[i].used_ = false;
+    if (buffer_)
+    {
+        const auto fillValue = (int)OCCLUSION_Z_SCALE;
+        const unsigned numPixels = blockMaxDepth_.size() * OCCLUSION_BLOCK_WIDTH * OCCLUSION_BLOCK_HEIGHT;
+        ea::fill_n(buffer_.get(), numPixels, fillValue);
+        ea::fill(blockMaxDepth_.begin(), blockMaxDepth_.end(), fillValue);
+    }
+
+    reprojected_ = false;
+    reprojectionMargin_ = 0;
 
     depthHierarchyDirty_ = true;
 }
@@ -206,41 +309,118 @@ bool OcclusionBuffer::AddTriangles(const Matrix3x4& model, const void* vertexDat
 
 void OcclusionBuffer::DrawTriangles()
 {
-    if (buffers_.size() == 1)
+    if (buffer_ && !batches_.empty())
     {
-        // Not threaded
-        for (auto i = batches_.begin(); i != batches_.end(); ++i)
-            DrawBatch(*i, 0);
+        URHO3D_PROFILE("DrawOcclusionTriangles");
 
-        depthHierarchyDirty_ = true;
-    }
-    else if (buffers_.size() > 1)
-    {
-        // Threaded
-        auto* queue = GetSubsystem<WorkQueue>();
+        auto* queue = threaded_ ? GetSubsystem<WorkQueue>() : nullptr;
+        triangles_.Clear();
 
-        for (auto i = batches_.begin(); i != batches_.end(); ++i)
+        // Transform and clip triangles
+        if (queue)
         {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = DrawOcclusionBatchWork;
-            item->aux_ = this;
-            item->start_ = &(*i);
-            queue->AddWorkItem(item);
+            std::atomic<unsigned> numTriangles{};
+            ForEachParallel(queue, batches_, [&](unsigned /*index*/, const OcclusionBatch& batch)
+            {
+                numTriangles += DrawBatch(batch);
+            });
+            numTriangles_ += numTriangles;
+        }
+        else
+        {
+            for (const OcclusionBatch& batch : batches_)
+                numTriangles_ += DrawBatch(batch);
         }
 
-        queue->Complete(M_MAX_UNSIGNED);
-
-        MergeBuffers();
-        depthHierarchyDirty_ = true;
+        RasterizeTriangles(queue);
     }
 
     batches_.clear();
 }
 
+bool OcclusionBuffer::Reproject(const OcclusionBuffer& previous)
+{
+    if (!buffer_ || previous.width_ != width_ || previous.height_ != height_ || previous.depthHierarchyDirty_)
+        return false;
+
+    URHO3D_PROFILE("ReprojectOcclusion");
+
+    // Each texel of the second mip level covers 4x4 pixels, small buffers may have only one mip level
+    const unsigned mipLevel = Min(1u, static_cast<unsigned>(mipBuffers_.size()) - 1);
+    const int cellSize = 2 << mipLevel;
+    const int mipWidth = (width_ + cellSize - 1) / cellSize;
+    const int mipHeight = (height_ + cellSize - 1) / cellSize;
+    const DepthValue* mipBuffer = previous.mipBuffers_[mipLevel].get();
+
+    // Transform from previous clip space to current clip space
+    const Matrix4 reprojection = viewProj_ * previous.viewProj_.Inverse();
+
+    auto* queue = threaded_ ? GetSubsystem<WorkQueue>() : nullptr;
+    triangles_.Clear();
+
+    // Replace each fully covered cell with a quad at the farthest depth of the cell.
+    // Uncovered cells and gaps between cells stay empty, so they never occlude.
+    const auto reprojectRows = [&](unsigned beginY, unsigned endY)
+    {
+        // Theoretical max. amount of vertices if each of the 6 clipping planes doubles the triangle count
+        Vector4 vertices[64 * 3];
+        for (int y = static_cast<int>(beginY); y < static_cast<int>(endY); ++y)
+        {
+            // Pixel (x, y) is sampled at (x + 1, y + 1), so cell edges are half pixel apart from sample positions
+            const float top = (y * cellSize + 0.5f - previous.offsetY_) / previous.scaleY_;
+            const float bottom = (Min((y + 1) * cellSize, height_) + 0.5f - previous.offsetY_) / previous.scaleY_;
+
+            for (int x = 0; x < mipWidth; ++x)
+            {
+                const int maxDepth = mipBuffer[y * mipWidth + x].max_;
+                if (maxDepth >= static_cast<int>(OCCLUSION_Z_SCALE))
+                    continue;
+
+                const float left = (x * cellSize + 0.5f - previous.offsetX_) / previous.scaleX_;
+                const float right = (Min((x + 1) * cellSize, width_) + 0.5f - previous.offsetX_) / previous.scaleX_;
+                const float depth = maxDepth / OCCLUSION_Z_SCALE;
+
+                const Vector4 corners[4] = {
+                    reprojection * Vector4{ left, top, depth, 1.0f },
+                    reprojection * Vector4{ right, top, depth, 1.0f },
+                    reprojection * Vector4{ right, bottom, depth, 1.0f },
+                    reprojection * Vector4{ left, bottom, depth, 1.0f },
+                };
+
+                vertices[0] = corners[0];
+                vertices[1] = corners[1];
+                vertices[2] = corners[2];
+                DrawTriangle(vertices);
+
+                vertices[0] = corners[2];
+                vertices[1] = corners[3];
+                vertices[2] = corners[0];
+                DrawTriangle(vertices);
+            }
+        }
+    };
+
+    // Reprojected quads may face either way in the current view
+    const CullMode cullMode = cullMode_;
+    cullMode_ = CULL_NONE;
+    if (queue)
+        ForEachParallel(queue, 1, static_cast<unsigned>(mipHeight), reprojectRows);
+    else
+        reprojectRows(0, mipHeight);
+    cullMode_ = cullMode;
+
+    RasterizeTriangles(queue);
+    reprojected_ = true;
+
+    // Cells are flattened to their farthest depth, so when the view changes, reprojected depth may spill over
+    // silhouettes of occluders. Boxes are culled only if their neighborhood of one cell is occluded too.
+    reprojectionMargin_ = viewProj_.Equals(previous.viewProj_) ? 0 : cellSize;
+    return true;
+}
+
 void OcclusionBuffer::BuildDepthHierarchy()
 {
-    if (buffers_.empty() || !depthHierarchyDirty_)
+    if (!buffer_ || !depthHierarchyDirty_)
         return;
 
     URHO3D_PROFILE("BuildDepthHierarchy");
@@ -252,7 +432,7 @@ void OcclusionBuffer::BuildDepthHierarchy()
     {
         for (int y = 0; y < height; ++y)
         {
-            int* src = buffers_[0].data_ + (y * 2) * width_;
+            int* src = buffer_.get() + (y * 2) * width_;
             DepthValue* dest = mipBuffers_[0].get() + y * width;
             DepthValue* end = dest + width;
 
@@ -342,7 +522,7 @@ void OcclusionBuffer::ResetUseTimer()
 
 bool OcclusionBuffer::IsVisible(const BoundingBox& worldSpaceBox) const
 {
-    if (buffers_.empty())
+    if (!buffer_)
         return true;
 
     // Transform corners to projection space
@@ -386,8 +566,115 @@ bool OcclusionBuffer::IsVisible(const BoundingBox& worldSpaceBox) const
         if (projected.z_ < minZ) minZ = projected.z_;
     }
 
+    return IsProjectedBoxVisible(minX, minY, maxX, maxY, minZ);
+}
+
+void OcclusionBuffer::AreVisible(ea::span<const BoundingBox> worldSpaceBoxes, ea::span<bool> result) const
+{
+    const unsigned numBoxes = worldSpaceBoxes.size();
+    assert(result.size() >= numBoxes);
+
+    unsigned boxIndex = 0;
+#ifdef URHO3D_SSE
+    if (buffer_)
+    {
+        const Matrix4& m = viewProj_;
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 bias = _mm_set1_ps(OCCLUSION_RELATIVE_BIAS);
+        const __m128 scaleX = _mm_set1_ps(scaleX_);
+        const __m128 scaleY = _mm_set1_ps(scaleY_);
+        const __m128 scaleZ = _mm_set1_ps(OCCLUSION_Z_SCALE);
+        const __m128 offsetX = _mm_set1_ps(offsetX_);
+        const __m128 offsetY = _mm_set1_ps(offsetY_);
+
+        // Project corners of 4 boxes at once
+        for (; boxIndex + 4 <= numBoxes; boxIndex += 4)
+        {
+            const BoundingBox* boxes = &worldSpaceBoxes[boxIndex];
+            const __m128 boxMin[3] = {
+                _mm_setr_ps(boxes[0].min_.x_, boxes[1].min_.x_, boxes[2].min_.x_, boxes[3].min_.x_),
+                _mm_setr_ps(boxes[0].min_.y_, boxes[1].min_.y_, boxes[2].min_.y_, boxes[3].min_.y_),
+                _mm_setr_ps(boxes[0].min_.z_, boxes[1].min_.z_, boxes[2].min_.z_, boxes[3].min_.z_) };
+            const __m128 boxMax[3] = {
+                _mm_setr_ps(boxes[0].max_.x_, boxes[1].max_.x_, boxes[2].max_.x_, boxes[3].max_.x_),
+                _mm_setr_ps(boxes[0].max_.y_, boxes[1].max_.y_, boxes[2].max_.y_, boxes[3].max_.y_),
+                _mm_setr_ps(boxes[0].max_.z_, boxes[1].max_.z_, boxes[2].max_.z_, boxes[3].max_.z_) };
+
+            __m128 minX = _mm_set1_ps(M_INFINITY);
+            __m128 minY = minX;
+            __m128 minZ = minX;
+            __m128 maxX = _mm_set1_ps(-M_INFINITY);
+            __m128 maxY = maxX;
+            __m128 crossesNearPlane = zero;
+
+            for (unsigned corner = 0; corner < 8; ++corner)
+            {
+                const __m128 x = (corner & 1u) ? boxMax[0] : boxMin[0];
+                const __m128 y = (corner & 2u) ? boxMax[1] : boxMin[1];
+                const __m128 z = (corner & 4u) ? boxMax[2] : boxMin[2];
+
+                const auto transformRow = [&](float m0, float m1, float m2, float m3)
+                {
+                    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m0), x), _mm_mul_ps(_mm_set1_ps(m1), y)),
+                        _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m2), z), _mm_set1_ps(m3)));
+                };
+                const __m128 clipX = transformRow(m.m00_, m.m01_, m.m02_, m.m03_);
+                const __m128 clipY = transformRow(m.m10_, m.m11_, m.m12_, m.m13_);
+                const __m128 clipZ = _mm_sub_ps(transformRow(m.m20_, m.m21_, m.m22_, m.m23_), bias);
+                const __m128 clipW = transformRow(m.m30_, m.m31_, m.m32_, m.m33_);
+
+                crossesNearPlane = _mm_or_ps(crossesNearPlane, _mm_cmple_ps(clipZ, zero));
+
+                const __m128 invW = _mm_div_ps(one, clipW);
+                const __m128 projectedX = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(invW, clipX), scaleX), offsetX);
+                const __m128 projectedY = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(invW, clipY), scaleY), offsetY);
+                const __m128 projectedZ = _mm_mul_ps(_mm_mul_ps(invW, clipZ), scaleZ);
+
+                minX = _mm_min_ps(minX, projectedX);
+                maxX = _mm_max_ps(maxX, projectedX);
+                minY = _mm_min_ps(minY, projectedY);
+                maxY = _mm_max_ps(maxY, projectedY);
+                minZ = _mm_min_ps(minZ, projectedZ);
+            }
+
+            alignas(16) float minXs[4];
+            alignas(16) float minYs[4];
+            alignas(16) float maxXs[4];
+            alignas(16) float maxYs[4];
+            alignas(16) float minZs[4];
+            _mm_store_ps(minXs, minX);
+            _mm_store_ps(minYs, minY);
+            _mm_store_ps(maxXs, maxX);
+            _mm_store_ps(maxYs, maxY);
+            _mm_store_ps(minZs, minZ);
+            const int crossesNearPlaneMask = _mm_movemask_ps(crossesNearPlane);
+
+            // If any of the corners cross the near plane, assume visible
+            for (unsigned i = 0; i < 4; ++i)
+            {
+                result[boxIndex + i] = (crossesNearPlaneMask & (1 << i))
+                    || IsProjectedBoxVisible(minXs[i], minYs[i], maxXs[i], maxYs[i], minZs[i]);
+            }
+        }
+    }
+#endif
+
+    for (; boxIndex < numBoxes; ++boxIndex)
+        result[boxIndex] = IsVisible(worldSpaceBoxes[boxIndex]);
+}
+
+bool OcclusionBuffer::IsProjectedBoxVisible(float minX, float minY, float maxX, float maxY, float minZ) const
+{
     // Expand the bounding box 1 pixel in each direction to be conservative and correct rasterization offset
     IntRect rect((int)(minX - 1.5f), (int)(minY - 1.5f), RoundToInt(maxX), RoundToInt(maxY));
+    if (reprojectionMargin_)
+    {
+        rect.left_ -= reprojectionMargin_;
+        rect.top_ -= reprojectionMargin_;
+        rect.right_ += reprojectionMargin_;
+        rect.bottom_ += reprojectionMargin_;
+    }
 
     // If the rect is outside, let frustum culling handle
     if (rect.right_ < 0 || rect.bottom_ < 0)
@@ -444,8 +731,8 @@ bool OcclusionBuffer::IsVisible(const BoundingBox& worldSpaceBox) const
     }
 
     // If no conclusive result, finally check the pixel-level data
-    int* row = buffers_[0].data_ + rect.top_ * width_;
-    int* endRow = buffers_[0].data_ + rect.bottom_ * width_;
+    int* row = buffer_.get() + rect.top_ * width_;
+    int* endRow = buffer_.get() + rect.bottom_ * width_;
     while (row <= endRow)
     {
         int* src = row + rect.left_;
@@ -467,16 +754,9 @@ unsigned OcclusionBuffer::GetUseTimer()
     return useTimer_.GetMSec(false);
 }
 
-
-void OcclusionBuffer::DrawBatch(const OcclusionBatch& batch, unsigned threadIndex)
+unsigned OcclusionBuffer::DrawBatch(const OcclusionBatch& batch)
 {
-    // If buffer not yet used, clear it
-    if (threadIndex > 0 && !buffers_[threadIndex].used_)
-    {
-        ClearBuffer(threadIndex);
-        buffers_[threadIndex].used_ = true;
-    }
-
+    unsigned numTriangles = 0;
     Matrix4 modelViewProj = viewProj_ * batch.model_;
 
     // Theoretical max. amount of vertices if each of the 6 clipping planes doubles the triangle count
@@ -496,7 +776,8 @@ void OcclusionBuffer::DrawBatch(const OcclusionBatch& batch, unsigned threadInde
             vertices[0] = ModelTransform(modelViewProj, v0);
             vertices[1] = ModelTransform(modelViewProj, v1);
             vertices[2] = ModelTransform(modelViewProj, v2);
-            DrawTriangle(vertices, threadIndex);
+            if (DrawTriangle(vertices))
+                ++numTriangles;
 
             index += 3;
         }
@@ -520,7 +801,8 @@ void OcclusionBuffer::DrawBatch(const OcclusionBatch& batch, unsigned threadInde
                 vertices[0] = ModelTransform(modelViewProj, v0);
                 vertices[1] = ModelTransform(modelViewProj, v1);
                 vertices[2] = ModelTransform(modelViewProj, v2);
-                DrawTriangle(vertices, threadIndex);
+                if (DrawTriangle(vertices))
+                    ++numTriangles;
 
                 indices += 3;
             }
@@ -539,12 +821,15 @@ void OcclusionBuffer::DrawBatch(const OcclusionBatch& batch, unsigned threadInde
                 vertices[0] = ModelTransform(modelViewProj, v0);
                 vertices[1] = ModelTransform(modelViewProj, v1);
                 vertices[2] = ModelTransform(modelViewProj, v2);
-                DrawTriangle(vertices, threadIndex);
+                if (DrawTriangle(vertices))
+                    ++numTriangles;
 
                 indices += 3;
             }
         }
     }
+
+    return numTriangles;
 }
 
 inline Vector4 OcclusionBuffer::ModelTransform(const Matrix4& transform, const Vector3& vertex) const
@@ -593,7 +878,7 @@ void OcclusionBuffer::CalculateViewport()
     projOffsetScaleY_ = projection_.m11_ * scaleY_;
 }
 
-void OcclusionBuffer::DrawTriangle(Vector4* vertices, unsigned threadIndex)
+bool OcclusionBuffer::DrawTriangle(Vector4* vertices)
 {
     ClipMaskFlags clipMask{};
     ClipMaskFlags andClipMask{};
@@ -628,7 +913,7 @@ void OcclusionBuffer::DrawTriangle(Vector4* vertices, unsigned threadIndex)
 
     // If triangle is fully behind any clip plane, can reject quickly
     if (andClipMask)
-        return;
+        return false;
 
     // Check if triangle is fully inside
     if (!clipMask)
@@ -640,7 +925,7 @@ void OcclusionBuffer::DrawTriangle(Vector4* vertices, unsigned threadIndex)
         bool clockwise = SignedArea(projected[0], projected[1], projected[2]) < 0.0f;
         if (cullMode_ == CULL_NONE || (cullMode_ == CULL_CCW && clockwise) || (cullMode_ == CULL_CW && !clockwise))
         {
-            DrawTriangle2D(projected, clockwise, threadIndex);
+            DrawTriangle2D(projected);
             drawOk = true;
         }
     }
@@ -678,15 +963,14 @@ void OcclusionBuffer::DrawTriangle(Vector4* vertices, unsigned threadIndex)
                 bool clockwise = SignedArea(projected[0], projected[1], projected[2]) < 0.0f;
                 if (cullMode_ == CULL_NONE || (cullMode_ == CULL_CCW && clockwise) || (cullMode_ == CULL_CW && !clockwise))
                 {
-                    DrawTriangle2D(projected, clockwise, threadIndex);
+                    DrawTriangle2D(projected);
                     drawOk = true;
                 }
             }
         }
     }
 
-    if (drawOk)
-        ++numTriangles_;
+    return drawOk;
 }
 
 void OcclusionBuffer::ClipVertices(const Vector4& plane, Vector4* vertices, bool* triangles, unsigned& numTriangles)
@@ -759,290 +1043,169 @@ void OcclusionBuffer::ClipVertices(const Vector4& plane, Vector4* vertices, bool
     }
 }
 
-// Code based on Chris Hecker's Perspective Texture Mapping series in the Game Developer magazine
-// Also available online at http://chrishecker.com/Miscellaneous_Technical_Articles
-
-/// %Gradients of a software rasterized triangle.
-struct Gradients
+void OcclusionBuffer::DrawTriangle2D(const Vector3* vertices)
 {
-    /// Construct from vertices.
-    explicit Gradients(const Vector3* vertices)
-    {
-        float invdX = 1.0f / (((vertices[1].x_ - vertices[2].x_) *
-                               (vertices[0].y_ - vertices[2].y_)) -
-                              ((vertices[0].x_ - vertices[2].x_) *
-                               (vertices[1].y_ - vertices[2].y_)));
-
-        float invdY = -invdX;
-
-        dInvZdX_ = invdX * (((vertices[1].z_ - vertices[2].z_) * (vertices[0].y_ - vertices[2].y_)) -
-                            ((vertices[0].z_ - vertices[2].z_) * (vertices[1].y_ - vertices[2].y_)));
-
-        dInvZdY_ = invdY * (((vertices[1].z_ - vertices[2].z_) * (vertices[0].x_ - vertices[2].x_)) -
-                            ((vertices[0].z_ - vertices[2].z_) * (vertices[1].x_ - vertices[2].x_)));
+    // Pixel (x, y) is sampled at (x + 1, y + 1) because viewport transform includes half pixel offset
+    const Vector2 v0{ vertices[0].x_ - 1.0f, vertices[0].y_ - 1.0f };
+    const Vector2 v1{ vertices[1].x_ - 1.0f, vertices[1].y_ - 1.0f };
+    const Vector2 v2{ vertices[2].x_ - 1.0f, vertices[2].y_ - 1.0f };
+
+    IntRect rect;
+    rect.left_ = Max(CeilToInt(Min(Min(v0.x_, v1.x_), v2.x_)), 0);
+    rect.top_ = Max(CeilToInt(Min(Min(v0.y_, v1.y_), v2.y_)), 0);
+    rect.right_ = Min(FloorToInt(Max(Max(v0.x_, v1.x_), v2.x_)), width_ - 1);
+    rect.bottom_ = Min(FloorToInt(Max(Max(v0.y_, v1.y_), v2.y_)), height_ - 1);
+
+    // Check for triangle that covers no pixel centers
+    if (rect.left_ > rect.right_ || rect.top_ > rect.bottom_)
+        return;
 
-        dInvZdXInt_ = (int)dInvZdX_;
-    }
+    // Edge function is zero at the edge and equal to doubled triangle area at the opposite vertex
+    const auto makeEdge = [](const Vector2& from, const Vector2& to)
+    {
+        return Vector3{ from.y_ - to.y_, to.x_ - from.x_, from.x_ * to.y_ - from.y_ * to.x_ };
+    };
+    Vector3 edge0 = makeEdge(v1, v2);
+    Vector3 edge1 = makeEdge(v2, v0);
+    Vector3 edge2 = makeEdge(v0, v1);
 
-    /// Integer horizontal gradient.
-    int dInvZdXInt_;
-    /// Horizontal gradient.
-    float dInvZdX_;
-    /// Vertical gradient.
-    float dInvZdY_;
-};
+    // Check for degenerate triangle
+    float area = edge0.x_ * v0.x_ + edge0.y_ * v0.y_ + edge0.z_;
+    if (Abs(area) < M_EPSILON)
+        return;
 
-/// %Edge of a software rasterized triangle.
-struct Edge
-{
-    /// Construct from gradients and top & bottom vertices.
-    Edge(const Gradients& gradients, const Vector3& top, const Vector3& bottom, int topY)
+    // Make edge functions positive inside regardless of winding
+    if (area < 0.0f)
     {
-        float height = (bottom.y_ - top.y_);
-        float slope = (height != 0.0f) ? (bottom.x_ - top.x_) / height : 0.0f;
-        float yPreStep = (float)(topY + 1) - top.y_;
-        float xPreStep = slope * yPreStep;
-
-        x_ = RoundToInt((xPreStep + top.x_) * OCCLUSION_X_SCALE);
-        xStep_ = RoundToInt(slope * OCCLUSION_X_SCALE);
-        invZ_ = RoundToInt(top.z_ + xPreStep * gradients.dInvZdX_ + yPreStep * gradients.dInvZdY_);
-        invZStep_ = RoundToInt(slope * gradients.dInvZdX_ + gradients.dInvZdY_);
+        edge0 = -edge0;
+        edge1 = -edge1;
+        edge2 = -edge2;
+        area = -area;
     }
 
-    /// X coordinate.
-    int x_;
-    /// X coordinate step.
-    int xStep_;
-    /// Inverse Z.
-    int invZ_;
-    /// Inverse Z step.
-    int invZStep_;
-};
+    // Barycentric coordinates are edge functions divided by area, so depth is linear in screen space
+    const float z0 = vertices[0].z_;
+    const float z1 = vertices[1].z_;
+    const float z2 = vertices[2].z_;
+
+    OcclusionTriangle& triangle = triangles_.Emplace();
+    triangle.edges_[0] = edge0;
+    triangle.edges_[1] = edge1;
+    triangle.edges_[2] = edge2;
+    triangle.depthPlane_ = (edge0 * z0 + edge1 * z1 + edge2 * z2) / area;
+    triangle.minDepth_ = Min(Min(z0, z1), z2);
+    triangle.maxDepth_ = Max(Max(z0, z1), z2);
+    triangle.rect_ = rect;
+}
 
-void OcclusionBuffer::DrawTriangle2D(const Vector3* vertices, bool clockwise, unsigned threadIndex)
+void OcclusionBuffer::RasterizeTriangles(WorkQueue* queue)
 {
-    int top, middle, bottom;
-    bool middleIsRight;
-
-    // Sort vertices in Y-direction
-    if (vertices[0].y_ < vertices[1].y_)
+    if (queue)
     {
-        if (vertices[2].y_ < vertices[0].y_)
-        {
-            top = 2;
-            middle = 0;
-            bottom = 1;
-            middleIsRight = true;
-        }
-        else
+        // Each tile owns its pixels, so tiles are rasterized independently
+        BinTriangles();
+        ForEachParallel(queue, 1, tileTriangles_.size(), [this](unsigned beginIndex, unsigned endIndex)
         {
-            top = 0;
-            if (vertices[1].y_ < vertices[2].y_)
-            {
-                middle = 1;
-                bottom = 2;
-                middleIsRight = true;
-            }
-            else
-            {
-                middle = 2;
-                bottom = 1;
-                middleIsRight = false;
-            }
-        }
+            for (unsigned tileIndex = beginIndex; tileIndex < endIndex; ++tileIndex)
+                RasterizeTile(tileIndex);
+        });
     }
     else
     {
-        if (vertices[2].y_ < vertices[1].y_)
-        {
-            top = 2;
-            middle = 1;
-            bottom = 0;
-            middleIsRight = false;
-        }
-        else
-        {
-            top = 1;
-            if (vertices[0].y_ < vertices[2].y_)
-            {
-                middle = 0;
-                bottom = 2;
-                middleIsRight = false;
-            }
-            else
-            {
-                middle = 2;
-                bottom = 0;
-                middleIsRight = true;
-            }
-        }
+        // Binning doesn't pay off on single thread, rasterize whole triangles in submission order
+        const IntRect bufferRect{ 0, 0, width_ - 1, height_ - 1 };
+        for (const OcclusionTriangle& triangle : triangles_)
+            RasterizeTriangle(triangle, bufferRect);
     }
 
-    auto topY = (int)vertices[top].y_;
-    auto middleY = (int)vertices[middle].y_;
-    auto bottomY = (int)vertices[bottom].y_;
-
-    // Check for degenerate triangle
-    if (topY == bottomY)
-        return;
-
-    // Reverse middleIsRight test if triangle is counterclockwise
-    if (!clockwise)
-        middleIsRight = !middleIsRight;
-
-    const bool topDegenerate = topY == middleY;
-    const bool bottomDegenerate = middleY == bottomY;
-
-    Gradients gradients(vertices);
-    Edge topToBottom(gradients, vertices[top], vertices[bottom], topY);
+    depthHierarchyDirty_ = true;
+}
 
-    int* bufferData = buffers_[threadIndex].data_;
+void OcclusionBuffer::BinTriangles()
+{
+    for (auto& tile : tileTriangles_)
+        tile.clear();
 
-    if (middleIsRight)
+    for (const OcclusionTriangle& triangle : triangles_)
     {
-        // Top half
-        if (!topDegenerate)
-        {
-            Edge topToMiddle(gradients, vertices[top], vertices[middle], topY);
-            int* row = bufferData + topY * width_;
-            int* endRow = bufferData + middleY * width_;
-            while (row < endRow)
-            {
-                int invZ = topToBottom.invZ_;
-                int* dest = row + (topToBottom.x_ >> 16u);
-                int* end = row + (topToMiddle.x_ >> 16u);
-                while (dest < end)
-                {
-                    if (invZ < *dest)
-                        *dest = invZ;
-                    invZ += gradients.dInvZdXInt_;
-                    ++dest;
-                }
-
-                topToBottom.x_ += topToBottom.xStep_;
-                topToBottom.invZ_ += topToBottom.invZStep_;
-                topToMiddle.x_ += topToMiddle.xStep_;
-                row += width_;
-            }
-        }
+        const IntRect& rect = triangle.rect_;
+        const int beginTileX = rect.left_ / OCCLUSION_TILE_WIDTH;
+        const int endTileX = rect.right_ / OCCLUSION_TILE_WIDTH;
+        const int beginTileY = rect.top_ / OCCLUSION_TILE_HEIGHT;
+        const int endTileY = rect.bottom_ / OCCLUSION_TILE_HEIGHT;
 
-        // Bottom half
-        if (!bottomDegenerate)
+        for (int tileY = beginTileY; tileY <= endTileY; ++tileY)
         {
-            Edge middleToBottom(gradients, vertices[middle], vertices[bottom], middleY);
-            int* row = bufferData + middleY * width_;
-            int* endRow = bufferData + bottomY * width_;
-            while (row < endRow)
-            {
-                int invZ = topToBottom.invZ_;
-                int* dest = row + (topToBottom.x_ >> 16u);
-                int* end = row + (middleToBottom.x_ >> 16u);
-                while (dest < end)
-                {
-                    if (invZ < *dest)
-                        *dest = invZ;
-                    invZ += gradients.dInvZdXInt_;
-                    ++dest;
-                }
-
-                topToBottom.x_ += topToBottom.xStep_;
-                topToBottom.invZ_ += topToBottom.invZStep_;
-                middleToBottom.x_ += middleToBottom.xStep_;
-                row += width_;
-            }
+            for (int tileX = beginTileX; tileX <= endTileX; ++tileX)
+                tileTriangles_[tileY * numTilesX_ + tileX].push_back(&triangle);
         }
     }
-    else
-    {
-        // Top half
-        if (!topDegenerate)
-        {
-            Edge topToMiddle(gradients, vertices[top], vertices[middle], topY);
-            int* row = bufferData + topY * width_;
-            int* endRow = bufferData + middleY * width_;
-            while (row < endRow)
-            {
-                int invZ = topToMiddle.invZ_;
-                int* dest = row + (topToMiddle.x_ >> 16u);
-                int* end = row + (topToBottom.x_ >> 16u);
-                while (dest < end)
-                {
-                    if (invZ < *dest)
-                        *dest = invZ;
-                    invZ += gradients.dInvZdXInt_;
-                    ++dest;
-                }
-
-                topToMiddle.x_ += topToMiddle.xStep_;
-                topToMiddle.invZ_ += topToMiddle.invZStep_;
-                topToBottom.x_ += topToBottom.xStep_;
-                row += width_;
-            }
-        }
+}
 
-        // Bottom half
-        if (!bottomDegenerate)
-        {
-            Edge middleToBottom(gradients, vertices[middle], vertices[bottom], middleY);
-            int* row = bufferData + middleY * width_;
-            int* endRow = bufferData + bottomY * width_;
-            while (row < endRow)
-            {
-                int invZ = middleToBottom.invZ_;
-                int* dest = row + (middleToBottom.x_ >> 16u);
-                int* end = row + (topToBottom.x_ >> 16u);
-                while (dest < end)
-                {
-                    if (invZ < *dest)
-                        *dest = invZ;
-                    invZ += gradients.dInvZdXInt_;
-                    ++dest;
-                }
+void OcclusionBuffer::RasterizeTile(unsigned tileIndex)
+{
+    const int left = static_cast<int>(tileIndex) % numTilesX_ * OCCLUSION_TILE_WIDTH;
+    const int top = static_cast<int>(tileIndex) / numTilesX_ * OCCLUSION_TILE_HEIGHT;
+    const IntRect tileRect{ left, top,
+        Min(left + OCCLUSION_TILE_WIDTH, width_) - 1, Min(top + OCCLUSION_TILE_HEIGHT, height_) - 1 };
 
-                middleToBottom.x_ += middleToBottom.xStep_;
-                middleToBottom.invZ_ += middleToBottom.invZStep_;
-                topToBottom.x_ += topToBottom.xStep_;
-                row += width_;
-            }
-        }
-    }
+    for (const OcclusionTriangle* triangle : tileTriangles_[tileIndex])
+        RasterizeTriangle(*triangle, tileRect);
 }
 
-void OcclusionBuffer::MergeBuffers()
+void OcclusionBuffer::RasterizeTriangle(const OcclusionTriangle& triangle, const IntRect& tileRect)
 {
-    URHO3D_PROFILE("MergeBuffers");
-
-    for (unsigned i = 1; i < buffers_.size(); ++i)
+    // Tiles are aligned to blocks, so blocks never cross tile boundaries
+    const int left = Max(triangle.rect_.left_, tileRect.left_) & ~(OCCLUSION_BLOCK_WIDTH - 1);
+    const int top = Max(triangle.rect_.top_, tileRect.top_) & ~(OCCLUSION_BLOCK_HEIGHT - 1);
+    const int right = Min(triangle.rect_.right_, tileRect.right_);
+    const int bottom = Min(triangle.rect_.bottom_, tileRect.bottom_);
+    const Vector3* edges = triangle.edges_;
+    const Vector3& depthPlane = triangle.depthPlane_;
+
+    // Offset from block origin to the block corner that is the most inside for each edge
+    float innerCornerOffsets[3];
+    for (unsigned i = 0; i < 3; ++i)
     {
-        if (!buffers_[i].used_)
-            continue;
+        innerCornerOffsets[i] = Max(0.0f, edges[i].x_ * (OCCLUSION_BLOCK_WIDTH - 1))
+            + Max(0.0f, edges[i].y_ * (OCCLUSION_BLOCK_HEIGHT - 1));
+    }
 
-        int* src = buffers_[i].data_;
-        int* dest = buffers_[0].data_;
-        int count = width_ * height_;
+    // Offset from block origin to the block corner with the smallest depth
+    const float nearCornerOffset = Min(0.0f, depthPlane.x_ * (OCCLUSION_BLOCK_WIDTH - 1))
+        + Min(0.0f, depthPlane.y_ * (OCCLUSION_BLOCK_HEIGHT - 1));
 
-        while (count--)
-        {
-            // If thread buffer's depth value is closer, overwrite the original
-            if (*src < *dest)
-                *dest = *src;
-            ++src;
-            ++dest;
-        }
-    }
-}
+    for (int blockY = top; blockY <= bottom; blockY += OCCLUSION_BLOCK_HEIGHT)
+    {
+        const auto y = static_cast<float>(blockY);
+        int* blockMaxDepthRow = &blockMaxDepth_[blockY / OCCLUSION_BLOCK_HEIGHT * numBlocksX_];
 
-void OcclusionBuffer::ClearBuffer(unsigned threadIndex)
-{
-    if (threadIndex >= buffers_.size())
-        return;
+        for (int blockX = left; blockX <= right; blockX += OCCLUSION_BLOCK_WIDTH)
+        {
+            // Skip block if the triangle is behind everything already drawn there
+            const auto x = static_cast<float>(blockX);
+            const float depthValue = depthPlane.x_ * x + depthPlane.y_ * y + depthPlane.z_;
+            const float minDepth = Max(depthValue + nearCornerOffset, triangle.minDepth_);
+            int& blockMaxDepth = blockMaxDepthRow[blockX / OCCLUSION_BLOCK_WIDTH];
+            if (minDepth >= static_cast<float>(blockMaxDepth))
+                continue;
 
-    int* dest = buffers_[threadIndex].data_;
-    int count = width_ * height_;
-    auto fillValue = (int)OCCLUSION_Z_SCALE;
+            // Skip block if it is completely outside of any edge
+            float edgeValues[3];
+            bool outside = false;
+            for (unsigned i = 0; i < 3; ++i)
+            {
+                edgeValues[i] = edges[i].x_ * x + edges[i].y_ * y + edges[i].z_;
+                if (edgeValues[i] + innerCornerOffsets[i] < 0.0f)
+                    outside = true;
+            }
+            if (outside)
+                continue;
 
-    while (count--)
-        *dest++ = fillValue;
+            int* data = buffer_.get() + blockY * width_ + blockX;
+            blockMaxDepth = RasterizeBlock(data, width_, triangle, edgeValues, depthValue);
+        }
+    }
 }
 
 }
@@ -25,11 +25,14 @@
 #pragma once
 
 #include <EASTL/shared_array.h>
+#include <EASTL/span.h>
 
 #include "../Core/Object.h"
 #include "../Core/Timer.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/GraphicsDefs.h"
 #include "../Math/Frustum.h"
+#include "../Math/Rect.h"
 
 namespace Urho3D
 {
@@ -37,10 +40,7 @@ namespace Urho3D
 class BoundingBox;
 class Camera;
 class IndexBuffer;
-class IntRect;
 class VertexBuffer;
-struct Edge;
-struct Gradients;
 
 /// Occlusion hierarchy depth value.
 struct DepthValue
@@ -51,15 +51,19 @@ struct DepthValue
     int max_;
 };
 
-/// Per-thread occlusion buffer data.
-struct OcclusionBufferData
+/// Occluder triangle prepared for rasterization.
+struct OcclusionTriangle
 {
-    /// Full buffer data with safety padding.
-    ea::shared_array<int> dataWithSafety_;
-    /// Buffer data.
-    int* data_;
-    /// Use flag.
-    bool used_;
+    /// Edge functions as (a, b, c) so that a * x + b * y + c is non-negative inside the triangle.
+    Vector3 edges_[3];
+    /// Depth plane as (a, b, c) so that depth is a * x + b * y + c.
+    Vector3 depthPlane_;
+    /// Minimum depth of triangle vertices.
+    float minDepth_;
+    /// Maximum depth of triangle vertices.
+    float maxDepth_;
+    /// Covered pixels, inclusive.
+    IntRect rect_;
 };
 
 /// Stored occlusion render job.
@@ -87,8 +91,13 @@ static const float OCCLUSION_RELATIVE_BIAS = 0.00001f;
 static const int OCCLUSION_FIXED_BIAS = 16;
 static const float OCCLUSION_X_SCALE = 65536.0f;
 static const float OCCLUSION_Z_SCALE = 16777216.0f;
+static const int OCCLUSION_BLOCK_WIDTH = 8;
+static const int OCCLUSION_BLOCK_HEIGHT = 4;
+static const int OCCLUSION_TILE_WIDTH = 32;
+static const int OCCLUSION_TILE_HEIGHT = 32;
 
 /// Software renderer for occlusion.
+/// Triangles are binned into screen tiles, and tiles are rasterized independently in blocks of 8x4 pixels.
 class URHO3D_API OcclusionBuffer : public Object
 {
     URHO3D_OBJECT(OcclusionBuffer, Object);
@@ -102,7 +111,7 @@ public:
     /// Register object with the engine.
     static void RegisterObject(Context* context);
 
-    /// Set occlusion buffer size and whether to reserve multiple buffers for threading optimization.
+    /// Set occlusion buffer size and whether to rasterize in worker threads. Width should be a power of two not less than 8.
     bool SetSize(int width, int height, bool threaded);
     /// Set camera view to render from.
     void SetView(Camera* camera);
@@ -123,11 +132,16 @@ public:
     void DrawTriangles();
     /// Build reduced size mip levels.
     void BuildDepthHierarchy();
+    /// Draw depth of the previous frame buffer reprojected into the current view.
+    /// Buffers should have the same size, and depth hierarchy of the previous buffer should be built.
+    /// If the view has changed, boxes tested against reprojected depth are culled only if they are occluded with some margin.
+    /// Return true on success.
+    bool Reproject(const OcclusionBuffer& previous);
     /// Reset last used timer.
     void ResetUseTimer();
 
     /// Return highest level depth values.
-    int* GetBuffer() const { return buffers_.size() ? buffers_[0].data_ : nullptr; }
+    int* GetBuffer() const { return buffer_.get(); }
 
     /// Return view transform matrix.
     const Matrix3x4& GetView() const { return view_; }
@@ -151,17 +165,21 @@ public:
     CullMode GetCullMode() const { return cullMode_; }
 
     /// Return whether is using threads to speed up rendering.
-    bool IsThreaded() const { return buffers_.size() > 1; }
+    bool IsThreaded() const { return threaded_; }
+
+    /// Return whether the buffer contains depth reprojected from the previous frame.
+    bool IsReprojected() const { return reprojected_; }
 
     /// Test a bounding box for visibility. For best performance, build depth hierarchy first.
     bool IsVisible(const BoundingBox& worldSpaceBox) const;
+    /// Test multiple bounding boxes for visibility. Boxes are projected several at once.
+    void AreVisible(ea::span<const BoundingBox> worldSpaceBoxes, ea::span<bool> result) const;
     /// Return time since last use in milliseconds.
     unsigned GetUseTimer();
 
-    /// Draw a batch. Called internally.
-    void DrawBatch(const OcclusionBatch& batch, unsigned threadIndex);
-
 private:
+    /// Transform, clip and set up triangles of a batch. Return number of accepted triangles.
+    unsigned DrawBatch(const OcclusionBatch& batch);
     /// Apply modelview transform to vertex.
     inline Vector4 ModelTransform(const Matrix4& transform, const Vector3& vertex) const;
     /// Apply projection and viewport transform to vertex.
@@ -172,19 +190,31 @@ private:
     inline float SignedArea(const Vector3& v0, const Vector3& v1, const Vector3& v2) const;
     /// Calculate viewport transform.
     void CalculateViewport();
-    /// Draw a triangle.
-    void DrawTriangle(Vector4* vertices, unsigned threadIndex);
+    /// Draw a triangle. Return true if any part of the triangle was accepted.
+    bool DrawTriangle(Vector4* vertices);
     /// Clip vertices against a plane.
     void ClipVertices(const Vector4& plane, Vector4* vertices, bool* triangles, unsigned& numTriangles);
-    /// Draw a clipped triangle.
-    void DrawTriangle2D(const Vector3* vertices, bool clockwise, unsigned threadIndex);
-    /// Clear a thread work buffer.
-    void ClearBuffer(unsigned threadIndex);
-    /// Merge thread work buffers into the first buffer.
-    void MergeBuffers();
-
-    /// Highest-level buffer data per thread.
-    ea::vector<OcclusionBufferData> buffers_;
+    /// Set up a clipped triangle for rasterization.
+    void DrawTriangle2D(const Vector3* vertices);
+    /// Rasterize all set up triangles.
+    void RasterizeTriangles(WorkQueue* queue);
+    /// Assign set up triangles to tiles they overlap.
+    void BinTriangles();
+    /// Rasterize all triangles overlapping a tile.
+    void RasterizeTile(unsigned tileIndex);
+    /// Rasterize part of triangle within a tile.
+    void RasterizeTriangle(const OcclusionTriangle& triangle, const IntRect& tileRect);
+    /// Test projected bounding rectangle for visibility.
+    bool IsProjectedBoxVisible(float minX, float minY, float maxX, float maxY, float minZ) const;
+
+    /// Highest-level buffer data. Height is padded to whole blocks.
+    ea::shared_array<int> buffer_;
+    /// Maximum depth of each pixel block.
+    ea::vector<int> blockMaxDepth_;
+    /// Triangles prepared for rasterization.
+    WorkQueueVector<OcclusionTriangle> triangles_;
+    /// Triangles overlapping each tile.
+    ea::vector<ea::vector<const OcclusionTriangle*>> tileTriangles_;
     /// Reduced size depth buffers.
     ea::vector<ea::shared_array<DepthValue> > mipBuffers_;
     /// Submitted render jobs.
@@ -193,6 +223,18 @@ private:
     int width_{};
     /// Buffer height.
     int height_{};
+    /// Number of pixel blocks in a row.
+    int numBlocksX_{};
+    /// Number of tiles in a row.
+    int numTilesX_{};
+    /// Number of tiles in a column.
+    int numTilesY_{};
+    /// Whether to use worker threads.
+    bool threaded_{};
+    /// Whether the buffer contains reprojected depth.
+    bool reprojected_{};
+    /// Margin in pixels around tested boxes that must be occluded too because reprojected depth is approximate.
+    int reprojectionMargin_{};
     /// Number of rendered triangles.
     unsigned numTriangles_{};
     /// Maximum number of triangles.
@@ -38,6 +38,10 @@
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 #ifdef _MSC_VER
@@ -57,6 +61,8 @@ static ea::vector<Drawable*> unusedDrawablesVector;
 
 static const float DEFAULT_OCTREE_SIZE = 1000.0f;
 static const int DEFAULT_OCTREE_LEVELS = 8;
+static const unsigned OCTREE_REINSERTION_BUCKET = 64;
+static const unsigned RAYCAST_BATCH_BUCKET = 16;
 
 extern const char* SUBSYSTEM_CATEGORY;
 
@@ -81,6 +87,221 @@ inline bool CompareRayQueryResults(const RayQueryResult& lhs, const RayQueryResu
     return lhs.distance_ < rhs.distance_;
 }
 
+/// Packet of rays traversing the octree together, each ray looks for the closest hit.
+struct RayQueryPacket
+{
+    /// Max number of rays in packet.
+    static const unsigned MaxRays = 4;
+
+    /// Construct.
+    RayQueryPacket(RayQueryLevel level, float maxDistance, DrawableFlags drawableFlags, unsigned viewMask,
+        ea::vector<RayQueryResult>& hits)
+        : level_(level)
+        , maxDistance_(maxDistance)
+        , drawableFlags_(drawableFlags)
+        , viewMask_(viewMask)
+        , hits_(hits)
+    {
+    }
+
+    /// Start processing new rays.
+    void Reset(const Ray* rays, RayQueryResult* results, unsigned numRays)
+    {
+        for (unsigned i = 0; i < MaxRays; ++i)
+        {
+            // Unused lanes repeat the first ray
+            const unsigned rayIndex = i < numRays ? i : 0;
+            const Ray& ray = rays[rayIndex];
+            rays_[i] = &ray;
+            results_[i] = &results[rayIndex];
+
+            // Avoid division by zero, so slab test doesn't produce NaNs
+            const auto safeInverse = [](float value)
+            {
+                static const float minValue = 1e-20f;
+                return 1.0f / (Abs(value) >= minValue ? value : (value >= 0.0f ? minValue : -minValue));
+            };
+
+            originX_[i] = ray.origin_.x_;
+            originY_[i] = ray.origin_.y_;
+            originZ_[i] = ray.origin_.z_;
+            invDirX_[i] = safeInverse(ray.direction_.x_);
+            invDirY_[i] = safeInverse(ray.direction_.y_);
+            invDirZ_[i] = safeInverse(ray.direction_.z_);
+            closestDistance_[i] = maxDistance_;
+        }
+
+        for (unsigned i = 0; i < numRays; ++i)
+        {
+            *results_[i] = RayQueryResult{};
+            results_[i]->distance_ = M_INFINITY;
+        }
+
+        // Visit child octants in the front-to-back order of the first ray
+        childOrder_ = 0;
+        if (rays[0].direction_.x_ < 0.0f)
+            childOrder_ |= 1;
+        if (rays[0].direction_.y_ < 0.0f)
+            childOrder_ |= 2;
+        if (rays[0].direction_.z_ < 0.0f)
+            childOrder_ |= 4;
+    }
+
+    /// Test rays against the box. Return mask of rays that hit the box closer than the closest hit so far.
+    unsigned TestBox(float minX, float minY, float minZ, float maxX, float maxY, float maxZ, unsigned activeRays) const
+    {
+#ifdef URHO3D_SSE
+        const __m128 invDirX = _mm_load_ps(invDirX_);
+        const __m128 invDirY = _mm_load_ps(invDirY_);
+        const __m128 invDirZ = _mm_load_ps(invDirZ_);
+        const __m128 originX = _mm_load_ps(originX_);
+        const __m128 originY = _mm_load_ps(originY_);
+        const __m128 originZ = _mm_load_ps(originZ_);
+
+        const __m128 x1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(minX), originX), invDirX);
+        const __m128 x2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(maxX), originX), invDirX);
+        const __m128 y1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(minY), originY), invDirY);
+        const __m128 y2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(maxY), originY), invDirY);
+        const __m128 z1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(minZ), originZ), invDirZ);
+        const __m128 z2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(maxZ), originZ), invDirZ);
+
+        __m128 entry = _mm_max_ps(_mm_min_ps(x1, x2), _mm_setzero_ps());
+        entry = _mm_max_ps(entry, _mm_min_ps(y1, y2));
+        entry = _mm_max_ps(entry, _mm_min_ps(z1, z2));
+        __m128 exit = _mm_max_ps(x1, x2);
+        exit = _mm_min_ps(exit, _mm_max_ps(y1, y2));
+        exit = _mm_min_ps(exit, _mm_max_ps(z1, z2));
+
+        const __m128 isHit = _mm_and_ps(_mm_cmple_ps(entry, exit), _mm_cmplt_ps(entry, _mm_load_ps(closestDistance_)));
+        return static_cast<unsigned>(_mm_movemask_ps(isHit)) & activeRays;
+#else
+        unsigned hitRays = 0;
+        for (unsigned i = 0; i < MaxRays; ++i)
+        {
+            const float x1 = (minX - originX_[i]) * invDirX_[i];
+            const float x2 = (maxX - originX_[i]) * invDirX_[i];
+            const float y1 = (minY - originY_[i]) * invDirY_[i];
+            const float y2 = (maxY - originY_[i]) * invDirY_[i];
+            const float z1 = (minZ - originZ_[i]) * invDirZ_[i];
+            const float z2 = (maxZ - originZ_[i]) * invDirZ_[i];
+
+            const float entry = Max(Max(Min(x1, x2), 0.0f), Max(Min(y1, y2), Min(z1, z2)));
+            const float exit = Min(Max(x1, x2), Min(Max(y1, y2), Max(z1, z2)));
+            if (entry <= exit && entry < closestDistance_[i])
+                hitRays |= 1u << i;
+        }
+        return hitRays & activeRays;
+#endif
+    }
+
+    /// Test rays against the box.
+    unsigned TestBox(const BoundingBox& box, unsigned activeRays) const
+    {
+        return TestBox(box.min_.x_, box.min_.y_, box.min_.z_, box.max_.x_, box.max_.y_, box.max_.z_, activeRays);
+    }
+
+    /// Perform precise test of the ray against the drawable.
+    void ProcessDrawable(unsigned rayIndex, Drawable* drawable)
+    {
+        RayOctreeQuery query(hits_, *rays_[rayIndex], level_, closestDistance_[rayIndex], drawableFlags_, viewMask_);
+        hits_.clear();
+        drawable->ProcessRayQuery(query, hits_);
+
+        for (const RayQueryResult& hit : hits_)
+        {
+            if (hit.distance_ < closestDistance_[rayIndex])
+            {
+                closestDistance_[rayIndex] = hit.distance_;
+                *results_[rayIndex] = hit;
+            }
+        }
+    }
+
+    /// Ray origins.
+    alignas(16) float originX_[MaxRays]{};
+    alignas(16) float originY_[MaxRays]{};
+    alignas(16) float originZ_[MaxRays]{};
+    /// Inverse ray directions.
+    alignas(16) float invDirX_[MaxRays]{};
+    alignas(16) float invDirY_[MaxRays]{};
+    alignas(16) float invDirZ_[MaxRays]{};
+    /// Closest hit distances.
+    alignas(16) float closestDistance_[MaxRays]{};
+    /// Rays.
+    const Ray* rays_[MaxRays]{};
+    /// Results.
+    RayQueryResult* results_[MaxRays]{};
+    /// Child octant visiting order.
+    unsigned childOrder_{};
+
+    /// Raycast detail level.
+    RayQueryLevel level_{};
+    /// Maximum ray distance.
+    float maxDistance_{};
+    /// Drawable flags to include.
+    DrawableFlags drawableFlags_;
+    /// Drawable layers to include.
+    unsigned viewMask_{};
+    /// Temporary storage for precise test results.
+    ea::vector<RayQueryResult>& hits_;
+};
+
+void OctantCullingData::Push(Drawable* drawable)
+{
+    const BoundingBox& box = drawable->GetWorldBoundingBox();
+    minX_.push_back(box.min_.x_);
+    minY_.push_back(box.min_.y_);
+    minZ_.push_back(box.min_.z_);
+    maxX_.push_back(box.max_.x_);
+    maxY_.push_back(box.max_.y_);
+    maxZ_.push_back(box.max_.z_);
+    viewMasks_.push_back(drawable->GetViewMask());
+    drawableFlags_.push_back(drawable->GetDrawableFlags());
+}
+
+void OctantCullingData::Set(unsigned index, Drawable* drawable)
+{
+    const BoundingBox& box = drawable->GetWorldBoundingBox();
+    minX_[index] = box.min_.x_;
+    minY_[index] = box.min_.y_;
+    minZ_[index] = box.min_.z_;
+    maxX_[index] = box.max_.x_;
+    maxY_[index] = box.max_.y_;
+    maxZ_[index] = box.max_.z_;
+    viewMasks_[index] = drawable->GetViewMask();
+    drawableFlags_[index] = drawable->GetDrawableFlags();
+}
+
+void OctantCullingData::EraseSwap(unsigned index)
+{
+    const auto eraseSwap = [index](auto& vector)
+    {
+        vector[index] = vector.back();
+        vector.pop_back();
+    };
+
+    eraseSwap(minX_);
+    eraseSwap(minY_);
+    eraseSwap(minZ_);
+    eraseSwap(maxX_);
+    eraseSwap(maxY_);
+    eraseSwap(maxZ_);
+    eraseSwap(viewMasks_);
+    eraseSwap(drawableFlags_);
+}
+
+void OctantCullingData::Clear()
+{
+    minX_.clear();
+    minY_.clear();
+    minZ_.clear();
+    maxX_.clear();
+    maxY_.clear();
+    maxZ_.clear();
+    viewMasks_.clear();
+    drawableFlags_.clear();
+}
+
 Octant::Octant(const BoundingBox& box, unsigned level, Octant* parent, Octree* octree, unsigned index) :
     level_(level),
     parent_(parent),
@@ -99,11 +320,11 @@ Octant::~Octant()
         // Remove the drawables (if any) from this octant to the root octant
         for (auto i = drawables_.begin(); i != drawables_.end(); ++i)
         {
-            (*i)->SetOctant(rootOctant);
-            rootOctant->drawables_.push_back(*i);
+            rootOctant->PushDrawable(*i);
             octree_->QueueUpdate(*i);
         }
         drawables_.clear();
+        cullingData_.Clear();
         numDrawables_ = 0;
     }
 
@@ -150,34 +371,44 @@ void Octant::InsertDrawable(Drawable* drawable)
 {
     const BoundingBox& box = drawable->GetWorldBoundingBox();
 
-    // If root octant, insert all non-occludees here, so that octant occlusion does not hide the drawable.
-    // Also if drawable is outside the root octant bounds, insert to root
-    bool insertHere;
-    if (this == octree_->GetRootOctant())
-        insertHere = !drawable->IsOccludee() || cullingBox_.IsInside(box) != INSIDE || CheckDrawableFit(box);
-    else
-        insertHere = CheckDrawableFit(box);
-
-    if (insertHere)
+    if (IsInsertionOctant(box, drawable->IsOccludee()))
     {
         Octant* oldOctant = drawable->octant_;
         if (oldOctant != this)
         {
-            // Add first, then remove, because drawable count going to zero deletes the octree branch in question
+            // Add first, then remove, because drawable count going to zero deletes the octree branch in question.
+            // Index in old octant is overwritten on add, so remember it
+            const unsigned oldIndex = drawable->octantIndex_;
             AddDrawable(drawable);
             if (oldOctant)
-                oldOctant->RemoveDrawable(drawable, false);
+            {
+                oldOctant->EraseDrawable(oldIndex);
+                oldOctant->DecDrawableCount();
+            }
         }
+        else
+            UpdateCullingData(drawable);
     }
     else
-    {
-        Vector3 boxCenter = box.Center();
-        unsigned x = boxCenter.x_ < center_.x_ ? 0 : 1;
-        unsigned y = boxCenter.y_ < center_.y_ ? 0 : 2;
-        unsigned z = boxCenter.z_ < center_.z_ ? 0 : 4;
+        GetOrCreateChild(GetChildIndex(box.Center()))->InsertDrawable(drawable);
+}
 
-        GetOrCreateChild(x + y + z)->InsertDrawable(drawable);
+Octant* Octant::FindInsertionOctant(const BoundingBox& box, bool isOccludee, bool& isExisting)
+{
+    Octant* octant = this;
+    while (!octant->IsInsertionOctant(box, isOccludee))
+    {
+        Octant* child = octant->children_[octant->GetChildIndex(box.Center())];
+        if (!child)
+        {
+            isExisting = false;
+            return octant;
+        }
+        octant = child;
     }
+
+    isExisting = true;
+    return octant;
 }
 
 bool Octant::CheckDrawableFit(const BoundingBox& box) const
@@ -204,6 +435,24 @@ bool Octant::CheckDrawableFit(const BoundingBox& box) const
     return false;
 }
 
+bool Octant::IsInsertionOctant(const BoundingBox& box, bool isOccludee) const
+{
+    // If root octant, insert all non-occludees here, so that octant occlusion does not hide the drawable.
+    // Also if drawable is outside the root octant bounds, insert to root
+    if (this == octree_->GetRootOctant())
+        return !isOccludee || cullingBox_.IsInside(box) != INSIDE || CheckDrawableFit(box);
+    else
+        return CheckDrawableFit(box);
+}
+
+unsigned Octant::GetChildIndex(const Vector3& position) const
+{
+    const unsigned x = position.x_ < center_.x_ ? 0 : 1;
+    const unsigned y = position.y_ < center_.y_ ? 0 : 2;
+    const unsigned z = position.z_ < center_.z_ ? 0 : 4;
+    return x + y + z;
+}
+
 void Octant::SetRootSize(const BoundingBox& box)
 {
     // If drawables exist, they are temporarily moved to the root
@@ -246,6 +495,33 @@ void Octant::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
     }
 }
 
+void Octant::UpdateCullingData(Drawable* drawable)
+{
+    const unsigned index = drawable->octantIndex_;
+    if (index < drawables_.size() && drawables_[index] == drawable)
+        cullingData_.Set(index, drawable);
+}
+
+void Octant::PushDrawable(Drawable* drawable)
+{
+    drawable->SetOctant(this);
+    drawable->octantIndex_ = drawables_.size();
+    drawables_.push_back(drawable);
+    cullingData_.Push(drawable);
+}
+
+void Octant::EraseDrawable(unsigned index)
+{
+    if (index + 1 < drawables_.size())
+    {
+        Drawable* replacement = drawables_.back();
+        drawables_[index] = replacement;
+        replacement->octantIndex_ = index;
+    }
+    drawables_.pop_back();
+    cullingData_.EraseSwap(index);
+}
+
 void Octant::Initialize(const BoundingBox& box)
 {
     worldBoundingBox_ = box;
@@ -272,7 +548,7 @@ void Octant::GetDrawablesInternal(OctreeQuery& query, bool inside) const
     {
         auto** start = const_cast<Drawable**>(&drawables_[0]);
         Drawable** end = start + drawables_.size();
-        query.TestDrawables(start, end, inside);
+        query.TestOctantDrawables(cullingData_, start, end, inside);
     }
 
     for (auto child : children_)
@@ -336,6 +612,37 @@ void Octant::GetDrawablesOnlyInternal(RayOctreeQuery& query, ea::vector<Drawable
     }
 }
 
+void Octant::GetDrawablesInternal(RayQueryPacket& packet, unsigned activeRays) const
+{
+    activeRays = packet.TestBox(cullingBox_, activeRays);
+    if (!activeRays)
+        return;
+
+    const unsigned numDrawables = drawables_.size();
+    for (unsigned i = 0; i < numDrawables; ++i)
+    {
+        if (!(cullingData_.drawableFlags_[i] & packet.drawableFlags_) || !(cullingData_.viewMasks_[i] & packet.viewMask_))
+            continue;
+
+        const unsigned hitRays = packet.TestBox(cullingData_.minX_[i], cullingData_.minY_[i], cullingData_.minZ_[i],
+            cullingData_.maxX_[i], cullingData_.maxY_[i], cullingData_.maxZ_[i], activeRays);
+        if (!hitRays)
+            continue;
+
+        for (unsigned rayIndex = 0; rayIndex < RayQueryPacket::MaxRays; ++rayIndex)
+        {
+            if (hitRays & (1u << rayIndex))
+                packet.ProcessDrawable(rayIndex, drawables_[i]);
+        }
+    }
+
+    for (unsigned i = 0; i < NUM_OCTANTS; ++i)
+    {
+        if (Octant* child = children_[i ^ packet.childOrder_])
+            child->GetDrawablesInternal(packet, activeRays);
+    }
+}
+
 ZoneLookupIndex::ZoneLookupIndex(Context* context)
 {
     if (auto renderer = context->GetSubsystem<Renderer>())
@@ -438,7 +745,7 @@ Octree::Octree(Context* context) :
     // If the engine is running headless, subscribe to RenderUpdate events for manually updating the octree
     // to allow raycasts and animation update
     if (!GetSubsystem<Graphics>())
-        SubscribeToEvent(E_RENDERUPDATE, URHO3D_HANDLER(Octree, HandleRenderUpdate));
+        SubscribeToTypedEvent<RenderUpdateEventArgs>([this](const RenderUpdateEventArgs& args) { HandleRenderUpdate(args); });
 }
 
 Octree::~Octree()
@@ -548,12 +855,10 @@ void Octree::Update(const FrameInfo& frame)
     Scene* scene = GetScene();
     if (scene)
     {
-        using namespace SceneDrawableUpdateFinished;
-
-        VariantMap& eventData = GetEventDataMap();
-        eventData[P_SCENE] = scene;
-        eventData[P_TIMESTEP] = frame.timeStep_;
-        scene->SendEvent(E_SCENEDRAWABLEUPDATEFINISHED, eventData);
+        SceneDrawableUpdateFinishedEventArgs args;
+        args.scene_ = scene;
+        args.timeStep_ = frame.timeStep_;
+        scene->SendTypedEvent(args);
     }
 
     // Reinsert drawables that have been moved or resized, or that have been newly added to the octree and do not sit inside
@@ -562,38 +867,130 @@ void Octree::Update(const FrameInfo& frame)
     {
         URHO3D_PROFILE("ReinsertToOctree");
 
-        for (auto i = drawableUpdates_.begin(); i != drawableUpdates_.end(); ++i)
+        // Bounding boxes of some drawables are updated lazily on access with side effects,
+        // so update them in the main thread. Worker threads only read the cached bounding boxes
+        for (Drawable* drawable : drawableUpdates_)
         {
-            Drawable* drawable = *i;
-            drawable->updateQueued_ = false;
-            Octant* octant = drawable->GetOctant();
-            const BoundingBox& box = drawable->GetWorldBoundingBox();
+            if (drawable)
+                drawable->GetWorldBoundingBox();
+        }
 
-            // Skip if no octant or does not belong to this octree anymore
-            if (!octant || octant->GetOctree() != this)
-                continue;
-            // Skip if still fits the current octant
-            if (drawable->IsOccludee() && octant->GetCullingBox().IsInside(box) == INSIDE && octant->CheckDrawableFit(box))
-                continue;
+        // Find new octants in worker threads without modifying the octree
+        {
+            URHO3D_PROFILE("FindOctants");
 
-            rootOctant_.InsertDrawable(drawable);
+            auto* queue = GetSubsystem<WorkQueue>();
+            if (scene)
+                scene->BeginThreadedUpdate();
 
-#ifdef _DEBUG
-            // Verify that the drawable will be culled correctly
-            octant = drawable->GetOctant();
-            if (octant != GetRootOctant() && octant->GetCullingBox().IsInside(box) != INSIDE)
+            reinsertions_.resize(drawableUpdates_.size());
+            ForEachParallel(queue, OCTREE_REINSERTION_BUCKET, drawableUpdates_.size(),
+                [this](unsigned beginIndex, unsigned endIndex)
             {
-                URHO3D_LOGERROR("Drawable is not fully inside its octant's culling bounds: drawable box " + box.ToString() +
-                         " octant box " + octant->GetCullingBox().ToString());
-            }
-#endif
+                for (unsigned i = beginIndex; i < endIndex; ++i)
+                    reinsertions_[i] = FindReinsertion(drawableUpdates_[i]);
+            });
+
+            if (scene)
+                scene->EndThreadedUpdate();
         }
+
+        CommitReinsertions();
     }
 
     drawableUpdates_.clear();
     zones_.Commit();
 }
 
+Octree::Reinsertion Octree::FindReinsertion(Drawable* drawable)
+{
+    if (!drawable)
+        return {};
+
+    drawable->updateQueued_ = false;
+    Octant* octant = drawable->GetOctant();
+
+    // Skip if no octant or does not belong to this octree anymore
+    if (!octant || octant->GetOctree() != this)
+        return {};
+
+    // World bounding box is already up to date, see Update
+    const BoundingBox& box = drawable->worldBoundingBox_;
+    const bool isOccludee = drawable->IsOccludee();
+
+    // Skip if still fits the current octant, only refresh culling data
+    if (isOccludee && octant->GetCullingBox().IsInside(box) == INSIDE && octant->CheckDrawableFit(box))
+    {
+        octant->UpdateCullingData(drawable);
+        return {};
+    }
+
+    bool isExisting{};
+    Octant* newOctant = rootOctant_.FindInsertionOctant(box, isOccludee, isExisting);
+    if (isExisting && newOctant == octant)
+    {
+        octant->UpdateCullingData(drawable);
+        return {};
+    }
+
+    return { drawable, octant, newOctant, isExisting };
+}
+
+void Octree::CommitReinsertions()
+{
+    URHO3D_PROFILE("CommitReinsertions");
+
+    // Skip drawables that stay in their octants
+    reinsertions_.erase(ea::remove_if(reinsertions_.begin(), reinsertions_.end(),
+        [](const Reinsertion& reinsertion) { return !reinsertion.drawable_; }), reinsertions_.end());
+
+    // Group moves to existing octants by new octant.
+    // Drawables that require new octants are inserted one by one afterwards.
+    // Sort is stable so the order of drawables within octants does not depend on octant addresses
+    ea::stable_sort(reinsertions_.begin(), reinsertions_.end(), [](const Reinsertion& lhs, const Reinsertion& rhs)
+    {
+        if (lhs.isExisting_ != rhs.isExisting_)
+            return lhs.isExisting_;
+        return lhs.newOctant_ < rhs.newOctant_;
+    });
+    const auto simpleMovesEnd = ea::find_if(reinsertions_.begin(), reinsertions_.end(),
+        [](const Reinsertion& reinsertion) { return !reinsertion.isExisting_; });
+
+    // Remove drawables from old octants first, so indices of drawables in old octants are kept valid.
+    // Octant drawable counts are updated after all moves, so no octant is deleted in the middle
+    for (auto iter = reinsertions_.begin(); iter != simpleMovesEnd; ++iter)
+        iter->oldOctant_->EraseDrawable(iter->drawable_->octantIndex_);
+
+    for (auto iter = reinsertions_.begin(); iter != simpleMovesEnd; ++iter)
+        iter->newOctant_->PushDrawable(iter->drawable_);
+
+    // Increment counts first because drawable count going to zero deletes the octree branch in question
+    for (auto iter = reinsertions_.begin(); iter != simpleMovesEnd; ++iter)
+        iter->newOctant_->IncDrawableCount();
+    for (auto iter = reinsertions_.begin(); iter != simpleMovesEnd; ++iter)
+        iter->oldOctant_->DecDrawableCount();
+
+    // Found octants may have been deleted, so insert from the root
+    for (auto iter = simpleMovesEnd; iter != reinsertions_.end(); ++iter)
+        rootOctant_.InsertDrawable(iter->drawable_);
+
+#ifdef _DEBUG
+    // Verify that the drawables will be culled correctly
+    for (const Reinsertion& reinsertion : reinsertions_)
+    {
+        const BoundingBox& box = reinsertion.drawable_->GetWorldBoundingBox();
+        Octant* octant = reinsertion.drawable_->GetOctant();
+        if (octant != GetRootOctant() && octant->GetCullingBox().IsInside(box) != INSIDE)
+        {
+            URHO3D_LOGERROR("Drawable is not fully inside its octant's culling bounds: drawable box " + box.ToString() +
+                     " octant box " + octant->GetCullingBox().ToString());
+        }
+    }
+#endif
+
+    reinsertions_.clear();
+}
+
 void Octree::AddManualDrawable(Drawable* drawable)
 {
     if (!drawable || drawable->GetOctant())
@@ -736,6 +1133,35 @@ void Octree::RaycastSingle(RayOctreeQuery& query) const
     }
 }
 
+void Octree::RaycastSingleBatch(ea::span<const Ray> rays, ea::span<RayQueryResult> results, RayQueryLevel level,
+    float maxDistance, DrawableFlags drawableFlags, unsigned viewMask) const
+{
+    URHO3D_PROFILE("RaycastBatch");
+
+    if (results.size() < rays.size())
+    {
+        URHO3D_LOGERROR("Not enough space for raycast results");
+        return;
+    }
+
+    const auto processRays = [&](unsigned beginIndex, unsigned endIndex)
+    {
+        ea::vector<RayQueryResult> hits;
+        RayQueryPacket packet(level, maxDistance, drawableFlags, viewMask, hits);
+        for (unsigned i = beginIndex; i < endIndex; i += RayQueryPacket::MaxRays)
+        {
+            const unsigned numRays = ea::min(RayQueryPacket::MaxRays, endIndex - i);
+            packet.Reset(&rays[i], &results[i], numRays);
+            rootOctant_.GetDrawablesInternal(packet, (1u << numRays) - 1);
+        }
+    };
+
+    if (auto* workQueue = GetSubsystem<WorkQueue>())
+        ForEachParallel(workQueue, RAYCAST_BATCH_BUCKET, rays.size(), processRays);
+    else
+        processRays(0, rays.size());
+}
+
 CachedDrawableZone Octree::QueryZone(Drawable* drawable) const
 {
     return zones_.QueryZone(drawable->GetWorldBoundingBox().Center(), drawable->GetZoneMask());
@@ -753,23 +1179,34 @@ Zone* Octree::GetBackgroundZone() const
 
 void Octree::QueueUpdate(Drawable* drawable)
 {
+    // Drawable may be dirtied from several threads at once, queue it only once
+    if (drawable->updateQueued_.exchange(true))
+        return;
+
+    // Drawables may also be dirtied from worker threads during rendering, they are updated in the next frame
     Scene* scene = GetScene();
-    if (scene && scene->IsThreadedUpdate())
+    if ((scene && scene->IsThreadedUpdate()) || !Thread::IsMainThread())
     {
         MutexLock lock(octreeMutex_);
         threadedDrawableUpdates_.push_back(drawable);
     }
     else
         drawableUpdates_.push_back(drawable);
-
-    drawable->updateQueued_ = true;
 }
 
 void Octree::CancelUpdate(Drawable* drawable)
 {
-    // This doesn't have to take into account scene being in threaded update, because it is called only
-    // when removing a drawable from octree, which should only ever happen from the main thread.
+    // This is called only when removing a drawable from octree, which should only ever happen from the main thread.
+    // Drawable may have been queued from worker threads though, and that queue is processed in the next frame.
     drawableUpdates_.erase_first(drawable);
+    {
+        MutexLock lock(octreeMutex_);
+        for (Drawable*& queuedDrawable : threadedDrawableUpdates_)
+        {
+            if (queuedDrawable == drawable)
+                queuedDrawable = nullptr;
+        }
+    }
     drawable->updateQueued_ = false;
 }
 
@@ -779,18 +1216,16 @@ void Octree::DrawDebugGeometry(bool depthTest)
     DrawDebugGeometry(debug, depthTest);
 }
 
-void Octree::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
+void Octree::HandleRenderUpdate(const RenderUpdateEventArgs& args)
 {
     // When running in headless mode, update the Octree manually during the RenderUpdate event
     Scene* scene = GetScene();
     if (!scene || !scene->IsUpdateEnabled())
         return;
 
-    using namespace RenderUpdate;
-
     FrameInfo frame;
     frame.frameNumber_ = GetSubsystem<Time>()->GetFrameNumber();
-    frame.timeStep_ = eventData[P_TIMESTEP].GetFloat();
+    frame.timeStep_ = args.timeStep_;
     frame.camera_ = nullptr;
 
     Update(frame);
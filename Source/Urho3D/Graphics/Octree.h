@@ -26,19 +26,56 @@
 #include "../Graphics/Drawable.h"
 #include "../Graphics/OctreeQuery.h"
 
+#include <EASTL/span.h>
+
 namespace Urho3D
 {
 
 class Octree;
 class Zone;
+struct RayQueryPacket;
+struct RenderUpdateEventArgs;
 
 static const int NUM_OCTANTS = 8;
 static const unsigned ROOT_INDEX = M_MAX_UNSIGNED;
 
+/// Structure-of-arrays copy of drawable data used for culling. Elements match drawables of octant.
+/// @nobind
+struct URHO3D_API OctantCullingData
+{
+    /// Append drawable data.
+    void Push(Drawable* drawable);
+    /// Update drawable data at index.
+    void Set(unsigned index, Drawable* drawable);
+    /// Remove drawable data at index by moving the last element in its place.
+    void EraseSwap(unsigned index);
+    /// Remove all drawable data.
+    void Clear();
+
+    /// Bounding box minimum X coordinates.
+    ea::vector<float> minX_;
+    /// Bounding box minimum Y coordinates.
+    ea::vector<float> minY_;
+    /// Bounding box minimum Z coordinates.
+    ea::vector<float> minZ_;
+    /// Bounding box maximum X coordinates.
+    ea::vector<float> maxX_;
+    /// Bounding box maximum Y coordinates.
+    ea::vector<float> maxY_;
+    /// Bounding box maximum Z coordinates.
+    ea::vector<float> maxZ_;
+    /// View masks.
+    ea::vector<unsigned> viewMasks_;
+    /// Drawable flags.
+    ea::vector<unsigned> drawableFlags_;
+};
+
 /// %Octree octant.
 /// @nobind
 class URHO3D_API Octant
 {
+    friend class Octree;
+
 public:
     /// Construct.
     Octant(const BoundingBox& box, unsigned level, Octant* parent, Octree* octree, unsigned index = ROOT_INDEX);
@@ -53,28 +90,35 @@ public:
     void InsertDrawable(Drawable* drawable);
     /// Check if a drawable object fits.
     bool CheckDrawableFit(const BoundingBox& box) const;
+    /// Return octant where a drawable object should be inserted without modifying the octree.
+    /// If child octant has to be created, return the deepest existing octant instead and set isExisting to false.
+    Octant* FindInsertionOctant(const BoundingBox& box, bool isOccludee, bool& isExisting);
 
     /// Add a drawable object to this octant.
     void AddDrawable(Drawable* drawable)
     {
-        drawable->SetOctant(this);
-        drawables_.push_back(drawable);
+        PushDrawable(drawable);
         IncDrawableCount();
     }
 
     /// Remove a drawable object from this octant.
     void RemoveDrawable(Drawable* drawable, bool resetOctant = true)
     {
-        auto it = drawables_.find(drawable);
-        if (it != drawables_.end())
+        const unsigned index = drawable->octantIndex_;
+        if (index < drawables_.size() && drawables_[index] == drawable)
         {
-            drawables_.erase(it);
+            EraseDrawable(index);
             if (resetOctant)
                 drawable->SetOctant(nullptr);
             DecDrawableCount();
         }
     }
 
+    /// Update culling data of a drawable object in this octant.
+    void UpdateCullingData(Drawable* drawable);
+    /// Return culling data of drawable objects in this octant.
+    const OctantCullingData& GetCullingData() const { return cullingData_; }
+
     /// Return world-space bounding box.
     /// @property
     const BoundingBox& GetWorldBoundingBox() const { return worldBoundingBox_; }
@@ -111,10 +155,20 @@ public:
     void GetDrawablesInternal(RayOctreeQuery& query) const;
     /// Return drawable objects only for a threaded ray query, called internally.
     void GetDrawablesOnlyInternal(RayOctreeQuery& query, ea::vector<Drawable*>& drawables) const;
+    /// Return closest drawable objects for a packet of rays, called internally.
+    void GetDrawablesInternal(RayQueryPacket& packet, unsigned activeRays) const;
 
 protected:
     /// Initialize bounding box.
     void Initialize(const BoundingBox& box);
+    /// Return whether a drawable object should be inserted into this octant rather than into child octant.
+    bool IsInsertionOctant(const BoundingBox& box, bool isOccludee) const;
+    /// Return index of child octant containing the point.
+    unsigned GetChildIndex(const Vector3& position) const;
+    /// Append a drawable object without updating drawable count.
+    void PushDrawable(Drawable* drawable);
+    /// Remove a drawable object at index without updating drawable count. Last drawable is moved in its place.
+    void EraseDrawable(unsigned index);
 
     /// Increase drawable object count recursively.
     void IncDrawableCount()
@@ -146,6 +200,8 @@ protected:
     BoundingBox cullingBox_;
     /// Drawable objects.
     ea::vector<Drawable*> drawables_;
+    /// Culling data of drawable objects. Updated on insertion and when reinserted during octree update.
+    OctantCullingData cullingData_;
     /// Child octants.
     Octant* children_[NUM_OCTANTS]{};
     /// World bounding box center.
@@ -241,12 +297,20 @@ public:
     void MarkZoneDirty(Zone* zone);
 
     /// Return drawable objects by a query.
+    /// Queries may be executed concurrently from multiple threads as long as the octree is not being updated.
     /// @nobind
     void GetDrawables(OctreeQuery& query) const;
     /// Return drawable objects by a ray query.
     void Raycast(RayOctreeQuery& query) const;
     /// Return the closest drawable object by a ray query.
     void RaycastSingle(RayOctreeQuery& query) const;
+    /// Return the closest drawable object for each ray. Result is written for each ray,
+    /// drawable is null and distance is infinite if there is no hit.
+    /// Rays are tested in packets and distributed between WorkQueue threads.
+    /// Should be called from the main thread or WorkQueue thread while the octree is not being updated.
+    /// @nobind
+    void RaycastSingleBatch(ea::span<const Ray> rays, ea::span<RayQueryResult> results, RayQueryLevel level = RAY_TRIANGLE,
+        float maxDistance = M_INFINITY, DrawableFlags drawableFlags = DRAWABLE_ANY, unsigned viewMask = DEFAULT_VIEWMASK) const;
     /// Return best zone for drawable.
     CachedDrawableZone QueryZone(Drawable* drawable) const;
     /// Return best zone for drawable with given center in world space and zone mask.
@@ -275,8 +339,25 @@ public:
     void DrawDebugGeometry(bool depthTest);
 
 private:
+    /// Pending move of drawable object between octants.
+    struct Reinsertion
+    {
+        /// Drawable object.
+        Drawable* drawable_{};
+        /// Current octant.
+        Octant* oldOctant_{};
+        /// New octant if exists.
+        Octant* newOctant_{};
+        /// Whether the new octant already exists.
+        bool isExisting_{};
+    };
+
     /// Handle render update in case of headless execution.
-    void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleRenderUpdate(const RenderUpdateEventArgs& args);
+    /// Find new octant for updated drawable object. World bounding box should be up to date. Safe to call from multiple threads.
+    Reinsertion FindReinsertion(Drawable* drawable);
+    /// Move drawable objects to new octants.
+    void CommitReinsertions();
     /// Update octree size.
     void UpdateOctreeSize() { SetSize(worldBoundingBox_, numLevels_); }
 
@@ -286,6 +367,8 @@ private:
     ea::vector<Drawable*> drawableUpdates_;
     /// Drawable objects that were inserted during threaded update phase.
     ea::vector<Drawable*> threadedDrawableUpdates_;
+    /// Pending moves of drawable objects between octants, one per updated drawable.
+    ea::vector<Reinsertion> reinsertions_;
     /// All Drawable objects.
     ea::vector<Drawable*> drawables_;
     /// Mutex for octree reinsertions.
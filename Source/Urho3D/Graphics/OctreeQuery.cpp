@@ -22,13 +22,26 @@
 
 #include "../Precompiled.h"
 
+#include "../Graphics/Octree.h"
 #include "../Graphics/OctreeQuery.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
 {
 
+namespace
+{
+
+/// Max number of drawables passed to TestDrawables at once after culling.
+static const unsigned MAX_CULLED_BATCH = 64;
+
+}
+
 Intersection PointOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
     if (inside)
@@ -117,6 +130,105 @@ void FrustumOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool in
     }
 }
 
+void FrustumOctreeQuery::TestOctantDrawables(const OctantCullingData& data, Drawable** start, Drawable** end, bool inside)
+{
+    const unsigned numDrawables = end - start;
+    const unsigned flagsMask = drawableFlags_;
+
+    // For each plane, choose the box corner farthest along plane normal.
+    // Box is outside if this corner is behind any plane.
+    const float* cornerX[NUM_FRUSTUM_PLANES];
+    const float* cornerY[NUM_FRUSTUM_PLANES];
+    const float* cornerZ[NUM_FRUSTUM_PLANES];
+    for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+    {
+        const Vector3& normal = frustum_.planes_[i].normal_;
+        cornerX[i] = normal.x_ >= 0.0f ? data.maxX_.data() : data.minX_.data();
+        cornerY[i] = normal.y_ >= 0.0f ? data.maxY_.data() : data.minY_.data();
+        cornerZ[i] = normal.z_ >= 0.0f ? data.maxZ_.data() : data.minZ_.data();
+    }
+
+    Drawable* batch[MAX_CULLED_BATCH];
+    unsigned batchSize = 0;
+    unsigned index = 0;
+
+#ifdef URHO3D_SSE
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i flagsMaskVec = _mm_set1_epi32(static_cast<int>(flagsMask));
+    const __m128i viewMaskVec = _mm_set1_epi32(static_cast<int>(viewMask_));
+
+    for (; index + 4 <= numDrawables; index += 4)
+    {
+        const __m128i flags = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&data.drawableFlags_[index]));
+        const __m128i viewMasks = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&data.viewMasks_[index]));
+        const __m128i rejected = _mm_or_si128(
+            _mm_cmpeq_epi32(_mm_and_si128(flags, flagsMaskVec), zero),
+            _mm_cmpeq_epi32(_mm_and_si128(viewMasks, viewMaskVec), zero));
+        __m128 outside = _mm_castsi128_ps(rejected);
+
+        if (!inside)
+        {
+            for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+            {
+                const Plane& plane = frustum_.planes_[i];
+                __m128 distance = _mm_set1_ps(plane.d_);
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.normal_.x_), _mm_loadu_ps(cornerX[i] + index)));
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.normal_.y_), _mm_loadu_ps(cornerY[i] + index)));
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.normal_.z_), _mm_loadu_ps(cornerZ[i] + index)));
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+            }
+        }
+
+        const unsigned outsideMask = static_cast<unsigned>(_mm_movemask_ps(outside));
+        for (unsigned lane = 0; lane < 4; ++lane)
+        {
+            if (!(outsideMask & (1u << lane)))
+                batch[batchSize++] = start[index + lane];
+        }
+
+        if (batchSize + 4 > MAX_CULLED_BATCH)
+        {
+            TestDrawables(batch, batch + batchSize, true);
+            batchSize = 0;
+        }
+    }
+#endif
+
+    for (; index < numDrawables; ++index)
+    {
+        if (!(data.drawableFlags_[index] & flagsMask) || !(data.viewMasks_[index] & viewMask_))
+            continue;
+
+        bool isOutside = false;
+        if (!inside)
+        {
+            for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+            {
+                const Plane& plane = frustum_.planes_[i];
+                const float distance = plane.normal_.x_ * cornerX[i][index] + plane.normal_.y_ * cornerY[i][index]
+                    + plane.normal_.z_ * cornerZ[i][index] + plane.d_;
+                if (distance < 0.0f)
+                {
+                    isOutside = true;
+                    break;
+                }
+            }
+        }
+
+        if (!isOutside)
+        {
+            batch[batchSize++] = start[index];
+            if (batchSize == MAX_CULLED_BATCH)
+            {
+                TestDrawables(batch, batch + batchSize, true);
+                batchSize = 0;
+            }
+        }
+    }
+
+    if (batchSize)
+        TestDrawables(batch, batch + batchSize, true);
+}
 
 Intersection AllContentOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
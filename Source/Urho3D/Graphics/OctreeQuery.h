@@ -36,6 +36,7 @@ namespace Urho3D
 
 class Drawable;
 class Node;
+struct OctantCullingData;
 
 /// Base class for octree queries.
 class URHO3D_API OctreeQuery : private NonCopyable
@@ -56,6 +57,12 @@ public:
     virtual Intersection TestOctant(const BoundingBox& box, bool inside) = 0;
     /// Intersection test for drawables.
     virtual void TestDrawables(Drawable** start, Drawable** end, bool inside) = 0;
+    /// Intersection test for drawables of octant. Culling data elements match the drawables.
+    /// By default culling data is ignored.
+    virtual void TestOctantDrawables(const OctantCullingData& data, Drawable** start, Drawable** end, bool inside)
+    {
+        TestDrawables(start, end, inside);
+    }
 
     /// Result vector reference.
     ea::vector<Drawable*>& result_;
@@ -148,6 +155,9 @@ public:
     Intersection TestOctant(const BoundingBox& box, bool inside) override;
     /// Intersection test for drawables.
     void TestDrawables(Drawable** start, Drawable** end, bool inside) override;
+    /// Intersection test for drawables of octant. Drawables are tested against drawable flags, view mask
+    /// and frustum using culling data, and passed to TestDrawables as inside if the tests pass.
+    void TestOctantDrawables(const OctantCullingData& data, Drawable** start, Drawable** end, bool inside) override;
 
     /// Frustum.
     Frustum frustum_;
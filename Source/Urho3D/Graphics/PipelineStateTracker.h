@@ -120,7 +120,7 @@ private:
     DependantVector::iterator FindSubscriberIter(PipelineStateTracker* subscriber);
 
     /// Cached hash.
-    mutable std::atomic_uint32_t pipelineStateHash_;
+    mutable std::atomic_uint32_t pipelineStateHash_{};
     /// Other pipeline state trackers depending on this tracker.
     DependantVector subscribers_;
 };
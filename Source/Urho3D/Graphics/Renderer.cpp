@@ -1759,7 +1759,7 @@ void Renderer::Initialize()
 
     initialized_ = true;
 
-    SubscribeToEvent(E_RENDERUPDATE, URHO3D_HANDLER(Renderer, HandleRenderUpdate));
+    SubscribeToTypedEvent<RenderUpdateEventArgs>([this](const RenderUpdateEventArgs& args) { HandleRenderUpdate(args); });
 
     URHO3D_LOGINFO("Initialized renderer");
 }
@@ -2110,11 +2110,9 @@ void Renderer::HandleScreenMode(StringHash eventType, VariantMap& eventData)
         resetViews_ = true;
 }
 
-void Renderer::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
+void Renderer::HandleRenderUpdate(const RenderUpdateEventArgs& args)
 {
-    using namespace RenderUpdate;
-
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(args.timeStep_);
 }
 
 
@@ -49,6 +49,7 @@ class Octree;
 class Graphics;
 class RenderPath;
 class RenderSurface;
+struct RenderUpdateEventArgs;
 class ResourceCache;
 class Scene;
 class Skeleton;
@@ -574,7 +575,7 @@ private:
     /// Handle screen mode event.
     void HandleScreenMode(StringHash eventType, VariantMap& eventData);
     /// Handle render update event.
-    void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleRenderUpdate(const RenderUpdateEventArgs& args);
     /// Blur the shadow map.
     void BlurShadowMap(View* view, Texture2D* shadowMap, float blurScale);
 
@@ -25,6 +25,8 @@
 #include "../Graphics/Skeleton.h"
 #include "../IO/Log.h"
 
+#include <EASTL/algorithm.h>
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -110,6 +112,7 @@ void Skeleton::Define(const Skeleton& src)
     for (auto i = bones_.begin(); i != bones_.end(); ++i)
         i->node_.Reset();
     rootBoneIndex_ = src.rootBoneIndex_;
+    boneOrderDirty_ = true;
 }
 
 void Skeleton::SetRootBoneIndex(unsigned index)
@@ -123,12 +126,51 @@ void Skeleton::SetRootBoneIndex(unsigned index)
 void Skeleton::SetNumBones(unsigned numBones)
 {
     bones_.resize(numBones);
+    boneOrderDirty_ = true;
 }
 
 void Skeleton::ClearBones()
 {
     bones_.clear();
     rootBoneIndex_ = M_MAX_UNSIGNED;
+    boneOrderDirty_ = true;
+}
+
+const ea::vector<unsigned>& Skeleton::GetBoneOrder() const
+{
+    if (!boneOrderDirty_)
+        return boneOrder_;
+
+    boneOrderDirty_ = false;
+    const unsigned numBones = bones_.size();
+
+    // Build lists of children
+    ea::vector<unsigned> firstChild(numBones, M_MAX_UNSIGNED);
+    ea::vector<unsigned> nextSibling(numBones, M_MAX_UNSIGNED);
+    boneOrder_.clear();
+    for (unsigned i = numBones; i-- > 0;)
+    {
+        const unsigned parentIndex = bones_[i].parentIndex_;
+        if (parentIndex == i)
+            boneOrder_.push_back(i);
+        else if (parentIndex < numBones)
+        {
+            nextSibling[i] = firstChild[parentIndex];
+            firstChild[parentIndex] = i;
+        }
+    }
+    ea::reverse(boneOrder_.begin(), boneOrder_.end());
+
+    // Append children of already sorted bones. Bones in cycles or with invalid parents are never reached
+    for (unsigned i = 0; i < boneOrder_.size(); ++i)
+    {
+        for (unsigned child = firstChild[boneOrder_[i]]; child != M_MAX_UNSIGNED; child = nextSibling[child])
+            boneOrder_.push_back(child);
+    }
+
+    if (boneOrder_.size() != numBones)
+        boneOrder_.clear();
+    return boneOrder_;
 }
 
 void Skeleton::Reset()
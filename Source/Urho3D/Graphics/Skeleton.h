@@ -122,8 +122,12 @@ public:
     /// Return all bones.
     const ea::vector<Bone>& GetBones() const { return bones_; }
 
-    /// Return modifiable bones.
-    ea::vector<Bone>& GetModifiableBones() { return bones_; }
+    /// Return modifiable bones. Bone hierarchy order is recalculated on next use.
+    ea::vector<Bone>& GetModifiableBones() { boneOrderDirty_ = true; return bones_; }
+
+    /// Return bone indices sorted so that every parent precedes its children.
+    /// Return empty array if bone hierarchy is broken, i.e. contains cycles or invalid parent indices.
+    const ea::vector<unsigned>& GetBoneOrder() const;
 
     /// Return number of bones.
     /// @property
@@ -158,6 +162,10 @@ private:
     ea::vector<Bone> bones_;
     /// Root bone index.
     unsigned rootBoneIndex_;
+    /// Bone indices sorted so that every parent precedes its children.
+    mutable ea::vector<unsigned> boneOrder_;
+    /// Whether the bone order should be recalculated.
+    mutable bool boneOrderDirty_{ true };
 };
 
 }
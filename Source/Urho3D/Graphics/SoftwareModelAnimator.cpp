@@ -23,6 +23,7 @@
 #include "../Precompiled.h"
 
 #include "../Core/Context.h"
+#include "../Core/WorkQueue.h"
 #include "../IO/Log.h"
 #include "../Graphics/Geometry.h"
 #include "../Graphics/IndexBuffer.h"
@@ -48,6 +49,134 @@ Vector3 TransformNormal(const Matrix3x4& m, const Vector3& v)
     };
 }
 
+#ifdef URHO3D_SSE
+/// Blend rows of bone transforms for one vertex.
+void BlendTransformRows(const SoftwareSkinningParams& params, unsigned vertexIndex, __m128& row0, __m128& row1, __m128& row2)
+{
+    const unsigned char* indices = params.blendIndices_ + vertexIndex * params.numBones_;
+    const float* weights = params.blendWeights_ + vertexIndex * params.numBones_;
+
+    const Matrix3x4& firstTransform = params.boneTransforms_[indices[0]];
+    const __m128 firstWeight = _mm_set1_ps(weights[0]);
+    row0 = _mm_mul_ps(_mm_loadu_ps(&firstTransform.m00_), firstWeight);
+    row1 = _mm_mul_ps(_mm_loadu_ps(&firstTransform.m10_), firstWeight);
+    row2 = _mm_mul_ps(_mm_loadu_ps(&firstTransform.m20_), firstWeight);
+
+    for (unsigned boneIndex = 1; boneIndex < params.numBones_; ++boneIndex)
+    {
+        const Matrix3x4& transform = params.boneTransforms_[indices[boneIndex]];
+        const __m128 weight = _mm_set1_ps(weights[boneIndex]);
+        row0 = _mm_add_ps(row0, _mm_mul_ps(_mm_loadu_ps(&transform.m00_), weight));
+        row1 = _mm_add_ps(row1, _mm_mul_ps(_mm_loadu_ps(&transform.m10_), weight));
+        row2 = _mm_add_ps(row2, _mm_mul_ps(_mm_loadu_ps(&transform.m20_), weight));
+    }
+}
+
+/// Transform Vector3 elements of 4 vertices. Matrix columns hold one element of blended matrices of all vertices.
+template <bool Translate>
+void TransformVectors4(unsigned char* data, unsigned vertexSize,
+    const __m128 (&columns0)[4], const __m128 (&columns1)[4], const __m128 (&columns2)[4])
+{
+    float* vectors[4];
+    for (unsigned i = 0; i < 4; ++i)
+        vectors[i] = reinterpret_cast<float*>(data + i * vertexSize);
+
+    const __m128 x = _mm_setr_ps(vectors[0][0], vectors[1][0], vectors[2][0], vectors[3][0]);
+    const __m128 y = _mm_setr_ps(vectors[0][1], vectors[1][1], vectors[2][1], vectors[3][1]);
+    const __m128 z = _mm_setr_ps(vectors[0][2], vectors[1][2], vectors[2][2], vectors[3][2]);
+
+    __m128 resultX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(columns0[0], x), _mm_mul_ps(columns0[1], y)), _mm_mul_ps(columns0[2], z));
+    __m128 resultY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(columns1[0], x), _mm_mul_ps(columns1[1], y)), _mm_mul_ps(columns1[2], z));
+    __m128 resultZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(columns2[0], x), _mm_mul_ps(columns2[1], y)), _mm_mul_ps(columns2[2], z));
+    if (Translate)
+    {
+        resultX = _mm_add_ps(resultX, columns0[3]);
+        resultY = _mm_add_ps(resultY, columns1[3]);
+        resultZ = _mm_add_ps(resultZ, columns2[3]);
+    }
+
+    alignas(16) float results[3][4];
+    _mm_store_ps(results[0], resultX);
+    _mm_store_ps(results[1], resultY);
+    _mm_store_ps(results[2], resultZ);
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        vectors[i][0] = results[0][i];
+        vectors[i][1] = results[1][i];
+        vectors[i][2] = results[2][i];
+    }
+}
+#endif
+
+template <bool SkinNormals, bool SkinTangents>
+void SkinVertexRange(const SoftwareSkinningParams& params, unsigned beginVertex, unsigned endVertex)
+{
+    const unsigned vertexSize = params.vertexSize_;
+    unsigned vertexIndex = beginVertex;
+
+#ifdef URHO3D_SSE
+    // Skin 4 vertices at once: blend matrix rows per vertex, then transpose them so that
+    // each register holds the same matrix element of all 4 vertices
+    for (; vertexIndex + 4 <= endVertex; vertexIndex += 4)
+    {
+        __m128 columns[3][4];
+        for (unsigned i = 0; i < 4; ++i)
+            BlendTransformRows(params, vertexIndex + i, columns[0][i], columns[1][i], columns[2][i]);
+
+        _MM_TRANSPOSE4_PS(columns[0][0], columns[0][1], columns[0][2], columns[0][3]);
+        _MM_TRANSPOSE4_PS(columns[1][0], columns[1][1], columns[1][2], columns[1][3]);
+        _MM_TRANSPOSE4_PS(columns[2][0], columns[2][1], columns[2][2], columns[2][3]);
+
+        unsigned char* vertexData = params.vertexData_ + vertexIndex * vertexSize;
+        TransformVectors4<true>(vertexData, vertexSize, columns[0], columns[1], columns[2]);
+        if (SkinNormals)
+            TransformVectors4<false>(vertexData + params.normalOffset_, vertexSize, columns[0], columns[1], columns[2]);
+        if (SkinTangents)
+            TransformVectors4<false>(vertexData + params.tangentOffset_, vertexSize, columns[0], columns[1], columns[2]);
+    }
+#endif
+
+    const unsigned char* indicesData = params.blendIndices_ + vertexIndex * params.numBones_;
+    const float* weightsData = params.blendWeights_ + vertexIndex * params.numBones_;
+
+    unsigned char* positionsData = params.vertexData_ + vertexIndex * vertexSize;
+    unsigned char* normalsData = SkinNormals ? positionsData + params.normalOffset_ : nullptr;
+    unsigned char* tangentsData = SkinTangents ? positionsData + params.tangentOffset_ : nullptr;
+
+    Matrix3x4 matrix;
+    for (; vertexIndex < endVertex; ++vertexIndex)
+    {
+        matrix = params.boneTransforms_[indicesData[0]] * weightsData[0];
+        for (unsigned boneIndex = 1; boneIndex < params.numBones_; ++boneIndex)
+            matrix = matrix + params.boneTransforms_[indicesData[boneIndex]] * weightsData[boneIndex];
+
+        Vector3& position = *reinterpret_cast<Vector3*>(positionsData);
+        position = matrix * position;
+
+        if (SkinNormals)
+        {
+            Vector3& normal = *reinterpret_cast<Vector3*>(normalsData);
+            normal = TransformNormal(matrix, normal);
+        }
+
+        if (SkinTangents)
+        {
+            Vector3& tangent = *reinterpret_cast<Vector3*>(tangentsData);
+            tangent = TransformNormal(matrix, tangent);
+        }
+
+        // Advance
+        indicesData += params.numBones_;
+        weightsData += params.numBones_;
+
+        positionsData += vertexSize;
+        if (SkinNormals)
+            normalsData += vertexSize;
+        if (SkinTangents)
+            tangentsData += vertexSize;
+    }
+}
+
 }
 
 SoftwareModelAnimator::SoftwareModelAnimator(Context* context) : Object(context) {}
@@ -117,68 +246,50 @@ void SoftwareModelAnimator::ApplySkinning(ea::span<const Matrix3x4> worldTransfo
         if (!clonedBuffer || !animationData.hasSkeletalAnimation_)
             continue;
 
-        if (!animationData.skinNormals_ && !animationData.skinTangents_)
-            ApplyVertexBufferSkinning<false, false>(clonedBuffer, animationData, worldTransforms);
-        else if (animationData.skinNormals_ && !animationData.skinTangents_)
-            ApplyVertexBufferSkinning<true, false>(clonedBuffer, animationData, worldTransforms);
-        else if (animationData.skinNormals_ && animationData.skinTangents_)
-            ApplyVertexBufferSkinning<true, true>(clonedBuffer, animationData, worldTransforms);
-        else
-            ApplyVertexBufferSkinning<false, true>(clonedBuffer, animationData, worldTransforms); // this is really weird case
+        ApplyVertexBufferSkinning(clonedBuffer, animationData, worldTransforms);
     }
 }
 
-template <bool SkinNormals, bool SkinTangents>
-void SoftwareModelAnimator::ApplyVertexBufferSkinning(VertexBuffer* clonedBuffer, const VertexBufferAnimationData& animationData,
-    ea::span<const Matrix3x4> worldTransforms) const
+void SoftwareModelAnimator::SkinVertices(const SoftwareSkinningParams& params, unsigned beginVertex, unsigned endVertex)
 {
-    const unsigned clonedVertexSize = clonedBuffer->GetVertexSize();
-    const unsigned normalOffset = clonedBuffer->GetElementOffset(TYPE_VECTOR3, SEM_NORMAL);
-    const unsigned tangentOffset = clonedBuffer->GetElementOffset(TYPE_VECTOR4, SEM_TANGENT);
-
-    unsigned char* clonedBufferData = clonedBuffer->GetShadowData();
-
-    unsigned char* positionsData = clonedBufferData;
-    unsigned char* normalsData = SkinNormals ? clonedBufferData + normalOffset : nullptr;
-    unsigned char* tangentsData = SkinTangents ? clonedBufferData + tangentOffset : nullptr;
-
-    const unsigned char* indicesData = animationData.blendIndices_.data();
-    const float* weightsData = animationData.blendWeights_.data();
+    const bool skinNormals = params.normalOffset_ != M_MAX_UNSIGNED;
+    const bool skinTangents = params.tangentOffset_ != M_MAX_UNSIGNED;
+
+    if (!skinNormals && !skinTangents)
+        SkinVertexRange<false, false>(params, beginVertex, endVertex);
+    else if (skinNormals && !skinTangents)
+        SkinVertexRange<true, false>(params, beginVertex, endVertex);
+    else if (skinNormals && skinTangents)
+        SkinVertexRange<true, true>(params, beginVertex, endVertex);
+    else
+        SkinVertexRange<false, true>(params, beginVertex, endVertex); // this is really weird case
+}
 
+void SoftwareModelAnimator::ApplyVertexBufferSkinning(VertexBuffer* clonedBuffer,
+    const VertexBufferAnimationData& animationData, ea::span<const Matrix3x4> worldTransforms) const
+{
+    SoftwareSkinningParams params;
+    params.vertexData_ = clonedBuffer->GetShadowData();
+    params.vertexSize_ = clonedBuffer->GetVertexSize();
+    if (animationData.skinNormals_)
+        params.normalOffset_ = clonedBuffer->GetElementOffset(TYPE_VECTOR3, SEM_NORMAL);
+    if (animationData.skinTangents_)
+        params.tangentOffset_ = clonedBuffer->GetElementOffset(TYPE_VECTOR4, SEM_TANGENT);
+    params.blendIndices_ = animationData.blendIndices_.data();
+    params.blendWeights_ = animationData.blendWeights_.data();
+    params.numBones_ = numBones_;
+    params.boneTransforms_ = worldTransforms.data();
+
+    // Split large buffers into vertex ranges
     const unsigned numVertices = clonedBuffer->GetVertexCount();
-    Matrix3x4 matrix;
-    for (unsigned vertexIndex = 0; vertexIndex < numVertices; ++vertexIndex)
+    auto workQueue = GetSubsystem<WorkQueue>();
+    if (workQueue)
     {
-        matrix = worldTransforms[indicesData[0]] * weightsData[0];
-        for (unsigned boneIndex = 1; boneIndex < numBones_; ++boneIndex)
-            matrix = matrix + worldTransforms[indicesData[boneIndex]] * weightsData[boneIndex];
-
-        Vector3& position = *reinterpret_cast<Vector3*>(positionsData);
-        position = matrix * position;
-
-        if (SkinNormals)
-        {
-            Vector3& normal = *reinterpret_cast<Vector3*>(normalsData);
-            normal = TransformNormal(matrix, normal);
-        }
-
-        if (SkinTangents)
-        {
-            Vector3& tangent = *reinterpret_cast<Vector3*>(tangentsData);
-            tangent = TransformNormal(matrix, tangent);
-        }
-
-        // Advance
-        indicesData += numBones_;
-        weightsData += numBones_;
-
-        positionsData += clonedVertexSize;
-        if (SkinNormals)
-            normalsData += clonedVertexSize;
-        if (SkinTangents)
-            tangentsData += clonedVertexSize;
+        ForEachParallel(workQueue, SkinningBucket, numVertices,
+            [&](unsigned beginVertex, unsigned endVertex) { SkinVertices(params, beginVertex, endVertex); });
     }
-
+    else
+        SkinVertices(params, 0, numVertices);
 }
 
 void SoftwareModelAnimator::Commit()
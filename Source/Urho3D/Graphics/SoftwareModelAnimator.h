@@ -45,6 +45,27 @@ struct VertexBufferAnimationData
     ea::vector<unsigned char> blendIndices_;
 };
 
+/// Interleaved vertex data and blending data for software skinning of vertex range.
+struct SoftwareSkinningParams
+{
+    /// Interleaved vertex data. Position shall be Vector3 at offset 0.
+    unsigned char* vertexData_{};
+    /// Vertex size in bytes.
+    unsigned vertexSize_{};
+    /// Offset of Vector3 normal within vertex, M_MAX_UNSIGNED if not skinned.
+    unsigned normalOffset_{ M_MAX_UNSIGNED };
+    /// Offset of Vector4 tangent within vertex, M_MAX_UNSIGNED if not skinned.
+    unsigned tangentOffset_{ M_MAX_UNSIGNED };
+    /// Blend indices, numBones_ per vertex.
+    const unsigned char* blendIndices_{};
+    /// Blend weights, numBones_ per vertex.
+    const float* blendWeights_{};
+    /// Number of bones per vertex.
+    unsigned numBones_{};
+    /// Bone transforms.
+    const Matrix3x4* boneTransforms_{};
+};
+
 /// Class for software model animation (morphing and skinning).
 class URHO3D_API SoftwareModelAnimator : public Object
 {
@@ -53,6 +74,8 @@ class URHO3D_API SoftwareModelAnimator : public Object
 public:
     /// Max number of bones.
     static const unsigned MaxBones = 4;
+    /// Min number of vertices skinned by one worker thread.
+    static const unsigned SkinningBucket = 4096;
 
     /// Construct.
     explicit SoftwareModelAnimator(Context* context);
@@ -73,6 +96,9 @@ public:
     /// Commit data to GPU.
     void Commit();
 
+    /// Skin vertices in range. Safe to call from worker thread.
+    static void SkinVertices(const SoftwareSkinningParams& params, unsigned beginVertex, unsigned endVertex);
+
     /// Return animated geometries.
     const ea::vector<ea::vector<SharedPtr<Geometry>>>& GetGeometries() const { return geometries_; }
 
@@ -92,7 +118,6 @@ private:
     /// Apply a vertex buffer morph.
     void ApplyMorph(VertexBuffer* buffer, const VertexBufferMorph& morph, float weight);
     /// Apply skinning for given vertex buffer.
-    template <bool SkinNormals, bool SkinTangents>
     void ApplyVertexBufferSkinning(VertexBuffer* clonedBuffer, const VertexBufferAnimationData& animationData,
         ea::span<const Matrix3x4> worldTransforms) const;
 
@@ -176,9 +176,10 @@ void IKSolver::SetFeature(Feature feature, bool enable)
                 break;
 
             if (enable)
-                SubscribeToEvent(GetScene(), E_SCENEDRAWABLEUPDATEFINISHED, URHO3D_HANDLER(IKSolver, HandleSceneDrawableUpdateFinished));
+                SubscribeToTypedEvent<SceneDrawableUpdateFinishedEventArgs>(GetScene(),
+                    [this](const SceneDrawableUpdateFinishedEventArgs& args) { HandleSceneDrawableUpdateFinished(args); });
             else
-                UnsubscribeFromEvent(GetScene(), E_SCENEDRAWABLEUPDATEFINISHED);
+                UnsubscribeFromTypedEvent<SceneDrawableUpdateFinishedEventArgs>(GetScene());
         } break;
 
         default: break;
@@ -519,7 +520,8 @@ bool IKSolver::IsSolverTreeValid() const
 void IKSolver::OnSceneSet(Scene* scene)
 {
     if (features_ & AUTO_SOLVE)
-        SubscribeToEvent(scene, E_SCENEDRAWABLEUPDATEFINISHED, URHO3D_HANDLER(IKSolver, HandleSceneDrawableUpdateFinished));
+        SubscribeToTypedEvent<SceneDrawableUpdateFinishedEventArgs>(scene,
+            [this](const SceneDrawableUpdateFinishedEventArgs& args) { HandleSceneDrawableUpdateFinished(args); });
 }
 
 // ----------------------------------------------------------------------------
@@ -720,7 +722,7 @@ void IKSolver::HandleNodeRemoved(StringHash eventType, VariantMap& eventData)
 }
 
 // ----------------------------------------------------------------------------
-void IKSolver::HandleSceneDrawableUpdateFinished(StringHash eventType, VariantMap& eventData)
+void IKSolver::HandleSceneDrawableUpdateFinished(const SceneDrawableUpdateFinishedEventArgs& args)
 {
     Solve();
 }
@@ -32,6 +32,7 @@ namespace Urho3D
 class AnimationState;
 class IKConstraint;
 class IKEffector;
+struct SceneDrawableUpdateFinishedEventArgs;
 
 /*!
  * @brief Marks the root or "beginning" of an IK chain or multiple IK chains.
@@ -355,7 +356,7 @@ private:
     void HandleNodeAdded(StringHash eventType, VariantMap& eventData);
     void HandleNodeRemoved(StringHash eventType, VariantMap& eventData);
     /// Invokes the IK solver.
-    void HandleSceneDrawableUpdateFinished(StringHash eventType, VariantMap& eventData);
+    void HandleSceneDrawableUpdateFinished(const SceneDrawableUpdateFinishedEventArgs& args);
 
     // Need these wrapper functions flags of GetFeature/SetFeature can be correctly exposed to the editor and to AngelScript and lua
 public:
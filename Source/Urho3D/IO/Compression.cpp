@@ -31,10 +31,19 @@
 
 #include <LZ4/lz4.h>
 #include <LZ4/lz4hc.h>
+#include <STB/stb_image.h>
+
+#include <cstdlib>
+
+// Implemented by stb_image_write, but not declared in its header
+unsigned char* stbi_zlib_compress(unsigned char* data, int data_len, int* out_len, int quality);
 
 namespace Urho3D
 {
 
+/// Deflate compression quality. Higher values search longer for matches.
+static const int DEFLATE_QUALITY = 10;
+
 unsigned EstimateCompressBound(unsigned srcSize)
 {
     return (unsigned)LZ4_compressBound(srcSize);
@@ -56,6 +65,75 @@ unsigned DecompressData(void* dest, const void* src, unsigned destSize)
         return (unsigned)LZ4_decompress_fast((const char*)src, (char*)dest, destSize);
 }
 
+unsigned EstimateCompressBound(unsigned srcSize, CompressionCodec codec)
+{
+    switch (codec)
+    {
+    case CompressionCodec::LZ4:
+        return (unsigned)LZ4_compressBound(srcSize);
+    case CompressionCodec::Deflate:
+        // Fixed Huffman codes take at most 9 bits per literal, plus zlib header, block headers and checksum
+        return srcSize + srcSize / 8 + 64;
+    case CompressionCodec::None:
+    default:
+        return srcSize;
+    }
+}
+
+unsigned CompressData(void* dest, const void* src, unsigned srcSize, CompressionCodec codec)
+{
+    if (!dest || !src || !srcSize)
+        return 0;
+
+    switch (codec)
+    {
+    case CompressionCodec::LZ4:
+        return CompressData(dest, src, srcSize);
+
+    case CompressionCodec::Deflate:
+    {
+        int packedSize = 0;
+        unsigned char* packedData = stbi_zlib_compress(
+            static_cast<unsigned char*>(const_cast<void*>(src)), (int)srcSize, &packedSize, DEFLATE_QUALITY);
+        if (!packedData)
+            return 0;
+
+        const unsigned result = (unsigned)packedSize <= EstimateCompressBound(srcSize, codec) ? (unsigned)packedSize : 0;
+        if (result)
+            memcpy(dest, packedData, result);
+        free(packedData);
+        return result;
+    }
+
+    case CompressionCodec::None:
+    default:
+        memcpy(dest, src, srcSize);
+        return srcSize;
+    }
+}
+
+bool DecompressData(void* dest, unsigned destSize, const void* src, unsigned srcSize, CompressionCodec codec)
+{
+    if (!dest || !src || !destSize)
+        return false;
+
+    switch (codec)
+    {
+    case CompressionCodec::LZ4:
+        return LZ4_decompress_safe((const char*)src, (char*)dest, (int)srcSize, (int)destSize) == (int)destSize;
+
+    case CompressionCodec::Deflate:
+        return stbi_zlib_decode_buffer((char*)dest, (int)destSize, (const char*)src, (int)srcSize) == (int)destSize;
+
+    case CompressionCodec::None:
+    default:
+        if (srcSize != destSize)
+            return false;
+        memcpy(dest, src, srcSize);
+        return true;
+    }
+}
+
 bool CompressStream(Serializer& dest, Deserializer& src)
 {
     unsigned srcSize = src.GetSize() - src.GetPosition();
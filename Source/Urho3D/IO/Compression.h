@@ -31,12 +31,29 @@ class Deserializer;
 class Serializer;
 class VectorBuffer;
 
+/// Codec used to compress a block of data.
+enum class CompressionCodec : unsigned char
+{
+    /// Data is stored as is.
+    None,
+    /// LZ4 in high compression mode. Fastest decompression.
+    LZ4,
+    /// Deflate. Better compression ratio than LZ4 at the cost of slower decompression.
+    Deflate
+};
+
 /// Estimate and return worst case LZ4 compressed output size in bytes for given input size.
 URHO3D_API unsigned EstimateCompressBound(unsigned srcSize);
 /// Compress data using the LZ4 algorithm and return the compressed data size. The needed destination buffer worst-case size is given by EstimateCompressBound().
 URHO3D_API unsigned CompressData(void* dest, const void* src, unsigned srcSize);
 /// Uncompress data using the LZ4 algorithm. The uncompressed data size must be known. Return the number of compressed data bytes consumed.
 URHO3D_API unsigned DecompressData(void* dest, const void* src, unsigned destSize);
+/// Estimate and return worst case compressed output size in bytes for given input size and codec.
+URHO3D_API unsigned EstimateCompressBound(unsigned srcSize, CompressionCodec codec);
+/// Compress data using the specified codec and return the compressed data size, or 0 on failure. The needed destination buffer worst-case size is given by EstimateCompressBound().
+URHO3D_API unsigned CompressData(void* dest, const void* src, unsigned srcSize, CompressionCodec codec);
+/// Uncompress data produced with the specified codec. The uncompressed data size must be known. Return true on success.
+URHO3D_API bool DecompressData(void* dest, unsigned destSize, const void* src, unsigned srcSize, CompressionCodec codec);
 /// Compress a source stream (from current position to the end) to the destination stream using the LZ4 algorithm. Return true on success.
 URHO3D_API bool CompressStream(Serializer& dest, Deserializer& src);
 /// Decompress a compressed source stream produced using CompressStream() to the destination stream. Return true on success.
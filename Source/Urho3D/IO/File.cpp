@@ -23,6 +23,7 @@
 #include "../Precompiled.h"
 
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../IO/File.h"
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
@@ -63,6 +64,8 @@ static const char* openMode[] =
 static const unsigned READ_BUFFER_SIZE = 32768;
 #endif
 static const unsigned SKIP_BUFFER_SIZE = 1024;
+/// Minimum number of compressed blocks read at once to decompress them in parallel.
+static const unsigned PARALLEL_DECOMPRESS_MIN_BLOCKS = 4;
 
 File::File(Context* context) :
     Object(context),
@@ -136,11 +139,25 @@ bool File::Open(PackageFile* package, const ea::string& fileName)
     if (!entry)
         return false;
 
-    bool success = OpenInternal(package->GetName(), FILE_READ, true);
-    if (!success)
+    if (package->IsMemoryMapped())
     {
-        URHO3D_LOGERROR("Could not open package file " + fileName);
-        return false;
+        // Read directly from the mapping, no file handle needed
+        Close();
+        mappedData_ = package->GetMappedData();
+        absoluteFileName_ = package->GetName();
+        mode_ = FILE_READ;
+        position_ = 0;
+        readSyncNeeded_ = false;
+        writeSyncNeeded_ = false;
+    }
+    else
+    {
+        bool success = OpenInternal(package->GetName(), FILE_READ, true);
+        if (!success)
+        {
+            URHO3D_LOGERROR("Could not open package file " + fileName);
+            return false;
+        }
     }
 
     name_ = fileName;
@@ -148,6 +165,15 @@ bool File::Open(PackageFile* package, const ea::string& fileName)
     checksum_ = entry->checksum_;
     size_ = entry->size_;
     compressed_ = package->IsCompressed();
+    package_ = package;
+
+    if (package->HasBlockIndex())
+    {
+        codec_ = package->GetCodec();
+        blockSize_ = package->GetBlockSize();
+        blockOffsets_ = package->GetBlockOffsets().data() + entry->firstBlock_;
+        currentBlock_ = M_MAX_UNSIGNED;
+    }
 
     // Seek to beginning of package entry's file data
     SeekInternal(offset_);
@@ -208,6 +234,9 @@ unsigned File::Read(void* dest, unsigned size)
     }
 #endif
 
+    if (blockOffsets_)
+        return ReadBlocks(static_cast<unsigned char*>(dest), size);
+
     if (compressed_)
     {
         unsigned sizeLeft = size;
@@ -227,12 +256,22 @@ unsigned File::Read(void* dest, unsigned size)
                 if (!readBuffer_)
                 {
                     readBuffer_ = new unsigned char[unpackedSize];
-                    inputBuffer_ = new unsigned char[LZ4_compressBound(unpackedSize)];
+                    if (!mappedData_)
+                        inputBuffer_ = new unsigned char[LZ4_compressBound(unpackedSize)];
                 }
 
                 /// \todo Handle errors
-                ReadInternal(inputBuffer_.get(), packedSize);
-                LZ4_decompress_fast((const char*)inputBuffer_.get(), (char*)readBuffer_.get(), unpackedSize);
+                if (mappedData_)
+                {
+                    // Decompress straight from the mapping
+                    LZ4_decompress_fast((const char*)mappedData_ + mappedPosition_, (char*)readBuffer_.get(), unpackedSize);
+                    mappedPosition_ += packedSize;
+                }
+                else
+                {
+                    ReadInternal(inputBuffer_.get(), packedSize);
+                    LZ4_decompress_fast((const char*)inputBuffer_.get(), (char*)readBuffer_.get(), unpackedSize);
+                }
 
                 readBufferSize_ = unpackedSize;
                 readBufferOffset_ = 0;
@@ -281,6 +320,13 @@ unsigned File::Seek(unsigned position)
     if (mode_ == FILE_READ && position > size_)
         position = size_;
 
+    // Blocks are located through the index, so any position can be decompressed directly
+    if (blockOffsets_)
+    {
+        position_ = position;
+        return position_;
+    }
+
     if (compressed_)
     {
         // Start over from the beginning
@@ -393,10 +439,16 @@ void File::Close()
     readBuffer_.reset();
     inputBuffer_.reset();
 
-    if (handle_)
+    if (handle_ || mappedData_)
     {
-        fclose((FILE*)handle_);
+        if (handle_)
+            fclose((FILE*)handle_);
         handle_ = nullptr;
+        package_ = nullptr;
+        mappedData_ = nullptr;
+        mappedPosition_ = 0;
+        blockOffsets_ = nullptr;
+        currentBlock_ = M_MAX_UNSIGNED;
         position_ = 0;
         size_ = 0;
         offset_ = 0;
@@ -413,9 +465,9 @@ void File::Flush()
 bool File::IsOpen() const
 {
 #ifdef __ANDROID__
-    return handle_ != 0 || assetHandle_ != 0;
+    return handle_ != 0 || assetHandle_ != 0 || mappedData_ != nullptr;
 #else
-    return handle_ != nullptr;
+    return handle_ != nullptr || mappedData_ != nullptr;
 #endif
 }
 
@@ -521,6 +573,15 @@ bool File::OpenInternal(const ea::string& fileName, FileMode mode, bool fromPack
 
 bool File::ReadInternal(void* dest, unsigned size)
 {
+    if (mappedData_)
+    {
+        if (mappedPosition_ + size > package_->GetTotalSize())
+            return false;
+        memcpy(dest, mappedData_ + mappedPosition_, size);
+        mappedPosition_ += size;
+        return true;
+    }
+
 #ifdef __ANDROID__
     if (assetHandle_)
     {
@@ -533,6 +594,12 @@ bool File::ReadInternal(void* dest, unsigned size)
 
 void File::SeekInternal(unsigned newPosition)
 {
+    if (mappedData_)
+    {
+        mappedPosition_ = newPosition;
+        return;
+    }
+
 #ifdef __ANDROID__
     if (assetHandle_)
     {
@@ -546,6 +613,111 @@ void File::SeekInternal(unsigned newPosition)
         fseek((FILE*)handle_, newPosition, SEEK_SET);
 }
 
+unsigned File::ReadBlocks(unsigned char* dest, unsigned size)
+{
+    const unsigned numBlocksInFile = (size_ + blockSize_ - 1) / blockSize_;
+    const unsigned endPosition = position_ + size;
+    unsigned sizeLeft = size;
+
+    while (sizeLeft)
+    {
+        const unsigned blockIndex = position_ / blockSize_;
+        const unsigned blockOffset = position_ % blockSize_;
+
+        // Decompress whole blocks directly to the destination
+        if (!blockOffset && blockIndex != currentBlock_)
+        {
+            const unsigned endBlock = endPosition == size_ ? numBlocksInFile : endPosition / blockSize_;
+            if (endBlock > blockIndex)
+            {
+                if (!DecompressBlocks(dest, blockIndex, endBlock - blockIndex))
+                    break;
+
+                const unsigned copySize = Min(endBlock * blockSize_, size_) - position_;
+                dest += copySize;
+                sizeLeft -= copySize;
+                position_ += copySize;
+                continue;
+            }
+        }
+
+        if (blockIndex != currentBlock_)
+        {
+            if (!readBuffer_)
+                readBuffer_ = new unsigned char[blockSize_];
+            if (!DecompressBlocks(readBuffer_.get(), blockIndex, 1))
+                break;
+            currentBlock_ = blockIndex;
+        }
+
+        const unsigned blockUnpackedSize = Min(blockSize_, size_ - blockIndex * blockSize_);
+        const unsigned copySize = Min(blockUnpackedSize - blockOffset, sizeLeft);
+        memcpy(dest, readBuffer_.get() + blockOffset, copySize);
+        dest += copySize;
+        sizeLeft -= copySize;
+        position_ += copySize;
+    }
+
+    if (sizeLeft)
+        URHO3D_LOGERROR("Error while reading from file " + GetName());
+    return size - sizeLeft;
+}
+
+bool File::DecompressBlocks(unsigned char* dest, unsigned firstBlock, unsigned numBlocks)
+{
+    const unsigned packedBegin = blockOffsets_[firstBlock];
+    const unsigned packedEnd = blockOffsets_[firstBlock + numBlocks];
+
+    const unsigned char* packedData = nullptr;
+    ByteVector packedBuffer;
+    if (mappedData_)
+        packedData = mappedData_ + offset_ + packedBegin;
+    else
+    {
+        packedBuffer.resize(packedEnd - packedBegin);
+        SeekInternal(offset_ + packedBegin);
+        if (!ReadInternal(packedBuffer.data(), packedBuffer.size()))
+            return false;
+        packedData = packedBuffer.data();
+    }
+
+    const auto decompressBlock = [&](unsigned index)
+    {
+        const unsigned blockIndex = firstBlock + index;
+        const unsigned unpackedSize = Min(blockSize_, size_ - blockIndex * blockSize_);
+        const unsigned packedSize = blockOffsets_[blockIndex + 1] - blockOffsets_[blockIndex];
+        const unsigned char* src = packedData + blockOffsets_[blockIndex] - packedBegin;
+        unsigned char* dst = dest + index * blockSize_;
+
+        // Blocks that do not benefit from compression are stored as is
+        const CompressionCodec codec = packedSize == unpackedSize ? CompressionCodec::None : codec_;
+        return DecompressData(dst, unpackedSize, src, packedSize, codec);
+    };
+
+    // Nested parallel loops are only safe from the threads owned by WorkQueue
+    auto workQueue = GetSubsystem<WorkQueue>();
+    if (numBlocks >= PARALLEL_DECOMPRESS_MIN_BLOCKS && workQueue && WorkQueue::GetThreadIndex() != M_MAX_UNSIGNED)
+    {
+        std::atomic_bool success{true};
+        ForEachParallel(workQueue, 1, numBlocks, [&](unsigned beginIndex, unsigned endIndex)
+        {
+            for (unsigned index = beginIndex; index < endIndex; ++index)
+            {
+                if (!decompressBlock(index))
+                    success = false;
+            }
+        });
+        return success;
+    }
+
+    for (unsigned index = 0; index < numBlocks; ++index)
+    {
+        if (!decompressBlock(index))
+            return false;
+    }
+    return true;
+}
+
 void File::ReadBinary(ea::vector<unsigned char>& buffer)
 {
     buffer.clear();
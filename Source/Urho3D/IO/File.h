@@ -28,6 +28,7 @@
 
 #include "../Core/Object.h"
 #include "../IO/AbstractFile.h"
+#include "../IO/Compression.h"
 
 #ifdef __ANDROID__
 struct SDL_RWops;
@@ -112,6 +113,9 @@ public:
     /// @property
     bool IsPackaged() const { return offset_ != 0; }
 
+    /// Return the file contents without copying if the file is an uncompressed entry of a memory-mapped package, or null otherwise. Valid while the file is open.
+    const unsigned char* GetMappedData() const { return mappedData_ && !compressed_ ? mappedData_ + offset_ : nullptr; }
+
     /// Reads a binary file to buffer.
     void ReadBinary(ea::vector<unsigned char>& buffer);
 
@@ -135,6 +139,10 @@ private:
     bool ReadInternal(void* dest, unsigned size);
     /// Seek in file internally using either C standard IO functions or SDL RWops for Android asset files.
     void SeekInternal(unsigned newPosition);
+    /// Read from a compressed package file which has a block index. Return number of bytes actually read.
+    unsigned ReadBlocks(unsigned char* dest, unsigned size);
+    /// Decompress consecutive blocks of a compressed package file. Return true if successful.
+    bool DecompressBlocks(unsigned char* dest, unsigned firstBlock, unsigned numBlocks);
 
     /// Absolute file name.
     ea::string absoluteFileName_;
@@ -164,6 +172,20 @@ private:
     bool readSyncNeeded_;
     /// Synchronization needed before write -flag.
     bool writeSyncNeeded_;
+    /// Package the file is read from. Keeps the block index and the memory mapping alive while the file is open.
+    SharedPtr<PackageFile> package_;
+    /// Memory-mapped package contents.
+    const unsigned char* mappedData_{};
+    /// Read position within the memory-mapped package contents.
+    unsigned mappedPosition_{};
+    /// Compression codec of a package file with a block index.
+    CompressionCodec codec_{};
+    /// Uncompressed block size of a package file with a block index.
+    unsigned blockSize_{};
+    /// Compressed block offsets of a package file with a block index, null otherwise.
+    const unsigned* blockOffsets_{};
+    /// Block currently decompressed to the read buffer.
+    unsigned currentBlock_{M_MAX_UNSIGNED};
 };
 
 }
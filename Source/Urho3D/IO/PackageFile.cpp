@@ -27,6 +27,14 @@
 #include "../IO/PackageFile.h"
 #include "../IO/FileSystem.h"
 
+#ifdef _WIN32
+#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 namespace Urho3D
 {
 
@@ -49,10 +57,15 @@ PackageFile::PackageFile(Context* context, const ea::string& fileName, unsigned
     Open(fileName, startOffset);
 }
 
-PackageFile::~PackageFile() = default;
+PackageFile::~PackageFile()
+{
+    UnmapMemory();
+}
 
 bool PackageFile::Open(const ea::string& fileName, unsigned startOffset)
 {
+    UnmapMemory();
+
     SharedPtr<File> file(new File(context_, fileName));
     if (!file->IsOpen())
         return false;
@@ -88,18 +101,37 @@ bool PackageFile::Open(const ea::string& fileName, unsigned startOffset)
     nameHash_ = fileName_;
     totalSize_ = file->GetSize();
     compressed_ = id == "ULZ4" || id == "RLZ4";
+    codec_ = compressed_ ? CompressionCodec::LZ4 : CompressionCodec::None;
+    blockSize_ = 0;
+    blockOffsets_.clear();
     unsigned numFiles = file->ReadUInt();
     checksum_ = file->ReadUInt();
 
     if (id == "RPAK" || id == "RLZ4")
     {
         // New PAK file format includes two extra PAK header fields:
-        // * Version. At this time this field is unused and is always 0. It will be used in the future if PAK format needs to be extended.
+        // * Version. 0 for the original layout. Version 1 adds compression codec and block size to the header and
+        //   offsets of compressed blocks to every file entry, so that compressed files can be seeked in constant time.
         // * File list offset. New format writes file list in the end of the file. This allows PAK creation without knowing entire file list
         //   beforehand.
-        unsigned version = file->ReadUInt();                        // Reserved for future use.
-        assert(version == 0);
+        unsigned version = file->ReadUInt();
+        if (version > PACKAGE_VERSION_BLOCK_INDEX)
+        {
+            URHO3D_LOGERROR("{} has unsupported package version {}", fileName, version);
+            return false;
+        }
         int64_t fileListOffset = file->ReadInt64();                 // New format has file list at the end of the file.
+        if (version >= PACKAGE_VERSION_BLOCK_INDEX)
+        {
+            codec_ = static_cast<CompressionCodec>(file->ReadUByte());
+            blockSize_ = file->ReadUInt();
+            compressed_ = codec_ != CompressionCodec::None;
+            if (compressed_ && !blockSize_)
+            {
+                URHO3D_LOGERROR(fileName + " has invalid compressed block size");
+                return false;
+            }
+        }
         file->Seek(fileListOffset);                                 // TODO: Serializer/Deserializer do not support files bigger than 4 GB
     }
 
@@ -110,7 +142,20 @@ bool PackageFile::Open(const ea::string& fileName, unsigned startOffset)
         newEntry.offset_ = file->ReadUInt() + startOffset;
         totalDataSize_ += (newEntry.size_ = file->ReadUInt());
         newEntry.checksum_ = file->ReadUInt();
-        if (!compressed_ && newEntry.offset_ + newEntry.size_ > totalSize_)
+
+        unsigned storedSize = newEntry.size_;
+        if (HasBlockIndex())
+        {
+            // Block offsets are stored as end offsets, prepend the beginning of the first block
+            const unsigned numBlocks = (newEntry.size_ + blockSize_ - 1) / blockSize_;
+            newEntry.firstBlock_ = blockOffsets_.size();
+            blockOffsets_.push_back(0);
+            for (unsigned j = 0; j < numBlocks; ++j)
+                blockOffsets_.push_back(file->ReadUInt());
+            storedSize = blockOffsets_.back();
+        }
+
+        if ((!compressed_ || HasBlockIndex()) && newEntry.offset_ + storedSize > totalSize_)
         {
             URHO3D_LOGERROR("File entry " + entryName + " outside package file");
             return false;
@@ -122,6 +167,74 @@ bool PackageFile::Open(const ea::string& fileName, unsigned startOffset)
     return true;
 }
 
+bool PackageFile::MapMemory()
+{
+    if (mappedData_)
+        return true;
+    if (fileName_.empty() || !totalSize_)
+        return false;
+
+#ifdef __ANDROID__
+    // Files inside the APK are not accessible through the file system
+    if (URHO3D_IS_ASSET(fileName_))
+        return false;
+#endif
+
+#if defined(_WIN32)
+    HANDLE fileHandle = CreateFileW(GetWideNativePath(fileName_).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        return false;
+
+    // The mapping object keeps the file open, the file handle itself is not needed anymore
+    HANDLE mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(fileHandle);
+    if (!mappingHandle)
+        return false;
+
+    void* data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, totalSize_);
+    if (!data)
+    {
+        CloseHandle(mappingHandle);
+        return false;
+    }
+
+    mappingHandle_ = mappingHandle;
+    mappedData_ = static_cast<const unsigned char*>(data);
+    return true;
+#elif !defined(__EMSCRIPTEN__)
+    const int fd = open(GetNativePath(fileName_).c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    // The mapping stays valid after the descriptor is closed
+    void* data = mmap(nullptr, totalSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+
+    mappedData_ = static_cast<const unsigned char*>(data);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void PackageFile::UnmapMemory()
+{
+    if (!mappedData_)
+        return;
+
+#if defined(_WIN32)
+    UnmapViewOfFile(mappedData_);
+    CloseHandle(mappingHandle_);
+    mappingHandle_ = nullptr;
+#elif !defined(__EMSCRIPTEN__)
+    munmap(const_cast<unsigned char*>(mappedData_), totalSize_);
+#endif
+    mappedData_ = nullptr;
+}
+
 bool PackageFile::Exists(const ea::string& fileName) const
 {
     bool found = entries_.find(fileName) != entries_.end();
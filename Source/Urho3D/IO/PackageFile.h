@@ -23,10 +23,14 @@
 #pragma once
 
 #include "../Core/Object.h"
+#include "../IO/Compression.h"
 
 namespace Urho3D
 {
 
+/// Package format version which adds the compression codec, the block size and per-entry compressed block offsets.
+static const unsigned PACKAGE_VERSION_BLOCK_INDEX = 1;
+
 /// %File entry within the package file.
 struct PackageEntry
 {
@@ -36,6 +40,8 @@ struct PackageEntry
     unsigned size_;
     /// File checksum.
     unsigned checksum_;
+    /// Index of the entry's first block in the package block offsets. Only used if the package has a block index.
+    unsigned firstBlock_;
 };
 
 /// Stores files of a directory tree sequentially for convenient access.
@@ -53,6 +59,8 @@ public:
 
     /// Open the package file. Return true if successful.
     bool Open(const ea::string& fileName, unsigned startOffset = 0);
+    /// Map the opened package file into memory, so that files opened from it are read without file system calls. Return true if successful.
+    bool MapMemory();
     /// Check if a file exists within the package file. This will be case-insensitive on Windows and case-sensitive on other platforms.
     bool Exists(const ea::string& fileName) const;
     /// Return the file entry corresponding to the name, or null if not found. This will be case-insensitive on Windows and case-sensitive on other platforms.
@@ -88,6 +96,25 @@ public:
     /// @property
     bool IsCompressed() const { return compressed_; }
 
+    /// Return compression codec of the files.
+    CompressionCodec GetCodec() const { return codec_; }
+
+    /// Return uncompressed size of compressed blocks, or 0 if the package has no block index.
+    unsigned GetBlockSize() const { return blockSize_; }
+
+    /// Return whether the compressed files can be accessed randomly through the block index.
+    bool HasBlockIndex() const { return compressed_ && blockSize_ != 0; }
+
+    /// Return offsets of the compressed blocks of all entries, relative to the beginning of each entry. Every entry has one more offset than blocks.
+    const ea::vector<unsigned>& GetBlockOffsets() const { return blockOffsets_; }
+
+    /// Return whether the package file is mapped into memory.
+    /// @property
+    bool IsMemoryMapped() const { return mappedData_ != nullptr; }
+
+    /// Return the memory-mapped contents of the whole package file, or null if not mapped.
+    const unsigned char* GetMappedData() const { return mappedData_; }
+
     /// Return list of file names in the package.
     const ea::vector<ea::string> GetEntryNames() const { return entries_.keys(); }
 
@@ -107,6 +134,9 @@ public:
     void Scan(ea::vector<ea::string>& result, const ea::string& pathName, const ea::string& filter, bool recursive) const;
 
 private:
+    /// Release the memory mapping.
+    void UnmapMemory();
+
     /// File entries.
     ea::unordered_map<ea::string, PackageEntry> entries_;
     /// File name.
@@ -121,6 +151,18 @@ private:
     unsigned checksum_;
     /// Compressed flag.
     bool compressed_;
+    /// Compression codec.
+    CompressionCodec codec_{CompressionCodec::None};
+    /// Uncompressed size of compressed blocks, 0 if there is no block index.
+    unsigned blockSize_{};
+    /// Compressed block offsets of all entries.
+    ea::vector<unsigned> blockOffsets_;
+    /// Memory-mapped package file contents.
+    const unsigned char* mappedData_{};
+#ifdef _WIN32
+    /// File mapping object handle.
+    void* mappingHandle_{};
+#endif
 };
 
 }
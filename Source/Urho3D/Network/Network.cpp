@@ -220,7 +220,7 @@ Network::Network(Context* context) :
     RegisterNetworkLibrary(context_);
 
     SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(Network, HandleBeginFrame));
-    SubscribeToEvent(E_RENDERUPDATE, URHO3D_HANDLER(Network, HandleRenderUpdate));
+    SubscribeToTypedEvent<RenderUpdateEventArgs>([this](const RenderUpdateEventArgs& args) { HandleRenderUpdate(args); });
 
     // Blacklist remote events which are not to be allowed to be registered in any case
     blacklistedRemoteEvents_.insert(E_CONSOLECOMMAND);
@@ -974,11 +974,9 @@ void Network::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
     Update(eventData[P_TIMESTEP].GetFloat());
 }
 
-void Network::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
+void Network::HandleRenderUpdate(const RenderUpdateEventArgs& args)
 {
-    using namespace RenderUpdate;
-
-    PostUpdate(eventData[P_TIMESTEP].GetFloat());
+    PostUpdate(args.timeStep_);
 }
 
 void Network::OnServerConnected(const SLNet::AddressOrGUID& address)
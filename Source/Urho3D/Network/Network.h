@@ -34,6 +34,7 @@ namespace Urho3D
 class HttpRequest;
 class MemoryBuffer;
 class Scene;
+struct RenderUpdateEventArgs;
 
 /// %Network subsystem. Manages client-server communications using the UDP protocol.
 class URHO3D_API Network : public Object
@@ -149,7 +150,7 @@ private:
     /// Handle begin frame event.
     void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
     /// Handle render update frame event.
-    void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleRenderUpdate(const RenderUpdateEventArgs& args);
     /// Handle server connection.
     void OnServerConnected(const SLNet::AddressOrGUID& address);
     /// Handle server disconnection.
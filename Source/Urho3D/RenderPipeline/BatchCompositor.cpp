@@ -23,7 +23,11 @@
 #include "../Precompiled.h"
 
 #include "../IO/Log.h"
+#include "../Graphics/Geometry.h"
+#include "../Graphics/Material.h"
+#include "../Graphics/Octree.h"
 #include "../Graphics/Renderer.h"
+#include "../Graphics/Technique.h"
 #include "../RenderPipeline/BatchCompositor.h"
 #include "../RenderPipeline/LightProcessor.h"
 #include "../RenderPipeline/RenderPipelineDefs.h"
@@ -39,9 +43,10 @@ namespace
 
 /// Add batch or delayed batch.
 void AddPipelineBatch(const PipelineBatchDesc& desc, BatchStateCache& cache,
-    WorkQueueVector<PipelineBatch>& batches, WorkQueueVector<PipelineBatchDesc>& delayedBatches)
+    WorkQueueVector<PipelineBatch>& batches, WorkQueueVector<PipelineBatchDesc>& delayedBatches,
+    RetainedPipelineState* retainedState)
 {
-    PipelineState* pipelineState = cache.GetPipelineState(desc.GetKey());
+    PipelineState* pipelineState = RetainedBatchStorage::GetPipelineState(desc, cache, retainedState);
     if (pipelineState)
     {
         if (pipelineState->IsValid())
@@ -56,6 +61,80 @@ void AddPipelineBatch(const PipelineBatchDesc& desc, BatchStateCache& cache,
 
 }
 
+PipelineState* RetainedPipelineState::Get(const PipelineBatchDesc& desc) const
+{
+    if (pass_ != desc.pass_
+        || pixelLightHash_ != desc.pixelLightForPipelineStateHash_
+        || passHash_ != desc.pass_->GetPipelineStateHash())
+        return nullptr;
+    return pipelineState_;
+}
+
+void RetainedPipelineState::Set(const PipelineBatchDesc& desc, PipelineState* pipelineState)
+{
+    pass_ = desc.pass_;
+    passHash_ = desc.pass_->GetPipelineStateHash();
+    pixelLightHash_ = desc.pixelLightForPipelineStateHash_;
+    pipelineState_ = pipelineState;
+}
+
+void RetainedGeometryBatch::Validate(const PipelineBatchDesc& desc, unsigned version)
+{
+    const unsigned geometryHash = desc.geometry_->GetPipelineStateHash();
+    const unsigned materialHash = desc.material_->GetPipelineStateHash();
+    if (version_ == version
+        && drawableHash_ == desc.drawableHash_
+        && geometryType_ == desc.geometryType_
+        && geometry_ == desc.geometry_
+        && geometryHash_ == geometryHash
+        && material_ == desc.material_
+        && materialHash_ == materialHash)
+        return;
+
+    version_ = version;
+    drawableHash_ = desc.drawableHash_;
+    geometryType_ = desc.geometryType_;
+    geometry_ = desc.geometry_;
+    geometryHash_ = geometryHash;
+    material_ = desc.material_;
+    materialHash_ = materialHash;
+    for (RetainedPipelineState& state : states_)
+        state = {};
+}
+
+void RetainedBatchStorage::Allocate(Drawable* drawable, unsigned sourceBatchIndex)
+{
+    RetainedDrawableBatches& drawableBatches = drawableBatches_[drawable->GetDrawableIndex()];
+    if (drawableBatches.drawable_ != drawable)
+    {
+        drawableBatches.drawable_ = drawable;
+        drawableBatches.geometryBatches_.clear();
+    }
+
+    if (sourceBatchIndex >= drawableBatches.geometryBatches_.size())
+        drawableBatches.geometryBatches_.resize(sourceBatchIndex + 1);
+}
+
+RetainedGeometryBatch* RetainedBatchStorage::Get(const PipelineBatchDesc& desc)
+{
+    RetainedGeometryBatch& retainedBatch = drawableBatches_[desc.drawableIndex_].geometryBatches_[desc.sourceBatchIndex_];
+    retainedBatch.Validate(desc, version_);
+    return &retainedBatch;
+}
+
+PipelineState* RetainedBatchStorage::GetPipelineState(const PipelineBatchDesc& desc, const BatchStateCache& cache,
+    RetainedPipelineState* retainedState)
+{
+    PipelineState* pipelineState = retainedState ? retainedState->Get(desc) : nullptr;
+    if (!pipelineState)
+    {
+        pipelineState = cache.GetPipelineState(desc.GetKey());
+        if (pipelineState && retainedState)
+            retainedState->Set(desc, pipelineState);
+    }
+    return pipelineState;
+}
+
 BatchCompositorPass::BatchCompositorPass(RenderPipelineInterface* renderPipeline,
     DrawableProcessor* drawableProcessor, BatchStateCacheCallback* callback, DrawableProcessorPassFlags flags,
     unsigned deferredPassIndex, unsigned unlitBasePassIndex, unsigned litBasePassIndex, unsigned lightPassIndex)
@@ -70,6 +149,9 @@ BatchCompositorPass::BatchCompositorPass(RenderPipelineInterface* renderPipeline
 
 void BatchCompositorPass::ComposeBatches()
 {
+    if (retainBatches_)
+        PrepareRetainedBatches();
+
     // Try to process batches in worker threads
     ForEachParallel(workQueue_, geometryBatches_,
         [&](unsigned /*index*/, const GeometryBatch& geometryBatch)
@@ -87,6 +169,13 @@ void BatchCompositorPass::ComposeBatches()
     OnBatchesReady();
 }
 
+void BatchCompositorPass::SetRetainBatches(bool retainBatches)
+{
+    retainBatches_ = retainBatches;
+    if (!retainBatches_)
+        retainedBatches_.Clear();
+}
+
 void BatchCompositorPass::OnUpdateBegin(const CommonFrameInfo& frameInfo)
 {
     BaseClassName::OnUpdateBegin(frameInfo);
@@ -109,6 +198,27 @@ void BatchCompositorPass::OnPipelineStatesInvalidated()
     unlitBaseCache_.Invalidate();
     litBaseCache_.Invalidate();
     lightCache_.Invalidate();
+
+    // Retained raw pointers may be released together with cache entries
+    retainedBatches_.Invalidate();
+}
+
+void BatchCompositorPass::PrepareRetainedBatches()
+{
+    const unsigned numDrawables = drawableProcessor_->GetFrameInfo().octree_->GetAllDrawables().size();
+    retainedBatches_.Resize(numDrawables);
+
+    // Geometry batches of the same drawable may be processed by different threads, allocate storage beforehand
+    for (const GeometryBatch& geometryBatch : geometryBatches_)
+        retainedBatches_.Allocate(geometryBatch.drawable_, geometryBatch.sourceBatchIndex_);
+}
+
+RetainedGeometryBatch* BatchCompositorPass::GetRetainedBatch(const PipelineBatchDesc& desc)
+{
+    if (!retainBatches_)
+        return nullptr;
+
+    return retainedBatches_.Get(desc);
 }
 
 void BatchCompositorPass::ProcessGeometryBatch(const GeometryBatch& geometryBatch)
@@ -121,10 +231,14 @@ void BatchCompositorPass::ProcessGeometryBatch(const GeometryBatch& geometryBatc
     if (!desc.material_)
         desc.material_ = defaultMaterial_;
 
+    // Deferred or base batch uses the first retained state, light batches use the rest
+    RetainedGeometryBatch* retainedBatch = GetRetainedBatch(desc);
+    const auto getRetainedState = [&](unsigned index) { return retainedBatch ? retainedBatch->GetState(index) : nullptr; };
+
     // Always add deferred batch if possible.
     if (desc.pass_)
     {
-        AddPipelineBatch(desc, deferredCache_, deferredBatches_, delayedDeferredBatches_);
+        AddPipelineBatch(desc, deferredCache_, deferredBatches_, delayedDeferredBatches_, getRetainedState(0));
         return;
     }
 
@@ -154,10 +268,11 @@ void BatchCompositorPass::ProcessGeometryBatch(const GeometryBatch& geometryBatc
 
             desc.InitializeLitBatch(lightProcessor, lightIndex, lightProcessor->GetForwardLitHash());
 
+            RetainedPipelineState* retainedState = getRetainedState(i + 1);
             if (lightProcessor->GetLight()->IsNegative())
-                AddPipelineBatch(desc, lightCache_, negativeLightBatches_, delayedNegativeLightBatches_);
+                AddPipelineBatch(desc, lightCache_, negativeLightBatches_, delayedNegativeLightBatches_, retainedState);
             else
-                AddPipelineBatch(desc, lightCache_, lightBatches_, delayedLightBatches_);
+                AddPipelineBatch(desc, lightCache_, lightBatches_, delayedLightBatches_, retainedState);
         }
 
         // Initialize vertex lights after all light batches
@@ -170,13 +285,13 @@ void BatchCompositorPass::ProcessGeometryBatch(const GeometryBatch& geometryBatc
         LightProcessor* light = drawableProcessor_->GetLightProcessor(litBaseLightIndex);
         desc.InitializeLitBatch(light, litBaseLightIndex, light->GetForwardLitHash());
         desc.pass_ = geometryBatch.litBasePass_;
-        AddPipelineBatch(desc, litBaseCache_, baseBatches_, delayedLitBaseBatches_);
+        AddPipelineBatch(desc, litBaseCache_, baseBatches_, delayedLitBaseBatches_, getRetainedState(0));
     }
     else
     {
         desc.InitializeLitBatch(nullptr, M_MAX_UNSIGNED, 0);
         desc.pass_ = geometryBatch.unlitBasePass_;
-        AddPipelineBatch(desc, unlitBaseCache_, baseBatches_, delayedUnlitBaseBatches_);
+        AddPipelineBatch(desc, unlitBaseCache_, baseBatches_, delayedUnlitBaseBatches_, getRetainedState(0));
     }
 }
 
@@ -227,6 +342,15 @@ BatchCompositor::~BatchCompositor()
 void BatchCompositor::SetPasses(ea::vector<SharedPtr<BatchCompositorPass>> passes)
 {
     passes_ = passes;
+    for (BatchCompositorPass* pass : passes_)
+        pass->SetRetainBatches(retainSceneBatches_);
+}
+
+void BatchCompositor::SetRetainSceneBatches(bool retainBatches)
+{
+    retainSceneBatches_ = retainBatches;
+    for (BatchCompositorPass* pass : passes_)
+        pass->SetRetainBatches(retainSceneBatches_);
 }
 
 void BatchCompositor::ComposeShadowBatches()
@@ -298,7 +422,7 @@ void BatchCompositor::ComposeLightVolumeBatches()
     }
 
     FillSortKeys(sortedLightVolumeBatches_, lightVolumeBatches_);
-    ea::sort(sortedLightVolumeBatches_.begin(), sortedLightVolumeBatches_.end());
+    lightVolumeBatchSorter_.Sort(sortedLightVolumeBatches_, workQueue_);
 }
 
 void BatchCompositor::OnUpdateBegin(const CommonFrameInfo& frameInfo)
@@ -397,7 +521,7 @@ void BatchCompositor::FinalizeShadowBatchesComposition()
         {
             workQueue_->AddWorkItem([=](unsigned threadIndex)
             {
-                lightProcessor->GetMutableSplit(splitIndex)->FinalizeShadowBatches();
+                lightProcessor->GetMutableSplit(splitIndex)->FinalizeShadowBatches(workQueue_);
             }, M_MAX_UNSIGNED);
         }
     }
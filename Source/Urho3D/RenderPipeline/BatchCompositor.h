@@ -26,6 +26,7 @@
 #include "../RenderPipeline/BatchStateCache.h"
 #include "../RenderPipeline/DrawableProcessor.h"
 #include "../RenderPipeline/InstancingBuffer.h"
+#include "../RenderPipeline/PipelineBatchSorter.h"
 
 #include <EASTL/sort.h>
 
@@ -132,6 +133,75 @@ struct PipelineBatchDesc : public PipelineBatch
     }
 };
 
+/// Pipeline state of composed batch retained between frames.
+struct RetainedPipelineState
+{
+    Pass* pass_{};
+    unsigned passHash_{};
+    unsigned pixelLightHash_{};
+    PipelineState* pipelineState_{};
+
+    /// Return retained pipeline state if it's still valid for the batch, nullptr otherwise.
+    PipelineState* Get(const PipelineBatchDesc& desc) const;
+    /// Retain pipeline state for the batch.
+    void Set(const PipelineBatchDesc& desc, PipelineState* pipelineState);
+};
+
+/// Pipeline states of batches composed from one source batch, retained between frames.
+/// The first state is used by deferred or base batch, the rest are used by light batches.
+struct RetainedGeometryBatch
+{
+    static const unsigned MaxStates = LightAccumulator::MaxPixelLights + 1;
+
+    unsigned version_{};
+    unsigned drawableHash_{};
+    GeometryType geometryType_{};
+    Geometry* geometry_{};
+    unsigned geometryHash_{};
+    Material* material_{};
+    unsigned materialHash_{};
+    RetainedPipelineState states_[MaxStates];
+
+    /// Reset retained states if anything they depend on has changed, except pass and light.
+    void Validate(const PipelineBatchDesc& desc, unsigned version);
+    /// Return retained state or nullptr if there's no room for it.
+    RetainedPipelineState* GetState(unsigned index) { return index < MaxStates ? &states_[index] : nullptr; }
+};
+
+/// Retained batches of all drawables, indexed by drawable index.
+class URHO3D_API RetainedBatchStorage
+{
+public:
+    /// Resize storage for drawables. Should be called from main thread.
+    void Resize(unsigned numDrawables) { drawableBatches_.resize(numDrawables); }
+    /// Allocate retained batch for geometry batch of drawable. Should be called from main thread.
+    /// Retained batches of the drawable that previously had the same index are discarded.
+    void Allocate(Drawable* drawable, unsigned sourceBatchIndex);
+    /// Return validated retained batch. Should be allocated beforehand.
+    RetainedGeometryBatch* Get(const PipelineBatchDesc& desc);
+    /// Invalidate all retained pipeline states.
+    void Invalidate() { ++version_; }
+    /// Remove all retained batches.
+    void Clear() { drawableBatches_.clear(); }
+
+    /// Return retained pipeline state if valid, otherwise lookup pipeline state in cache and retain it.
+    /// Return nullptr if pipeline state is not cached yet.
+    static PipelineState* GetPipelineState(const PipelineBatchDesc& desc, const BatchStateCache& cache,
+        RetainedPipelineState* retainedState);
+
+private:
+    /// Retained batches of drawable.
+    struct RetainedDrawableBatches
+    {
+        Drawable* drawable_{};
+        /// Indexed by source batch index.
+        ea::vector<RetainedGeometryBatch> geometryBatches_;
+    };
+
+    unsigned version_{};
+    ea::vector<RetainedDrawableBatches> drawableBatches_;
+};
+
 /// Batch compositor for single scene pass.
 class URHO3D_API BatchCompositorPass : public DrawableProcessorPass
 {
@@ -144,6 +214,11 @@ public:
 
     void ComposeBatches();
 
+    /// Set whether to retain pipeline states of composed batches between frames.
+    /// Retained states are checked against batch parameters instead of being looked up in the cache every frame.
+    void SetRetainBatches(bool retainBatches);
+    bool GetRetainBatches() const { return retainBatches_; }
+
     bool HasBatches() const
     {
         return deferredBatches_.Size() > 0
@@ -177,6 +252,11 @@ protected:
 private:
     bool PreparePipelineBatch(PipelineBatchDesc& key, const GeometryBatch& geometryBatch) const;
 
+    /// Allocate retained batches for current geometry batches. Should be called from main thread.
+    void PrepareRetainedBatches();
+    /// Return validated retained batch for geometry batch, or nullptr if batches are not retained.
+    RetainedGeometryBatch* GetRetainedBatch(const PipelineBatchDesc& desc);
+
     void ProcessGeometryBatch(const GeometryBatch& geometryBatch);
     void ResolveDelayedBatches(BatchCompositorSubpass subpass, const WorkQueueVector<PipelineBatchDesc>& delayedBatches,
         BatchStateCache& cache, WorkQueueVector<PipelineBatch>& batches);
@@ -189,6 +269,12 @@ private:
     BatchStateCache lightCache_;
     /// @}
 
+    /// Retained batches, indexed by drawable index
+    /// @{
+    bool retainBatches_{};
+    RetainedBatchStorage retainedBatches_;
+    /// @}
+
     /// Batches whose processing is delayed due to missing pipeline state
     /// @{
     WorkQueueVector<PipelineBatchDesc> delayedDeferredBatches_;
@@ -217,6 +303,7 @@ public:
     ~BatchCompositor() override;
     void SetPasses(ea::vector<SharedPtr<BatchCompositorPass>> passes);
     void SetShadowMaterialQuality(MaterialQuality materialQuality) { shadowMaterialQuality_ = materialQuality; }
+    void SetRetainSceneBatches(bool retainBatches);
 
     /// Compose batches
     /// @{
@@ -278,6 +365,7 @@ private:
     /// @{
     ea::vector<SharedPtr<BatchCompositorPass>> passes_;
     MaterialQuality shadowMaterialQuality_{};
+    bool retainSceneBatches_{};
     SharedPtr<Material> lightVolumeMaterial_;
     SharedPtr<Material> negativeLightVolumeMaterial_;
     SharedPtr<Pass> lightVolumePass_;
@@ -289,6 +377,7 @@ private:
     WorkQueueVector<ea::pair<ShadowSplitProcessor*, PipelineBatchDesc>> delayedShadowBatches_;
     ea::vector<PipelineBatch> lightVolumeBatches_;
     ea::vector<PipelineBatchByState> sortedLightVolumeBatches_;
+    PipelineBatchSorter lightVolumeBatchSorter_;
 };
 
 }
@@ -22,6 +22,7 @@
 
 #include "../Precompiled.h"
 
+#include "../Core/Timer.h"
 #include "../Core/WorkQueue.h"
 #include "../Graphics/Drawable.h"
 #include "../Graphics/GlobalIllumination.h"
@@ -193,6 +194,7 @@ void DrawableProcessor::OnUpdateBegin(const FrameInfo& frameInfo)
     // Clean temporary containers
     sceneZRangeTemp_.clear();
     sceneZRangeTemp_.resize(WorkQueue::GetMaxThreadIndex());
+    sortedOccluders_.clear();
     sceneZRange_ = {};
 
     isDrawableUpdated_.resize(numDrawables_);
@@ -204,8 +206,8 @@ void DrawableProcessor::OnUpdateBegin(const FrameInfo& frameInfo)
 
     geometryZRanges_.resize(numDrawables_);
     geometryLighting_.resize(numDrawables_);
+    lastVisibleFrames_.resize(numDrawables_);
 
-    sortedOccluders_.clear();
     geometries_.Clear();
     threadedGeometryUpdates_.Clear();
     nonThreadedGeometryUpdates_.Clear();
@@ -214,6 +216,9 @@ void DrawableProcessor::OnUpdateBegin(const FrameInfo& frameInfo)
 
     queuedDrawableUpdates_.Clear();
 
+    numVisibleDrawableRanges_ = 0;
+    numStolenVisibleDrawableRanges_ = 0;
+
     // Update caches
     lightProcessorCache_->Update(frameInfo.timeStep_);
 }
@@ -223,6 +228,8 @@ void DrawableProcessor::OnCollectStatistics(RenderPipelineStats& stats)
     stats.numOccluders_ += sortedOccluders_.size();
     stats.numLights_ += lights_.size();
     stats.numShadowedLights_ += numShadowedLights_;
+    stats.numVisibleDrawableRanges_ += numVisibleDrawableRanges_;
+    stats.numStolenVisibleDrawableRanges_ += numStolenVisibleDrawableRanges_;
 }
 
 void DrawableProcessor::ProcessOccluders(const ea::vector<Drawable*>& occluders, float sizeThreshold)
@@ -270,18 +277,152 @@ void DrawableProcessor::ProcessOccluders(const ea::vector<Drawable*>& occluders,
     ea::sort(sortedOccluders_.begin(), sortedOccluders_.end());
 }
 
+void DrawableProcessor::PartitionVisibleDrawables(const ea::vector<Drawable*>& drawables)
+{
+    static const unsigned ChunksPerWorker = 4;
+    static const unsigned MaxBoundaryShift = 32;
+
+    const unsigned numVisibleDrawables = drawables.size();
+    drawableTypeCostIndices_.resize(numVisibleDrawables);
+    drawableCostPrefixSum_.resize(numVisibleDrawables + 1);
+    drawableCostPrefixSum_[0] = 0.0f;
+
+    // Drawables of the same type usually come in runs, so look up the type only when it changes
+    StringHash lastType;
+    unsigned lastCostIndex = M_MAX_UNSIGNED;
+    for (unsigned index = 0; index < numVisibleDrawables; ++index)
+    {
+        const StringHash type = drawables[index]->GetType();
+        if (type != lastType || lastCostIndex == M_MAX_UNSIGNED)
+        {
+            lastType = type;
+            lastCostIndex = GetDrawableTypeCostIndex(type);
+        }
+
+        drawableTypeCostIndices_[index] = static_cast<unsigned char>(lastCostIndex);
+        drawableCostPrefixSum_[index + 1] = drawableCostPrefixSum_[index] + drawableTypeCosts_[lastCostIndex].costUs_;
+    }
+
+    // Drawables are returned by octree query grouped by octant, keep the groups within one range if possible
+    const unsigned numWorkers = workQueue_->GetNumThreads() + 1;
+    visibleDrawableRanges_.Partition(drawableCostPrefixSum_, numWorkers, ChunksPerWorker, MaxBoundaryShift,
+        [&](unsigned index) { return drawables[index]->GetOctant() != drawables[index - 1]->GetOctant(); });
+}
+
+unsigned DrawableProcessor::GetDrawableTypeCostIndex(StringHash type)
+{
+    static const float DefaultCostUs = 1.0f;
+
+    const auto iter = ea::find_if(drawableTypeCosts_.begin(), drawableTypeCosts_.end(),
+        [&](const DrawableTypeCost& typeCost) { return typeCost.type_ == type; });
+    if (iter != drawableTypeCosts_.end())
+        return iter - drawableTypeCosts_.begin();
+
+    if (drawableTypeCosts_.size() < MaxDrawableTypes)
+    {
+        drawableTypeCosts_.push_back(DrawableTypeCost{ type, DefaultCostUs });
+        return drawableTypeCosts_.size() - 1;
+    }
+
+    return MaxDrawableTypes - 1;
+}
+
+void DrawableProcessor::UpdateDrawableTypeCosts()
+{
+    static const float AdaptationRate = 0.5f;
+    static const float MinCostUs = 0.01f;
+
+    // Normalized least mean squares: distribute error of predicted range time between types in the range
+    const unsigned numTypes = drawableTypeCosts_.size();
+    for (const DrawableRangeTiming& timing : drawableRangeTimings_)
+    {
+        float predictedUs = 0.0f;
+        float norm = 0.0f;
+        for (unsigned i = 0; i < numTypes; ++i)
+        {
+            const auto count = static_cast<float>(timing.numDrawables_[i]);
+            predictedUs += count * drawableTypeCosts_[i].costUs_;
+            norm += count * count;
+        }
+
+        if (norm == 0.0f)
+            continue;
+
+        const float correction = AdaptationRate * (timing.durationUs_ - predictedUs) / norm;
+        for (unsigned i = 0; i < numTypes; ++i)
+        {
+            float& costUs = drawableTypeCosts_[i].costUs_;
+            costUs = ea::max(MinCostUs, costUs + correction * timing.numDrawables_[i]);
+        }
+    }
+}
+
 void DrawableProcessor::ProcessVisibleDrawables(const ea::vector<Drawable*>& drawables, OcclusionBuffer* occlusionBuffer)
 {
     URHO3D_PROFILE("ProcessVisibleDrawables");
 
-    ForEachParallel(workQueue_, drawables,
-        [&](unsigned /*index*/, Drawable* drawable)
+    // Reprojected depth is approximate, so drawables culled by it may need to be kept visible
+    const bool isReprojected = occlusionBuffer && occlusionBuffer->IsReprojected();
+
+    const auto processDrawables = [&](unsigned beginIndex, unsigned endIndex)
     {
-        if (occlusionBuffer && drawable->IsOccludee() && !occlusionBuffer->IsVisible(drawable->GetWorldBoundingBox()))
-            return;
+        // Test occludees in groups so bounding boxes are projected several at once
+        static const unsigned MaxOccludees = 16;
+        Drawable* occludees[MaxOccludees];
+        BoundingBox boundingBoxes[MaxOccludees];
+        bool isVisible[MaxOccludees];
+        unsigned numOccludees = 0;
+
+        const auto processOccludees = [&]()
+        {
+            occlusionBuffer->AreVisible({ boundingBoxes, numOccludees }, { isVisible, numOccludees });
+            for (unsigned i = 0; i < numOccludees; ++i)
+            {
+                if (isVisible[i])
+                    ProcessVisibleDrawable(occludees[i]);
+                else
+                    ProcessOccludedDrawable(occludees[i], isReprojected);
+            }
+            numOccludees = 0;
+        };
 
-        ProcessVisibleDrawable(drawable);
+        for (unsigned index = beginIndex; index < endIndex; ++index)
+        {
+            Drawable* drawable = drawables[index];
+            if (!occlusionBuffer || !drawable->IsOccludee())
+            {
+                ProcessVisibleDrawable(drawable);
+                continue;
+            }
+
+            occludees[numOccludees] = drawable;
+            boundingBoxes[numOccludees] = drawable->GetWorldBoundingBox();
+            if (++numOccludees == MaxOccludees)
+                processOccludees();
+        }
+
+        if (numOccludees > 0)
+            processOccludees();
+    };
+
+    // Hand out ranges of similar estimated cost and measure them to refine the estimates
+    PartitionVisibleDrawables(drawables);
+    drawableRangeTimings_.Clear();
+    ForEachParallel(workQueue_, visibleDrawableRanges_, [&](unsigned beginIndex, unsigned endIndex)
+    {
+        HiresTimer timer;
+        processDrawables(beginIndex, endIndex);
+
+        DrawableRangeTiming timing;
+        timing.durationUs_ = static_cast<float>(timer.GetUSec(false));
+        for (unsigned index = beginIndex; index < endIndex; ++index)
+            ++timing.numDrawables_[drawableTypeCostIndices_[index]];
+        drawableRangeTimings_.Insert(timing);
     });
+    UpdateDrawableTypeCosts();
+
+    numVisibleDrawableRanges_ += visibleDrawableRanges_.GetNumChunks();
+    numStolenVisibleDrawableRanges_ += visibleDrawableRanges_.GetNumStolenChunks();
 
     // Sort lights by component ID for stability
     lights_.resize(lightsTemp_.Size());
@@ -383,6 +524,8 @@ void DrawableProcessor::ProcessVisibleDrawable(Drawable* drawable)
     drawable->UpdateBatches(frameInfo_);
     drawable->MarkInView(frameInfo_);
 
+    lastVisibleFrames_[drawableIndex] = { drawable, frameInfo_.frameNumber_ };
+
     isDrawableUpdated_[drawableIndex].test_and_set(std::memory_order_relaxed);
 
     // Skip if too far
@@ -651,6 +794,22 @@ void DrawableProcessor::ProcessShadowCasters()
     queuedDrawableUpdates_.Clear();
 }
 
+void DrawableProcessor::ProcessOccludedDrawable(Drawable* drawable, bool isReprojected)
+{
+    // Drawable index may be reused by another drawable, previous visibility is unknown in this case
+    LastVisibleFrame& lastVisibleFrame = lastVisibleFrames_[drawable->GetDrawableIndex()];
+    const bool isKnown = lastVisibleFrame.drawable_ == drawable;
+
+    if (!isReprojected)
+        lastVisibleFrame = { drawable, isKnown ? lastVisibleFrame.frameNumber_ : 0 };
+    else if (!isKnown || lastVisibleFrame.frameNumber_ + 1 >= frameInfo_.frameNumber_)
+    {
+        // Culling of drawables visible on previous frame is uncertain, keep them visible
+        // until occluders are drawn from scratch
+        ProcessVisibleDrawable(drawable);
+    }
+}
+
 void DrawableProcessor::ProcessQueuedDrawable(Drawable* drawable)
 {
     drawable->UpdateBatches(frameInfo_);
@@ -678,7 +837,7 @@ void DrawableProcessor::SortLightProcessorsByShadowMapSize()
 
 void DrawableProcessor::SortLightProcessorsByShadowMapTexture()
 {
-    lightProcessorsByShadowMapTexture_ = lightProcessors_;
+    lightProcessorsByShadowMapTexture_.assign(lightProcessors_.begin(), lightProcessors_.end());
     const auto compareShadowMapTexture = [](const LightProcessor* lhs, const LightProcessor* rhs)
     {
         return lhs->GetShadowMap().texture_ < rhs->GetShadowMap().texture_;
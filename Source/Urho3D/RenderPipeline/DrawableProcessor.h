@@ -201,12 +201,20 @@ public:
 
 protected:
     void ProcessVisibleDrawable(Drawable* drawable);
+    void ProcessOccludedDrawable(Drawable* drawable, bool isReprojected);
     void ProcessQueuedDrawable(Drawable* drawable);
     void UpdateDrawableZone(const BoundingBox& boundingBox, Drawable* drawable) const;
     void QueueDrawableUpdate(Drawable* drawable);
     void QueueDrawableGeometryUpdate(unsigned threadIndex, Drawable* drawable);
     void CheckMaterialForAuxiliaryRenderSurfaces(Material* material);
 
+    /// Split visible drawables into ranges of similar estimated cost.
+    void PartitionVisibleDrawables(const ea::vector<Drawable*>& drawables);
+    /// Return index of cost estimate for drawable type.
+    unsigned GetDrawableTypeCostIndex(StringHash type);
+    /// Update cost estimates of drawable types from measured timings of ranges.
+    void UpdateDrawableTypeCosts();
+
     FloatRange CalculateBoundingBoxZRange(const BoundingBox& boundingBox) const;
 
     void SortLightProcessorsByShadowMapSize();
@@ -222,6 +230,30 @@ private:
         UpdateFlag(UpdateFlag&& other) {}
     };
 
+    /// Last frame when the drawable was visible in cull camera.
+    struct LastVisibleFrame
+    {
+        Drawable* drawable_{};
+        unsigned frameNumber_{};
+    };
+
+    /// Max number of drawable types with individual cost estimates. Other types share the last one.
+    static const unsigned MaxDrawableTypes = 8;
+
+    /// Estimated cost of processing visible drawable of specified type.
+    struct DrawableTypeCost
+    {
+        StringHash type_;
+        float costUs_{};
+    };
+
+    /// Measured time of processing range of visible drawables.
+    struct DrawableRangeTiming
+    {
+        float durationUs_{};
+        unsigned numDrawables_[MaxDrawableTypes]{};
+    };
+
     /// External dependencies
     /// @{
     WorkQueue* workQueue_{};
@@ -233,6 +265,7 @@ private:
     ea::vector<SharedPtr<DrawableProcessorPass>> passes_;
     DrawableProcessorSettings settings_;
     ea::unique_ptr<LightProcessorCache> lightProcessorCache_;
+    ea::vector<DrawableTypeCost> drawableTypeCosts_;
     /// @}
 
     /// Constant within frame, changes between frames
@@ -256,6 +289,11 @@ private:
     ea::vector<LightAccumulator> geometryLighting_;
     /// @}
 
+    /// Arrays indexed with drawable index, preserved between frames
+    /// @{
+    ea::vector<LastVisibleFrame> lastVisibleFrames_;
+    /// @}
+
     ea::vector<FloatRange> sceneZRangeTemp_;
     FloatRange sceneZRange_;
 
@@ -274,6 +312,17 @@ private:
     unsigned numShadowedLights_{};
 
     WorkQueueVector<Drawable*> queuedDrawableUpdates_;
+
+    /// Arrays indexed with position in visible drawables list
+    /// @{
+    ea::vector<unsigned char> drawableTypeCostIndices_;
+    ea::vector<float> drawableCostPrefixSum_;
+    /// @}
+
+    PartitionedRange visibleDrawableRanges_;
+    WorkQueueVector<DrawableRangeTiming> drawableRangeTimings_;
+    unsigned numVisibleDrawableRanges_{};
+    unsigned numStolenVisibleDrawableRanges_{};
 };
 
 }
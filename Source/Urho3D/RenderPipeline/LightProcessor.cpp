@@ -250,21 +250,23 @@ void LightProcessor::Update(DrawableProcessor* drawableProcessor, const LightPro
 
     InitializeShadowSplits(drawableProcessor);
 
-    for (unsigned i = 0; i < numActiveSplits_; ++i)
+    if (lightType == LIGHT_DIRECTIONAL)
     {
-        switch (lightType)
+        // Each split queries octree independently
+        auto workQueue = drawableProcessor->GetSubsystem<WorkQueue>();
+        ForEachParallel(workQueue, GetMutableSplits(), [&](unsigned /*index*/, ShadowSplitProcessor& split)
         {
-        case LIGHT_SPOT:
-            splits_[i].ProcessSpotShadowCasters(drawableProcessor, shadowCasterCandidates_);
-            break;
-        case LIGHT_POINT:
-            splits_[i].ProcessPointShadowCasters(drawableProcessor, shadowCasterCandidates_);
-            break;
-        case LIGHT_DIRECTIONAL:
-            splits_[i].ProcessDirectionalShadowCasters(drawableProcessor, shadowCasterCandidates_);
-            break;
-        default:
-            break;
+            split.ProcessDirectionalShadowCasters(drawableProcessor);
+        });
+    }
+    else
+    {
+        for (unsigned i = 0; i < numActiveSplits_; ++i)
+        {
+            if (lightType == LIGHT_SPOT)
+                splits_[i].ProcessSpotShadowCasters(drawableProcessor, shadowCasterCandidates_);
+            else if (lightType == LIGHT_POINT)
+                splits_[i].ProcessPointShadowCasters(drawableProcessor, shadowCasterCandidates_);
         }
     }
 
@@ -157,6 +157,16 @@ struct PipelineBatchBackToFront
             return renderOrder_ < rhs.renderOrder_;
         return distance_ > rhs.distance_;
     }
+
+    /// Return 64-bit key that has the same order as comparison operator.
+    unsigned long long GetSortKey() const
+    {
+        // Map float to unsigned integer with the same order, then invert to sort back to front
+        // Negative zero is treated as positive zero
+        const unsigned distanceBits = distance_ != 0.0f ? FloatToRawIntBits(distance_) : 0u;
+        const unsigned orderedDistance = (distanceBits & 0x80000000u) ? ~distanceBits : (distanceBits | 0x80000000u);
+        return (static_cast<unsigned long long>(renderOrder_) << 32) | ~orderedDistance;
+    }
 };
 
 /// Group of batches to be rendered.
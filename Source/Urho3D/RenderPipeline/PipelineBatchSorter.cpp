@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../RenderPipeline/PipelineBatchSortKey.h"
+#include "../RenderPipeline/PipelineBatchSorter.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+void PipelineBatchSorter::Sort(ea::span<PipelineBatchByState> batches, WorkQueue* workQueue)
+{
+    const unsigned numBatches = batches.size();
+    if (numBatches < 2)
+        return;
+
+    items_.resize(numBatches);
+    buffer_.resize(numBatches);
+
+    // Key is 128-bit, sort by less important half first and rely on sort stability
+    for (unsigned i = 0; i < numBatches; ++i)
+        items_[i] = { batches[i].secondaryKey_, i };
+    RadixSort(items_, buffer_, workQueue);
+
+    for (RadixSortItem& item : items_)
+        item.key_ = batches[item.index_].primaryKey_;
+    RadixSort(items_, buffer_, workQueue);
+
+    ApplyOrder(batches, sortedBatchesByState_);
+}
+
+void PipelineBatchSorter::Sort(ea::span<PipelineBatchBackToFront> batches, WorkQueue* workQueue)
+{
+    const unsigned numBatches = batches.size();
+    if (numBatches < 2)
+        return;
+
+    items_.resize(numBatches);
+    buffer_.resize(numBatches);
+
+    for (unsigned i = 0; i < numBatches; ++i)
+        items_[i] = { batches[i].GetSortKey(), i };
+    RadixSort(items_, buffer_, workQueue);
+
+    ApplyOrder(batches, sortedBatchesBackToFront_);
+}
+
+template <class T>
+void PipelineBatchSorter::ApplyOrder(ea::span<T> batches, ea::vector<T>& sortedBatches) const
+{
+    const unsigned numBatches = batches.size();
+    sortedBatches.resize(numBatches);
+    for (unsigned i = 0; i < numBatches; ++i)
+        sortedBatches[i] = batches[items_[i].index_];
+    ea::copy(sortedBatches.begin(), sortedBatches.end(), batches.begin());
+}
+
+}
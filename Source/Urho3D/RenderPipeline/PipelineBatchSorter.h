@@ -0,0 +1,58 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Core/RadixSort.h"
+
+#include <EASTL/span.h>
+#include <EASTL/vector.h>
+
+namespace Urho3D
+{
+
+class WorkQueue;
+struct PipelineBatchBackToFront;
+struct PipelineBatchByState;
+
+/// Sorts pipeline batches using parallel radix sort over packed sort keys.
+/// Temporary buffers are reused, so single sorter should not be used from multiple threads at once.
+class URHO3D_API PipelineBatchSorter
+{
+public:
+    /// Sort batches in the same order as comparison operator of sorted batch.
+    /// @{
+    void Sort(ea::span<PipelineBatchByState> batches, WorkQueue* workQueue);
+    void Sort(ea::span<PipelineBatchBackToFront> batches, WorkQueue* workQueue);
+    /// @}
+
+private:
+    /// Reorder batches according to sorted items.
+    template <class T> void ApplyOrder(ea::span<T> batches, ea::vector<T>& sortedBatches) const;
+
+    ea::vector<RadixSortItem> items_;
+    ea::vector<RadixSortItem> buffer_;
+    ea::vector<PipelineBatchByState> sortedBatchesByState_;
+    ea::vector<PipelineBatchBackToFront> sortedBatchesBackToFront_;
+};
+
+}
@@ -243,6 +243,10 @@ struct RenderPipelineStats
     unsigned numShadowedLights_{};
     /// Number of occluders rendered.
     unsigned numOccluders_{};
+    /// Number of ranges visible drawables were split into for processing in threads.
+    unsigned numVisibleDrawableRanges_{};
+    /// Number of ranges of visible drawables processed by threads other than the planned ones.
+    unsigned numStolenVisibleDrawableRanges_{};
 };
 
 /// Base interface of render pipeline required by Render Pipeline classes.
@@ -461,6 +465,8 @@ struct ShadowMapAllocatorSettings
 struct OcclusionBufferSettings
 {
     bool threadedOcclusion_{};
+    /// Whether to reproject occlusion depth of the previous frame and draw only new occluders on top of it.
+    bool temporalOcclusion_{};
     unsigned maxOccluderTriangles_{ 5000 };
     unsigned occlusionBufferSize_{ 256 };
     float occluderSizeThreshold_{ 0.025f };
@@ -480,6 +486,7 @@ struct OcclusionBufferSettings
     bool operator==(const OcclusionBufferSettings& rhs) const
     {
         return threadedOcclusion_ == rhs.threadedOcclusion_
+            && temporalOcclusion_ == rhs.temporalOcclusion_
             && maxOccluderTriangles_ == rhs.maxOccluderTriangles_
             && occlusionBufferSize_ == rhs.occlusionBufferSize_
             && occluderSizeThreshold_ == rhs.occluderSizeThreshold_;
@@ -518,6 +525,7 @@ struct SceneProcessorSettings
     ReflectionQuality reflectionQuality_{ ReflectionQuality::Pixel };
     bool depthPrePass_{ false };
     bool enableShadows_{ true };
+    bool retainSceneBatches_{ false };
     DirectLightingMode lightingMode_{};
     unsigned directionalShadowSize_{ 1024 };
     unsigned spotShadowSize_{ 1024 };
@@ -569,6 +577,7 @@ struct SceneProcessorSettings
             && reflectionQuality_ == rhs.reflectionQuality_
             && depthPrePass_ == rhs.depthPrePass_
             && enableShadows_ == rhs.enableShadows_
+            && retainSceneBatches_ == rhs.retainSceneBatches_
             && lightingMode_ == rhs.lightingMode_
             && directionalShadowSize_ == rhs.directionalShadowSize_
             && spotShadowSize_ == rhs.spotShadowSize_
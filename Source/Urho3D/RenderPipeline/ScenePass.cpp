@@ -29,8 +29,6 @@
 #include "../RenderPipeline/BatchRenderer.h"
 #include "../RenderPipeline/ScenePass.h"
 
-#include <EASTL/sort.h>
-
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -57,12 +55,13 @@ void UnorderedScenePass::OnBatchesReady()
     BatchCompositor::FillSortKeys(sortedBaseBatches_, baseBatches_);
     BatchCompositor::FillSortKeys(sortedLightBatches_, lightBatches_, negativeLightBatches_);
 
-    ea::sort(sortedDeferredBatches_.begin(), sortedDeferredBatches_.end());
-    ea::sort(sortedBaseBatches_.begin(), sortedBaseBatches_.end());
+    batchSorter_.Sort(sortedDeferredBatches_, workQueue_);
+    batchSorter_.Sort(sortedBaseBatches_, workQueue_);
 
     const unsigned numNegativeLightBatches = negativeLightBatches_.Size();
-    ea::sort(sortedLightBatches_.begin(), sortedLightBatches_.end() - numNegativeLightBatches);
-    ea::sort(sortedLightBatches_.end() - numNegativeLightBatches, sortedLightBatches_.end());
+    const unsigned numAdditiveLightBatches = sortedLightBatches_.size() - numNegativeLightBatches;
+    batchSorter_.Sort({ sortedLightBatches_.data(), numAdditiveLightBatches }, workQueue_);
+    batchSorter_.Sort({ sortedLightBatches_.data() + numAdditiveLightBatches, numNegativeLightBatches }, workQueue_);
 
     deferredBatchGroup_ = { sortedDeferredBatches_ };
     baseBatchGroup_ = { sortedBaseBatches_ };
@@ -125,7 +124,7 @@ void BackToFrontScenePass::OnBatchesReady()
     for (unsigned i = substractiveLightBatchesBegin; i < substractiveLightBatchesEnd; ++i)
         sortedBatches_[i].distance_ *= substractiveDistanceFactor;
 
-    ea::sort(sortedBatches_.begin(), sortedBatches_.end());
+    batchSorter_.Sort(sortedBatches_, workQueue_);
 
     if (GetFlags().Test(DrawableProcessorPassFlag::RefractionPass))
     {
@@ -53,6 +53,10 @@ public:
 
     /// Prepare instancing buffer for scene pass.
     virtual void PrepareInstacingBuffer(BatchRenderer* batchRenderer) = 0;
+
+protected:
+    /// Sorter of scene batches.
+    PipelineBatchSorter batchSorter_;
 };
 
 /// Scene pass with batches sorted by render order and pipeline state.
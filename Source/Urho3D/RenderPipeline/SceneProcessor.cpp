@@ -260,35 +260,14 @@ void SceneProcessor::SetSettings(const ShaderProgramCompositorSettings& settings
         drawableProcessor_->SetSettings(settings.sceneProcessor_);
         batchRenderer_->SetSettings(settings.sceneProcessor_);
         batchCompositor_->SetShadowMaterialQuality(settings.sceneProcessor_.materialQuality_);
+        batchCompositor_->SetRetainSceneBatches(settings.sceneProcessor_.retainSceneBatches_);
     }
 }
 
 void SceneProcessor::Update()
 {
     // Collect occluders
-    currentOcclusionBuffer_ = nullptr;
-    if (settings_.maxOccluderTriangles_ > 0)
-    {
-        URHO3D_PROFILE("ProcessOccluders");
-
-        OccluderOctreeQuery occluderQuery(occluders_,
-            frameInfo_.camera_->GetFrustum(), frameInfo_.camera_->GetViewMask());
-        frameInfo_.octree_->GetDrawables(occluderQuery);
-        drawableProcessor_->ProcessOccluders(occluders_, settings_.occluderSizeThreshold_);
-
-        if (drawableProcessor_->HasOccluders())
-        {
-            if (!occlusionBuffer_)
-                occlusionBuffer_ = MakeShared<OcclusionBuffer>(context_);
-            const IntVector2 bufferSize = CalculateOcclusionBufferSize(settings_.occlusionBufferSize_, frameInfo_.camera_);
-            occlusionBuffer_->SetSize(bufferSize.x_, bufferSize.y_, settings_.threadedOcclusion_);
-            occlusionBuffer_->SetView(frameInfo_.camera_);
-
-            DrawOccluders();
-            if (occlusionBuffer_->GetNumTriangles() > 0)
-                currentOcclusionBuffer_ = occlusionBuffer_;
-        }
-    }
+    UpdateOcclusionBuffer();
 
     // Collect visible drawables
     if (currentOcclusionBuffer_)
@@ -501,20 +480,87 @@ ShadowMapRegion SceneProcessor::AllocateTransientShadowMap(const IntVector2& siz
     return shadowMapAllocator_->AllocateShadowMap(size);
 }
 
-void SceneProcessor::DrawOccluders()
+void SceneProcessor::UpdateOcclusionBuffer()
 {
+    currentOcclusionBuffer_ = nullptr;
+    if (settings_.maxOccluderTriangles_ == 0)
+    {
+        hasOcclusionHistory_ = false;
+        return;
+    }
+
+    URHO3D_PROFILE("ProcessOccluders");
+
+    OccluderOctreeQuery occluderQuery(occluders_,
+        frameInfo_.camera_->GetFrustum(), frameInfo_.camera_->GetViewMask());
+    frameInfo_.octree_->GetDrawables(occluderQuery);
+    drawableProcessor_->ProcessOccluders(occluders_, settings_.occluderSizeThreshold_);
+
+    if (!drawableProcessor_->HasOccluders())
+    {
+        hasOcclusionHistory_ = false;
+        return;
+    }
+
+    // Keep the buffer of previous frame as reprojection source
+    if (settings_.temporalOcclusion_)
+        ea::swap(occlusionBuffer_, previousOcclusionBuffer_);
+    else
+        previousOcclusionBuffer_ = nullptr;
+
+    if (!occlusionBuffer_)
+        occlusionBuffer_ = MakeShared<OcclusionBuffer>(context_);
+    const IntVector2 bufferSize = CalculateOcclusionBufferSize(settings_.occlusionBufferSize_, frameInfo_.camera_);
+    occlusionBuffer_->SetSize(bufferSize.x_, bufferSize.y_, settings_.threadedOcclusion_);
+    occlusionBuffer_->SetView(frameInfo_.camera_);
+
+    DrawOccluders(settings_.temporalOcclusion_);
+    if (occlusionBuffer_->GetNumTriangles() > 0 || occlusionBuffer_->IsReprojected())
+        currentOcclusionBuffer_ = occlusionBuffer_;
+}
+
+void SceneProcessor::DrawOccluders(bool allowReprojection)
+{
+    static const unsigned maxOcclusionHistoryAge = 8;
+
     const auto& activeOccluders = drawableProcessor_->GetOccluders();
 
     occlusionBuffer_->SetMaxTriangles(settings_.maxOccluderTriangles_);
     occlusionBuffer_->Clear();
 
+    // Reuse depth of previous frame if all occluders drawn into it are unchanged.
+    // Draw occluders from scratch every few frames, because reprojection loses some coverage each time.
+    const bool reprojected = allowReprojection && occlusionHistoryAge_ < maxOcclusionHistoryAge
+        && IsOcclusionHistoryValid() && occlusionBuffer_->Reproject(*previousOcclusionBuffer_);
+    if (reprojected)
+        ++occlusionHistoryAge_;
+    else
+    {
+        occlusionHistoryAge_ = 0;
+        drawnOccluders_.clear();
+        drawnOccluderSet_.clear();
+    }
+
+    // Only new occluders need to be drawn on top of reprojected depth
+    const bool trackHistory = settings_.temporalOcclusion_;
+    const auto isDrawn = [&](Drawable* occluder) { return drawnOccluderSet_.contains(occluder); };
+    const auto markDrawn = [&](Drawable* occluder)
+    {
+        if (trackHistory && drawnOccluderSet_.insert(occluder).second)
+            drawnOccluders_.push_back({ WeakPtr<Drawable>(occluder), occluder->GetWorldBoundingBox() });
+    };
+
     if (!occlusionBuffer_->IsThreaded())
     {
         // If not threaded, draw occluders one by one and test the next occluder against already rasterized depth
+        bool isBufferEmpty = !reprojected;
         for (unsigned i = 0; i < activeOccluders.size(); ++i)
         {
             Drawable* occluder = activeOccluders[i].drawable_;
-            if (i > 0)
+            if (isDrawn(occluder))
+                continue;
+
+            if (!isBufferEmpty)
             {
                 // For subsequent occluders, do a test against the pixel-level occlusion buffer to see if rendering is necessary
                 if (!occlusionBuffer_->IsVisible(occluder->GetWorldBoundingBox()))
@@ -525,6 +571,8 @@ void SceneProcessor::DrawOccluders()
             bool success = occluder->DrawOcclusion(occlusionBuffer_);
             // Draw triangles submitted by this occluder
             occlusionBuffer_->DrawTriangles();
+            markDrawn(occluder);
+            isBufferEmpty = false;
             if (!success)
                 break;
         }
@@ -534,8 +582,14 @@ void SceneProcessor::DrawOccluders()
         // In threaded mode submit all triangles first, then render (cannot test in this case)
         for (unsigned i = 0; i < activeOccluders.size(); ++i)
         {
+            Drawable* occluder = activeOccluders[i].drawable_;
+            if (isDrawn(occluder))
+                continue;
+
             // Check for running out of triangles
-            if (!activeOccluders[i].drawable_->DrawOcclusion(occlusionBuffer_))
+            const bool success = occluder->DrawOcclusion(occlusionBuffer_);
+            markDrawn(occluder);
+            if (!success)
                 break;
         }
 
@@ -544,6 +598,23 @@ void SceneProcessor::DrawOccluders()
 
     // Finally build the depth mip levels
     occlusionBuffer_->BuildDepthHierarchy();
+    hasOcclusionHistory_ = trackHistory;
+}
+
+bool SceneProcessor::IsOcclusionHistoryValid() const
+{
+    if (!hasOcclusionHistory_ || !previousOcclusionBuffer_)
+        return false;
+
+    // Moved or removed occluder leaves stale depth behind, so history has to be dropped
+    for (const DrawnOccluder& drawnOccluder : drawnOccluders_)
+    {
+        Drawable* occluder = drawnOccluder.drawable_;
+        if (!occluder || !occluder->IsEnabledEffective() || !occluder->IsOccluder()
+            || occluder->GetWorldBoundingBox() != drawnOccluder.worldBoundingBox_)
+            return false;
+    }
+    return true;
 }
 
 }
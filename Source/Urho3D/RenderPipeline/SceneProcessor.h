@@ -22,9 +22,12 @@
 
 #pragma once
 
+#include "../Math/BoundingBox.h"
 #include "../RenderPipeline/RenderPipelineDefs.h"
 #include "../RenderPipeline/PipelineBatchSortKey.h"
 
+#include <EASTL/unordered_set.h>
+
 namespace Urho3D
 {
 
@@ -125,7 +128,9 @@ private:
     ShadowMapRegion AllocateTransientShadowMap(const IntVector2& size) override;
     /// @}
 
-    void DrawOccluders();
+    void UpdateOcclusionBuffer();
+    void DrawOccluders(bool allowReprojection);
+    bool IsOcclusionHistoryValid() const;
     template <class T>
     void RenderBatchesInternal(ea::string_view debugName, Camera* camera, const PipelineBatchGroup<T>& batchGroup,
         ea::span<const ShaderResourceDesc> globalResources, ea::span<const ShaderParameterDesc> cameraParameters);
@@ -161,6 +166,23 @@ private:
     OcclusionBuffer* currentOcclusionBuffer_{};
     ea::vector<Drawable*> occluders_;
     ea::vector<Drawable*> drawables_;
+
+    /// Temporal occlusion state
+    /// @{
+    struct DrawnOccluder
+    {
+        WeakPtr<Drawable> drawable_;
+        BoundingBox worldBoundingBox_;
+    };
+    /// Buffer drawn on previous frame, used as reprojection source.
+    SharedPtr<OcclusionBuffer> previousOcclusionBuffer_;
+    /// Occluders that contribute to the current buffer directly or via reprojection.
+    ea::vector<DrawnOccluder> drawnOccluders_;
+    ea::unordered_set<Drawable*> drawnOccluderSet_;
+    /// Number of frames since occluders were drawn from scratch.
+    unsigned occlusionHistoryAge_{};
+    bool hasOcclusionHistory_{};
+    /// @}
 };
 
 }
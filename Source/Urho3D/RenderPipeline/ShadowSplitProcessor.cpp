@@ -34,8 +34,6 @@
 #include "../RenderPipeline/ShadowMapAllocator.h"
 #include "../RenderPipeline/ShadowSplitProcessor.h"
 
-#include <EASTL/sort.h>
-
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -138,8 +136,7 @@ void ShadowSplitProcessor::InitializePoint(CubeMapFace face)
     shadowCamera_->SetZoom(1.0f);
 }
 
-void ShadowSplitProcessor::ProcessDirectionalShadowCasters(
-    DrawableProcessor* drawableProcessor, ea::vector<Drawable*>& shadowCastersBuffer)
+void ShadowSplitProcessor::ProcessDirectionalShadowCasters(DrawableProcessor* drawableProcessor)
 {
     shadowCasters_.clear();
     unsortedShadowBatches_.clear();
@@ -155,11 +152,11 @@ void ShadowSplitProcessor::ProcessDirectionalShadowCasters(
     Octree* octree = frameInfo.octree_;
 
     DirectionalLightShadowCasterQuery query(
-        shadowCastersBuffer, shadowCamera_->GetFrustum(), DRAWABLE_GEOMETRY, light_, cullCamera->GetViewMask());
+        shadowCasterCandidates_, shadowCamera_->GetFrustum(), DRAWABLE_GEOMETRY, light_, cullCamera->GetViewMask());
     octree->GetDrawables(query);
 
     // Preprocess shadow casters
-    drawableProcessor->PreprocessShadowCasters(shadowCasters_, shadowCastersBuffer, cascadeZRange_, light_, shadowCamera_);
+    drawableProcessor->PreprocessShadowCasters(shadowCasters_, shadowCasterCandidates_, cascadeZRange_, light_, shadowCamera_);
 }
 
 void ShadowSplitProcessor::ProcessSpotShadowCasters(
@@ -356,10 +353,10 @@ Matrix4 ShadowSplitProcessor::GetWorldToShadowSpaceMatrix(float subPixelOffset)
     return texAdjust * shadowProj * shadowView;
 }
 
-void ShadowSplitProcessor::FinalizeShadowBatches()
+void ShadowSplitProcessor::FinalizeShadowBatches(WorkQueue* workQueue)
 {
     BatchCompositor::FillSortKeys(sortedShadowBatches_, unsortedShadowBatches_);
-    ea::sort(sortedShadowBatches_.begin(), sortedShadowBatches_.end());
+    batchSorter_.Sort(sortedShadowBatches_, workQueue);
     shadowBatches_ = { sortedShadowBatches_,
         BatchRenderFlag::EnableInstancingForStaticGeometry | BatchRenderFlag::DisableColorOutput };
 }
@@ -38,6 +38,7 @@ class Drawable;
 class DrawableProcessor;
 class Light;
 class LightProcessor;
+class WorkQueue;
 
 /// Manages single shadow split parameters and shadow casters.
 /// Spot lights always have one split.
@@ -57,15 +58,15 @@ public:
     void InitializePoint(CubeMapFace face);
     /// @}
 
-    /// Process shadow casters
+    /// Process shadow casters. Splits of directional light may be processed concurrently.
     /// @{
-    void ProcessDirectionalShadowCasters(DrawableProcessor* drawableProcessor, ea::vector<Drawable*>& shadowCastersBuffer);
+    void ProcessDirectionalShadowCasters(DrawableProcessor* drawableProcessor);
     void ProcessSpotShadowCasters(DrawableProcessor* drawableProcessor, const ea::vector<Drawable*>& shadowCasterCandidates);
     void ProcessPointShadowCasters(DrawableProcessor* drawableProcessor, const ea::vector<Drawable*>& shadowCasterCandidates);
     /// @}
 
     void FinalizeShadow(const ShadowMapRegion& shadowMap, unsigned pcfKernelSize);
-    void FinalizeShadowBatches();
+    void FinalizeShadowBatches(WorkQueue* workQueue);
 
     /// Return immutable
     /// @{
@@ -119,6 +120,7 @@ private:
     FloatRange cascadeZRange_{};
     FloatRange focusedCascadeZRange_{};
     ea::vector<Drawable*> shadowCasters_;
+    ea::vector<Drawable*> shadowCasterCandidates_;
 
     ShadowMapRegion shadowMap_;
     float shadowMapWorldSpaceTexelSize_{};
@@ -128,6 +130,7 @@ private:
     /// @{
     ea::vector<PipelineBatch> unsortedShadowBatches_;
     ea::vector<PipelineBatchByState> sortedShadowBatches_;
+    PipelineBatchSorter batchSorter_;
     PipelineBatchGroup<PipelineBatchByState> shadowBatches_;
     /// @}
 };
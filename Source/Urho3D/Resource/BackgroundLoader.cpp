@@ -25,6 +25,7 @@
 #include "../Precompiled.h"
 
 #include "../Core/Context.h"
+#include "../Core/ProcessUtils.h"
 #include "../Core/Profiler.h"
 #include "../IO/Log.h"
 #include "../Resource/BackgroundLoader.h"
@@ -36,78 +37,98 @@
 namespace Urho3D
 {
 
+/// Maximum number of loader threads created by default.
+static const unsigned MAX_DEFAULT_LOADER_THREADS = 4;
+
+/// Background loader thread.
+class BackgroundLoaderThread : public Thread, public RefCounted
+{
+public:
+    /// Construct.
+    explicit BackgroundLoaderThread(BackgroundLoader* owner) :
+        owner_(owner)
+    {
+    }
+
+    /// Load queued resources until stopped.
+    void ThreadFunction() override
+    {
+        URHO3D_PROFILE_THREAD("BackgroundLoader Thread");
+
+        while (shouldRun_)
+        {
+            // No resources to load found
+            if (!owner_->ProcessItem())
+                Time::Sleep(5);
+        }
+    }
+
+private:
+    /// Background loader.
+    BackgroundLoader* owner_;
+};
+
 BackgroundLoader::BackgroundLoader(ResourceCache* owner) :
-    owner_(owner)
+    owner_(owner),
+    numThreads_(Clamp(GetNumLogicalCPUs() / 2, 1u, MAX_DEFAULT_LOADER_THREADS))
 {
 }
 
 BackgroundLoader::~BackgroundLoader()
 {
+    StopThreads();
+
     MutexLock lock(backgroundLoadMutex_);
 
+    pendingQueue_.clear();
     backgroundLoadQueue_.clear();
 }
 
-void BackgroundLoader::ThreadFunction()
+void BackgroundLoader::SetNumThreads(unsigned numThreads)
 {
-    URHO3D_PROFILE_THREAD("BackgroundLoader Thread");
+    numThreads = Max(numThreads, 1u);
 
-    while (shouldRun_)
+    bool wasStarted{};
     {
-        backgroundLoadMutex_.Acquire();
+        MutexLock lock(backgroundLoadMutex_);
+        if (numThreads == numThreads_)
+            return;
 
-        // Search for a queued resource that has not been loaded yet
-        auto i = backgroundLoadQueue_.begin();
-        while (i != backgroundLoadQueue_.end())
-        {
-            if (i->second.resource_->GetAsyncLoadState() == ASYNC_QUEUED)
-                break;
-            else
-                ++i;
-        }
+        wasStarted = !threads_.empty();
+        numThreads_ = numThreads;
+    }
 
-        if (i == backgroundLoadQueue_.end())
-        {
-            // No resources to load found
-            backgroundLoadMutex_.Release();
-            Time::Sleep(5);
-        }
-        else
-        {
-            BackgroundLoadItem& item = i->second;
-            Resource* resource = item.resource_;
-            // We can be sure that the item is not removed from the queue as long as it is in the
-            // "queued" or "loading" state
-            backgroundLoadMutex_.Release();
+    // Running threads finish their current resource, the new amount is started on demand
+    StopThreads();
+    if (wasStarted)
+    {
+        MutexLock lock(backgroundLoadMutex_);
+        StartThreads();
+    }
+}
 
-            bool success = false;
-            SharedPtr<File> file = owner_->GetFile(resource->GetName(), item.sendEventOnFailure_);
-            if (file)
-            {
-                resource->SetAsyncLoadState(ASYNC_LOADING);
-                success = resource->BeginLoad(*file);
-            }
+void BackgroundLoader::SetMaxConcurrentLoads(StringHash type, unsigned maxLoads)
+{
+    MutexLock lock(backgroundLoadMutex_);
 
-            // Process dependencies now
-            // Need to lock the queue again when manipulating other entries
-            ea::pair<StringHash, StringHash> key = ea::make_pair(resource->GetType(), resource->GetNameHash());
-            backgroundLoadMutex_.Acquire();
-            if (item.dependents_.size())
-            {
-                for (auto i = item.dependents_.begin(); i != item.dependents_.end(); ++i)
-                {
-                    auto j = backgroundLoadQueue_.find(*i);
-                    if (j != backgroundLoadQueue_.end())
-                        j->second.dependencies_.erase(key);
-                }
+    if (maxLoads)
+        maxConcurrentLoads_[type] = maxLoads;
+    else
+        maxConcurrentLoads_.erase(type);
+}
 
-                item.dependents_.clear();
-            }
+bool BackgroundLoader::ProcessItem()
+{
+    backgroundLoadMutex_.Acquire();
+    BackgroundLoadItem* item = TakeQueuedItem();
+    // We can be sure that the item is not removed from the queue as long as it is in the "loading" state
+    backgroundLoadMutex_.Release();
 
-            resource->SetAsyncLoadState(success ? ASYNC_SUCCESS : ASYNC_FAIL);
-            backgroundLoadMutex_.Release();
-        }
-    }
+    if (!item)
+        return false;
+
+    LoadItem(*item);
+    return true;
 }
 
 bool BackgroundLoader::QueueResource(StringHash type, const ea::string& name, bool sendEventOnFailure, Resource* caller)
@@ -147,8 +168,10 @@ bool BackgroundLoader::QueueResource(StringHash type, const ea::string& name, bo
 
     item.resource_->SetName(name);
     item.resource_->SetAsyncLoadState(ASYNC_QUEUED);
+    item.timer_.Reset();
 
     // If this is a resource calling for the background load of more resources, mark the dependency as necessary
+    bool isDependency = false;
     if (caller)
     {
         ea::pair<StringHash, StringHash> callerKey = ea::make_pair(caller->GetType(), caller->GetNameHash());
@@ -159,15 +182,21 @@ bool BackgroundLoader::QueueResource(StringHash type, const ea::string& name, bo
             BackgroundLoadItem& callerItem = j->second;
             item.dependents_.insert(callerKey);
             callerItem.dependencies_.insert(key);
+            isDependency = true;
         }
         else
             URHO3D_LOGWARNING("Resource " + caller->GetName() +
                        " requested for a background loaded resource but was not in the background load queue");
     }
 
-    // Start the background loader thread now
-    if (!IsStarted())
-        Run();
+    // Load dependencies first, so that the resources waiting for them can finish sooner
+    if (isDependency)
+        pendingQueue_.push_front(key);
+    else
+        pendingQueue_.push_back(key);
+
+    // Start the background loader threads now
+    StartThreads();
 
     return true;
 }
@@ -182,16 +211,30 @@ void BackgroundLoader::WaitForResource(StringHash type, StringHash nameHash)
         key);
     if (i != backgroundLoadQueue_.end())
     {
+        // If no loader thread has picked the resource up yet, load it right here instead of waiting in the queue
+        BackgroundLoadItem& item = i->second;
+        const bool loadNow = item.resource_->GetAsyncLoadState() == ASYNC_QUEUED;
+        if (loadNow)
+        {
+            pendingQueue_.erase(ea::find(pendingQueue_.begin(), pendingQueue_.end(), key));
+            BeginLoading(item);
+        }
+
         backgroundLoadMutex_.Release();
 
+        if (loadNow)
+            LoadItem(item);
+
         {
-            Resource* resource = i->second.resource_;
+            Resource* resource = item.resource_;
             HiresTimer waitTimer;
             bool didWait = false;
 
             for (;;)
             {
-                unsigned numDeps = i->second.dependencies_.size();
+                backgroundLoadMutex_.Acquire();
+                unsigned numDeps = item.dependencies_.size();
+                backgroundLoadMutex_.Release();
                 AsyncLoadState state = resource->GetAsyncLoadState();
                 if (numDeps > 0 || state == ASYNC_QUEUED || state == ASYNC_LOADING)
                 {
@@ -208,7 +251,7 @@ void BackgroundLoader::WaitForResource(StringHash type, StringHash nameHash)
         }
 
         // This may take a long time and may potentially wait on other resources, so it is important we do not hold the mutex during this
-        FinishBackgroundLoading(i->second);
+        FinishBackgroundLoading(item);
 
         backgroundLoadMutex_.Acquire();
         backgroundLoadQueue_.erase(i);
@@ -220,12 +263,12 @@ void BackgroundLoader::WaitForResource(StringHash type, StringHash nameHash)
 
 void BackgroundLoader::FinishResources(int maxMs)
 {
-    if (IsStarted())
+    backgroundLoadMutex_.Acquire();
+
+    if (!threads_.empty())
     {
         HiresTimer timer;
 
-        backgroundLoadMutex_.Acquire();
-
         for (auto i = backgroundLoadQueue_.begin();
              i != backgroundLoadQueue_.end();)
         {
@@ -248,9 +291,9 @@ void BackgroundLoader::FinishResources(int maxMs)
             if (timer.GetUSec(false) >= maxMs * 1000LL)
                 break;
         }
-
-        backgroundLoadMutex_.Release();
     }
+
+    backgroundLoadMutex_.Release();
 }
 
 unsigned BackgroundLoader::GetNumQueuedResources() const
@@ -259,6 +302,108 @@ unsigned BackgroundLoader::GetNumQueuedResources() const
     return backgroundLoadQueue_.size();
 }
 
+unsigned BackgroundLoader::GetNumThreads() const
+{
+    MutexLock lock(backgroundLoadMutex_);
+    return numThreads_;
+}
+
+ea::unordered_map<StringHash, BackgroundLoadStats> BackgroundLoader::GetStats() const
+{
+    MutexLock lock(backgroundLoadMutex_);
+    return stats_;
+}
+
+void BackgroundLoader::StartThreads()
+{
+    if (!threads_.empty())
+        return;
+
+    for (unsigned i = 0; i < numThreads_; ++i)
+    {
+        SharedPtr<BackgroundLoaderThread> thread(new BackgroundLoaderThread(this));
+        thread->SetName(Format("BackgroundLoader {}", i + 1));
+        thread->Run();
+        threads_.push_back(thread);
+    }
+}
+
+void BackgroundLoader::StopThreads()
+{
+    // Loader threads need the mutex to finish their work, so don't hold it while waiting for them
+    ea::vector<SharedPtr<BackgroundLoaderThread>> threads;
+    {
+        MutexLock lock(backgroundLoadMutex_);
+        threads.swap(threads_);
+    }
+
+    for (BackgroundLoaderThread* thread : threads)
+        thread->Stop();
+}
+
+BackgroundLoadItem* BackgroundLoader::TakeQueuedItem()
+{
+    for (auto i = pendingQueue_.begin(); i != pendingQueue_.end(); ++i)
+    {
+        // Skip resource types which are loaded at their concurrency limit
+        const StringHash type = i->first;
+        const auto limit = maxConcurrentLoads_.find(type);
+        if (limit != maxConcurrentLoads_.end() && numActiveLoads_[type] >= limit->second)
+            continue;
+
+        BackgroundLoadItem& item = backgroundLoadQueue_[*i];
+        pendingQueue_.erase(i);
+        BeginLoading(item);
+        return &item;
+    }
+
+    return nullptr;
+}
+
+void BackgroundLoader::BeginLoading(BackgroundLoadItem& item)
+{
+    Resource* resource = item.resource_;
+    resource->SetAsyncLoadState(ASYNC_LOADING);
+
+    const unsigned numActiveLoads = ++numActiveLoads_[resource->GetType()];
+    BackgroundLoadStats& stats = stats_[resource->GetType()];
+    stats.maxConcurrentLoads_ = Max(stats.maxConcurrentLoads_, numActiveLoads);
+    stats.queueTimeUs_ += item.timer_.GetUSec(true);
+}
+
+void BackgroundLoader::LoadItem(BackgroundLoadItem& item)
+{
+    Resource* resource = item.resource_;
+
+    bool success = false;
+    SharedPtr<File> file = owner_->GetFile(resource->GetName(), item.sendEventOnFailure_);
+    if (file)
+        success = resource->BeginLoad(*file);
+
+    const long long beginLoadTime = item.timer_.GetUSec(true);
+
+    // Process dependencies now
+    // Need to lock the queue again when manipulating other entries
+    ea::pair<StringHash, StringHash> key = ea::make_pair(resource->GetType(), resource->GetNameHash());
+    MutexLock lock(backgroundLoadMutex_);
+    if (item.dependents_.size())
+    {
+        for (auto i = item.dependents_.begin(); i != item.dependents_.end(); ++i)
+        {
+            auto j = backgroundLoadQueue_.find(*i);
+            if (j != backgroundLoadQueue_.end())
+                j->second.dependencies_.erase(key);
+        }
+
+        item.dependents_.clear();
+    }
+
+    --numActiveLoads_[resource->GetType()];
+    stats_[resource->GetType()].beginLoadTimeUs_ += beginLoadTime;
+
+    resource->SetAsyncLoadState(success ? ASYNC_SUCCESS : ASYNC_FAIL);
+}
+
 void BackgroundLoader::FinishBackgroundLoading(BackgroundLoadItem& item)
 {
     Resource* resource = item.resource_;
@@ -270,10 +415,23 @@ void BackgroundLoader::FinishBackgroundLoading(BackgroundLoadItem& item)
         URHO3D_PROFILE("FinishBackgroundLoading");
         URHO3D_PROFILE_ZONENAME(resource->GetTypeName().c_str(), resource->GetTypeName().length());
         URHO3D_LOGDEBUG("Finishing background loaded resource " + resource->GetName());
+        HiresTimer endLoadTimer;
         success = resource->EndLoad();
+
+        MutexLock lock(backgroundLoadMutex_);
+        stats_[resource->GetType()].endLoadTimeUs_ += endLoadTimer.GetUSec(false);
     }
     resource->SetAsyncLoadState(ASYNC_DONE);
 
+    {
+        MutexLock lock(backgroundLoadMutex_);
+        BackgroundLoadStats& stats = stats_[resource->GetType()];
+        if (success)
+            ++stats.numLoaded_;
+        else
+            ++stats.numFailed_;
+    }
+
     if (!success && item.sendEventOnFailure_)
     {
         using namespace LoadFailed;
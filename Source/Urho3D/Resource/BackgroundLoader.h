@@ -22,19 +22,22 @@
 
 #pragma once
 
+#include <EASTL/deque.h>
 #include <EASTL/hash_set.h>
 #include <EASTL/unordered_map.h>
 
 #include "../Core/Mutex.h"
 #include "../Container/Ptr.h"
 #include "../Core/Thread.h"
+#include "../Core/Timer.h"
 #include "../Math/StringHash.h"
+#include "../Resource/ResourceCache.h"
 
 namespace Urho3D
 {
 
+class BackgroundLoaderThread;
 class Resource;
-class ResourceCache;
 
 /// Queue item for background loading of a resource.
 struct URHO3D_API BackgroundLoadItem
@@ -47,21 +50,25 @@ struct URHO3D_API BackgroundLoadItem
     ea::hash_set<ea::pair<StringHash, StringHash> > dependents_;
     /// Whether to send failure event.
     bool sendEventOnFailure_;
+    /// Timer for the current loading stage.
+    HiresTimer timer_;
 };
 
-/// Background loader of resources. Owned by the ResourceCache.
+/// Background loader of resources. Owned by the ResourceCache. Loads resources on a pool of threads.
 /// @nobind
-class URHO3D_API BackgroundLoader : public RefCounted, public Thread
+class URHO3D_API BackgroundLoader : public RefCounted
 {
 public:
     /// Construct.
     explicit BackgroundLoader(ResourceCache* owner);
 
-    /// Destruct. Forcibly clear the load queue.
+    /// Destruct. Stop the loader threads and forcibly clear the load queue.
     ~BackgroundLoader() override;
 
-    /// Resource background loading loop.
-    void ThreadFunction() override;
+    /// Set number of loader threads. Threads are started on the first queued resource.
+    void SetNumThreads(unsigned numThreads);
+    /// Set maximum number of resources of a specific type loaded concurrently, 0 is unlimited.
+    void SetMaxConcurrentLoads(StringHash type, unsigned maxLoads);
 
     /// Queue loading of a resource. The name must be sanitated to ensure consistent format. Return true if queued (not a duplicate and resource was a known type).
     bool QueueResource(StringHash type, const ea::string& name, bool sendEventOnFailure, Resource* caller);
@@ -69,11 +76,27 @@ public:
     void WaitForResource(StringHash type, StringHash nameHash);
     /// Process resources that are ready to finish.
     void FinishResources(int maxMs);
+    /// Begin loading of one queued resource in the calling thread. Return false if there is nothing to load.
+    bool ProcessItem();
 
     /// Return amount of resources in the load queue.
     unsigned GetNumQueuedResources() const;
+    /// Return number of loader threads.
+    unsigned GetNumThreads() const;
+    /// Return loading statistics per resource type.
+    ea::unordered_map<StringHash, BackgroundLoadStats> GetStats() const;
 
 private:
+    /// Start the loader threads if not started yet. Mutex must be held.
+    void StartThreads();
+    /// Stop the loader threads. Mutex must not be held.
+    void StopThreads();
+    /// Take the first queued resource whose type has not reached its concurrency limit. Mutex must be held.
+    BackgroundLoadItem* TakeQueuedItem();
+    /// Mark a queued resource as loading. Mutex must be held.
+    void BeginLoading(BackgroundLoadItem& item);
+    /// Call BeginLoad of a resource and update its dependents.
+    void LoadItem(BackgroundLoadItem& item);
     /// Finish one background loaded resource.
     void FinishBackgroundLoading(BackgroundLoadItem& item);
 
@@ -83,6 +106,18 @@ private:
     mutable Mutex backgroundLoadMutex_;
     /// Resources that are queued for background loading.
     ea::unordered_map<ea::pair<StringHash, StringHash>, BackgroundLoadItem> backgroundLoadQueue_;
+    /// Resources waiting for BeginLoad in the order they should be loaded.
+    ea::deque<ea::pair<StringHash, StringHash>> pendingQueue_;
+    /// Maximum number of concurrent loads per resource type.
+    ea::unordered_map<StringHash, unsigned> maxConcurrentLoads_;
+    /// Number of resources being loaded per resource type.
+    ea::unordered_map<StringHash, unsigned> numActiveLoads_;
+    /// Loading statistics per resource type.
+    ea::unordered_map<StringHash, BackgroundLoadStats> stats_;
+    /// Loader threads.
+    ea::vector<SharedPtr<BackgroundLoaderThread>> threads_;
+    /// Number of loader threads.
+    unsigned numThreads_;
 };
 
 }
@@ -2365,6 +2365,11 @@ unsigned char* Image::GetImageData(Deserializer& source, int& width, int& height
 {
     unsigned dataSize = source.GetSize();
 
+    // Decode uncompressed package entries directly from the memory-mapped package
+    auto* file = dynamic_cast<File*>(&source);
+    if (const unsigned char* mappedData = file ? file->GetMappedData() : nullptr)
+        return stbi_load_from_memory(mappedData, dataSize, &width, &height, (int*)&components, 0);
+
     ea::shared_array<unsigned char> buffer(new unsigned char[dataSize]);
     source.Read(buffer.get(), dataSize);
     return stbi_load_from_memory(buffer.get(), dataSize, &width, &height, (int*)&components, 0);
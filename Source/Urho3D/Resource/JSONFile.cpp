@@ -25,6 +25,7 @@
 #include "../Core/Profiler.h"
 #include "../Core/Context.h"
 #include "../IO/Deserializer.h"
+#include "../IO/File.h"
 #include "../IO/Log.h"
 #include "../IO/MemoryBuffer.h"
 #include "../Resource/JSONFile.h"
@@ -119,13 +120,21 @@ bool JSONFile::BeginLoad(Deserializer& source)
         return false;
     }
 
-    ea::shared_array<char> buffer(new char[dataSize + 1]);
-    if (source.Read(buffer.get(), dataSize) != dataSize)
-        return false;
-    buffer[dataSize] = '\0';
+    // Parse uncompressed package entries directly from the memory-mapped package
+    auto* file = dynamic_cast<File*>(&source);
+    const char* data = file ? reinterpret_cast<const char*>(file->GetMappedData()) : nullptr;
+
+    ea::shared_array<char> buffer;
+    if (!data)
+    {
+        buffer = new char[dataSize];
+        if (source.Read(buffer.get(), dataSize) != dataSize)
+            return false;
+        data = buffer.get();
+    }
 
     rapidjson::Document document;
-    if (document.Parse<kParseCommentsFlag | kParseTrailingCommasFlag>(buffer.get()).HasParseError())
+    if (document.Parse<kParseCommentsFlag | kParseTrailingCommasFlag>(data, dataSize).HasParseError())
     {
         URHO3D_LOGERROR("Could not parse JSON data from " + source.GetName());
         return false;
@@ -27,6 +27,7 @@
 #include "../IO/File.h"
 #include "../IO/Log.h"
 #include "../Resource/Resource.h"
+#include "../Resource/ResourceCache.h"
 #include "../Resource/XMLElement.h"
 
 namespace Urho3D
@@ -96,12 +97,17 @@ void Resource::SetName(const ea::string& name)
 
 void Resource::SetMemoryUse(unsigned size)
 {
+    // Keep memory use of the resource group up to date without rescanning it
+    if (resourceGroup_)
+        resourceGroup_->memoryUse_ = resourceGroup_->memoryUse_ - memoryUse_ + size;
     memoryUse_ = size;
 }
 
 void Resource::ResetUseTimer()
 {
     useTimer_.Reset();
+    if (resourceGroup_)
+        resourceGroup_->Touch(this);
 }
 
 void Resource::SetAsyncLoadState(AsyncLoadState newState)
@@ -114,7 +120,7 @@ unsigned Resource::GetUseTimer()
     // If more references than the resource cache, return always 0 & reset the timer
     if (Refs() > 1)
     {
-        useTimer_.Reset();
+        ResetUseTimer();
         return 0;
     }
     else
@@ -34,6 +34,7 @@ namespace Urho3D
 class Deserializer;
 class Serializer;
 class XMLElement;
+struct ResourceGroup;
 
 /// Asynchronous loading state of a resource.
 enum AsyncLoadState
@@ -55,6 +56,7 @@ enum AsyncLoadState
 class URHO3D_API Resource : public Object
 {
     URHO3D_OBJECT(Resource, Object);
+    friend struct ResourceGroup;
 
 public:
     /// Construct.
@@ -81,7 +83,7 @@ public:
     void SetName(const ea::string& name);
     /// Set memory use in bytes, possibly approximate.
     void SetMemoryUse(unsigned size);
-    /// Reset last used timer.
+    /// Reset last used timer. Marks the resource as most recently used in the resource cache.
     void ResetUseTimer();
     /// Set the asynchronous loading state. Called by ResourceCache. Resources in the middle of asynchronous loading are not normally returned to user.
     void SetAsyncLoadState(AsyncLoadState newState);
@@ -122,6 +124,12 @@ private:
     unsigned memoryUse_;
     /// Asynchronous loading state.
     AsyncLoadState asyncLoadState_;
+    /// Resource cache group the resource is stored in, or null if not stored.
+    ResourceGroup* resourceGroup_{};
+    /// Previous resource in the least recently used order of the resource group.
+    Resource* lruPrev_{};
+    /// Next resource in the least recently used order of the resource group.
+    Resource* lruNext_{};
 };
 
 /// Base class for resources that support arbitrary metadata stored. Metadata serialization shall be implemented in derived classes.
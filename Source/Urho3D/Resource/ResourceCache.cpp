@@ -80,6 +80,102 @@ static const char* checkDirs[] =
 
 static const SharedPtr<Resource> noResource;
 
+/// Return key of a file name in the resource directory index. File names are case-insensitive on Windows.
+static StringHash GetResourceDirIndexKey(const ea::string& fileName)
+{
+#ifdef _WIN32
+    return StringHash(fileName.to_lower());
+#else
+    return StringHash(fileName);
+#endif
+}
+
+void ResourceGroup::Store(Resource* resource)
+{
+    auto iter = resources_.find(resource->GetNameHash());
+    if (iter != resources_.end())
+    {
+        if (iter->second == resource)
+        {
+            Touch(resource);
+            return;
+        }
+        Erase(iter);
+    }
+
+    resources_.emplace(resource->GetNameHash(), SharedPtr<Resource>(resource));
+    resource->resourceGroup_ = this;
+    LinkLast(resource);
+    memoryUse_ += resource->GetMemoryUse();
+}
+
+ResourceGroup::ResourceMap::iterator ResourceGroup::Erase(ResourceMap::iterator iter)
+{
+    Resource* resource = iter->second;
+    memoryUse_ -= resource->GetMemoryUse();
+    Unlink(resource);
+    resource->resourceGroup_ = nullptr;
+    return resources_.erase(iter);
+}
+
+void ResourceGroup::Erase(StringHash nameHash)
+{
+    auto iter = resources_.find(nameHash);
+    if (iter != resources_.end())
+        Erase(iter);
+}
+
+void ResourceGroup::Touch(Resource* resource)
+{
+    if (resource != lruLast_)
+    {
+        Unlink(resource);
+        LinkLast(resource);
+    }
+}
+
+void ResourceGroup::Clear()
+{
+    for (auto& resourcePair : resources_)
+    {
+        Resource* resource = resourcePair.second;
+        resource->resourceGroup_ = nullptr;
+        resource->lruPrev_ = nullptr;
+        resource->lruNext_ = nullptr;
+    }
+    resources_.clear();
+    lruFirst_ = nullptr;
+    lruLast_ = nullptr;
+    memoryUse_ = 0;
+}
+
+void ResourceGroup::Unlink(Resource* resource)
+{
+    if (resource->lruPrev_)
+        resource->lruPrev_->lruNext_ = resource->lruNext_;
+    else
+        lruFirst_ = resource->lruNext_;
+
+    if (resource->lruNext_)
+        resource->lruNext_->lruPrev_ = resource->lruPrev_;
+    else
+        lruLast_ = resource->lruPrev_;
+
+    resource->lruPrev_ = nullptr;
+    resource->lruNext_ = nullptr;
+}
+
+void ResourceGroup::LinkLast(Resource* resource)
+{
+    resource->lruPrev_ = lruLast_;
+    resource->lruNext_ = nullptr;
+    if (lruLast_)
+        lruLast_->lruNext_ = resource;
+    else
+        lruFirst_ = resource;
+    lruLast_ = resource;
+}
+
 ResourceCache::ResourceCache(Context* context) :
     Object(context),
     autoReloadResources_(false),
@@ -92,7 +188,7 @@ ResourceCache::ResourceCache(Context* context) :
     RegisterResourceLibrary(context_);
 
 #ifdef URHO3D_THREADING
-    // Create resource background loader. Its thread will start on the first background request
+    // Create resource background loader. Its threads will start on the first background request
     backgroundLoader_ = new BackgroundLoader(this);
 #endif
 
@@ -106,6 +202,10 @@ ResourceCache::~ResourceCache()
     // Shut down the background loader first
     backgroundLoader_.Reset();
 #endif
+
+    // Resources referenced outside the cache must not refer to the destroyed resource groups
+    for (auto& groupPair : resourceGroups_)
+        groupPair.second.Clear();
 }
 
 bool ResourceCache::AddResourceDir(const ea::string& pathName, unsigned priority)
@@ -129,11 +229,6 @@ bool ResourceCache::AddResourceDir(const ea::string& pathName, unsigned priority
             return true;
     }
 
-    if (priority < resourceDirs_.size())
-        resourceDirs_.insert_at(priority, fixedPath);
-    else
-        resourceDirs_.push_back(fixedPath);
-
     // If resource auto-reloading active, create a file watcher for the directory
     if (autoReloadResources_)
     {
@@ -142,6 +237,21 @@ bool ResourceCache::AddResourceDir(const ea::string& pathName, unsigned priority
         fileWatchers_.push_back(watcher);
     }
 
+    // Index the files of the directory, so that finding existing resources does not need to query the file system.
+    // Index is built after the watcher is started, so no changes are missed
+    ResourceDirIndex index = BuildResourceDirIndex(fixedPath);
+
+    if (priority < resourceDirs_.size())
+    {
+        resourceDirs_.insert_at(priority, fixedPath);
+        resourceDirIndices_.insert_at(priority, ea::move(index));
+    }
+    else
+    {
+        resourceDirs_.push_back(fixedPath);
+        resourceDirIndices_.push_back(ea::move(index));
+    }
+
     URHO3D_LOGINFO("Added resource path " + fixedPath);
     return true;
 }
@@ -169,7 +279,11 @@ bool ResourceCache::AddPackageFile(PackageFile* package, unsigned priority)
 bool ResourceCache::AddPackageFile(const ea::string& fileName, unsigned priority)
 {
     SharedPtr<PackageFile> package(new PackageFile(context_));
-    return package->Open(fileName) && AddPackageFile(package, priority);
+    if (!package->Open(fileName))
+        return false;
+    if (memoryMappedPackages_ && !package->MapMemory())
+        URHO3D_LOGDEBUG("Could not memory-map package file " + fileName + ", falling back to file reads");
+    return AddPackageFile(package, priority);
 }
 
 bool ResourceCache::AddManualResource(Resource* resource)
@@ -188,7 +302,7 @@ bool ResourceCache::AddManualResource(Resource* resource)
     }
 
     resource->ResetUseTimer();
-    resourceGroups_[resource->GetType()].resources_[resource->GetNameHash()] = resource;
+    resourceGroups_[resource->GetType()].Store(resource);
     UpdateResourceGroup(resource->GetType());
     return true;
 }
@@ -204,6 +318,7 @@ void ResourceCache::RemoveResourceDir(const ea::string& pathName)
         if (!resourceDirs_[i].comparei(fixedPath))
         {
             resourceDirs_.erase_at(i);
+            resourceDirIndices_.erase_at(i);
             // Remove the filewatcher with the matching path
             for (unsigned j = 0; j < fileWatchers_.size(); ++j)
             {
@@ -266,7 +381,7 @@ void ResourceCache::ReleaseResource(StringHash type, const ea::string& name, boo
     // If other references exist, do not release, unless forced
     if ((existingRes.Refs() == 1 && existingRes.WeakRefs() == 0) || force)
     {
-        resourceGroups_[type].resources_.erase(nameHash);
+        resourceGroups_[type].Erase(nameHash);
         UpdateResourceGroup(type);
     }
 }
@@ -290,7 +405,7 @@ void ResourceCache::ReleaseResource(const ea::string& resourceName, bool force)
                     // If other references exist, do not release, unless forced
                     if ((current->second.Refs() == 1 && current->second.WeakRefs() == 0) || force)
                     {
-                        j = i->second.resources_.erase(current);
+                        j = i->second.Erase(current);
                         released = true;
                         continue;
                     }
@@ -318,7 +433,7 @@ void ResourceCache::ReleaseResources(StringHash type, bool force)
             // If other references exist, do not release, unless forced
             if ((current->second.Refs() == 1 && current->second.WeakRefs() == 0) || force)
             {
-                i->second.resources_.erase(current);
+                i->second.Erase(current);
                 released = true;
             }
         }
@@ -344,7 +459,7 @@ void ResourceCache::ReleaseResources(StringHash type, const ea::string& partialN
                 // If other references exist, do not release, unless forced
                 if ((current->second.Refs() == 1 && current->second.WeakRefs() == 0) || force)
                 {
-                    i->second.resources_.erase(current);
+                    i->second.Erase(current);
                     released = true;
                 }
             }
@@ -376,7 +491,7 @@ void ResourceCache::ReleaseResources(const ea::string& partialName, bool force)
                     // If other references exist, do not release, unless forced
                     if ((current->second.Refs() == 1 && current->second.WeakRefs() == 0) || force)
                     {
-                        i->second.resources_.erase(current);
+                        i->second.Erase(current);
                         released = true;
                     }
                 }
@@ -405,7 +520,7 @@ void ResourceCache::ReleaseAllResources(bool force)
                 // If other references exist, do not release, unless forced
                 if ((current->second.Refs() == 1 && current->second.WeakRefs() == 0) || force)
                 {
-                    i->second.resources_.erase(current);
+                    i->second.Erase(current);
                     released = true;
                 }
             }
@@ -491,6 +606,14 @@ void ResourceCache::ReloadResourceWithDependencies(const ea::string& fileName)
 void ResourceCache::SetMemoryBudget(StringHash type, unsigned long long budget)
 {
     resourceGroups_[type].memoryBudget_ = budget;
+    UpdateResourceGroup(type);
+}
+
+void ResourceCache::SetDeferredRelease(bool enable)
+{
+    deferredRelease_ = enable;
+    if (!deferredRelease_)
+        deferredReleaseResources_.clear();
 }
 
 void ResourceCache::SetAutoReloadResources(bool enable)
@@ -499,11 +622,16 @@ void ResourceCache::SetAutoReloadResources(bool enable)
     {
         if (enable)
         {
+            MutexLock lock(resourceMutex_);
+
             for (unsigned i = 0; i < resourceDirs_.size(); ++i)
             {
                 SharedPtr<FileWatcher> watcher(new FileWatcher(context_));
                 watcher->StartWatching(resourceDirs_[i], true);
                 fileWatchers_.push_back(watcher);
+
+                // Files may have changed while not watched
+                resourceDirIndices_[i] = BuildResourceDirIndex(resourceDirs_[i]);
             }
         }
         else
@@ -679,7 +807,7 @@ Resource* ResourceCache::GetResource(StringHash type, const ea::string& name, bo
 
     // Store to cache
     resource->ResetUseTimer();
-    resourceGroups_[type].resources_[nameHash] = resource;
+    resourceGroups_[type].Store(resource);
     UpdateResourceGroup(type);
 
     return resource;
@@ -768,6 +896,38 @@ unsigned ResourceCache::GetNumBackgroundLoadResources() const
 #endif
 }
 
+void ResourceCache::SetNumBackgroundLoadThreads(unsigned numThreads)
+{
+#ifdef URHO3D_THREADING
+    backgroundLoader_->SetNumThreads(numThreads);
+#endif
+}
+
+void ResourceCache::SetMaxConcurrentBackgroundLoads(StringHash type, unsigned maxLoads)
+{
+#ifdef URHO3D_THREADING
+    backgroundLoader_->SetMaxConcurrentLoads(type, maxLoads);
+#endif
+}
+
+unsigned ResourceCache::GetNumBackgroundLoadThreads() const
+{
+#ifdef URHO3D_THREADING
+    return backgroundLoader_->GetNumThreads();
+#else
+    return 0;
+#endif
+}
+
+ea::unordered_map<StringHash, BackgroundLoadStats> ResourceCache::GetBackgroundLoadStats() const
+{
+#ifdef URHO3D_THREADING
+    return backgroundLoader_->GetStats();
+#else
+    return {};
+#endif
+}
+
 void ResourceCache::GetResources(ea::vector<Resource*>& result, StringHash type) const
 {
     result.clear();
@@ -796,15 +956,11 @@ bool ResourceCache::Exists(const ea::string& name) const
             return true;
     }
 
-    auto* fileSystem = GetSubsystem<FileSystem>();
-    for (unsigned i = 0; i < resourceDirs_.size(); ++i)
-    {
-        if (fileSystem->FileExists(resourceDirs_[i] + sanitatedName))
-            return true;
-    }
+    if (FindResourceDir(sanitatedName) != M_MAX_UNSIGNED)
+        return true;
 
     // Fallback using absolute path
-    return fileSystem->FileExists(sanitatedName);
+    return GetSubsystem<FileSystem>()->FileExists(sanitatedName);
 }
 
 unsigned long long ResourceCache::GetMemoryBudget(StringHash type) const
@@ -832,13 +988,11 @@ ea::string ResourceCache::GetResourceFileName(const ea::string& name) const
 {
     MutexLock lock(resourceMutex_);
 
-    auto* fileSystem = GetSubsystem<FileSystem>();
-    for (unsigned i = 0; i < resourceDirs_.size(); ++i)
-    {
-        if (fileSystem->FileExists(resourceDirs_[i] + name))
-            return resourceDirs_[i] + name;
-    }
+    const unsigned dirIndex = FindResourceDir(name);
+    if (dirIndex != M_MAX_UNSIGNED)
+        return resourceDirs_[dirIndex] + name;
 
+    auto* fileSystem = GetSubsystem<FileSystem>();
     if (IsAbsolutePath(name) && fileSystem->FileExists(name))
         return name;
     else
@@ -1072,7 +1226,7 @@ void ResourceCache::ReleasePackageResources(PackageFile* package, bool force)
                 // If other references exist, do not release, unless forced
                 if ((k->second.Refs() == 1 && k->second.WeakRefs() == 0) || force)
                 {
-                    j->second.resources_.erase(k);
+                    j->second.Erase(k);
                     affectedGroups.insert(j->first);
                 }
                 break;
@@ -1090,40 +1244,51 @@ void ResourceCache::UpdateResourceGroup(StringHash type)
     if (i == resourceGroups_.end())
         return;
 
-    for (;;)
+    ResourceGroup& group = i->second;
+    if (!group.memoryBudget_ || group.memoryUse_ <= group.memoryBudget_)
+        return;
+
+    // Release least recently used resources until within memory budget. Resources in use are moved to the end of the
+    // order when their use timer is checked, so stop when reaching the first of them
+    Resource* firstInUse = nullptr;
+    Resource* resource = group.lruFirst_;
+    while (resource && resource != firstInUse && group.memoryUse_ > group.memoryBudget_)
     {
-        unsigned totalSize = 0;
-        unsigned oldestTimer = 0;
-        auto oldestResource = i->second.resources_.end();
+        Resource* next = ResourceGroup::GetNextUsed(resource);
 
-        for (auto j = i->second.resources_.begin();
-             j != i->second.resources_.end(); ++j)
+        // Resources in use always return a zero timer and can not be removed
+        if (resource->GetUseTimer() == 0)
         {
-            totalSize += j->second->GetMemoryUse();
-            unsigned useTimer = j->second->GetUseTimer();
-            if (useTimer > oldestTimer)
-            {
-                oldestTimer = useTimer;
-                oldestResource = j;
-            }
+            if (!firstInUse && resource->Refs() > 1)
+                firstInUse = resource;
         }
-
-        i->second.memoryUse_ = totalSize;
-
-        // If memory budget defined and is exceeded, remove the oldest resource and loop again
-        // (resources in use always return a zero timer and can not be removed)
-        if (i->second.memoryBudget_ && i->second.memoryUse_ > i->second.memoryBudget_ &&
-            oldestResource != i->second.resources_.end())
+        else
         {
-            URHO3D_LOGDEBUG("Resource group " + oldestResource->second->GetTypeName() + " over memory budget, releasing resource " +
-                     oldestResource->second->GetName());
-            i->second.resources_.erase(oldestResource);
+            URHO3D_LOGDEBUG("Resource group " + resource->GetTypeName() + " over memory budget, releasing resource " +
+                resource->GetName());
+            if (deferredRelease_)
+                deferredReleaseResources_.emplace_back(resource);
+            group.Erase(resource->GetNameHash());
         }
-        else
-            break;
+
+        resource = next;
     }
 }
 
+void ResourceCache::ProcessDeferredRelease()
+{
+    if (deferredReleaseResources_.empty())
+        return;
+
+    URHO3D_PROFILE("ReleaseDeferredResources");
+
+    HiresTimer timer;
+    do
+    {
+        deferredReleaseResources_.pop_front();
+    } while (!deferredReleaseResources_.empty() && timer.GetUSec(false) < deferredReleaseMs_ * 1000LL);
+}
+
 void ResourceCache::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
 {
     for (unsigned i = 0; i < fileWatchers_.size(); ++i)
@@ -1131,6 +1296,8 @@ void ResourceCache::HandleBeginFrame(StringHash eventType, VariantMap& eventData
         FileChange change;
         while (fileWatchers_[i]->GetNextChange(change))
         {
+            UpdateResourceDirIndex(fileWatchers_[i]->GetPath(), change);
+
             auto it = ignoreResourceAutoReload_.find(change.fileName_);
             if (it != ignoreResourceAutoReload_.end())
             {
@@ -1157,30 +1324,134 @@ void ResourceCache::HandleBeginFrame(StringHash eventType, VariantMap& eventData
         backgroundLoader_->FinishResources(finishBackgroundResourcesMs_);
     }
 #endif
+
+    ProcessDeferredRelease();
 }
 
 File* ResourceCache::SearchResourceDirs(const ea::string& name)
 {
-    auto* fileSystem = GetSubsystem<FileSystem>();
-    for (unsigned i = 0; i < resourceDirs_.size(); ++i)
+    for (unsigned i = FindResourceDir(name); i != M_MAX_UNSIGNED; i = FindResourceDir(name, i + 1))
     {
-        if (fileSystem->FileExists(resourceDirs_[i] + name))
+        // Construct the file first with full path, then rename it to not contain the resource path,
+        // so that the file's sanitatedName can be used in further GetFile() calls (for example over the network)
+        File* file(new File(context_, resourceDirs_[i] + name));
+        if (!file->IsOpen())
         {
-            // Construct the file first with full path, then rename it to not contain the resource path,
-            // so that the file's sanitatedName can be used in further GetFile() calls (for example over the network)
-            File* file(new File(context_, resourceDirs_[i] + name));
-            file->SetName(name);
-            return file;
+            // The index is stale, keep searching
+            delete file;
+            continue;
         }
+        file->SetName(name);
+        return file;
     }
 
     // Fallback using absolute path
+    auto* fileSystem = GetSubsystem<FileSystem>();
     if (fileSystem->FileExists(name))
         return new File(context_, name);
 
     return nullptr;
 }
 
+unsigned ResourceCache::FindResourceDir(const ea::string& name, unsigned startIndex) const
+{
+    auto* fileSystem = GetSubsystem<FileSystem>();
+    const StringHash nameHash = GetResourceDirIndexKey(name);
+
+    for (unsigned i = startIndex; i < resourceDirs_.size(); ++i)
+    {
+        const ResourceDirIndex& index = resourceDirIndices_[i];
+        if (index.indexed_ ? index.files_.contains(nameHash) : fileSystem->FileExists(resourceDirs_[i] + name))
+            return i;
+    }
+
+    // Indices may be outdated: files may be created before the file watcher reports them, in subdirectories
+    // the watcher doesn't track yet, or without a file watcher at all
+    for (unsigned i = startIndex; i < resourceDirs_.size(); ++i)
+    {
+        if (resourceDirIndices_[i].indexed_ && fileSystem->FileExists(resourceDirs_[i] + name))
+            return i;
+    }
+
+    return M_MAX_UNSIGNED;
+}
+
+ResourceDirIndex ResourceCache::BuildResourceDirIndex(const ea::string& pathName) const
+{
+    URHO3D_PROFILE("BuildResourceDirIndex");
+
+    ResourceDirIndex index;
+#ifdef __ANDROID__
+    // Listing APK assets is slow, search them file by file
+    if (URHO3D_IS_ASSET(pathName))
+        return index;
+#endif
+
+    auto* fileSystem = GetSubsystem<FileSystem>();
+    ea::vector<ea::string> fileNames;
+    ea::vector<ea::string> subdirNames;
+    fileSystem->ScanDir(fileNames, pathName, "*", SCAN_FILES | SCAN_HIDDEN, false);
+    fileSystem->ScanDir(subdirNames, pathName, "*", SCAN_DIRS | SCAN_HIDDEN, false);
+    subdirNames.erase(ea::remove_if(subdirNames.begin(), subdirNames.end(),
+        [](const ea::string& name) { return name == "." || name == ".."; }), subdirNames.end());
+
+    // Scan the subdirectories in parallel
+    ea::vector<ea::vector<ea::string>> subdirFileNames(subdirNames.size());
+    const auto scanSubdirs = [&](unsigned beginIndex, unsigned endIndex)
+    {
+        for (unsigned i = beginIndex; i < endIndex; ++i)
+            fileSystem->ScanDir(subdirFileNames[i], pathName + subdirNames[i], "*", SCAN_FILES | SCAN_HIDDEN, true);
+    };
+    if (auto workQueue = GetSubsystem<WorkQueue>())
+        ForEachParallel(workQueue, 1u, subdirNames.size(), scanSubdirs);
+    else
+        scanSubdirs(0, subdirNames.size());
+
+    for (const ea::string& fileName : fileNames)
+        index.files_.insert(GetResourceDirIndexKey(fileName));
+    for (unsigned i = 0; i < subdirNames.size(); ++i)
+    {
+        const ea::string prefix = subdirNames[i] + "/";
+        for (const ea::string& fileName : subdirFileNames[i])
+            index.files_.insert(GetResourceDirIndexKey(prefix + fileName));
+    }
+
+    index.indexed_ = true;
+    return index;
+}
+
+void ResourceCache::UpdateResourceDirIndex(const ea::string& pathName, const FileChange& change)
+{
+    MutexLock lock(resourceMutex_);
+
+    for (unsigned i = 0; i < resourceDirs_.size(); ++i)
+    {
+        if (resourceDirs_[i].comparei(pathName))
+            continue;
+
+        ResourceDirIndex& index = resourceDirIndices_[i];
+        if (!index.indexed_)
+            return;
+
+        switch (change.kind_)
+        {
+        case FILECHANGE_ADDED:
+            index.files_.insert(GetResourceDirIndexKey(change.fileName_));
+            break;
+        case FILECHANGE_REMOVED:
+            index.files_.erase(GetResourceDirIndexKey(change.fileName_));
+            break;
+        case FILECHANGE_RENAMED:
+            index.files_.erase(GetResourceDirIndexKey(change.oldFileName_));
+            index.files_.insert(GetResourceDirIndexKey(change.fileName_));
+            break;
+        default:
+            break;
+        }
+        return;
+    }
+}
+
 File* ResourceCache::SearchPackages(const ea::string& name)
 {
     for (unsigned i = 0; i < packages_.size(); ++i)
@@ -1386,10 +1657,10 @@ bool ResourceCache::RenameResource(const ea::string& source, const ea::string& d
                 ignoreResourceAutoReload_.emplace_back(resource->GetName());
             }
 
-            groupPair.second.resources_.erase(resource->GetNameHash());
+            groupPair.second.Erase(resource->GetNameHash());
             resource->SetName(newName);
             resource->SetAbsoluteFileName(newNativeFileName);
-            groupPair.second.resources_[resource->GetNameHash()] = resource;
+            groupPair.second.Store(resource);
             movedAny = true;
 
             using namespace ResourceRenamed;
@@ -1432,7 +1703,10 @@ void ResourceCache::RouteResourceName(ea::string& name, ResourceRequest requestT
 
 void ResourceCache::Clear()
 {
+    for (auto& groupPair : resourceGroups_)
+        groupPair.second.Clear();
     resourceGroups_.clear();
+    deferredReleaseResources_.clear();
     dependentResources_.clear();
 }
 
@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include <EASTL/deque.h>
 #include <EASTL/unique_ptr.h>
 #include <EASTL/hash_set.h>
 
@@ -38,13 +39,16 @@ namespace Urho3D
 class BackgroundLoader;
 class FileWatcher;
 class PackageFile;
+struct FileChange;
 
 /// Sets to priority so that a package or file is pushed to the end of the vector.
 static const unsigned PRIORITY_LAST = 0xffffffff;
 
 /// Container of resources with specific type.
-struct ResourceGroup
+struct URHO3D_API ResourceGroup
 {
+    using ResourceMap = ea::unordered_map<StringHash, SharedPtr<Resource> >;
+
     /// Construct with defaults.
     ResourceGroup() :
         memoryBudget_(0),
@@ -52,12 +56,61 @@ struct ResourceGroup
     {
     }
 
+    /// Store a resource as most recently used, replacing a resource with the same name.
+    void Store(Resource* resource);
+    /// Remove a resource. Return iterator to the next resource.
+    ResourceMap::iterator Erase(ResourceMap::iterator iter);
+    /// Remove a resource by name hash.
+    void Erase(StringHash nameHash);
+    /// Mark a stored resource as most recently used.
+    void Touch(Resource* resource);
+    /// Remove all resources.
+    void Clear();
+    /// Return the next more recently used resource.
+    static Resource* GetNextUsed(Resource* resource) { return resource->lruNext_; }
+
     /// Memory budget.
     unsigned long long memoryBudget_;
-    /// Current memory use.
+    /// Current memory use. Updated incrementally as resources are stored, removed and resized.
     unsigned long long memoryUse_;
     /// Resources.
-    ea::unordered_map<StringHash, SharedPtr<Resource> > resources_;
+    ResourceMap resources_;
+    /// Least recently used resource.
+    Resource* lruFirst_{};
+    /// Most recently used resource.
+    Resource* lruLast_{};
+
+private:
+    /// Unlink a resource from the least recently used order.
+    void Unlink(Resource* resource);
+    /// Link a resource as most recently used.
+    void LinkLast(Resource* resource);
+};
+
+/// Index of the files in a resource directory.
+struct ResourceDirIndex
+{
+    /// Whether the directory is indexed. Directories which can not be scanned are searched through the file system.
+    bool indexed_{};
+    /// Hashes of the file names relative to the directory.
+    ea::hash_set<StringHash> files_;
+};
+
+/// Background loading statistics of a resource type.
+struct BackgroundLoadStats
+{
+    /// Number of resources loaded successfully.
+    unsigned numLoaded_{};
+    /// Number of resources failed to load.
+    unsigned numFailed_{};
+    /// Peak number of resources loaded concurrently.
+    unsigned maxConcurrentLoads_{};
+    /// Total time resources spent in the queue before loading began, in microseconds.
+    long long queueTimeUs_{};
+    /// Total time spent in BeginLoad, in microseconds.
+    long long beginLoadTimeUs_{};
+    /// Total time spent in EndLoad on the main thread, in microseconds.
+    long long endLoadTimeUs_{};
 };
 
 /// Resource request types.
@@ -139,9 +192,24 @@ public:
     /// @property
     void SetSearchPackagesFirst(bool value) { searchPackagesFirst_ = value; }
 
+    /// Enable or disable memory mapping of package files added by name. Default true. Packages that cannot be mapped are read through the file system.
+    /// @property
+    void SetMemoryMappedPackages(bool enable) { memoryMappedPackages_ = enable; }
+
+    /// Set number of threads used for background loading. Default is half of the logical CPUs, but at most 4.
+    void SetNumBackgroundLoadThreads(unsigned numThreads);
+    /// Set maximum number of resources of a specific type loaded concurrently in the background, default 0 is unlimited.
+    void SetMaxConcurrentBackgroundLoads(StringHash type, unsigned maxLoads);
+
     /// Set how many milliseconds maximum per frame to spend on finishing background loaded resources.
     /// @property
     void SetFinishBackgroundResourcesMs(int ms) { finishBackgroundResourcesMs_ = Max(ms, 1); }
+    /// Enable or disable deferred release of resources evicted over memory budget. When enabled, evicted resources are destroyed at the beginning of the following frames instead of immediately. Default false.
+    /// @property
+    void SetDeferredRelease(bool enable);
+    /// Set how many milliseconds maximum per frame to spend on destroying resources with deferred release.
+    /// @property
+    void SetDeferredReleaseMs(int ms) { deferredReleaseMs_ = Max(ms, 1); }
 
     /// Add a resource router object. By default there is none, so the routing process is skipped.
     void AddResourceRouter(ResourceRouter* router, bool addAsFirst = false);
@@ -159,6 +227,10 @@ public:
     /// Return number of pending background-loaded resources.
     /// @property
     unsigned GetNumBackgroundLoadResources() const;
+    /// Return number of threads used for background loading.
+    unsigned GetNumBackgroundLoadThreads() const;
+    /// Return background loading statistics per resource type.
+    ea::unordered_map<StringHash, BackgroundLoadStats> GetBackgroundLoadStats() const;
     /// Return all loaded resources of a specific type.
     void GetResources(ea::vector<Resource*>& result, StringHash type) const;
     /// Return an already loaded resource of specific type & name, or null if not found. Will not load if does not exist. Specifying zero type will search all types.
@@ -213,10 +285,25 @@ public:
     /// @property
     bool GetSearchPackagesFirst() const { return searchPackagesFirst_; }
 
+    /// Return whether package files added by name are memory-mapped.
+    /// @property
+    bool GetMemoryMappedPackages() const { return memoryMappedPackages_; }
+
     /// Return how many milliseconds maximum to spend on finishing background loaded resources.
     /// @property
     int GetFinishBackgroundResourcesMs() const { return finishBackgroundResourcesMs_; }
 
+    /// Return whether resources evicted over memory budget are released with a delay.
+    /// @property
+    bool GetDeferredRelease() const { return deferredRelease_; }
+
+    /// Return how many milliseconds maximum per frame to spend on destroying resources with deferred release.
+    /// @property
+    int GetDeferredReleaseMs() const { return deferredReleaseMs_; }
+
+    /// Return number of evicted resources waiting for deferred release.
+    unsigned GetNumDeferredReleaseResources() const { return deferredReleaseResources_.size(); }
+
     /// Return a resource router by index.
     ResourceRouter* GetResourceRouter(unsigned index) const;
 
@@ -261,12 +348,20 @@ private:
     const SharedPtr<Resource>& FindResource(StringHash nameHash);
     /// Release resources loaded from a package file.
     void ReleasePackageResources(PackageFile* package, bool force = false);
-    /// Update a resource group. Recalculate memory use and release resources if over memory budget.
+    /// Update a resource group. Release least recently used resources if over memory budget.
     void UpdateResourceGroup(StringHash type);
+    /// Destroy resources with deferred release, up to the time limit.
+    void ProcessDeferredRelease();
     /// Handle begin frame event. Automatic resource reloads and the finalization of background loaded resources are processed here.
     void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
     /// Search FileSystem for file.
     File* SearchResourceDirs(const ea::string& name);
+    /// Return index of the first resource directory containing the file, or M_MAX_UNSIGNED if not found. Skips directories before startIndex.
+    unsigned FindResourceDir(const ea::string& name, unsigned startIndex = 0) const;
+    /// Scan a resource directory and return the index of its files.
+    ResourceDirIndex BuildResourceDirIndex(const ea::string& pathName) const;
+    /// Update the index of a resource directory from a file watcher change.
+    void UpdateResourceDirIndex(const ea::string& pathName, const FileChange& change);
     /// Search resource packages for file.
     File* SearchPackages(const ea::string& name);
 
@@ -276,6 +371,8 @@ private:
     ea::unordered_map<StringHash, ResourceGroup> resourceGroups_;
     /// Resource load directories.
     ea::vector<ea::string> resourceDirs_;
+    /// File indices of the resource load directories, in the same order.
+    ea::vector<ResourceDirIndex> resourceDirIndices_;
     /// File watchers for resource directories, if automatic reloading enabled.
     ea::vector<SharedPtr<FileWatcher> > fileWatchers_;
     /// Package files.
@@ -292,12 +389,20 @@ private:
     bool returnFailedResources_;
     /// Search priority flag.
     bool searchPackagesFirst_;
+    /// Memory-mapped packages flag.
+    bool memoryMappedPackages_{true};
     /// Resource routing flag to prevent endless recursion.
     mutable bool isRouting_;
     /// How many milliseconds maximum per frame to spend on finishing background loaded resources.
     int finishBackgroundResourcesMs_;
     /// List of resources that will not be auto-reloaded if reloading event triggers.
     ea::vector<ea::string> ignoreResourceAutoReload_;
+    /// Deferred release flag.
+    bool deferredRelease_{};
+    /// How many milliseconds maximum per frame to spend on destroying resources with deferred release.
+    int deferredReleaseMs_{1};
+    /// Evicted resources waiting for deferred release.
+    ea::deque<SharedPtr<Resource> > deferredReleaseResources_;
 };
 
 template <class T> T* ResourceCache::GetExistingResource(const ea::string& name)
@@ -299,7 +299,7 @@ RmlUI::RmlUI(Context* context, const char* name)
     SubscribeToEvent(E_DROPFILE, &RmlUI::HandleDropFile);
 
     SubscribeToEvent(E_SCREENMODE, &RmlUI::HandleScreenMode);
-    SubscribeToEvent(E_POSTUPDATE, &RmlUI::HandlePostUpdate);
+    SubscribeToTypedEvent<PostUpdateEventArgs>([this](const PostUpdateEventArgs& args) { HandlePostUpdate(args); });
     SubscribeToEvent(E_ENDALLVIEWSRENDER, &RmlUI::HandleEndAllViewsRender);
 
     SubscribeToEvent(E_FILECHANGED, &RmlUI::HandleResourceReloaded);
@@ -487,9 +487,9 @@ void RmlUI::HandleTextInput(StringHash, VariantMap& eventData)
     rmlContext_->ProcessTextInput(eventData[P_TEXT].GetString().c_str());
 }
 
-void RmlUI::HandlePostUpdate(StringHash, VariantMap& eventData)
+void RmlUI::HandlePostUpdate(const PostUpdateEventArgs& args)
 {
-    Update(eventData[PostUpdate::P_TIMESTEP].GetFloat());
+    Update(args.timeStep_);
 }
 
 void RmlUI::HandleDropFile(StringHash, VariantMap& eventData)
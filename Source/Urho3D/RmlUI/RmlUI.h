@@ -42,6 +42,8 @@ namespace Urho3D
 
 namespace Detail { class RmlContext; class RmlPlugin; }
 
+struct PostUpdateEventArgs;
+
 struct RmlCanvasResizedArgs
 {
     /// Previous size of canvas.
@@ -140,7 +142,7 @@ private:
     /// Handle text input event.
     void HandleTextInput(StringHash eventType, VariantMap& eventData);
     /// Handle logic post-update event.
-    void HandlePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandlePostUpdate(const PostUpdateEventArgs& args);
     /// Handle a file being drag-dropped into the application window.
     void HandleDropFile(StringHash eventType, VariantMap& eventData);
     /// Handle rendering to a texture.
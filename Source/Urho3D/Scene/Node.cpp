@@ -39,6 +39,7 @@
 #include "../Scene/UnknownComponent.h"
 
 #include <charconv>
+#include <thread>
 
 #include "../DebugNew.h"
 
@@ -587,6 +588,7 @@ void Node::RemoveAllTags()
 
 void Node::SetPosition(const Vector3& position)
 {
+    PrepareTransformChange();
     position_ = position;
     MarkDirty();
 
@@ -595,6 +597,7 @@ void Node::SetPosition(const Vector3& position)
 
 void Node::SetRotation(const Quaternion& rotation)
 {
+    PrepareTransformChange();
     rotation_ = rotation;
     MarkDirty();
 
@@ -613,6 +616,7 @@ void Node::SetScale(float scale)
 
 void Node::SetScale(const Vector3& scale)
 {
+    PrepareTransformChange();
     scale_ = scale;
     // Prevent exact zero scale e.g. from momentary edits as this may cause division by zero
     // when decomposing the world transform matrix
@@ -629,6 +633,7 @@ void Node::SetScale(const Vector3& scale)
 
 void Node::SetTransform(const Vector3& position, const Quaternion& rotation)
 {
+    PrepareTransformChange();
     position_ = position;
     rotation_ = rotation;
     MarkDirty();
@@ -643,6 +648,7 @@ void Node::SetTransform(const Vector3& position, const Quaternion& rotation, flo
 
 void Node::SetTransform(const Vector3& position, const Quaternion& rotation, const Vector3& scale)
 {
+    PrepareTransformChange();
     position_ = position;
     rotation_ = rotation;
     scale_ = scale;
@@ -709,6 +715,7 @@ void Node::SetWorldTransform(const Matrix3x4& worldTransform)
 
 void Node::Translate(const Vector3& delta, TransformSpace space)
 {
+    PrepareTransformChange();
     switch (space)
     {
     case TS_LOCAL:
@@ -732,6 +739,7 @@ void Node::Translate(const Vector3& delta, TransformSpace space)
 
 void Node::Rotate(const Quaternion& delta, TransformSpace space)
 {
+    PrepareTransformChange();
     switch (space)
     {
     case TS_LOCAL:
@@ -760,6 +768,7 @@ void Node::Rotate(const Quaternion& delta, TransformSpace space)
 
 void Node::RotateAround(const Vector3& point, const Quaternion& delta, TransformSpace space)
 {
+    PrepareTransformChange();
     Vector3 parentSpacePoint;
     Quaternion oldRotation = rotation_;
 
@@ -870,6 +879,7 @@ void Node::Scale(float scale)
 
 void Node::Scale(const Vector3& scale)
 {
+    PrepareTransformChange();
     scale_ *= scale;
     MarkDirty();
 
@@ -1007,6 +1017,7 @@ void Node::AddChild(Node* node, unsigned index)
     if (scene_ && node->GetScene() != scene_)
         scene_->NodeAdded(node);
 
+    node->PrepareTransformChange();
     node->parent_ = this;
     node->MarkDirty();
     node->MarkNetworkUpdate();
@@ -1787,11 +1798,13 @@ void Node::SetNetParentAttr(const ea::vector<unsigned char>& value)
 
 const Vector3& Node::GetNetPositionAttr() const
 {
+    ApplyPendingTransform();
     return position_;
 }
 
 const ea::vector<unsigned char>& Node::GetNetRotationAttr() const
 {
+    ApplyPendingTransform();
     impl_->attrBuffer_.Clear();
     impl_->attrBuffer_.WritePackedQuaternion(rotation_);
     return impl_->attrBuffer_.GetBuffer();
@@ -2169,6 +2182,7 @@ unsigned Node::GetNumPersistentComponents() const
 
 void Node::SetTransformSilent(const Vector3& position, const Quaternion& rotation, const Vector3& scale)
 {
+    PrepareTransformChange();
     position_ = position;
     rotation_ = rotation;
     scale_ = scale;
@@ -2179,6 +2193,50 @@ void Node::SetTransformSilent(const Matrix3x4& matrix)
     SetTransformSilent(matrix.Translation(), matrix.Rotation(), matrix.Scale());
 }
 
+void NodeTransformSource::WritePendingTransformsOnce()
+{
+    while (true)
+    {
+        PendingTransformsState state = pendingTransformsState_.load(std::memory_order_acquire);
+        if (state == PendingTransformsState::None)
+            return;
+
+        if (state == PendingTransformsState::Pending
+            && pendingTransformsState_.compare_exchange_weak(state, PendingTransformsState::Writing, std::memory_order_acquire))
+        {
+            WritePendingTransforms();
+            pendingTransformsState_.store(PendingTransformsState::None, std::memory_order_release);
+            return;
+        }
+
+        // Another thread is writing transforms, they must not be read until it is finished
+        if (state == PendingTransformsState::Writing)
+            std::this_thread::yield();
+    }
+}
+
+void NodeTransformSource::DiscardPendingTransforms()
+{
+    while (true)
+    {
+        PendingTransformsState state = pendingTransformsState_.load(std::memory_order_acquire);
+        if (state == PendingTransformsState::None)
+            return;
+
+        if (state == PendingTransformsState::Writing)
+            std::this_thread::yield();
+        else if (pendingTransformsState_.compare_exchange_weak(state, PendingTransformsState::None, std::memory_order_acquire))
+            return;
+    }
+}
+
+void NodeTransformSource::WriteNodeTransform(Node* node, const Vector3& position, const Quaternion& rotation, const Vector3& scale)
+{
+    node->position_ = position;
+    node->rotation_ = rotation;
+    node->scale_ = scale;
+}
+
 void Node::OnAttributeAnimationAdded()
 {
     if (attributeAnimationInfos_.size() == 1)
@@ -2404,6 +2462,7 @@ void Node::RemoveChild(ea::vector<SharedPtr<Node> >::iterator i)
         scene_->SendEvent(E_NODEREMOVED, eventData);
     }
 
+    child->PrepareTransformChange();
     child->parent_ = nullptr;
     child->MarkDirty();
     child->MarkNetworkUpdate();
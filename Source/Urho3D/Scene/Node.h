@@ -28,6 +28,8 @@
 #include "../Math/Matrix3x4.h"
 #include "../Scene/Animatable.h"
 
+#include <atomic>
+
 namespace Urho3D
 {
 
@@ -71,12 +73,60 @@ struct URHO3D_API NodeImpl
     mutable VectorBuffer attrBuffer_;
 };
 
+/// Source of local node transforms that are evaluated outside of the node and written to it on demand,
+/// e.g. animation pose of AnimatedModel bones.
+class URHO3D_API NodeTransformSource
+{
+public:
+    /// Destruct.
+    virtual ~NodeTransformSource() = default;
+
+    /// Write pending transforms to nodes if there are any. Safe to call from multiple threads at once:
+    /// if another thread is writing, wait until it is finished.
+    void ApplyPendingTransforms()
+    {
+        if (pendingTransformsState_.load(std::memory_order_acquire) != PendingTransformsState::None)
+            WritePendingTransformsOnce();
+    }
+    /// Handle local transform or parent of the node being changed externally.
+    virtual void OnNodeTransformChanged(Node* node) = 0;
+
+protected:
+    /// Write pending transforms to nodes.
+    virtual void WritePendingTransforms() = 0;
+    /// Write local transform to the node without notifying the source or marking the node dirty.
+    static void WriteNodeTransform(Node* node, const Vector3& position, const Quaternion& rotation, const Vector3& scale);
+
+    /// Drop pending transforms without writing them, wait if another thread is writing them.
+    /// Transforms may be modified after this call, nodes keep the transforms written last.
+    void DiscardPendingTransforms();
+    /// Mark modified transforms as not written to nodes yet.
+    void SetTransformsPending() { pendingTransformsState_.store(PendingTransformsState::Pending, std::memory_order_release); }
+
+private:
+    /// State of transforms evaluated but not written to nodes.
+    enum class PendingTransformsState : unsigned char
+    {
+        None,
+        Pending,
+        Writing
+    };
+
+    /// Write pending transforms or wait until another thread writes them.
+    void WritePendingTransformsOnce();
+
+    /// Whether there are evaluated transforms not written to nodes yet.
+    /// Reset only after the transforms are written, so no thread reads stale transforms.
+    std::atomic<PendingTransformsState> pendingTransformsState_{};
+};
+
 /// %Scene node that may contain components and child nodes.
 class URHO3D_API Node : public Animatable
 {
     URHO3D_OBJECT(Node, Animatable);
 
     friend class Connection;
+    friend class NodeTransformSource;
 
 public:
     /// Construct.
@@ -424,43 +474,43 @@ public:
 
     /// Return position in parent space.
     /// @property
-    const Vector3& GetPosition() const { return position_; }
+    const Vector3& GetPosition() const { ApplyPendingTransform(); return position_; }
 
     /// Return position in parent space (for Urho2D).
     /// @property
-    Vector2 GetPosition2D() const { return Vector2(position_.x_, position_.y_); }
+    Vector2 GetPosition2D() const { ApplyPendingTransform(); return Vector2(position_.x_, position_.y_); }
 
     /// Return rotation in parent space.
     /// @property
-    const Quaternion& GetRotation() const { return rotation_; }
+    const Quaternion& GetRotation() const { ApplyPendingTransform(); return rotation_; }
 
     /// Return rotation in parent space (for Urho2D).
     /// @property
-    float GetRotation2D() const { return rotation_.RollAngle(); }
+    float GetRotation2D() const { ApplyPendingTransform(); return rotation_.RollAngle(); }
 
     /// Return forward direction in parent space. Positive Z axis equals identity rotation.
     /// @property
-    Vector3 GetDirection() const { return rotation_ * Vector3::FORWARD; }
+    Vector3 GetDirection() const { ApplyPendingTransform(); return rotation_ * Vector3::FORWARD; }
 
     /// Return up direction in parent space. Positive Y axis equals identity rotation.
     /// @property
-    Vector3 GetUp() const { return rotation_ * Vector3::UP; }
+    Vector3 GetUp() const { ApplyPendingTransform(); return rotation_ * Vector3::UP; }
 
     /// Return right direction in parent space. Positive X axis equals identity rotation.
     /// @property
-    Vector3 GetRight() const { return rotation_ * Vector3::RIGHT; }
+    Vector3 GetRight() const { ApplyPendingTransform(); return rotation_ * Vector3::RIGHT; }
 
     /// Return scale in parent space.
     /// @property
-    const Vector3& GetScale() const { return scale_; }
+    const Vector3& GetScale() const { ApplyPendingTransform(); return scale_; }
 
     /// Return scale in parent space (for Urho2D).
     /// @property
-    Vector2 GetScale2D() const { return Vector2(scale_.x_, scale_.y_); }
+    Vector2 GetScale2D() const { ApplyPendingTransform(); return Vector2(scale_.x_, scale_.y_); }
 
     /// Return parent space transform matrix.
     /// @property
-    Matrix3x4 GetTransform() const { return Matrix3x4(position_, rotation_, scale_); }
+    Matrix3x4 GetTransform() const { ApplyPendingTransform(); return Matrix3x4(position_, rotation_, scale_); }
 
     /// Return position in world space.
     /// @property
@@ -705,13 +755,13 @@ public:
     unsigned GetNumPersistentComponents() const;
 
     /// Set position in parent space silently without marking the node & child nodes dirty. Used by animation code.
-    void SetPositionSilent(const Vector3& position) { position_ = position; }
+    void SetPositionSilent(const Vector3& position) { PrepareTransformChange(); position_ = position; }
 
     /// Set position in parent space silently without marking the node & child nodes dirty. Used by animation code.
-    void SetRotationSilent(const Quaternion& rotation) { rotation_ = rotation; }
+    void SetRotationSilent(const Quaternion& rotation) { PrepareTransformChange(); rotation_ = rotation; }
 
     /// Set scale in parent space silently without marking the node & child nodes dirty. Used by animation code.
-    void SetScaleSilent(const Vector3& scale) { scale_ = scale; }
+    void SetScaleSilent(const Vector3& scale) { PrepareTransformChange(); scale_ = scale; }
 
     /// Set local transform silently without marking the node & child nodes dirty. Used by animation code.
     void SetTransformSilent(const Vector3& position, const Quaternion& rotation, const Vector3& scale);
@@ -719,6 +769,11 @@ public:
     /// Set local transform silently without marking the node & child nodes dirty. Used by animation code.
     void SetTransformSilent(const Matrix3x4& matrix);
 
+    /// Set source of local transform that is written to the node on demand. Used by animation code.
+    void SetTransformSource(NodeTransformSource* source) { transformSource_ = source; }
+    /// Return source of local transform.
+    NodeTransformSource* GetTransformSource() const { return transformSource_; }
+
 protected:
     /// Handle attribute animation added.
     void OnAttributeAnimationAdded() override;
@@ -734,6 +789,21 @@ private:
     Component* SafeCreateComponent(const ea::string& typeName, StringHash type, CreateMode mode, unsigned id);
     /// Recalculate the world transform.
     void UpdateWorldTransform() const;
+    /// Write pending local transform from transform source.
+    void ApplyPendingTransform() const
+    {
+        if (transformSource_)
+            transformSource_->ApplyPendingTransforms();
+    }
+    /// Write pending local transform and notify transform source before local transform or parent is changed.
+    void PrepareTransformChange()
+    {
+        if (transformSource_)
+        {
+            transformSource_->ApplyPendingTransforms();
+            transformSource_->OnNodeTransformChanged(this);
+        }
+    }
     /// Remove child node by iterator.
     void RemoveChild(ea::vector<SharedPtr<Node> >::iterator i);
     /// Return child nodes recursively.
@@ -790,6 +860,8 @@ private:
     ea::vector<SharedPtr<Node> > children_;
     /// Node listeners.
     ea::vector<WeakPtr<Component> > listeners_;
+    /// Source of local transform written on demand.
+    NodeTransformSource* transformSource_{};
     /// Pointer to implementation.
     ea::unique_ptr<NodeImpl> impl_;
 
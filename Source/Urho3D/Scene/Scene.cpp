@@ -80,7 +80,7 @@ Scene::Scene(Context* context) :
     SetID(GetFreeNodeID(REPLICATED));
     NodeAdded(this);
 
-    SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(Scene, HandleUpdate));
+    SubscribeToTypedEvent<UpdateEventArgs>([this](const UpdateEventArgs& args) { HandleUpdate(args); });
     SubscribeToEvent(E_RESOURCEBACKGROUNDLOADED, URHO3D_HANDLER(Scene, HandleResourceBackgroundLoaded));
 }
 
@@ -1239,13 +1239,12 @@ void Scene::MarkReplicationDirty(Node* node)
     }
 }
 
-void Scene::HandleUpdate(StringHash eventType, VariantMap& eventData)
+void Scene::HandleUpdate(const UpdateEventArgs& args)
 {
     if (!updateEnabled_)
         return;
 
-    using namespace Update;
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(args.timeStep_);
 }
 
 void Scene::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData)
@@ -1632,4 +1631,11 @@ void RegisterSceneLibrary(Context* context)
     CameraViewport::RegisterObject(context);
 }
 
+void SceneDrawableUpdateFinishedEventArgs::ToVariantMap(VariantMap& eventData) const
+{
+    using namespace SceneDrawableUpdateFinished;
+    eventData[P_SCENE] = scene_;
+    eventData[P_TIMESTEP] = timeStep_;
+}
+
 }
@@ -27,6 +27,8 @@
 namespace Urho3D
 {
 
+class Scene;
+
 /// Variable timestep scene update.
 URHO3D_EVENT(E_SCENEUPDATE, SceneUpdate)
 {
@@ -55,6 +57,20 @@ URHO3D_EVENT(E_SCENEDRAWABLEUPDATEFINISHED, SceneDrawableUpdateFinished)
     URHO3D_PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed payload of E_SCENEDRAWABLEUPDATEFINISHED.
+struct URHO3D_API SceneDrawableUpdateFinishedEventArgs
+{
+    /// Scene.
+    Scene* scene_{};
+    /// Frame time step.
+    float timeStep_{};
+
+    /// Return event type.
+    static StringHash GetEventType() { return E_SCENEDRAWABLEUPDATEFINISHED; }
+    /// Convert to event parameters.
+    void ToVariantMap(VariantMap& eventData) const;
+};
+
 /// SmoothedTransform target position changed.
 URHO3D_EVENT(E_TARGETPOSITION, TargetPositionChanged)
 {
@@ -867,8 +867,8 @@ void UI::Initialize()
     initialized_ = true;
 
     SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(UI, HandleBeginFrame));
-    SubscribeToEvent(E_POSTUPDATE, URHO3D_HANDLER(UI, HandlePostUpdate));
-    SubscribeToEvent(E_RENDERUPDATE, URHO3D_HANDLER(UI, HandleRenderUpdate));
+    SubscribeToTypedEvent<PostUpdateEventArgs>([this](const PostUpdateEventArgs& args) { HandlePostUpdate(args); });
+    SubscribeToTypedEvent<RenderUpdateEventArgs>([this](const RenderUpdateEventArgs& args) { HandleRenderUpdate(args); });
 }
 
 void UI::Update(float timeStep, UIElement* element)
@@ -1921,14 +1921,12 @@ void UI::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
         cursor_->SetShape(CS_NORMAL);
 }
 
-void UI::HandlePostUpdate(StringHash eventType, VariantMap& eventData)
+void UI::HandlePostUpdate(const PostUpdateEventArgs& args)
 {
-    using namespace PostUpdate;
-
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(args.timeStep_);
 }
 
-void UI::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
+void UI::HandleRenderUpdate(const RenderUpdateEventArgs& args)
 {
     RenderUpdate();
 }
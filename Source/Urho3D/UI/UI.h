@@ -57,6 +57,8 @@ class XMLElement;
 class XMLFile;
 class RenderSurface;
 class UIComponent;
+struct PostUpdateEventArgs;
+struct RenderUpdateEventArgs;
 
 /// %UI subsystem. Manages the graphical user interface.
 class URHO3D_API UI : public Object
@@ -362,9 +364,9 @@ private:
     /// Handle frame begin event.
     void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
     /// Handle logic post-update event.
-    void HandlePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandlePostUpdate(const PostUpdateEventArgs& args);
     /// Handle render update event.
-    void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleRenderUpdate(const RenderUpdateEventArgs& args);
     /// Handle a file being drag-dropped into the application window.
     void HandleDropFile(StringHash eventType, VariantMap& eventData);
     /// Handle off-screen UI subsystems gaining focus.
@@ -1909,13 +1909,13 @@ IntVector2 UIElement::GetEffectiveMinSize() const
 void UIElement::OnAttributeAnimationAdded()
 {
     if (attributeAnimationInfos_.size() == 1)
-        SubscribeToEvent(E_POSTUPDATE, URHO3D_HANDLER(UIElement, HandlePostUpdate));
+        SubscribeToTypedEvent<PostUpdateEventArgs>([this](const PostUpdateEventArgs& args) { HandlePostUpdate(args); });
 }
 
 void UIElement::OnAttributeAnimationRemoved()
 {
     if (attributeAnimationInfos_.empty())
-        UnsubscribeFromEvent(E_POSTUPDATE);
+        UnsubscribeFromTypedEvent<PostUpdateEventArgs>();
 }
 
 Animatable* UIElement::FindAttributeAnimationTarget(const ea::string& name, ea::string& outName)
@@ -2267,11 +2267,9 @@ void UIElement::VerifyChildAlignment()
     }
 }
 
-void UIElement::HandlePostUpdate(StringHash eventType, VariantMap& eventData)
+void UIElement::HandlePostUpdate(const PostUpdateEventArgs& args)
 {
-    using namespace PostUpdate;
-
-    UpdateAttributeAnimations(eventData[P_TIMESTEP].GetFloat());
+    UpdateAttributeAnimations(args.timeStep_);
 }
 
 }
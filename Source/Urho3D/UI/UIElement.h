@@ -117,6 +117,7 @@ URHO3D_FLAGSET(DragAndDropMode, DragAndDropModeFlags);
 class Cursor;
 class ResourceCache;
 class Texture2D;
+struct PostUpdateEventArgs;
 
 /// Base class for %UI elements.
 class URHO3D_API UIElement : public Animatable
@@ -874,7 +875,7 @@ private:
     /// Verify that child elements have proper alignment for layout mode.
     void VerifyChildAlignment();
     /// Handle logic post-update event.
-    void HandlePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandlePostUpdate(const PostUpdateEventArgs& args);
 
     /// Size.
     IntVector2 size_;